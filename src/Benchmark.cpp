@@ -0,0 +1,678 @@
+#include "Benchmark.h"
+#include "Caps.h"
+#include "DeferredDelete.h"
+#include "Gfx.h"
+#include "PointCloud.h"
+#include "Scene.h"
+#include "Stats.h"
+#include "Tilemap.h"
+#include "TimeSeries.h"
+#include "Window.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    double MsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // minimal JSON reader, enough for the files WriteBenchJson produces
+    struct JsonReader
+    {
+        const char* p;
+        const char* end;
+
+        void SkipWs() { while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) ++p; }
+        bool Eat(char c) { SkipWs(); if (p < end && *p == c) { ++p; return true; } return false; }
+
+        bool String(std::string& out)
+        {
+            out.clear();
+            if (!Eat('"')) return false;
+            while (p < end && *p != '"')
+            {
+                if (*p == '\\' && p + 1 < end) ++p;
+                out.push_back(*p++);
+            }
+            return Eat('"');
+        }
+
+        bool Number(double& out)
+        {
+            SkipWs();
+            char* stop = nullptr;
+            out = strtod(p, &stop);
+            if (stop == p) return false;
+            p = stop;
+            return true;
+        }
+
+        // skips any value we do not care about
+        bool Skip()
+        {
+            SkipWs();
+            if (p >= end) return false;
+            std::string s;
+            double d;
+            if (*p == '"') return String(s);
+            if (*p == '{' || *p == '[')
+            {
+                char close = *p == '{' ? '}' : ']';
+                bool object = *p == '{';
+                ++p;
+                if (Eat(close)) return true;
+                do
+                {
+                    if (object && (!String(s) || !Eat(':'))) return false;
+                    if (!Skip()) return false;
+                } while (Eat(','));
+                return Eat(close);
+            }
+            if (!strncmp(p, "true", 4)) { p += 4; return true; }
+            if (!strncmp(p, "false", 5)) { p += 5; return true; }
+            if (!strncmp(p, "null", 4)) { p += 4; return true; }
+            return Number(d);
+        }
+
+        bool Case(BenchCase& c)
+        {
+            if (!Eat('{')) return false;
+            if (Eat('}')) return true;
+            do
+            {
+                std::string key;
+                if (!String(key) || !Eat(':')) return false;
+                if (key == "name") { if (!String(c.name)) return false; }
+                else if (key == "unit") { if (!String(c.unit)) return false; }
+                else if (key == "samples")
+                {
+                    if (!Eat('[')) return false;
+                    if (Eat(']')) continue;
+                    do
+                    {
+                        double v;
+                        if (!Number(v)) return false;
+                        c.samples.push_back(v);
+                    } while (Eat(','));
+                    if (!Eat(']')) return false;
+                }
+                else if (!Skip()) return false;
+            } while (Eat(','));
+            return Eat('}');
+        }
+    };
+
+    // Mann-Whitney U of "current" against "baseline" with the normal approximation,
+    // tie and continuity correction. Returns the one-sided p-value for current being
+    // larger and the common-language effect size A = P(current > baseline).
+    void MannWhitney(const std::vector<double>& baseline, const std::vector<double>& current, double& pSlower, double& effectA)
+    {
+        const size_t n1 = current.size();
+        const size_t n2 = baseline.size();
+        pSlower = 1.0;
+        effectA = 0.5;
+        if (n1 == 0 || n2 == 0) return;
+
+        struct Ranked { double v; int group; };
+        std::vector<Ranked> all;
+        for (double v : current) all.push_back({ v, 0 });
+        for (double v : baseline) all.push_back({ v, 1 });
+        std::sort(all.begin(), all.end(), [](const Ranked& a, const Ranked& b) { return a.v < b.v; });
+
+        const double n = (double)all.size();
+        double rankSum = 0.0;
+        double tieTerm = 0.0;
+        for (size_t i = 0; i < all.size();)
+        {
+            size_t j = i;
+            while (j < all.size() && all[j].v == all[i].v) ++j;
+            double rank = 0.5 * (double)(i + j + 1);   // average of ranks i+1..j
+            for (size_t k = i; k < j; ++k)
+                if (all[k].group == 0) rankSum += rank;
+            double t = (double)(j - i);
+            tieTerm += t * t * t - t;
+            i = j;
+        }
+
+        double u = rankSum - (double)n1 * (n1 + 1) / 2.0;
+        effectA = u / ((double)n1 * n2);
+
+        double mean = (double)n1 * n2 / 2.0;
+        double var = (double)n1 * n2 / 12.0 * ((n + 1.0) - tieTerm / (n * (n - 1.0)));
+        if (var <= 0.0) return;
+        double z = (u - mean - 0.5) / sqrt(var);
+        pSlower = 0.5 * erfc(z / sqrt(2.0));
+    }
+
+    // mean frame time over `frames` frames after `warmup`, including GPU completion
+    double MeasureScene(const Scene& scene, const SceneProgram& program, const BenchOptions& options)
+    {
+        double total = 0.0;
+        for (int f = 0; f < options.warmupFrames + options.frames; ++f)
+        {
+            Clock::time_point start = Clock::now();
+            GfxClear(0.0f, 0.0f, 0.0f, 1.0f);
+            DrawScene(scene, program, (float)f / 60.0f);
+            glFinish();
+            Loop();
+            DeferredDeleteEndFrame();
+            if (f >= options.warmupFrames)
+                total += MsSince(start);
+        }
+        return total / options.frames;
+    }
+
+    // same, for a tilemap panned by 1% of the view per frame so the texture reads move
+    double MeasureTilemap(const Tilemap& map, double zoom, const BenchOptions& options)
+    {
+        Camera2D camera;
+        camera.zoom = zoom;
+        camera.center[0] = map.origin[0] + 0.25 * map.width * map.tileSize;
+        camera.center[1] = map.origin[1] + 0.5 * map.height * map.tileSize;
+        const float viewScale[2] = { 1.0f, 1.0f };
+        double total = 0.0;
+        for (int f = 0; f < options.warmupFrames + options.frames; ++f)
+        {
+            Clock::time_point start = Clock::now();
+            camera.center[0] += 0.02 / zoom;
+            CameraUpload(camera);
+            GfxClear(0.0f, 0.0f, 0.0f, 1.0f);
+            DrawTilemap(map, camera, viewScale, (float)f / 60.0f);
+            glFinish();
+            Loop();
+            if (f >= options.warmupFrames)
+                total += MsSince(start);
+        }
+        CameraUpload(Camera2D());
+        return total / options.frames;
+    }
+
+    // same, for a time series swept back and forth by a quarter view around the series
+    // center; appends `append` to the series every frame first, as streaming data would
+    double MeasureTimeSeries(TimeSeries& series, double zoom, const std::vector<float>& append,
+        const BenchOptions& options)
+    {
+        Camera2D camera;
+        camera.zoom = zoom;
+        const double center = series.origin[0] + 0.5 * (double)series.count * series.sampleWidth;
+        camera.center[1] = series.origin[1];
+        const float viewScale[2] = { 1.0f, 1.0f };
+        double total = 0.0;
+        for (int f = 0; f < options.warmupFrames + options.frames; ++f)
+        {
+            Clock::time_point start = Clock::now();
+            camera.center[0] = center + 0.25 / zoom * sin(f * 0.1);
+            CameraUpload(camera);
+            if (!append.empty())
+                TimeSeriesAppend(series, append.data(), append.size());
+            GfxClear(0.0f, 0.0f, 0.0f, 1.0f);
+            DrawTimeSeries(series, camera, viewScale, 800, 1.0f, 1.0f, 1.0f);
+            glFinish();
+            Loop();
+            DeferredDeleteEndFrame();
+            if (f >= options.warmupFrames)
+                total += MsSince(start);
+        }
+        CameraUpload(Camera2D());
+        return total / options.frames;
+    }
+
+    // same, for a point cloud swept back and forth by a tenth of the view
+    double MeasurePoints(const PointCloud& cloud, PointSplatMode mode, PointDrawPath path, const BenchOptions& options)
+    {
+        Camera2D camera;
+        const float viewScale[2] = { 1.0f, 1.0f };
+        double total = 0.0;
+        for (int f = 0; f < options.warmupFrames + options.frames; ++f)
+        {
+            Clock::time_point start = Clock::now();
+            camera.center[0] = 0.1 * sin(f * 0.1);
+            CameraUpload(camera);
+            GfxClear(0.0f, 0.0f, 0.0f, 1.0f);
+            DrawPointCloud(cloud, camera, viewScale, 800, 800, mode, path);
+            glFinish();
+            Loop();
+            DeferredDeleteEndFrame();
+            if (f >= options.warmupFrames)
+                total += MsSince(start);
+        }
+        CameraUpload(Camera2D());
+        return total / options.frames;
+    }
+
+    // ms per program build; cold sources carry a unique comment so no driver cache hits
+    double MeasureShaderBuild(bool cold, int builds)
+    {
+        static unsigned nonce = 0;
+        std::string vs = SceneVertexSource();
+        std::string fs = SceneFragmentSource();
+        std::string err;
+        double total = 0.0;
+
+        if (!cold)
+        {
+            // prime whatever the driver caches
+            Shader prime;
+            prime.CreateFromSource(vs.c_str(), fs.c_str(), err);
+            prime.Destroy();
+        }
+
+        for (int i = 0; i < builds; ++i)
+        {
+            std::string v = vs, f = fs;
+            if (cold)
+            {
+                char tag[96];
+                snprintf(tag, sizeof(tag), "\n// bench %u %lld\n", nonce++,
+                    (long long)Clock::now().time_since_epoch().count());
+                // must come after the #version line
+                v.insert(v.find('\n', v.find("#version")), tag);
+                f.insert(f.find('\n', f.find("#version")), tag);
+            }
+            Shader s;
+            Clock::time_point start = Clock::now();
+            bool ok = s.CreateFromSource(v.c_str(), f.c_str(), err);
+            glFinish();
+            total += MsSince(start);
+            s.Destroy();
+            if (!ok)
+            {
+                fprintf(stderr, "bench: shader build failed:\n%s\n", err.c_str());
+                return -1.0;
+            }
+        }
+        return total / builds;
+    }
+
+    bool Selected(const BenchOptions& options, const char* name)
+    {
+        return !options.filter || strstr(name, options.filter) != nullptr;
+    }
+
+    // the tilemap, time series and point cloud cases allocate hundreds of MB and take
+    // hours on llvmpipe, so only --large or a --filter matching them runs them
+    bool SelectedLarge(const BenchOptions& options, const char* name)
+    {
+        return (options.large || options.filter) && Selected(options, name);
+    }
+}
+
+bool WriteBenchJson(const char* path, const std::vector<BenchCase>& cases)
+{
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "{\n  \"version\": 1,\n  \"renderer\": \"%s\",\n  \"cases\": [\n",
+        glGetString(GL_RENDERER) ? (const char*)glGetString(GL_RENDERER) : "unknown");
+    for (size_t i = 0; i < cases.size(); ++i)
+    {
+        const BenchCase& c = cases[i];
+        fprintf(f, "    { \"name\": \"%s\", \"unit\": \"%s\", \"samples\": [", c.name.c_str(), c.unit.c_str());
+        for (size_t s = 0; s < c.samples.size(); ++s)
+            fprintf(f, "%s%.6f", s ? ", " : "", c.samples[s]);
+        fprintf(f, "] }%s\n", i + 1 < cases.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    return fclose(f) == 0;
+}
+
+bool ReadBenchJson(const char* path, std::vector<BenchCase>& cases)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    std::string text;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) text.append(buf, n);
+    fclose(f);
+
+    JsonReader r{ text.data(), text.data() + text.size() };
+    if (!r.Eat('{')) return false;
+    do
+    {
+        std::string key;
+        if (!r.String(key) || !r.Eat(':')) return false;
+        if (key != "cases")
+        {
+            if (!r.Skip()) return false;
+            continue;
+        }
+        if (!r.Eat('[')) return false;
+        if (r.Eat(']')) continue;
+        do
+        {
+            BenchCase c;
+            if (!r.Case(c)) return false;
+            cases.push_back(c);
+        } while (r.Eat(','));
+        if (!r.Eat(']')) return false;
+    } while (r.Eat(','));
+    return r.Eat('}');
+}
+
+bool CompareBenchResults(const std::vector<BenchCase>& baseline, const std::vector<BenchCase>& current,
+    double threshold, double alpha)
+{
+    bool regressed = false;
+    printf("\n%-22s %12s %12s %9s %7s %9s  %s\n", "case", "baseline", "current", "change", "A", "p", "verdict");
+    for (const BenchCase& c : current)
+    {
+        auto it = std::find_if(baseline.begin(), baseline.end(), [&](const BenchCase& b) { return b.name == c.name; });
+        double cur = Median(c.samples);
+        if (it == baseline.end() || it->samples.empty())
+        {
+            printf("%-22s %12s %9.4f %-2s %9s %7s %9s  new\n", c.name.c_str(), "-", cur, c.unit.c_str(), "-", "-", "-");
+            continue;
+        }
+
+        double base = Median(it->samples);
+        double change = base > 0.0 ? (cur - base) / base : 0.0;
+        double p = 1.0, a = 0.5;
+        MannWhitney(it->samples, c.samples, p, a);
+
+        // significant and large enough to matter; either alone is noise or nitpicking
+        const char* verdict = "ok";
+        if (p < alpha && change > threshold) { verdict = "REGRESSION"; regressed = true; }
+        else
+        {
+            double pFaster = 1.0, aFaster = 0.5;
+            MannWhitney(c.samples, it->samples, pFaster, aFaster);
+            if (pFaster < alpha && change < -threshold) verdict = "improved";
+        }
+        printf("%-22s %9.4f %-2s %9.4f %-2s %+8.1f%% %7.2f %9.5f  %s\n", c.name.c_str(),
+            base, c.unit.c_str(), cur, c.unit.c_str(), change * 100.0, a, p, verdict);
+    }
+    printf("\nmedians of per-run means; A = P(current > baseline); regression needs p < %.3f and change > %.1f%%\n",
+        alpha, threshold * 100.0);
+    return regressed;
+}
+
+int RunBenchmarkSuite(const BenchOptions& options)
+{
+    if (!CreateWindow(800, 800, "Benchmark", false))
+        return -1;
+    SetSwapInterval(0);
+    glViewport(0, 0, 800, 800);
+    printf("bench: %s / %s\n", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+    // the modules check optional ES 3.1 limits through it
+    GpuCaps caps;
+    ProbeCaps(nullptr, caps);
+    CameraInit();
+
+    // one program per way of fetching vertices, indexed by VertexFetch; the pulled
+    // ones are optional and their cases are skipped when the driver cannot run them
+    SceneProgram programs[FetchCount];
+    bool haveProgram[FetchCount] = {};
+    std::string err;
+    for (int fetch = 0; fetch < FetchCount; ++fetch)
+    {
+        haveProgram[fetch] = CreateSceneProgram(programs[fetch], err, (VertexFetch)fetch);
+        if (haveProgram[fetch])
+            continue;
+        if (fetch != FetchAttributes && caps.maxVertexStorageBlocks < 1)
+        {
+            printf("bench: skipping %s cases: %s\n", VertexFetchName((VertexFetch)fetch), err.c_str());
+            continue;
+        }
+        fprintf(stderr, "bench: scene shader (%s) failed:\n%s\n", VertexFetchName((VertexFetch)fetch), err.c_str());
+        for (int i = 0; i < fetch; ++i) DestroySceneProgram(programs[i]);
+        CameraShutdown();
+        DestroyWindow();
+        return -1;
+    }
+
+    struct SceneCase { const char* name; int triangles; };
+    const SceneCase sceneCases[] = {
+        { "five_mode", 0 },
+        { "stress_10k", 10000 },
+        { "stress_100k", 100000 },
+        { "stress_1m", 1000000 },
+    };
+
+    std::vector<BenchCase> results;
+    for (const SceneCase& sc : sceneCases)
+    {
+        // stress scenes also run with vertex pulling: <name>_pulled and <name>_packed
+        for (int fetch = 0; fetch < (sc.triangles ? (int)FetchCount : 1); ++fetch)
+        {
+            std::string name = sc.name;
+            if (fetch != FetchAttributes)
+                name += std::string("_") + VertexFetchName((VertexFetch)fetch);
+            if (!haveProgram[fetch] || !Selected(options, name.c_str())) continue;
+            Scene scene;
+            if (sc.triangles) BuildStressScene(scene, sc.triangles, 1234u, (VertexFetch)fetch);
+            else BuildFiveModeScene(scene);
+
+            BenchCase c;
+            c.name = name;
+            c.unit = "ms";
+            for (int run = 0; run < options.runs; ++run)
+                c.samples.push_back(MeasureScene(scene, programs[fetch], options));
+            printf("bench: %-20s median %.4f ms over %d runs\n", name.c_str(), Median(c.samples), options.runs);
+            results.push_back(c);
+            DestroyScene(scene);
+        }
+    }
+
+    // a 16k x 16k map with a ground and a decoration layer (512 MB of indices), drawn as
+    // one quad at ~16 tiles across the window, ~1 tile per pixel and the whole map
+    struct TilemapCase { const char* name; double zoom; };
+    const TilemapCase tilemapCases[] = {
+        { "tilemap_16k_near", 4.0 },
+        { "tilemap_16k_pixel", 0.08 },
+        { "tilemap_16k_whole", 2.0 / 512.0 },
+    };
+    bool anyTilemap = false;
+    for (const TilemapCase& tc : tilemapCases)
+        anyTilemap = anyTilemap || SelectedLarge(options, tc.name);
+    Tilemap map;
+    if (anyTilemap && (!TilemapInit(err) || !CreateTilemap(map, 16384, 16384, 2, err)))
+    {
+        printf("bench: skipping tilemap cases: %s\n", err.c_str());
+        anyTilemap = false;
+    }
+    Clock::time_point tilemapStart = Clock::now();
+    if (anyTilemap)
+    {
+        map.origin[0] = -0.5 * map.width * map.tileSize;
+        map.origin[1] = -0.5 * map.height * map.tileSize;
+        if (!BuildDemoTilemap(map, 1234u, err))
+        {
+            printf("bench: skipping tilemap cases: %s\n", err.c_str());
+            anyTilemap = false;
+        }
+    }
+    if (anyTilemap)
+    {
+        glFinish();
+        printf("bench: tilemap 16384x16384x2 built in %.0f ms\n", MsSince(tilemapStart));
+        for (const TilemapCase& tc : tilemapCases)
+        {
+            if (!SelectedLarge(options, tc.name)) continue;
+            BenchCase c;
+            c.name = tc.name;
+            c.unit = "ms";
+            for (int run = 0; run < options.runs; ++run)
+                c.samples.push_back(MeasureTilemap(map, tc.zoom, options));
+            printf("bench: %-20s median %.4f ms over %d runs\n", tc.name, Median(c.samples), options.runs);
+            results.push_back(c);
+        }
+    }
+    DestroyTilemap(map);
+    TilemapShutdown();
+
+    // 100M samples spanning 2 world units: all of them, ~1M and ~8k across the 800 px
+    // window, and all of them with 100k samples appended per frame
+    struct TimeSeriesCase { const char* name; double zoom; size_t append; };
+    const TimeSeriesCase seriesCases[] = {
+        { "timeseries_100m_whole", 1.0, 0 },
+        { "timeseries_100m_1m", 100.0, 0 },
+        { "timeseries_100m_8k", 12500.0, 0 },
+        { "timeseries_100m_append", 1.0, 100000 },
+    };
+    const uint64_t seriesSamples = 100000000;
+    bool anySeries = false;
+    for (const TimeSeriesCase& tc : seriesCases)
+        anySeries = anySeries || SelectedLarge(options, tc.name);
+    TimeSeries series;
+    series.origin[0] = -1.0;
+    series.sampleWidth = 2.0 / (double)seriesSamples;
+    series.valueScale = 0.4;
+    if (anySeries && (!TimeSeriesInit(err) || !CreateTimeSeries(series, seriesSamples, err)))
+    {
+        printf("bench: skipping time series cases: %s\n", err.c_str());
+        anySeries = false;
+    }
+    if (anySeries)
+    {
+        Clock::time_point start = Clock::now();
+        std::vector<float> chunk((size_t)1 << 20);
+        for (uint64_t first = 0; first < seriesSamples; first += chunk.size())
+        {
+            size_t n = (size_t)std::min<uint64_t>(chunk.size(), seriesSamples - first);
+            GenerateSensorSamples(first, n, 1234u, chunk.data());
+            TimeSeriesAppend(series, chunk.data(), n);
+        }
+        glFinish();
+        printf("bench: time series of %llu samples built in %.0f ms (%.0f MB on the GPU)\n",
+            (unsigned long long)seriesSamples, MsSince(start), series.bytes / (1024.0 * 1024.0));
+        for (const TimeSeriesCase& tc : seriesCases)
+        {
+            if (!SelectedLarge(options, tc.name)) continue;
+            std::vector<float> append(tc.append);
+            if (!append.empty())
+                GenerateSensorSamples(series.count, append.size(), 1234u, append.data());
+            BenchCase c;
+            c.name = tc.name;
+            c.unit = "ms";
+            for (int run = 0; run < options.runs; ++run)
+                c.samples.push_back(MeasureTimeSeries(series, tc.zoom, append, options));
+            printf("bench: %-22s median %.4f ms over %d runs (level %d, %u points)\n", tc.name, Median(c.samples),
+                options.runs, series.drawLevel, series.drawPoints);
+            results.push_back(c);
+        }
+    }
+    DestroyTimeSeries(series);
+    TimeSeriesShutdown();
+
+    // the whole cloud in the 800x800 window (~16-160 points per pixel on average, far
+    // more in the cluster cores): compute splatting in both modes against the fixed pipeline
+    struct PointCase { const char* name; PointSplatMode mode; PointDrawPath path; };
+    const PointCase pointCases[] = {
+        { "splat_density", SplatDensity, PointPathCompute },
+        { "splat_nearest", SplatNearest, PointPathCompute },
+        { "gl_points", SplatDensity, PointPathPoints },
+        { "quads", SplatDensity, PointPathQuads },
+    };
+    const uint64_t pointCounts[] = { 10000000, 100000000 };
+    bool pointsReady = false;
+    for (uint64_t count : pointCounts)
+    {
+        const std::string prefix = "points_" + std::to_string(count / 1000000) + "m_";
+        bool any = false;
+        for (const PointCase& pc : pointCases)
+            any = any || SelectedLarge(options, (prefix + pc.name).c_str());
+        if (!any) continue;
+        if (!pointsReady && !PointCloudInit(err))
+        {
+            printf("bench: skipping point cloud cases: %s\n", err.c_str());
+            break;
+        }
+        pointsReady = true;
+        PointCloud cloud;
+        if (!CreatePointCloud(cloud, count, err))
+        {
+            printf("bench: skipping %s*: %s\n", prefix.c_str(), err.c_str());
+            continue;
+        }
+        Clock::time_point start = Clock::now();
+        const size_t chunk = (size_t)1 << 20;
+        std::vector<float> positions(2 * chunk), values(chunk);
+        for (uint64_t first = 0; first < count; first += chunk)
+        {
+            size_t n = (size_t)std::min<uint64_t>(chunk, count - first);
+            GenerateScatterPoints(first, n, 1234u, positions.data(), values.data());
+            PointCloudAppend(cloud, positions.data(), values.data(), n);
+        }
+        glFinish();
+        printf("bench: point cloud of %llu points built in %.0f ms\n", (unsigned long long)count, MsSince(start));
+        for (const PointCase& pc : pointCases)
+        {
+            const std::string name = prefix + pc.name;
+            if (!SelectedLarge(options, name.c_str())) continue;
+            BenchCase c;
+            c.name = name;
+            c.unit = "ms";
+            for (int run = 0; run < options.runs; ++run)
+                c.samples.push_back(MeasurePoints(cloud, pc.mode, pc.path, options));
+            printf("bench: %-24s median %.4f ms over %d runs\n", name.c_str(), Median(c.samples), options.runs);
+            results.push_back(c);
+        }
+        DestroyPointCloud(cloud);
+        DeferredDeleteFlush();
+    }
+    PointCloudShutdown();
+
+    const bool shaderCold[] = { true, false };
+    for (bool cold : shaderCold)
+    {
+        const char* name = cold ? "shader_compile_cold" : "shader_compile_warm";
+        if (!Selected(options, name)) continue;
+        BenchCase c;
+        c.name = name;
+        c.unit = "ms";
+        for (int run = 0; run < options.runs; ++run)
+        {
+            double ms = MeasureShaderBuild(cold, 8);
+            if (ms < 0.0)
+            {
+                for (SceneProgram& p : programs) DestroySceneProgram(p);
+                DestroyWindow();
+                return -1;
+            }
+            c.samples.push_back(ms);
+        }
+        printf("bench: %-14s median %.4f ms over %d runs\n", name, Median(c.samples), options.runs);
+        results.push_back(c);
+    }
+
+    if (options.outputPath && !WriteBenchJson(options.outputPath, results))
+        fprintf(stderr, "bench: cannot write %s\n", options.outputPath);
+
+    int status = 0;
+    if (options.updateBaseline)
+    {
+        if (!WriteBenchJson(options.baselinePath, results))
+        {
+            fprintf(stderr, "bench: cannot write baseline %s\n", options.baselinePath);
+            status = -1;
+        }
+        else printf("bench: baseline updated at %s\n", options.baselinePath);
+    }
+    else
+    {
+        std::vector<BenchCase> baseline;
+        // a gate without a baseline would pass everything, so that is an error
+        if (!ReadBenchJson(options.baselinePath, baseline))
+        {
+            fprintf(stderr, "bench: no baseline at %s, nothing was compared; record one with --update-baseline\n",
+                options.baselinePath);
+            status = -1;
+        }
+        else if (CompareBenchResults(baseline, results, options.threshold, options.alpha))
+            status = 1;
+    }
+
+    for (SceneProgram& p : programs) DestroySceneProgram(p);
+    CameraShutdown();
+    DeferredDeleteFlush();
+    DestroyWindow();
+    return status;
+}
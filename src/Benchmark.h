@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// one measured quantity; every sample is the mean of one independent run
+struct BenchCase
+{
+    std::string name;
+    std::string unit;
+    std::vector<double> samples;
+};
+
+bool WriteBenchJson(const char* path, const std::vector<BenchCase>& cases);
+bool ReadBenchJson(const char* path, std::vector<BenchCase>& cases);
+
+struct BenchOptions
+{
+    int runs = 7;                   // independent samples per case
+    int frames = 120;               // measured frames per run
+    int warmupFrames = 10;          // frames dropped at the start of each run
+    const char* baselinePath = "bench/baseline.json";
+    const char* outputPath = "bench/results.json";
+    const char* filter = nullptr;   // only cases whose name contains this
+    bool updateBaseline = false;    // write the results over the baseline instead of comparing
+    bool large = false;             // also run the tilemap, time series and point cloud cases
+    double threshold = 0.05;        // median slowdown that counts as a regression
+    double alpha = 0.01;            // one-sided Mann-Whitney significance level
+};
+
+// Runs the fixed scene/shader suite in a hidden window, writes the results as JSON and
+// compares them against the baseline. Returns 0 when nothing regressed, 1 on a
+// regression and -1 on errors, which include a missing baseline. Works on software GL (e.g. LIBGL_ALWAYS_SOFTWARE=1).
+int RunBenchmarkSuite(const BenchOptions& options);
+
+// compares two result sets and prints a report; true if any case regressed
+bool CompareBenchResults(const std::vector<BenchCase>& baseline, const std::vector<BenchCase>& current,
+    double threshold, double alpha);
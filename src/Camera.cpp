@@ -0,0 +1,126 @@
+#include "Camera.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // matches the std140 block in the shaders
+    struct CameraBlock
+    {
+        float transform[4];
+        float center[2];
+        float pad[2];
+    };
+
+    const double kMinZoom = 1e-9;
+    const double kMaxZoom = 1e9;
+
+    GLuint gCameraBuffer = 0;
+
+    // view = M * relative, M = zoom * rotation(-camera.rotation)
+    void ViewMatrix(const Camera2D& camera, double* m)
+    {
+        double c = cos(camera.rotation) * camera.zoom;
+        double s = sin(camera.rotation) * camera.zoom;
+        m[0] = c;   // column 0
+        m[1] = -s;
+        m[2] = s;   // column 1
+        m[3] = c;
+    }
+}
+
+bool CameraInit()
+{
+    if (gCameraBuffer) return true;
+    glGenBuffers(1, &gCameraBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, gCameraBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    ProfilerTrackGpuBytes((int64_t)sizeof(CameraBlock));
+    CameraUpload(Camera2D());
+    return true;
+}
+
+void CameraShutdown()
+{
+    if (!gCameraBuffer) return;
+    glDeleteBuffers(1, &gCameraBuffer);
+    gCameraBuffer = 0;
+    ProfilerTrackGpuBytes(-(int64_t)sizeof(CameraBlock));
+}
+
+void CameraUpload(const Camera2D& camera)
+{
+    if (!gCameraBuffer) return;
+    double m[4];
+    ViewMatrix(camera, m);
+    CameraBlock block;
+    for (int i = 0; i < 4; ++i)
+        block.transform[i] = (float)m[i];
+    block.center[0] = (float)camera.center[0];
+    block.center[1] = (float)camera.center[1];
+    block.pad[0] = block.pad[1] = 0.0f;
+    glBindBuffer(GL_UNIFORM_BUFFER, gCameraBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    CameraBind();
+}
+
+void CameraBind()
+{
+    glBindBufferBase(GL_UNIFORM_BUFFER, kCameraBinding, gCameraBuffer);
+}
+
+void CameraRelative(const Camera2D& camera, const double* world, float* out)
+{
+    out[0] = (float)(world[0] - camera.center[0]);
+    out[1] = (float)(world[1] - camera.center[1]);
+}
+
+void CameraViewToWorld(const Camera2D& camera, double viewX, double viewY, double* world)
+{
+    // inverse of M: rotate back by +rotation and divide by zoom
+    double c = cos(camera.rotation) / camera.zoom;
+    double s = sin(camera.rotation) / camera.zoom;
+    world[0] = camera.center[0] + c * viewX - s * viewY;
+    world[1] = camera.center[1] + s * viewX + c * viewY;
+}
+
+void CameraPanView(Camera2D& camera, double viewDx, double viewDy)
+{
+    double origin[2], moved[2];
+    CameraViewToWorld(camera, 0.0, 0.0, origin);
+    CameraViewToWorld(camera, viewDx, viewDy, moved);
+    // dragging the content right moves the camera left
+    camera.center[0] -= moved[0] - origin[0];
+    camera.center[1] -= moved[1] - origin[1];
+}
+
+void CameraZoomAt(Camera2D& camera, double factor, double viewX, double viewY)
+{
+    double before[2], after[2];
+    CameraViewToWorld(camera, viewX, viewY, before);
+    camera.zoom = std::min(kMaxZoom, std::max(kMinZoom, camera.zoom * factor));
+    CameraViewToWorld(camera, viewX, viewY, after);
+    camera.center[0] += before[0] - after[0];
+    camera.center[1] += before[1] - after[1];
+}
+
+void CameraVisibleBounds(const Camera2D& camera, const float* viewScale, double* minOut, double* maxOut)
+{
+    // the window shows view x in [-1/scale.x, 1/scale.x], likewise y
+    double hx = viewScale[0] > 0.0f ? 1.0 / viewScale[0] : 1.0;
+    double hy = viewScale[1] > 0.0f ? 1.0 / viewScale[1] : 1.0;
+    const double corners[4][2] = { { -hx, -hy }, { hx, -hy }, { hx, hy }, { -hx, hy } };
+    for (int i = 0; i < 4; ++i)
+    {
+        double w[2];
+        CameraViewToWorld(camera, corners[i][0], corners[i][1], w);
+        for (int a = 0; a < 2; ++a)
+        {
+            minOut[a] = i == 0 ? w[a] : std::min(minOut[a], w[a]);
+            maxOut[a] = i == 0 ? w[a] : std::max(maxOut[a], w[a]);
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <glad/glad.h>
+
+// 2D camera over an unbounded world. World positions are doubles on the CPU; the GPU
+// only ever sees positions relative to the camera, computed in double and rounded to
+// float once, so content millions of units from the origin renders without jitter.
+//
+// Shaders read the camera from a std140 uniform block at kCameraBinding:
+//   layout(std140, binding = 0) uniform Camera { vec4 cameraTransform; vec2 cameraCenter; };
+// mat2(cameraTransform.xy, cameraTransform.zw) rotates and zooms a camera-relative
+// position into view space (the [-1,1] square, before the per-window aspect
+// correction). cameraCenter is the camera position rounded to float, only for content
+// that is already stored as float world coordinates (debug draw, instances).
+
+static const GLuint kCameraBinding = 0;
+
+struct Camera2D
+{
+    double center[2] = { 0.0, 0.0 };
+    double zoom = 1.0;      // view units per world unit
+    double rotation = 0.0;  // radians, counter-clockwise
+};
+
+// creates the uniform buffer with the identity camera and binds it
+bool CameraInit();
+void CameraShutdown();
+// uploads the camera and binds the block in the current context
+void CameraUpload(const Camera2D& camera);
+// binds the block in the current context (each context has its own binding points)
+void CameraBind();
+
+// world -> camera-relative in double, rounded to float at the end
+void CameraRelative(const Camera2D& camera, const double* world, float* out);
+// view-space point ([-1,1] before aspect correction) -> world
+void CameraViewToWorld(const Camera2D& camera, double viewX, double viewY, double* world);
+// moves the camera by a view-space delta, so a drag follows the cursor at any zoom/rotation
+void CameraPanView(Camera2D& camera, double viewDx, double viewDy);
+// multiplies the zoom, keeping the world point under the view-space anchor in place
+void CameraZoomAt(Camera2D& camera, double factor, double viewX, double viewY);
+// world-space bounding box of what a window with the given aspect correction shows
+void CameraVisibleBounds(const Camera2D& camera, const float* viewScale, double* minOut, double* maxOut);
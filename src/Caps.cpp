@@ -0,0 +1,187 @@
+#include "Caps.h"
+#include "Gfx.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#endif
+
+namespace
+{
+    GpuCaps gCaps;
+
+    std::string GlString(GLenum name)
+    {
+        const GLubyte* s = glGetString(name);
+        return s ? std::string((const char*)s) : std::string();
+    }
+
+    int GlInt(GLenum name)
+    {
+        GLint v = 0;
+        glGetIntegerv(name, &v);
+        return v;
+    }
+
+    struct LimitField
+    {
+        const char* key;
+        int GpuCaps::* field;
+    };
+
+    const LimitField kLimits[] = {
+        { "maxTextureSize", &GpuCaps::maxTextureSize },
+        { "maxUniformBlockSize", &GpuCaps::maxUniformBlockSize },
+        { "maxShaderStorageBlockSize", &GpuCaps::maxShaderStorageBlockSize },
+        { "maxShaderStorageBindings", &GpuCaps::maxShaderStorageBindings },
+        { "maxVertexStorageBlocks", &GpuCaps::maxVertexStorageBlocks },
+        { "maxFragmentStorageBlocks", &GpuCaps::maxFragmentStorageBlocks },
+        { "maxFragmentImageUniforms", &GpuCaps::maxFragmentImageUniforms },
+        { "maxComputeInvocations", &GpuCaps::maxComputeInvocations },
+        { "maxVertexAttribs", &GpuCaps::maxVertexAttribs },
+        { "maxSamples", &GpuCaps::maxSamples },
+        { "programBinaryFormats", &GpuCaps::programBinaryFormats },
+    };
+}
+
+std::string GpuCaps::DriverKey() const
+{
+    return vendor + " | " + renderer + " | " + version;
+}
+
+bool GpuCaps::HasExtension(const char* name) const
+{
+    return std::binary_search(extensions.begin(), extensions.end(), std::string(name));
+}
+
+bool LoadCapsCache(const char* path, GpuCaps& out)
+{
+    std::ifstream in(path);
+    if (!in)
+        return false;
+
+    // one key=value per line, extensions as repeated ext= lines
+    GpuCaps caps;
+    std::string line;
+    size_t limits = 0;
+    while (std::getline(in, line))
+    {
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        std::string key = line.substr(0, eq);
+        std::string value = line.substr(eq + 1);
+        if (key == "vendor") caps.vendor = value;
+        else if (key == "renderer") caps.renderer = value;
+        else if (key == "version") caps.version = value;
+        else if (key == "glsl") caps.glslVersion = value;
+        else if (key == "backend") caps.backend = value;
+        else if (key == "ext") caps.extensions.push_back(value);
+        else
+        {
+            for (const LimitField& f : kLimits)
+                if (key == f.key)
+                {
+                    caps.*(f.field) = atoi(value.c_str());
+                    ++limits;
+                }
+        }
+    }
+    // a cache written before a limit was added would read it as 0
+    if (caps.version.empty() || limits < sizeof(kLimits) / sizeof(kLimits[0]))
+        return false;
+    std::sort(caps.extensions.begin(), caps.extensions.end());
+    caps.fromCache = true;
+    out = caps;
+    return true;
+}
+
+bool SaveCapsCache(const char* path, const GpuCaps& caps)
+{
+    std::ofstream out(path, std::ios::trunc);
+    if (!out)
+        return false;
+    out << "vendor=" << caps.vendor << "\n"
+        << "renderer=" << caps.renderer << "\n"
+        << "version=" << caps.version << "\n"
+        << "glsl=" << caps.glslVersion << "\n"
+        << "backend=" << caps.backend << "\n";
+    for (const LimitField& f : kLimits)
+        out << f.key << "=" << caps.*(f.field) << "\n";
+    for (const std::string& e : caps.extensions)
+        out << "ext=" << e << "\n";
+    return (bool)out;
+}
+
+void ProbeCaps(const GpuCaps* cached, GpuCaps& out)
+{
+    GpuCaps caps;
+    caps.vendor = GlString(GL_VENDOR);
+    caps.renderer = GlString(GL_RENDERER);
+    caps.version = GlString(GL_VERSION);
+
+    if (cached && cached->DriverKey() == caps.DriverKey())
+    {
+        out = *cached;
+        out.fromCache = true;
+        gCaps = out;
+        return;
+    }
+
+    caps.glslVersion = GlString(GL_SHADING_LANGUAGE_VERSION);
+    // ES has no profiles to ask about
+    if (gGfxGles)
+        caps.backend = "gles31";
+    else
+    {
+        GLint profile = 0;
+        glGetIntegerv(GL_CONTEXT_PROFILE_MASK, &profile);
+        caps.backend = GLVersion.major * 10 + GLVersion.minor >= 43 && (profile & GL_CONTEXT_CORE_PROFILE_BIT)
+            ? "gl43core" : "gl43compat";
+    }
+    caps.maxTextureSize = GlInt(GL_MAX_TEXTURE_SIZE);
+    caps.maxUniformBlockSize = GlInt(GL_MAX_UNIFORM_BLOCK_SIZE);
+    caps.maxShaderStorageBlockSize = GlInt(GL_MAX_SHADER_STORAGE_BLOCK_SIZE);
+    caps.maxShaderStorageBindings = GlInt(GL_MAX_SHADER_STORAGE_BUFFER_BINDINGS);
+    caps.maxVertexStorageBlocks = GlInt(GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS);
+    caps.maxFragmentStorageBlocks = GlInt(GL_MAX_FRAGMENT_SHADER_STORAGE_BLOCKS);
+    caps.maxFragmentImageUniforms = GlInt(GL_MAX_FRAGMENT_IMAGE_UNIFORMS);
+    caps.maxComputeInvocations = GlInt(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS);
+    caps.maxVertexAttribs = GlInt(GL_MAX_VERTEX_ATTRIBS);
+    caps.maxSamples = GlInt(GL_MAX_SAMPLES);
+    caps.programBinaryFormats = GlInt(GL_NUM_PROGRAM_BINARY_FORMATS);
+
+    GLint count = GlInt(GL_NUM_EXTENSIONS);
+    caps.extensions.reserve(count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const GLubyte* e = glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (e) caps.extensions.push_back((const char*)e);
+    }
+    std::sort(caps.extensions.begin(), caps.extensions.end());
+
+    out = caps;
+    gCaps = caps;
+}
+
+const GpuCaps& GetGpuCaps()
+{
+    return gCaps;
+}
+
+bool EnsureDirectory(const char* path)
+{
+    struct stat st;
+    if (stat(path, &st) == 0)
+        return (st.st_mode & S_IFDIR) != 0;
+#ifdef _WIN32
+    return _mkdir(path) == 0;
+#else
+    return mkdir(path, 0755) == 0;
+#endif
+}
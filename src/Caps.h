@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// What the current GL driver supports. Probing walks every extension string and a
+// list of limits; the result is cached on disk keyed by the driver string
+// (vendor | renderer | version) so later launches on the same driver only query
+// those three strings.
+struct GpuCaps
+{
+    std::string vendor;
+    std::string renderer;
+    std::string version;
+    std::string glslVersion;
+    std::string backend;                // context flavour we run on, "gl43core", "gles31"
+    int maxTextureSize = 0;
+    int maxUniformBlockSize = 0;
+    int maxShaderStorageBlockSize = 0;
+    int maxShaderStorageBindings = 0;
+    // ES 3.1 may report 0 for these; the SSBO vertex and fragment paths check them
+    int maxVertexStorageBlocks = 0;
+    int maxFragmentStorageBlocks = 0;
+    int maxFragmentImageUniforms = 0;
+    int maxComputeInvocations = 0;
+    int maxVertexAttribs = 0;
+    int maxSamples = 0;
+    int programBinaryFormats = 0;       // 0 = program binaries cannot be cached
+    std::vector<std::string> extensions;
+    bool fromCache = false;
+
+    std::string DriverKey() const;
+    bool HasExtension(const char* name) const;
+};
+
+// file access only, safe to run on a background thread before the context exists
+bool LoadCapsCache(const char* path, GpuCaps& out);
+bool SaveCapsCache(const char* path, const GpuCaps& caps);
+
+// fills out for the current context, taking everything but the driver strings from
+// cached when its driver key matches
+void ProbeCaps(const GpuCaps* cached, GpuCaps& out);
+// result of the last ProbeCaps
+const GpuCaps& GetGpuCaps();
+
+// creates the directory (one level) if it does not exist
+bool EnsureDirectory(const char* path);
@@ -0,0 +1,234 @@
+#include "Capture.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+bool gCaptureActive = false;
+
+namespace
+{
+    struct CaptureState
+    {
+        FILE* file = nullptr;
+        std::vector<uint8_t> buffer;
+        std::unordered_set<GLuint> meshes;
+        GLuint boundVao = 0;
+        bool boundKnown = false;
+        std::chrono::steady_clock::time_point start;
+        uint64_t frames = 0;
+        bool failed = false;
+    } gCapture;
+
+    // flushed at frame boundaries once this much is pending
+    const size_t kFlushBytes = 1 << 20;
+
+    template <typename T>
+    void Put(const T& v)
+    {
+        const uint8_t* p = (const uint8_t*)&v;
+        gCapture.buffer.insert(gCapture.buffer.end(), p, p + sizeof(T));
+    }
+
+    void PutBytes(const void* data, uint32_t size)
+    {
+        Put(size);
+        const uint8_t* p = (const uint8_t*)data;
+        gCapture.buffer.insert(gCapture.buffer.end(), p, p + size);
+    }
+
+    void PutString(const char* s)
+    {
+        PutBytes(s, (uint32_t)strlen(s));
+    }
+
+    void Op(CaptureOp op)
+    {
+        gCapture.buffer.push_back((uint8_t)op);
+    }
+
+    void Flush()
+    {
+        if (gCapture.file && !gCapture.buffer.empty() &&
+            fwrite(gCapture.buffer.data(), 1, gCapture.buffer.size(), gCapture.file) != gCapture.buffer.size())
+        {
+            // the stream cannot be replayed past a gap, so stop recording
+            fprintf(stderr, "capture: write failed, recording stopped\n");
+            fclose(gCapture.file);
+            gCapture.file = nullptr;
+            gCapture.failed = true;
+            gCaptureActive = false;
+        }
+        gCapture.buffer.clear();
+    }
+}
+
+bool CaptureBegin(const char* path, int width, int height)
+{
+    if (gCapture.file)
+        CaptureEnd();
+
+    gCapture.file = fopen(path, "wb");
+    if (!gCapture.file)
+        return false;
+
+    gCapture.buffer.clear();
+    gCapture.buffer.reserve(kFlushBytes * 2);
+    gCapture.meshes.clear();
+    gCapture.boundVao = 0;
+    gCapture.boundKnown = false;
+    gCapture.frames = 0;
+    gCapture.failed = false;
+    gCapture.start = std::chrono::steady_clock::now();
+
+    const char magic[5] = { 'G', 'L', 'C', 'A', 'P' };
+    gCapture.buffer.insert(gCapture.buffer.end(), magic, magic + 5);
+    Put(kCaptureVersion);
+    Put((uint32_t)width);
+    Put((uint32_t)height);
+    gCaptureActive = true;
+    return true;
+}
+
+bool CaptureEnd()
+{
+    if (gCapture.file)
+    {
+        Op(CapEnd);
+        Flush();
+    }
+    if (gCapture.file && fclose(gCapture.file) != 0)
+        gCapture.failed = true;
+    gCapture.file = nullptr;
+    gCaptureActive = false;
+    bool ok = !gCapture.failed;
+    gCapture.failed = false;
+    return ok;
+}
+
+void CaptureCreateProgram(GLuint program, const char* vertexSrc, const char* fragmentSrc)
+{
+    Op(CapCreateProgram);
+    Put((uint32_t)program);
+    PutString(vertexSrc);
+    PutString(fragmentSrc);
+
+    // locations are driver-assigned, so store names and let the replay remap them
+    GLint count = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+    std::vector<std::pair<std::string, GLint>> uniforms;
+    for (GLint i = 0; i < count; ++i)
+    {
+        char name[256];
+        GLsizei len = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program, (GLuint)i, sizeof(name), &len, &size, &type, name);
+        GLint loc = glGetUniformLocation(program, name);
+        if (loc >= 0)
+            uniforms.emplace_back(std::string(name, len), loc);
+    }
+    Put((uint32_t)uniforms.size());
+    for (auto& u : uniforms)
+    {
+        PutString(u.first.c_str());
+        Put((int32_t)u.second);
+    }
+}
+
+void CaptureCreateMesh(GLuint vao, const float* data, size_t floatCount)
+{
+    gCapture.meshes.insert(vao);
+    Op(CapCreateMesh);
+    Put((uint32_t)vao);
+    PutBytes(data, (uint32_t)(floatCount * sizeof(float)));
+}
+
+void CaptureDestroyMesh(GLuint vao)
+{
+    if (!gCapture.meshes.erase(vao))
+        return;
+    Op(CapDestroyMesh);
+    Put((uint32_t)vao);
+}
+
+void CaptureClear(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+{
+    Op(CapClear);
+    Put(r);
+    Put(g);
+    Put(b);
+    Put(a);
+}
+
+void CaptureBlend(bool enabled, GLenum src, GLenum dst)
+{
+    Op(CapBlend);
+    Put((uint32_t)enabled);
+    Put((uint32_t)src);
+    Put((uint32_t)dst);
+}
+
+void CaptureUseProgram(GLuint program)
+{
+    Op(CapUseProgram);
+    Put((uint32_t)program);
+}
+
+void CaptureBindVertexArray(GLuint vao)
+{
+    gCapture.boundVao = vao;
+    gCapture.boundKnown = vao == 0 || gCapture.meshes.count(vao) != 0;
+    if (!gCapture.boundKnown)
+        return;
+    Op(CapBindVertexArray);
+    Put((uint32_t)vao);
+}
+
+void CaptureUniform1i(GLint location, GLint v)
+{
+    Op(CapUniform1i);
+    Put((int32_t)location);
+    Put((int32_t)v);
+}
+
+void CaptureUniform1f(GLint location, GLfloat v)
+{
+    Op(CapUniform1f);
+    Put((int32_t)location);
+    Put(v);
+}
+
+void CaptureUniform2f(GLint location, GLfloat x, GLfloat y)
+{
+    Op(CapUniform2f);
+    Put((int32_t)location);
+    Put(x);
+    Put(y);
+}
+
+void CaptureDraw(GLenum mode, GLint first, GLsizei count)
+{
+    // streamed overlay geometry is not part of the capture
+    if (!gCapture.boundKnown || gCapture.boundVao == 0)
+        return;
+    Op(CapDraw);
+    Put((uint32_t)mode);
+    Put((int32_t)first);
+    Put((int32_t)count);
+}
+
+void CaptureFrame(double appTime)
+{
+    Op(CapFrame);
+    Put(appTime);
+    uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - gCapture.start).count();
+    Put(ns);
+    gCapture.frames++;
+
+    if (gCapture.buffer.size() >= kFlushBytes)
+        Flush();
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+
+// Records the renderer's high-level command stream to a binary file so a session can be
+// replayed headless later (see Replay.h). Only resources created through CreateTriangle
+// and Shader are captured; draws from VAOs the capture does not know about (debug draw,
+// HUD) are dropped so a replay contains the scene workload only.
+//
+// File layout: "GLCAP" magic, u32 version, u32 width, u32 height, then a stream of records, each a u8 opcode
+// followed by its payload in little-endian order. Strings and blobs are u32 length + bytes.
+
+// version 2 added CapBlend; replay still reads version 1 streams, which have none
+static const uint32_t kCaptureVersion = 2;
+
+enum CaptureOp : uint8_t
+{
+    CapCreateProgram = 1,   // u32 id, str vs, str fs, u32 n, n x (str name, i32 location)
+    CapCreateMesh,          // u32 id, blob floats (pos2 + color3 interleaved)
+    CapDestroyMesh,         // u32 id
+    CapUseProgram,          // u32 id
+    CapBindVertexArray,     // u32 id (0 unbinds)
+    CapUniform1i,           // i32 location, i32 v
+    CapUniform1f,           // i32 location, f32 v
+    CapUniform2f,           // i32 location, f32 x, f32 y
+    CapDraw,                // u32 mode, i32 first, i32 count
+    CapFrame,               // f64 app time, u64 ns since capture start
+    CapClear,               // f32 r, g, b, a (color buffer only)
+    CapEnd,
+    CapBlend,               // u32 enabled, u32 src factor, u32 dst factor (GL enums)
+};
+
+// checked inline by the Gfx wrappers so an inactive capture costs one branch
+extern bool gCaptureActive;
+
+// width/height is the framebuffer size the stream was recorded at. A failed write
+// stops the recording; CaptureEnd then returns false and the file is incomplete.
+bool CaptureBegin(const char* path, int width, int height);
+bool CaptureEnd();
+
+void CaptureCreateProgram(GLuint program, const char* vertexSrc, const char* fragmentSrc);
+void CaptureCreateMesh(GLuint vao, const float* data, size_t floatCount);
+void CaptureDestroyMesh(GLuint vao);
+void CaptureClear(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+// blending state after a pipeline bind changed it; factors are ignored when disabled
+void CaptureBlend(bool enabled, GLenum src, GLenum dst);
+void CaptureUseProgram(GLuint program);
+void CaptureBindVertexArray(GLuint vao);
+void CaptureUniform1i(GLint location, GLint v);
+void CaptureUniform1f(GLint location, GLfloat v);
+void CaptureUniform2f(GLint location, GLfloat x, GLfloat y);
+void CaptureDraw(GLenum mode, GLint first, GLsizei count);
+// marks the end of a frame; appTime is the value the frame animated with
+void CaptureFrame(double appTime);
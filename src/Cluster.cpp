@@ -0,0 +1,517 @@
+#include "Cluster.h"
+#include "Benchmark.h"
+#include "DeferredDelete.h"
+#include "Gfx.h"
+#include "Net.h"
+#include "Process.h"
+#include "RenderTarget.h"
+#include "Scene.h"
+#include "Stats.h"
+#include "Window.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    enum ClusterMessage : uint32_t
+    {
+        MsgHello = 1,   // worker -> coordinator: u32 index
+        MsgScene,       // coordinator -> worker: serialized GeneratedScene
+        MsgTile,        // coordinator -> worker: TileDesc
+        MsgFrame,       // coordinator -> worker: FrameDesc
+        MsgPixels,      // worker -> coordinator: PixelsHeader + RGBA8 rows, bottom-up
+        MsgQuit,
+    };
+
+    struct TileDesc
+    {
+        int32_t x, y, width, height;    // in the full frame, origin bottom-left
+        int32_t frameWidth, frameHeight;
+    };
+
+    // the "scene delta" for one frame. Workers animate the scene they were sent from the
+    // time alone; spawns, despawns and parameter edits are not sent, so the scene is fixed
+    // for the session.
+    struct FrameDesc
+    {
+        uint32_t frame;
+        float time;
+    };
+
+    struct PixelsHeader
+    {
+        uint32_t frame;
+        float renderMs;                 // worker side draw + readback
+    };
+
+    const int kFramesInFlight = 2;
+    const size_t kMaxSceneBytes = (size_t)1 << 30;
+    const float kSimStep = 1.0f / 60.0f; // fixed animation step, every worker agrees on t
+
+    struct WorkerLink
+    {
+        NetSocket socket = kInvalidSocket;
+        ProcessHandle process = kInvalidProcess;
+        TileDesc tile;
+    };
+
+    struct ClusterStats
+    {
+        std::vector<double> frameMs;        // completion-to-completion on the coordinator
+        double workerRenderMs = 0.0;        // mean over all tiles
+        double compositeMs = 0.0;           // mean per frame
+        double seconds = 0.0;
+    };
+
+    // rows x cols as close to square as the worker count allows
+    std::vector<TileDesc> SplitFrame(int workers, int width, int height)
+    {
+        int rows = 1;
+        for (int r = 1; r * r <= workers; ++r)
+            if (workers % r == 0) rows = r;
+        int cols = workers / rows;
+
+        std::vector<TileDesc> tiles;
+        for (int r = 0; r < rows; ++r)
+            for (int c = 0; c < cols; ++c)
+            {
+                TileDesc t;
+                t.x = width * c / cols;
+                t.y = height * r / rows;
+                t.width = width * (c + 1) / cols - t.x;
+                t.height = height * (r + 1) / rows - t.y;
+                t.frameWidth = width;
+                t.frameHeight = height;
+                tiles.push_back(t);
+            }
+        return tiles;
+    }
+
+    std::string ListenAddress(const char* transport)
+    {
+        if (!strcmp(transport, "unix"))
+        {
+            char path[128];
+            snprintf(path, sizeof(path), "unix:/tmp/glcluster-%d.sock", CurrentProcessId());
+            return path;
+        }
+        return "tcp:127.0.0.1:0";
+    }
+
+    void ShutdownWorkers(std::vector<WorkerLink>& links)
+    {
+        // Close every socket before waiting: a worker may be blocked sending a frame in
+        // flight and never read the quit, the closed connection fails that send instead.
+        for (WorkerLink& w : links)
+        {
+            if (w.socket != kInvalidSocket)
+                NetSendMessage(w.socket, MsgQuit, nullptr, 0);
+            NetClose(w.socket);
+            w.socket = kInvalidSocket;
+        }
+        for (WorkerLink& w : links)
+            WaitProcess(w.process);
+        links.clear();
+    }
+
+    bool StartWorkers(int count, const char* transport, const std::string& sceneBytes, int width, int height,
+        std::vector<WorkerLink>& links)
+    {
+        std::string bound;
+        std::string address = ListenAddress(transport);
+        NetSocket listener = NetListen(address.c_str(), bound);
+        if (listener == kInvalidSocket)
+        {
+            fprintf(stderr, "cluster: cannot listen on %s\n", address.c_str());
+            return false;
+        }
+
+        std::vector<TileDesc> tiles = SplitFrame(count, width, height);
+        links.assign(count, WorkerLink());
+        std::vector<ProcessHandle> spawned;
+        for (int i = 0; i < count; ++i)
+        {
+            std::vector<std::string> args = { "--cluster-worker", bound, std::to_string(i) };
+            ProcessHandle p = SpawnSelf(args);
+            if (p == kInvalidProcess)
+            {
+                fprintf(stderr, "cluster: cannot start worker %d (%s)\n", i, ExecutablePath());
+                break;
+            }
+            spawned.push_back(p);
+        }
+
+        // workers connect in any order, the hello tells us which slot they belong to
+        bool ok = (int)spawned.size() == count;
+        for (int i = 0; ok && i < count; ++i)
+        {
+            NetSocket s = NetPoll(listener, 30000) ? NetAccept(listener) : kInvalidSocket;
+            uint32_t type = 0;
+            std::string payload;
+            ok = s != kInvalidSocket && NetRecvMessage(s, type, payload, sizeof(uint32_t)) && type == MsgHello
+                && payload.size() == sizeof(uint32_t);
+            uint32_t index = 0;
+            if (ok) memcpy(&index, payload.data(), sizeof(index));
+            ok = ok && index < (uint32_t)count && links[index].socket == kInvalidSocket;
+            if (!ok)
+            {
+                fprintf(stderr, "cluster: worker handshake failed\n");
+                NetClose(s);
+                break;
+            }
+            links[index].socket = s;
+            links[index].process = spawned[index];
+            links[index].tile = tiles[index];
+        }
+        NetClose(listener);
+        if (!strcmp(transport, "unix"))
+            remove(bound.c_str() + 5);
+
+        if (!ok)
+        {
+            // workers that never connected are still waited for, they exit on a failed connect
+            for (size_t i = 0; i < spawned.size(); ++i)
+                links[i].process = spawned[i];
+            ShutdownWorkers(links);
+            return false;
+        }
+
+        for (WorkerLink& w : links)
+        {
+            if (!NetSendMessage(w.socket, MsgScene, sceneBytes.data(), (uint32_t)sceneBytes.size())
+                || !NetSendMessage(w.socket, MsgTile, &w.tile, sizeof(w.tile)))
+            {
+                fprintf(stderr, "cluster: cannot send the scene to a worker\n");
+                ShutdownWorkers(links);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool SendFrame(std::vector<WorkerLink>& links, uint32_t frame)
+    {
+        FrameDesc desc = { frame, frame * kSimStep };
+        for (WorkerLink& w : links)
+        {
+            if (!NetSendMessage(w.socket, MsgFrame, &desc, sizeof(desc)))
+                return false;
+        }
+        return true;
+    }
+
+    // blocks until every worker delivered its tile of this frame and copies them into image
+    bool GatherFrame(std::vector<WorkerLink>& links, uint32_t frame, std::vector<uint8_t>& image,
+        ClusterStats& stats)
+    {
+        std::string payload;
+        double compositeMs = 0.0;
+        for (WorkerLink& w : links)
+        {
+            uint32_t type = 0;
+            const TileDesc& t = w.tile;
+            PixelsHeader header;
+            const size_t rowBytes = (size_t)t.width * 4;
+            if (!NetRecvMessage(w.socket, type, payload, sizeof(header) + rowBytes * t.height) || type != MsgPixels)
+                return false;
+
+            if (payload.size() != sizeof(header) + rowBytes * t.height)
+                return false;
+            memcpy(&header, payload.data(), sizeof(header));
+            if (header.frame != frame)
+                return false;
+            stats.workerRenderMs += header.renderMs;
+
+            Clock::time_point start = Clock::now();
+            const size_t frameRowBytes = (size_t)t.frameWidth * 4;
+            const char* src = payload.data() + sizeof(header);
+            for (int y = 0; y < t.height; ++y)
+                memcpy(&image[(size_t)(t.y + y) * frameRowBytes + (size_t)t.x * 4], src + y * rowBytes, rowBytes);
+            compositeMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+        stats.compositeMs += compositeMs;
+        return true;
+    }
+
+    // The tile's view of the full frame without a frame-sized viewport, which a video
+    // wall can make larger than GL_MAX_VIEWPORT_DIMS: the camera is centered on the tile
+    // and the view scale stretches the full frame's aspect correction to the tile.
+    void TileCamera(const TileDesc& t, SceneProgram& program, Camera2D& camera)
+    {
+        float frameScale[2];
+        ComputeViewScale(t.frameWidth, t.frameHeight, frameScale);
+        program.viewScale[0] = frameScale[0] * (float)t.frameWidth / (float)t.width;
+        program.viewScale[1] = frameScale[1] * (float)t.frameHeight / (float)t.height;
+        // tile center in the full frame's NDC, back to view space
+        double ndcX = (2.0 * t.x + t.width) / t.frameWidth - 1.0;
+        double ndcY = (2.0 * t.y + t.height) / t.frameHeight - 1.0;
+        CameraViewToWorld(Camera2D(), ndcX / frameScale[0], ndcY / frameScale[1], camera.center);
+    }
+
+    bool WritePpm(const char* path, const std::vector<uint8_t>& image, int width, int height)
+    {
+        FILE* f = fopen(path, "wb");
+        if (!f) return false;
+        fprintf(f, "P6\n%d %d\n255\n", width, height);
+        std::vector<uint8_t> row((size_t)width * 3);
+        for (int y = height - 1; y >= 0; --y) // GL rows are bottom-up
+        {
+            const uint8_t* src = &image[(size_t)y * width * 4];
+            for (int x = 0; x < width; ++x)
+            {
+                row[x * 3 + 0] = src[x * 4 + 0];
+                row[x * 3 + 1] = src[x * 4 + 1];
+                row[x * 3 + 2] = src[x * 4 + 2];
+            }
+            fwrite(row.data(), 1, row.size(), f);
+        }
+        return fclose(f) == 0;
+    }
+
+    // drives one session; frames < 0 runs until the display window is closed
+    bool RunSession(const ClusterOptions& options, const std::string& sceneBytes, ClusterStats& stats)
+    {
+        const char* transport = options.transport ? options.transport : NetDefaultLocalTransport();
+        std::vector<WorkerLink> links;
+        if (!StartWorkers(std::max(1, options.workers), transport, sceneBytes, options.width, options.height, links))
+            return false;
+
+        std::vector<uint8_t> image((size_t)options.width * options.height * 4);
+        RenderTarget* target = nullptr;
+        if (options.display)
+        {
+            if (!CreateWindow(options.width, options.height, "Graphics 1 - cluster"))
+            {
+                ShutdownWorkers(links);
+                return false;
+            }
+            SetSwapInterval(0);
+            target = AcquireRenderTarget(options.width, options.height);
+        }
+
+        const int frames = options.display ? -1 : std::max(1, options.frames);
+        uint32_t sent = 0;
+        uint32_t done = 0;
+        bool ok = true;
+        Clock::time_point start = Clock::now();
+        Clock::time_point last = start;
+        while (ok)
+        {
+            bool more = frames < 0 ? !WindowShouldClose() : (int)sent < frames;
+            while (more && sent - done < (uint32_t)kFramesInFlight && ok)
+            {
+                ok = SendFrame(links, sent++);
+                more = frames < 0 || (int)sent < frames;
+            }
+            if (!ok || done == sent)
+                break;
+
+            ok = GatherFrame(links, done++, image, stats);
+            Clock::time_point now = Clock::now();
+            stats.frameMs.push_back(std::chrono::duration<double, std::milli>(now - last).count());
+            last = now;
+
+            if (ok && target)
+            {
+                glBindTexture(GL_TEXTURE_2D, target->color);
+                glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, options.width, options.height, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+                glBindTexture(GL_TEXTURE_2D, 0);
+                int fbW = 0, fbH = 0;
+                GetFramebufferSize(fbW, fbH);
+                BlitToBackbuffer(*target, fbW, fbH);
+                Loop();
+            }
+        }
+        stats.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        if (!ok)
+            fprintf(stderr, "cluster: lost a worker at frame %u\n", done);
+
+        if (options.dumpPath && done > 0 && !WritePpm(options.dumpPath, image, options.width, options.height))
+            fprintf(stderr, "cluster: cannot write %s\n", options.dumpPath);
+
+        ShutdownWorkers(links);
+        if (target)
+        {
+            ReleaseRenderTarget(target);
+            RenderTargetPoolShutdown();
+            DestroyWindow();
+        }
+        if (!stats.frameMs.empty())
+        {
+            stats.workerRenderMs /= (double)stats.frameMs.size() * std::max(1, options.workers);
+            stats.compositeMs /= (double)stats.frameMs.size();
+        }
+        return ok;
+    }
+
+}
+
+int RunClusterCoordinator(const ClusterOptions& options, const GeneratedScene& scene)
+{
+    if (!NetInit())
+        return -1;
+    std::string sceneBytes;
+    SerializeScene(scene, sceneBytes);
+
+    ClusterStats stats;
+    bool ok = RunSession(options, sceneBytes, stats);
+    if (!stats.frameMs.empty())
+    {
+        printf("cluster %d worker%s %dx%d: %zu frames, %.1f fps, median %.3f ms, worker render %.3f ms, composite %.3f ms\n",
+            options.workers, options.workers == 1 ? "" : "s", options.width, options.height, stats.frameMs.size(),
+            stats.frameMs.size() / std::max(1e-9, stats.seconds), Median(stats.frameMs), stats.workerRenderMs,
+            stats.compositeMs);
+    }
+    NetShutdown();
+    return ok ? 0 : -1;
+}
+
+int RunClusterBenchmark(const ClusterOptions& options, const GeneratedScene& scene, int maxWorkers,
+    const char* outputPath)
+{
+    if (!NetInit())
+        return -1;
+    std::string sceneBytes;
+    SerializeScene(scene, sceneBytes);
+
+    printf("cluster scaling, %zu objects at %dx%d, %d frames per run\n", scene.objects.size(),
+        options.width, options.height, options.frames);
+    printf("%8s %10s %12s %10s %12s %12s\n", "workers", "fps", "median ms", "speedup", "efficiency", "worker ms");
+
+    std::vector<BenchCase> cases;
+    double baseFps = 0.0;
+    bool ok = true;
+    for (int n = 1; n <= std::max(1, maxWorkers) && ok; ++n)
+    {
+        ClusterOptions run = options;
+        run.workers = n;
+        run.display = false;
+        run.dumpPath = nullptr;
+        ClusterStats stats;
+        ok = RunSession(run, sceneBytes, stats);
+        if (!ok || stats.frameMs.empty())
+            break;
+
+        // the first frames include worker warm-up (shader compile, first upload)
+        std::vector<double> steady(stats.frameMs.begin() + std::min<size_t>(stats.frameMs.size() - 1, kFramesInFlight * 2),
+            stats.frameMs.end());
+        double fps = stats.frameMs.size() / std::max(1e-9, stats.seconds);
+        if (n == 1) baseFps = fps;
+        double speedup = baseFps > 0.0 ? fps / baseFps : 0.0;
+        printf("%8d %10.1f %12.3f %9.2fx %11.0f%% %12.3f\n", n, fps, Median(steady), speedup,
+            100.0 * speedup / n, stats.workerRenderMs);
+
+        BenchCase c;
+        c.name = "cluster_w" + std::to_string(n);
+        c.unit = "ms";
+        c.samples = steady;
+        cases.push_back(c);
+    }
+    if (ok && outputPath && !WriteBenchJson(outputPath, cases))
+        fprintf(stderr, "cluster: cannot write %s\n", outputPath);
+
+    NetShutdown();
+    return ok ? 0 : -1;
+}
+
+int RunClusterWorker(const char* address, int index)
+{
+    if (!NetInit())
+        return -1;
+    NetSocket s = NetConnect(address);
+    uint32_t hello = (uint32_t)index;
+    if (s == kInvalidSocket || !NetSendMessage(s, MsgHello, &hello, sizeof(hello)))
+    {
+        fprintf(stderr, "cluster worker %d: cannot connect to %s\n", index, address);
+        NetClose(s);
+        NetShutdown();
+        return -1;
+    }
+
+    GeneratedScene generated;
+    TileDesc tile = {};
+    uint32_t type = 0;
+    std::string payload;
+    bool ok = NetRecvMessage(s, type, payload, kMaxSceneBytes) && type == MsgScene
+        && DeserializeScene(payload.data(), payload.size(), generated)
+        && NetRecvMessage(s, type, payload, sizeof(TileDesc)) && type == MsgTile && payload.size() == sizeof(tile);
+    if (ok) memcpy(&tile, payload.data(), sizeof(tile));
+    if (!ok || tile.width <= 0 || tile.height <= 0)
+    {
+        fprintf(stderr, "cluster worker %d: bad setup from coordinator\n", index);
+        NetClose(s);
+        NetShutdown();
+        return -1;
+    }
+
+    // the window only provides the context, the tile is rendered into an FBO
+    if (!CreateWindow(std::min(tile.width, 256), std::min(tile.height, 256), "Graphics 1 - cluster worker", false))
+    {
+        NetClose(s);
+        NetShutdown();
+        return -1;
+    }
+    SetSwapInterval(0);
+
+    SceneProgram program;
+    Scene scene;
+    std::string err;
+    RenderTarget* target = nullptr;
+    // tiles always show the default camera, cut to the tile
+    CameraInit();
+    Camera2D camera;
+    ok = CreateSceneProgram(program, err);
+    if (ok)
+    {
+        InstantiateScene(generated, scene);
+        generated.objects.clear();
+        TileCamera(tile, program, camera);
+        CameraUpload(camera);
+        target = AcquireRenderTarget(tile.width, tile.height);
+        ok = target != nullptr;
+    }
+    const bool setupOk = ok;
+    if (!ok)
+        fprintf(stderr, "cluster worker %d: GL setup failed %s\n", index, err.c_str());
+
+    const size_t pixelBytes = (size_t)tile.width * tile.height * 4;
+    std::string reply(sizeof(PixelsHeader) + pixelBytes, '\0');
+    while (ok && NetRecvMessage(s, type, payload, sizeof(FrameDesc)) && type == MsgFrame && payload.size() == sizeof(FrameDesc))
+    {
+        FrameDesc desc;
+        memcpy(&desc, payload.data(), sizeof(desc));
+
+        Clock::time_point start = Clock::now();
+        glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+        glViewport(0, 0, tile.width, tile.height);
+        GfxClear(239.0f / 255.0f, 136.0f / 255.0f, 190.0f / 255.0f, 1.0f);
+        DrawScene(scene, program, desc.time, camera);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, tile.width, tile.height, GL_RGBA, GL_UNSIGNED_BYTE, &reply[sizeof(PixelsHeader)]);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        PixelsHeader header = { desc.frame, std::chrono::duration<float, std::milli>(Clock::now() - start).count() };
+        memcpy(&reply[0], &header, sizeof(header));
+        ok = NetSendMessage(s, MsgPixels, reply.data(), (uint32_t)reply.size());
+    }
+
+    if (target) ReleaseRenderTarget(target);
+    RenderTargetPoolShutdown();
+    DestroyScene(scene);
+    DestroySceneProgram(program);
+    CameraShutdown();
+    DeferredDeleteFlush();
+    DestroyWindow();
+    NetClose(s);
+    NetShutdown();
+    // the loop ends when the coordinator quits or hangs up, both are a normal exit
+    return setupOk ? 0 : -1;
+}
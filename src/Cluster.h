@@ -0,0 +1,33 @@
+#pragma once
+#include "SceneGen.h"
+
+// Sort-first rendering across local worker processes. The coordinator splits the frame
+// into one screen tile per worker, sends the scene once and then one small frame
+// message (frame number + animation time) per frame; every worker renders its tile
+// headless and returns the pixels. A frame is only composited once all tiles of that
+// frame arrived (frame lock), with up to two frames in flight so workers render the
+// next frame while the coordinator composites.
+//
+// Transport is unix domain sockets where available and loopback TCP otherwise.
+
+struct ClusterOptions
+{
+    int workers = 2;
+    int width = 1280;
+    int height = 720;
+    int frames = 300;               // headless runs only
+    bool display = false;           // show the composite in a window until it is closed
+    const char* transport = nullptr; // "unix" or "tcp", nullptr = platform default
+    const char* dumpPath = nullptr; // write the last composited frame as a PPM
+};
+
+// spawns the workers and drives them; returns a process exit code
+int RunClusterCoordinator(const ClusterOptions& options, const GeneratedScene& scene);
+
+// entry point of a worker process started by the coordinator
+int RunClusterWorker(const char* address, int index);
+
+// runs the coordinator headless for 1..maxWorkers workers and prints throughput and
+// speedup per worker count; writes BenchCase JSON when outputPath is set
+int RunClusterBenchmark(const ClusterOptions& options, const GeneratedScene& scene, int maxWorkers,
+    const char* outputPath);
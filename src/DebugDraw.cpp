@@ -0,0 +1,362 @@
+#include "DebugDraw.h"
+#include "Gfx.h"
+#include "Pipeline.h"
+#include "VertexFormat.h"
+#include "Warmup.h"
+#include "Shader.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    struct DebugVertex
+    {
+        float x, y;
+        uint32_t color;
+    };
+
+    struct DebugThreadBuffer
+    {
+        std::mutex mutex;               // producer appends vs the flush swapping them out
+        std::vector<DebugVertex> lines;
+        std::vector<DebugVertex> tris;
+        bool exited = false;            // owner thread is gone, freed by the next flush
+    };
+
+    // positions are float world coordinates seen through the camera, color is normalized from bytes
+    const char* debugVertexSrc = R"(
+#version 430 core
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec4 aColor;
+uniform vec2 viewScale;
+layout(std140, binding = 0) uniform Camera { vec4 cameraTransform; vec2 cameraCenter; };
+out vec4 vColor;
+void main()
+{
+    vec2 view = mat2(cameraTransform.xy, cameraTransform.zw) * (aPos - cameraCenter);
+    gl_Position = vec4(view * viewScale, 0.0, 1.0);
+    vColor = aColor;
+}
+)";
+
+    const char* debugFragmentSrc = R"(
+#version 430 core
+in vec4 vColor;
+out vec4 FragColor;
+void main()
+{
+    FragColor = vColor;
+}
+)";
+
+    struct DebugDrawState
+    {
+        Shader shader;
+        PipelineId pipeline = 0;
+        GLint locViewScale = -1;
+        float viewScale[2] = { 1.0f, 1.0f };
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        size_t vboCapacity = 0; // in vertices
+        uint32_t lastPrimitives = 0;
+
+        // buffers are owned here so what a thread queued outlives it until the next flush
+        std::mutex registryMutex;
+        std::vector<std::unique_ptr<DebugThreadBuffer>> buffers;
+        // what the flush swapped out, one pair per buffer; their capacity goes back
+        // to the producers on the next swap
+        std::vector<std::vector<DebugVertex>> drainedLines;
+        std::vector<std::vector<DebugVertex>> drainedTris;
+    } gDebug;
+
+    std::atomic<bool> gDebugEnabled(true);
+
+    // marks the thread's buffer for release when the thread exits
+    struct ThreadBufferOwner
+    {
+        DebugThreadBuffer* buffer = nullptr;
+        ~ThreadBufferOwner()
+        {
+            if (!buffer) return;
+            std::lock_guard<std::mutex> lock(gDebug.registryMutex);
+            buffer->exited = true;
+        }
+    };
+    thread_local ThreadBufferOwner tBuffer;
+
+    DebugThreadBuffer& ThreadBuffer()
+    {
+        if (!tBuffer.buffer)
+        {
+            // only taken once per thread
+            std::lock_guard<std::mutex> lock(gDebug.registryMutex);
+            gDebug.buffers.emplace_back(new DebugThreadBuffer());
+            tBuffer.buffer = gDebug.buffers.back().get();
+            tBuffer.buffer->lines.reserve(4096);
+            tBuffer.buffer->tris.reserve(4096);
+        }
+        return *tBuffer.buffer;
+    }
+
+    // drops the buffers of threads that have exited; registryMutex must be held
+    void ReleaseExitedBuffers()
+    {
+        auto& buffers = gDebug.buffers;
+        buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+            [](const std::unique_ptr<DebugThreadBuffer>& b) { return b->exited; }), buffers.end());
+    }
+
+    inline void PushLine(DebugThreadBuffer& b, float x0, float y0, float x1, float y1, uint32_t color)
+    {
+        b.lines.push_back({ x0, y0, color });
+        b.lines.push_back({ x1, y1, color });
+    }
+
+    inline void PushTri(DebugThreadBuffer& b, float x0, float y0, float x1, float y1, float x2, float y2, uint32_t color)
+    {
+        b.tris.push_back({ x0, y0, color });
+        b.tris.push_back({ x1, y1, color });
+        b.tris.push_back({ x2, y2, color });
+    }
+}
+
+uint32_t DebugColor(float r, float g, float b, float a)
+{
+    auto toByte = [](float v) -> uint32_t {
+        v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+        return (uint32_t)(v * 255.0f + 0.5f);
+    };
+    return toByte(r) | (toByte(g) << 8) | (toByte(b) << 16) | (toByte(a) << 24);
+}
+
+bool DebugDrawInit(std::string& errorOut)
+{
+    if (!gDebug.shader.CreateFromSource(debugVertexSrc, debugFragmentSrc, errorOut))
+        return false;
+    gDebug.locViewScale = glGetUniformLocation(gDebug.shader.GetID(), "viewScale");
+
+    glGenVertexArrays(1, &gDebug.vao);
+    glGenBuffers(1, &gDebug.vbo);
+
+    glBindVertexArray(gDebug.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, gDebug.vbo);
+
+    // vec2 position + vec4 color packed as RGBA8
+    ApplyVertexFormat(PackedColorVertexFormat());
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    PipelineDesc desc;
+    desc.program = gDebug.shader.GetID();
+    desc.format = PackedColorVertexFormat();
+    desc.blend = BlendAlpha;
+    gDebug.pipeline = CreatePipeline(desc);
+    WarmupRegister("debug tris", gDebug.pipeline, GL_TRIANGLES);
+    WarmupRegister("debug lines", gDebug.pipeline, GL_LINES);
+    return true;
+}
+
+void DebugDrawShutdown()
+{
+    if (gDebug.vbo) { glDeleteBuffers(1, &gDebug.vbo); gDebug.vbo = 0; }
+    if (gDebug.vao) { glDeleteVertexArrays(1, &gDebug.vao); gDebug.vao = 0; }
+    ProfilerTrackGpuBytes(-(int64_t)(gDebug.vboCapacity * sizeof(DebugVertex)));
+    gDebug.vboCapacity = 0;
+    WarmupUnregister(gDebug.pipeline);
+    DestroyPipeline(gDebug.pipeline);
+    gDebug.pipeline = 0;
+    gDebug.shader.Destroy();
+
+    std::lock_guard<std::mutex> lock(gDebug.registryMutex);
+    for (auto& b : gDebug.buffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(b->mutex);
+        b->lines.clear();
+        b->tris.clear();
+    }
+    ReleaseExitedBuffers();
+    gDebug.drainedLines.clear();
+    gDebug.drainedTris.clear();
+}
+
+void DebugDrawSetViewScale(float x, float y)
+{
+    gDebug.viewScale[0] = x;
+    gDebug.viewScale[1] = y;
+}
+
+void DebugDrawSetEnabled(bool enabled)
+{
+    gDebugEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool DebugDrawIsEnabled()
+{
+    return gDebugEnabled.load(std::memory_order_relaxed);
+}
+
+void DebugLine(float x0, float y0, float x1, float y1, uint32_t color)
+{
+    if (!DebugDrawIsEnabled()) return;
+    DebugThreadBuffer& b = ThreadBuffer();
+    std::lock_guard<std::mutex> lock(b.mutex);
+    PushLine(b, x0, y0, x1, y1, color);
+}
+
+void DebugRect(float minX, float minY, float maxX, float maxY, uint32_t color, bool filled)
+{
+    if (!DebugDrawIsEnabled()) return;
+    DebugThreadBuffer& b = ThreadBuffer();
+    std::lock_guard<std::mutex> lock(b.mutex);
+    if (filled)
+    {
+        PushTri(b, minX, minY, maxX, minY, maxX, maxY, color);
+        PushTri(b, minX, minY, maxX, maxY, minX, maxY, color);
+        return;
+    }
+    PushLine(b, minX, minY, maxX, minY, color);
+    PushLine(b, maxX, minY, maxX, maxY, color);
+    PushLine(b, maxX, maxY, minX, maxY, color);
+    PushLine(b, minX, maxY, minX, minY, color);
+}
+
+void DebugCircle(float cx, float cy, float radius, uint32_t color, int segments)
+{
+    if (!DebugDrawIsEnabled()) return;
+    if (segments < 3) segments = 3;
+    DebugThreadBuffer& b = ThreadBuffer();
+    std::lock_guard<std::mutex> lock(b.mutex);
+
+    // rotate the first point incrementally instead of calling sin/cos per segment
+    const float step = 6.2831853f / (float)segments;
+    const float cs = cosf(step);
+    const float sn = sinf(step);
+    float px = radius, py = 0.0f;
+    for (int i = 0; i < segments; ++i)
+    {
+        float nx = cs * px - sn * py;
+        float ny = sn * px + cs * py;
+        PushLine(b, cx + px, cy + py, cx + nx, cy + ny, color);
+        px = nx;
+        py = ny;
+    }
+}
+
+void DebugArrow(float x0, float y0, float x1, float y1, uint32_t color, float headSize)
+{
+    if (!DebugDrawIsEnabled()) return;
+    DebugThreadBuffer& b = ThreadBuffer();
+    std::lock_guard<std::mutex> lock(b.mutex);
+    PushLine(b, x0, y0, x1, y1, color);
+
+    float dx = x1 - x0;
+    float dy = y1 - y0;
+    float len = sqrtf(dx * dx + dy * dy);
+    if (len <= 0.0f) return;
+    dx /= len;
+    dy /= len;
+
+    // head is a filled triangle pointing along the shaft
+    float bx = x1 - dx * headSize;
+    float by = y1 - dy * headSize;
+    float hw = headSize * 0.5f;
+    PushTri(b, x1, y1, bx - dy * hw, by + dx * hw, bx + dy * hw, by - dx * hw, color);
+}
+
+void DebugMarker(float x, float y, float size, uint32_t color)
+{
+    if (!DebugDrawIsEnabled()) return;
+    DebugThreadBuffer& b = ThreadBuffer();
+    std::lock_guard<std::mutex> lock(b.mutex);
+    float h = size * 0.5f;
+    PushTri(b, x, y + h, x - h, y, x + h, y, color);
+    PushTri(b, x, y - h, x + h, y, x - h, y, color);
+    PushLine(b, x - size, y, x + size, y, color);
+    PushLine(b, x, y - size, x, y + size, color);
+}
+
+void DebugDrawFlush()
+{
+    // registering threads wait for the swap; producers only wait for their own buffer
+    std::vector<std::vector<DebugVertex>>& lines = gDebug.drainedLines;
+    std::vector<std::vector<DebugVertex>>& tris = gDebug.drainedTris;
+    size_t lineVerts = 0;
+    size_t triVerts = 0;
+    {
+        std::lock_guard<std::mutex> lock(gDebug.registryMutex);
+        lines.resize(gDebug.buffers.size());
+        tris.resize(gDebug.buffers.size());
+        for (size_t i = 0; i < gDebug.buffers.size(); ++i)
+        {
+            DebugThreadBuffer& b = *gDebug.buffers[i];
+            lines[i].clear();
+            tris[i].clear();
+            std::lock_guard<std::mutex> bufferLock(b.mutex);
+            lines[i].swap(b.lines);
+            tris[i].swap(b.tris);
+            lineVerts += lines[i].size();
+            triVerts += tris[i].size();
+        }
+        // their last primitives were just swapped out
+        ReleaseExitedBuffers();
+    }
+
+    gDebug.lastPrimitives = (uint32_t)(lineVerts / 2 + triVerts / 3);
+    if (!gDebug.vao || lineVerts + triVerts == 0 || !DebugDrawIsEnabled())
+        return;
+
+    const size_t total = lineVerts + triVerts;
+    glBindBuffer(GL_ARRAY_BUFFER, gDebug.vbo);
+    if (total > gDebug.vboCapacity)
+    {
+        // grow geometrically so a steady workload stops reallocating after a few frames
+        size_t cap = gDebug.vboCapacity ? gDebug.vboCapacity : 16384;
+        while (cap < total) cap *= 2;
+        ProfilerTrackGpuBytes((int64_t)((cap - gDebug.vboCapacity) * sizeof(DebugVertex)));
+        gDebug.vboCapacity = cap;
+    }
+    // orphan the previous contents so we never wait on last frame's draw
+    glBufferData(GL_ARRAY_BUFFER, gDebug.vboCapacity * sizeof(DebugVertex), nullptr, GL_STREAM_DRAW);
+
+    // triangles first, lines after, both copied straight into the mapped range
+    DebugVertex* dst = (DebugVertex*)glMapBufferRange(GL_ARRAY_BUFFER, 0, total * sizeof(DebugVertex),
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+    if (dst)
+    {
+        DebugVertex* triDst = dst;
+        DebugVertex* lineDst = dst + triVerts;
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            if (!tris[i].empty())
+            {
+                memcpy(triDst, tris[i].data(), tris[i].size() * sizeof(DebugVertex));
+                triDst += tris[i].size();
+            }
+            if (!lines[i].empty())
+            {
+                memcpy(lineDst, lines[i].data(), lines[i].size() * sizeof(DebugVertex));
+                lineDst += lines[i].size();
+            }
+        }
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+
+        BindPipeline(gDebug.pipeline);
+        GfxUniform2f(gDebug.locViewScale, gDebug.viewScale[0], gDebug.viewScale[1]);
+        GfxBindVertexArray(gDebug.vao);
+        if (triVerts) GfxDrawArrays(GL_TRIANGLES, 0, (GLsizei)triVerts);
+        if (lineVerts) GfxDrawArrays(GL_LINES, (GLint)triVerts, (GLsizei)lineVerts);
+        GfxBindVertexArray(0);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+uint32_t DebugDrawLastPrimitiveCount()
+{
+    return gDebug.lastPrimitives;
+}
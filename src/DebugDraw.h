@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Immediate-mode debug drawing in world coordinates, transformed by the camera block
+// (see Camera.h); with the default camera these are NDC.
+// Any thread may call the Debug* functions at any time; primitives are appended to a
+// buffer owned by the calling thread, under a lock only DebugDrawFlush() competes for.
+// DebugDrawFlush() runs on the GL thread and swaps every buffer out under its lock, so
+// a primitive lands in the flush that follows it; it uploads everything and issues at
+// most two draws (triangles + lines). A thread's buffer is freed after it exits.
+
+
+// pack a color as 0xAABBGGRR (matches GL_UNSIGNED_BYTE x4 attribute order)
+uint32_t DebugColor(float r, float g, float b, float a = 1.0f);
+
+bool DebugDrawInit(std::string& errorOut);
+void DebugDrawShutdown();
+
+// aspect correction matching the scene's (see ComputeViewScale)
+void DebugDrawSetViewScale(float x, float y);
+
+// when disabled the Debug* calls return immediately and flush draws nothing
+void DebugDrawSetEnabled(bool enabled);
+bool DebugDrawIsEnabled();
+
+void DebugLine(float x0, float y0, float x1, float y1, uint32_t color);
+void DebugRect(float minX, float minY, float maxX, float maxY, uint32_t color, bool filled = false);
+void DebugCircle(float cx, float cy, float radius, uint32_t color, int segments = 24);
+void DebugArrow(float x0, float y0, float x1, float y1, uint32_t color, float headSize = 0.04f);
+// cross with arms of half-length size through a filled diamond half that size
+void DebugMarker(float x, float y, float size, uint32_t color);
+
+// upload and draw all primitives queued since the last flush, then reset the buffers
+void DebugDrawFlush();
+
+// number of primitives submitted in the last flush (lines + triangles)
+uint32_t DebugDrawLastPrimitiveCount();
@@ -0,0 +1,100 @@
+#include "DeferredDelete.h"
+#include <deque>
+#include <vector>
+
+namespace
+{
+    struct DeferredObject
+    {
+        DeferredKind kind;
+        GLuint name;
+    };
+
+    struct DeferredBatch
+    {
+        GLsync fence = nullptr;
+        std::vector<DeferredObject> objects;
+    };
+
+    struct DeferredDeleteState
+    {
+        std::vector<DeferredObject> current;    // queued this frame, not fenced yet
+        std::deque<DeferredBatch> inFlight;     // oldest first
+        unsigned pending = 0;
+        unsigned long long deleted = 0;
+    } gDeferred;
+
+    void DeleteObjects(const std::vector<DeferredObject>& objects)
+    {
+        for (const DeferredObject& o : objects)
+        {
+            switch (o.kind)
+            {
+            case DeferBuffer: glDeleteBuffers(1, &o.name); break;
+            case DeferVertexArray: glDeleteVertexArrays(1, &o.name); break;
+            case DeferTexture: glDeleteTextures(1, &o.name); break;
+            case DeferFramebuffer: glDeleteFramebuffers(1, &o.name); break;
+            }
+        }
+        gDeferred.pending -= (unsigned)objects.size();
+        gDeferred.deleted += objects.size();
+    }
+}
+
+void DeferDelete(DeferredKind kind, GLuint name)
+{
+    if (!name)
+        return;
+    gDeferred.current.push_back({ kind, name });
+    gDeferred.pending++;
+}
+
+void DeferredDeleteEndFrame()
+{
+    if (!gDeferred.current.empty())
+    {
+        DeferredBatch batch;
+        batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        batch.objects.swap(gDeferred.current);
+        gDeferred.inFlight.push_back(std::move(batch));
+    }
+
+    // fences signal in order, so stop at the first one that has not
+    while (!gDeferred.inFlight.empty())
+    {
+        DeferredBatch& b = gDeferred.inFlight.front();
+        if (b.fence)
+        {
+            GLenum status = glClientWaitSync(b.fence, 0, 0);
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                break;
+            glDeleteSync(b.fence);
+        }
+        DeleteObjects(b.objects);
+        gDeferred.inFlight.pop_front();
+    }
+}
+
+void DeferredDeleteFlush()
+{
+    if (gDeferred.pending == 0)
+        return;
+    glFinish();
+    for (DeferredBatch& b : gDeferred.inFlight)
+    {
+        if (b.fence) glDeleteSync(b.fence);
+        DeleteObjects(b.objects);
+    }
+    gDeferred.inFlight.clear();
+    DeleteObjects(gDeferred.current);
+    gDeferred.current.clear();
+}
+
+DeferredDeleteStats GetDeferredDeleteStats()
+{
+    DeferredDeleteStats s;
+    s.pending = gDeferred.pending;
+    s.batches = (unsigned)gDeferred.inFlight.size() + (gDeferred.current.empty() ? 0u : 1u);
+    s.deleted = gDeferred.deleted;
+    return s;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <glad/glad.h>
+
+// GL objects released while earlier frames may still be in flight on the GPU. Deletes
+// queued during a frame are fenced at DeferredDeleteEndFrame() and carried out once
+// that fence has signaled, so a resource is never pulled from under a queued draw and
+// the driver never has to stall to orphan it. All calls on the GL thread, with the
+// context that owns the objects current (VAOs are per context: queue only the
+// primary's here).
+
+enum DeferredKind
+{
+    DeferBuffer = 0,
+    DeferVertexArray,
+    DeferTexture,
+    DeferFramebuffer,
+};
+
+struct DeferredDeleteStats
+{
+    unsigned pending = 0;       // objects waiting on a fence
+    unsigned batches = 0;       // frames with pending objects
+    unsigned long long deleted = 0;
+};
+
+void DeferDelete(DeferredKind kind, GLuint name);
+// fences this frame's deletes and performs those whose frames have completed
+void DeferredDeleteEndFrame();
+// waits for the GPU and deletes everything queued; call before destroying the context
+void DeferredDeleteFlush();
+DeferredDeleteStats GetDeferredDeleteStats();
@@ -0,0 +1,513 @@
+#include "FrameExport.h"
+#include "Net.h"
+#include "Process.h"
+#include "Readback.h"
+#include "SharedMemory.h"
+#include "Stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const uint32_t kExportSlots = 4;
+    const size_t kMaxHelloBytes = 64;                                   // transport name
+    const size_t kMaxPipeFrameBytes = kExportSlotHeaderBytes + ((size_t)1 << 30);
+    static_assert(sizeof(ExportRingHeader) <= kExportHeaderBytes, "ring header grew past its reserved space");
+    static_assert(sizeof(ExportSlotHeader) <= kExportSlotHeaderBytes, "slot header grew past its reserved space");
+
+    enum ExportMessage : uint32_t
+    {
+        MsgExportHello = 1,     // consumer -> producer: transport name
+        MsgExportFrame,         // producer -> consumer, pipe transport: ExportSlotHeader + pixels
+        MsgExportDone,          // producer -> consumer, pipe transport
+        MsgExportResult,        // consumer -> producer: ConsumerResult
+    };
+
+    struct ConsumerResult
+    {
+        uint64_t frames;
+        uint64_t errors;        // frames whose header does not fit the ring, skipped
+        uint64_t checksum;
+        double cpuSeconds;
+        double seconds;
+        double latencyMs;       // mean capture-to-read
+    };
+
+    // spins briefly, then yields the core; the consumer waits here between frames
+    void Backoff(int& spins)
+    {
+        if (++spins < 64)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    size_t SlotStride(uint32_t width, uint32_t height)
+    {
+        size_t bytes = kExportSlotHeaderBytes + (size_t)width * height * 4;
+        return (bytes + 4095) & ~(size_t)4095;
+    }
+
+    // The other process maps the ring writable and could change the geometry in its
+    // header, so each side addresses slots only through its own copy of it.
+    struct RingGeometry
+    {
+        uint32_t slotCount;
+        uint32_t maxWidth;
+        uint32_t maxHeight;
+        size_t slotStride;
+    };
+
+    RingGeometry MakeGeometry(uint32_t slots, uint32_t width, uint32_t height)
+    {
+        RingGeometry g = { slots, width, height, SlotStride(width, height) };
+        return g;
+    }
+
+    ExportRingHeader* InitRing(SharedMemory& shm, const RingGeometry& g)
+    {
+        ExportRingHeader* h = new (shm.data) ExportRingHeader();
+        memcpy(h->magic, "GLEXPORT", 8);
+        h->version = kExportVersion;
+        h->slotCount = g.slotCount;
+        h->maxWidth = g.maxWidth;
+        h->maxHeight = g.maxHeight;
+        h->slotStride = g.slotStride;
+        h->written.store(0, std::memory_order_relaxed);
+        h->consumed.store(0, std::memory_order_relaxed);
+        h->closed.store(0, std::memory_order_release);
+        return h;
+    }
+
+    ExportSlotHeader* Slot(ExportRingHeader* h, const RingGeometry& g, uint64_t index)
+    {
+        return (ExportSlotHeader*)((uint8_t*)h + kExportHeaderBytes + (index % g.slotCount) * g.slotStride);
+    }
+
+    uint8_t* SlotPixels(ExportSlotHeader* slot)
+    {
+        return (uint8_t*)slot + kExportSlotHeaderBytes;
+    }
+
+    // next free slot for the producer, nullptr while the consumer still holds all of them
+    ExportSlotHeader* AcquireSlot(ExportRingHeader* h, const RingGeometry& g)
+    {
+        uint64_t w = h->written.load(std::memory_order_relaxed);
+        if (w - h->consumed.load(std::memory_order_acquire) >= g.slotCount)
+            return nullptr;
+        return Slot(h, g, w);
+    }
+
+    void PublishSlot(ExportRingHeader* h)
+    {
+        h->written.store(h->written.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // checksum over every 8-byte word so both transports touch all pixels
+    uint64_t Touch(const uint8_t* p, size_t bytes)
+    {
+        uint64_t sum = 0;
+        for (size_t i = 0; i + 8 <= bytes; i += 8)
+        {
+            uint64_t v;
+            memcpy(&v, p + i, 8);
+            sum += v;
+        }
+        return sum;
+    }
+
+    struct FrameExporter
+    {
+        bool running = false;
+        NetSocket listener = kInvalidSocket;
+        NetSocket consumer = kInvalidSocket;
+        SharedMemory shm;
+        ExportRingHeader* ring = nullptr;
+        RingGeometry geometry = {};
+        ReadbackRing readback;
+        uint64_t captureNs[kReadbackSlots * 2] = {};
+        FrameExportStats stats;
+        double copyMsTotal = 0.0;
+    } gExport;
+
+    void AcceptConsumer()
+    {
+        FrameExporter& e = gExport;
+        if (e.consumer != kInvalidSocket)
+        {
+            // a readable control socket means the consumer hung up
+            if (!NetPoll(e.consumer, 0)) return;
+            NetClose(e.consumer);
+            e.consumer = kInvalidSocket;
+        }
+        if (!NetPoll(e.listener, 0)) return;
+
+        NetSocket c = NetAccept(e.listener);
+        uint32_t type = 0;
+        std::string payload;
+        if (c == kInvalidSocket || !NetRecvMessage(c, type, payload, kMaxHelloBytes) || type != MsgExportHello || payload != "shm")
+        {
+            fprintf(stderr, "export: rejected a consumer (only the shm transport is served here)\n");
+            NetClose(c);
+            return;
+        }
+        // nobody reads the ring between consumers, start it over
+        InitRing(e.shm, e.geometry);
+        if (!SharedMemorySend(c, e.shm))
+        {
+            NetClose(c);
+            return;
+        }
+        e.consumer = c;
+    }
+
+    void ExportFrame(const ReadbackFrame& frame)
+    {
+        FrameExporter& e = gExport;
+        ExportRingHeader* h = e.ring;
+        const RingGeometry& g = e.geometry;
+        ExportSlotHeader* slot = (uint32_t)frame.width <= g.maxWidth && (uint32_t)frame.height <= g.maxHeight
+            ? AcquireSlot(h, g) : nullptr;
+        if (!slot)
+        {
+            e.stats.framesDropped++;
+            return;
+        }
+        Clock::time_point start = Clock::now();
+        slot->frame = frame.frame;
+        slot->width = (uint32_t)frame.width;
+        slot->height = (uint32_t)frame.height;
+        slot->timestampNs = e.captureNs[frame.frame % (kReadbackSlots * 2)];
+        memcpy(SlotPixels(slot), frame.pixels, (size_t)frame.width * frame.height * 4);
+        PublishSlot(h);
+        e.copyMsTotal += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        e.stats.framesExported++;
+    }
+
+    int ConsumeShm(NetSocket s, ConsumerResult& result)
+    {
+        SharedMemory shm;
+        std::string err;
+        if (!SharedMemoryReceive(s, shm, err))
+        {
+            fprintf(stderr, "export consumer: %s\n", err.c_str());
+            return -1;
+        }
+        ExportRingHeader* h = (ExportRingHeader*)shm.data;
+        if (shm.size < kExportHeaderBytes || memcmp(h->magic, "GLEXPORT", 8) != 0 || h->version != kExportVersion)
+        {
+            fprintf(stderr, "export consumer: not an export ring\n");
+            SharedMemoryClose(shm);
+            return -1;
+        }
+        // copied once and checked against the mapping before any slot is addressed
+        RingGeometry g = { h->slotCount, h->maxWidth, h->maxHeight, (size_t)h->slotStride };
+        const size_t ringBytes = shm.size - kExportHeaderBytes;
+        if (g.slotCount == 0 || (uint64_t)g.maxWidth * g.maxHeight > ringBytes / 4
+            || g.slotStride < SlotStride(g.maxWidth, g.maxHeight) || g.slotStride > ringBytes / g.slotCount)
+        {
+            fprintf(stderr, "export consumer: ring does not fit its %zu byte mapping\n", shm.size);
+            SharedMemoryClose(shm);
+            return -1;
+        }
+
+        double latencyTotal = 0.0;
+        int spins = 0;
+        for (;;)
+        {
+            uint64_t c = h->consumed.load(std::memory_order_relaxed);
+            if (c == h->written.load(std::memory_order_acquire))
+            {
+                // closed is set after the last publish, so re-check before leaving
+                if (h->closed.load(std::memory_order_acquire) && c == h->written.load(std::memory_order_acquire))
+                    break;
+                if (NetPoll(s, 0)) break; // producer hung up without closing
+                Backoff(spins);
+                continue;
+            }
+            spins = 0;
+            ExportSlotHeader* slot = Slot(h, g, c);
+            const uint32_t width = slot->width;
+            const uint32_t height = slot->height;
+            const uint64_t timestampNs = slot->timestampNs;
+            if (width <= g.maxWidth && height <= g.maxHeight)
+            {
+                result.checksum += Touch(SlotPixels(slot), (size_t)width * height * 4);
+                latencyTotal += (NowNs() - timestampNs) * 1e-6;
+                result.frames++;
+            }
+            else
+            {
+                result.errors++;
+            }
+            h->consumed.store(c + 1, std::memory_order_release);
+        }
+        result.latencyMs = result.frames ? latencyTotal / result.frames : 0.0;
+        SharedMemoryClose(shm);
+        return 0;
+    }
+
+    int ConsumePipe(NetSocket s, ConsumerResult& result)
+    {
+        std::string payload;
+        uint32_t type = 0;
+        double latencyTotal = 0.0;
+        while (NetRecvMessage(s, type, payload, kMaxPipeFrameBytes) && type == MsgExportFrame && payload.size() >= kExportSlotHeaderBytes)
+        {
+            ExportSlotHeader slot;
+            memcpy(&slot, payload.data(), sizeof(slot));
+            result.checksum += Touch((const uint8_t*)payload.data() + kExportSlotHeaderBytes, payload.size() - kExportSlotHeaderBytes);
+            latencyTotal += (NowNs() - slot.timestampNs) * 1e-6;
+            result.frames++;
+        }
+        result.latencyMs = result.frames ? latencyTotal / result.frames : 0.0;
+        return type == MsgExportDone ? 0 : -1;
+    }
+
+    struct TransportRun
+    {
+        double seconds = 0.0;
+        double producerCpu = 0.0;
+        ConsumerResult consumer = {};
+        bool ok = false;
+    };
+
+    TransportRun RunTransport(const char* transport, int width, int height, int frames)
+    {
+        TransportRun run;
+        std::string bound;
+        char address[128];
+#ifdef _WIN32
+        snprintf(address, sizeof(address), "tcp:127.0.0.1:0");
+#else
+        snprintf(address, sizeof(address), "unix:/tmp/glexport-bench-%d.sock", CurrentProcessId());
+#endif
+        NetSocket listener = NetListen(address, bound);
+        if (listener == kInvalidSocket)
+            return run;
+        ProcessHandle child = SpawnSelf({ "--export-consume", bound, transport });
+        NetSocket s = child != kInvalidProcess && NetPoll(listener, 30000) ? NetAccept(listener) : kInvalidSocket;
+        NetClose(listener);
+        if (!strncmp(bound.c_str(), "unix:", 5))
+            remove(bound.c_str() + 5);
+        uint32_t type = 0;
+        std::string payload;
+        if (s == kInvalidSocket || !NetRecvMessage(s, type, payload, kMaxHelloBytes) || type != MsgExportHello)
+        {
+            NetClose(s);
+            WaitProcess(child);
+            return run;
+        }
+
+        // the source stands in for a mapped readback buffer
+        const size_t frameBytes = (size_t)width * height * 4;
+        std::vector<uint8_t> source(kExportSlotHeaderBytes + frameBytes);
+        for (size_t i = 0; i < frameBytes; ++i)
+            source[kExportSlotHeaderBytes + i] = (uint8_t)(i * 31);
+
+        SharedMemory shm;
+        const RingGeometry geometry = MakeGeometry(kExportSlots, (uint32_t)width, (uint32_t)height);
+        ExportRingHeader* h = nullptr;
+        std::string err;
+        bool ok = true;
+        if (!strcmp(transport, "shm"))
+        {
+            ok = SharedMemoryCreate(kExportHeaderBytes + kExportSlots * geometry.slotStride, shm, err);
+            if (ok)
+            {
+                h = InitRing(shm, geometry);
+                ok = SharedMemorySend(s, shm);
+            }
+        }
+
+        double cpuStart = ProcessCpuSeconds();
+        Clock::time_point start = Clock::now();
+        for (int f = 0; f < frames && ok; ++f)
+        {
+            ExportSlotHeader header = { (uint64_t)f, (uint32_t)width, (uint32_t)height, NowNs() };
+            source[kExportSlotHeaderBytes] = (uint8_t)f; // every frame differs
+            if (h)
+            {
+                // a benchmark wants every frame delivered, so wait instead of dropping
+                ExportSlotHeader* slot;
+                int spins = 0;
+                while (!(slot = AcquireSlot(h, geometry)))
+                    Backoff(spins);
+                *slot = header;
+                memcpy(SlotPixels(slot), &source[kExportSlotHeaderBytes], frameBytes);
+                PublishSlot(h);
+            }
+            else
+            {
+                memcpy(source.data(), &header, sizeof(header));
+                ok = NetSendMessage(s, MsgExportFrame, source.data(), (uint32_t)source.size());
+            }
+        }
+        if (h)
+            h->closed.store(1, std::memory_order_release);
+        else if (ok)
+            ok = NetSendMessage(s, MsgExportDone, nullptr, 0);
+
+        ok = ok && NetRecvMessage(s, type, payload, sizeof(ConsumerResult)) && type == MsgExportResult && payload.size() == sizeof(ConsumerResult);
+        run.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        run.producerCpu = ProcessCpuSeconds() - cpuStart;
+        if (ok) memcpy(&run.consumer, payload.data(), sizeof(run.consumer));
+        run.ok = ok && run.consumer.frames == (uint64_t)frames && run.consumer.errors == 0;
+
+        NetClose(s);
+        WaitProcess(child);
+        if (shm.data) SharedMemoryClose(shm);
+        return run;
+    }
+}
+
+bool FrameExportStart(const char* address, int maxWidth, int maxHeight, std::string& errorOut)
+{
+    FrameExporter& e = gExport;
+    if (e.running) return true;
+    if (!NetInit())
+    {
+        errorOut = "socket init failed";
+        return false;
+    }
+    std::string bound;
+    e.listener = NetListen(address, bound);
+    if (e.listener == kInvalidSocket)
+    {
+        errorOut = std::string("cannot listen on ") + address;
+        NetShutdown();
+        return false;
+    }
+    const RingGeometry geometry = MakeGeometry(kExportSlots, (uint32_t)maxWidth, (uint32_t)maxHeight);
+    size_t bytes = kExportHeaderBytes + kExportSlots * geometry.slotStride;
+    if (!SharedMemoryCreate(bytes, e.shm, errorOut))
+    {
+        NetClose(e.listener);
+        NetShutdown();
+        return false;
+    }
+    e.geometry = geometry;
+    e.ring = InitRing(e.shm, e.geometry);
+    e.stats = FrameExportStats();
+    e.copyMsTotal = 0.0;
+    e.running = true;
+    printf("exporting frames up to %dx%d on %s\n", maxWidth, maxHeight, bound.c_str());
+    return true;
+}
+
+bool FrameExportRunning()
+{
+    return gExport.running;
+}
+
+void FrameExportCaptureFrame(int width, int height)
+{
+    FrameExporter& e = gExport;
+    if (!e.running || width <= 0 || height <= 0) return;
+
+    AcceptConsumer();
+    ReadbackFrame frame;
+    while (ReadbackMapOldest(e.readback, ReadbackFull(e.readback), frame))
+    {
+        if (e.consumer != kInvalidSocket)
+            ExportFrame(frame);
+        ReadbackUnmapOldest(e.readback);
+    }
+    // no readback cost at all while nobody is attached
+    if (e.consumer == kInvalidSocket)
+        return;
+    uint32_t queued = ReadbackQueue(e.readback, width, height);
+    e.captureNs[queued % (kReadbackSlots * 2)] = NowNs();
+}
+
+FrameExportStats FrameExportGetStats()
+{
+    FrameExportStats out = gExport.stats;
+    out.copyMs = out.framesExported ? gExport.copyMsTotal / out.framesExported : 0.0;
+    return out;
+}
+
+void FrameExportStop()
+{
+    FrameExporter& e = gExport;
+    if (!e.running) return;
+    ReadbackDestroy(e.readback);
+    e.ring->closed.store(1, std::memory_order_release);
+    NetClose(e.consumer);
+    NetClose(e.listener);
+    e.consumer = e.listener = kInvalidSocket;
+    // the consumer keeps its own mapping alive until it is done
+    SharedMemoryClose(e.shm);
+    e.ring = nullptr;
+    NetShutdown();
+    e.running = false;
+}
+
+int RunExportConsumer(const char* address, const char* transport)
+{
+    if (!NetInit())
+        return -1;
+    NetSocket s = NetConnect(address);
+    std::string name = transport;
+    if (s == kInvalidSocket || !NetSendMessage(s, MsgExportHello, name.data(), (uint32_t)name.size()))
+    {
+        fprintf(stderr, "export consumer: cannot connect to %s\n", address);
+        NetClose(s);
+        NetShutdown();
+        return -1;
+    }
+
+    ConsumerResult result = {};
+    double cpuStart = ProcessCpuSeconds();
+    Clock::time_point start = Clock::now();
+    int rc = name == "pipe" ? ConsumePipe(s, result) : ConsumeShm(s, result);
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    result.cpuSeconds = ProcessCpuSeconds() - cpuStart;
+
+    // the benchmark producer waits for this; a renderer producer has already gone
+    NetSendMessage(s, MsgExportResult, &result, sizeof(result));
+    printf("export consumer (%s): %llu frames, %.1f fps, latency %.3f ms, cpu %.3f ms/frame\n", transport,
+        (unsigned long long)result.frames, result.frames / std::max(1e-9, result.seconds), result.latencyMs,
+        result.frames ? result.cpuSeconds * 1000.0 / result.frames : 0.0);
+    if (result.errors)
+    {
+        fprintf(stderr, "export consumer: skipped %llu frames larger than the ring\n", (unsigned long long)result.errors);
+        rc = -1;
+    }
+    NetClose(s);
+    NetShutdown();
+    return rc;
+}
+
+int RunExportBenchmark(int width, int height, int frames)
+{
+    if (!NetInit())
+        return -1;
+    printf("frame export %dx%d, %d frames\n", width, height, frames);
+    printf("%10s %10s %10s %14s %14s %12s\n", "transport", "fps", "GB/s", "producer cpu", "consumer cpu", "latency");
+    const char* transports[] = { "shm", "pipe" };
+    bool ok = true;
+    for (const char* t : transports)
+    {
+        TransportRun run = RunTransport(t, width, height, std::max(1, frames));
+        if (!run.ok)
+        {
+            fprintf(stderr, "export bench: %s transport failed\n", t);
+            ok = false;
+            continue;
+        }
+        double fps = frames / std::max(1e-9, run.seconds);
+        printf("%10s %10.1f %10.2f %11.3f ms %11.3f ms %9.3f ms\n", t, fps,
+            fps * width * height * 4 / 1e9, run.producerCpu * 1000.0 / frames,
+            run.consumer.cpuSeconds * 1000.0 / frames, run.consumer.latencyMs);
+    }
+    NetShutdown();
+    return ok ? 0 : -1;
+}
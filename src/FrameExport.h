@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Hands finished frames to a compositor process through a ring of frame buffers in
+// shared memory. The consumer connects to the export socket once, receives the
+// mapping, and from then on reads pixels in place: the only synchronization is the
+// pair of sequence counters below (single producer, single consumer, no locks, no
+// per-frame syscalls). When the ring is full the producer drops the frame rather
+// than wait for the consumer.
+//
+// Layout, for consumers written against it:
+//   ExportRingHeader at offset 0
+//   slot i at kExportHeaderBytes + i * slotStride: ExportSlotHeader, pixels at +kExportSlotHeaderBytes
+// Pixels are tightly packed RGBA8 with bottom-up rows.
+
+static const uint32_t kExportVersion = 1;
+static const size_t kExportHeaderBytes = 256;
+static const size_t kExportSlotHeaderBytes = 64;
+
+struct ExportRingHeader
+{
+    char magic[8];                          // "GLEXPORT"
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t maxWidth;
+    uint32_t maxHeight;
+    uint64_t slotStride;
+    alignas(64) std::atomic<uint64_t> written;  // frames published, advanced by the producer
+    alignas(64) std::atomic<uint64_t> consumed; // frames released, advanced by the consumer
+    alignas(64) std::atomic<uint32_t> closed;   // producer is gone once the ring drains
+};
+
+struct ExportSlotHeader
+{
+    uint64_t frame;
+    uint32_t width;
+    uint32_t height;
+    uint64_t timestampNs;                   // steady clock at capture, for latency
+};
+
+struct FrameExportStats
+{
+    uint64_t framesExported = 0;
+    uint64_t framesDropped = 0;             // ring full or frame larger than a slot
+    double copyMs = 0.0;                    // mean readback-to-slot copy on the render thread
+};
+
+// address: where the consumer connects ("unix:/path" on POSIX, "tcp:host:port" on Windows)
+bool FrameExportStart(const char* address, int maxWidth, int maxHeight, std::string& errorOut);
+void FrameExportStop();
+bool FrameExportRunning();
+// queue the back buffer for export; call after drawing, before the swap
+void FrameExportCaptureFrame(int width, int height);
+FrameExportStats FrameExportGetStats();
+
+// Reference consumer. transport is "shm" (map the ring) or "pipe" (raw frames on the
+// socket, the baseline). Reads until the producer closes and reports fps, latency and
+// CPU time.
+int RunExportConsumer(const char* address, const char* transport);
+
+// Producer side of the transport comparison: streams synthetic frames of the given size
+// to a spawned consumer through the shared-memory ring and through a pipe-like socket.
+int RunExportBenchmark(int width, int height, int frames);
@@ -0,0 +1,199 @@
+#include "FramePacer.h"
+#include "Stats.h"
+#include "Window.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+    typedef std::chrono::duration<double> Seconds;
+
+    static const int kPacingHistory = 240;
+
+    struct PacerState
+    {
+        PacingMode mode = PacingVsync;
+        double targetHz = 60.0;
+        bool started = false;
+        bool modeDirty = true;
+
+        Clock::time_point epoch;
+        Clock::time_point deadline;     // next present target for cap / latelatch
+        Clock::time_point sampleTime;   // when this frame sampled the time
+        uint64_t inputPollNs = 0;       // when the input this frame uses was polled
+        Clock::time_point lastPresent;
+        bool hasLastPresent = false;
+
+        // learned online: how late sleeps wake up, how long sample-to-submit takes
+        double sleepOvershoot = 0.001;
+        double predictedWork = 0.002;
+
+        float intervals[kPacingHistory] = {};
+        float latencies[kPacingHistory] = {};
+        int head = 0;
+        int count = 0;
+        PacingStats stats;
+    } gPacer;
+
+    const char* kModeNames[PacingModeCount] = { "vsync", "uncapped", "cap", "latelatch" };
+
+    // sleep for the bulk of the wait, spin the last stretch the OS timer cannot hit
+    void WaitUntil(Clock::time_point target)
+    {
+        Clock::time_point now = Clock::now();
+        double remaining = Seconds(target - now).count();
+        double margin = gPacer.sleepOvershoot * 1.5 + 0.0002;
+        if (remaining > margin)
+        {
+            Clock::time_point wake = target - std::chrono::duration_cast<Clock::duration>(Seconds(margin));
+            std::this_thread::sleep_until(wake);
+            double overshoot = Seconds(Clock::now() - wake).count();
+            // track the overshoot with a fast attack / slow decay so spikes widen the margin
+            if (overshoot > gPacer.sleepOvershoot) gPacer.sleepOvershoot = overshoot;
+            else gPacer.sleepOvershoot += (overshoot - gPacer.sleepOvershoot) * 0.05;
+        }
+        while (Clock::now() < target)
+            std::this_thread::yield();
+    }
+
+    void UpdateStats()
+    {
+        PacingStats& s = gPacer.stats;
+        int n = gPacer.count;
+        if (n == 0) return;
+        double sum = 0.0, sumSq = 0.0, lat = 0.0;
+        float maxMs = 0.0f;
+        for (int i = 0; i < n; ++i)
+        {
+            sum += gPacer.intervals[i];
+            sumSq += (double)gPacer.intervals[i] * gPacer.intervals[i];
+            lat += gPacer.latencies[i];
+            maxMs = std::max(maxMs, gPacer.intervals[i]);
+        }
+        double mean = sum / n;
+        s.avgFrameMs = (float)mean;
+        s.jitterMs = (float)sqrt(std::max(0.0, sumSq / n - mean * mean));
+        s.maxFrameMs = maxMs;
+        s.latencyMs = (float)(lat / n + mean * 0.5);
+        s.sleepOvershootMs = (float)(gPacer.sleepOvershoot * 1000.0);
+        s.predictedWorkMs = (float)(gPacer.predictedWork * 1000.0);
+    }
+}
+
+const char* PacingModeName(PacingMode mode)
+{
+    return mode >= 0 && mode < PacingModeCount ? kModeNames[mode] : "?";
+}
+
+bool ParsePacingMode(const char* name, PacingMode& mode)
+{
+    for (int m = 0; m < PacingModeCount; ++m)
+    {
+        if (!strcmp(name, kModeNames[m]))
+        {
+            mode = (PacingMode)m;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PacerSetMode(PacingMode mode, double targetHz)
+{
+    gPacer.mode = mode;
+    gPacer.targetHz = targetHz > 1.0 ? targetHz : 60.0;
+    gPacer.modeDirty = true;
+    gPacer.count = 0;
+    gPacer.head = 0;
+    gPacer.hasLastPresent = false;
+}
+
+PacingMode PacerMode()
+{
+    return gPacer.mode;
+}
+
+double PacerTargetHz()
+{
+    return gPacer.targetHz;
+}
+
+double PacerBeginFrame()
+{
+    Clock::time_point now = Clock::now();
+    if (!gPacer.started)
+    {
+        gPacer.epoch = now;
+        gPacer.started = true;
+    }
+    if (gPacer.modeDirty)
+    {
+        SetSwapInterval(gPacer.mode == PacingVsync ? 1 : 0);
+        gPacer.deadline = now;
+        gPacer.modeDirty = false;
+    }
+
+    const Clock::duration period = std::chrono::duration_cast<Clock::duration>(Seconds(1.0 / gPacer.targetHz));
+    if (gPacer.mode == PacingCapped || gPacer.mode == PacingLateLatch)
+    {
+        gPacer.deadline += period;
+        // fell more than a frame behind: re-anchor instead of bursting to catch up
+        if (gPacer.deadline < now)
+            gPacer.deadline = now + (gPacer.mode == PacingLateLatch ? period : Clock::duration(0));
+
+        Clock::time_point start = gPacer.deadline;
+        if (gPacer.mode == PacingLateLatch)
+        {
+            // start late enough that the frame finishes right at the deadline
+            Seconds lead(gPacer.predictedWork * 1.2 + 0.0005);
+            start -= std::chrono::duration_cast<Clock::duration>(lead);
+        }
+        WaitUntil(start);
+    }
+
+    // latch input right before the time sample so both describe the same instant
+    if (gPacer.mode == PacingLateLatch)
+        PollEvents();
+    gPacer.inputPollNs = LastInputPollNs();
+    gPacer.sampleTime = Clock::now();
+    return Seconds(gPacer.sampleTime - gPacer.epoch).count();
+}
+
+double PacerNow()
+{
+    if (!gPacer.started)
+    {
+        gPacer.epoch = Clock::now();
+        gPacer.started = true;
+    }
+    return Seconds(Clock::now() - gPacer.epoch).count();
+}
+
+void PacerEndFrame()
+{
+    Clock::time_point present = Clock::now();
+    double work = Seconds(present - gPacer.sampleTime).count();
+    // other modes poll in Loop() after the previous swap, so the pacing wait counts too
+    double latency = gPacer.inputPollNs ? (NowNs() - gPacer.inputPollNs) * 1e-9 : work;
+    gPacer.predictedWork += (work - gPacer.predictedWork) * (work > gPacer.predictedWork ? 0.5 : 0.05);
+
+    if (gPacer.hasLastPresent)
+    {
+        gPacer.intervals[gPacer.head] = (float)(Seconds(present - gPacer.lastPresent).count() * 1000.0);
+        gPacer.latencies[gPacer.head] = (float)(latency * 1000.0);
+        gPacer.head = (gPacer.head + 1) % kPacingHistory;
+        gPacer.count = std::min(gPacer.count + 1, kPacingHistory);
+        UpdateStats();
+    }
+    gPacer.lastPresent = present;
+    gPacer.hasLastPresent = true;
+}
+
+const PacingStats& PacerStats()
+{
+    return gPacer.stats;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+// Frame pacing and latency measurement for the render loop.
+//
+//   vsync      swap interval 1, the driver blocks in SwapBuffers
+//   uncapped   swap interval 0, frames start as soon as the previous one is submitted
+//   cap        swap interval 0, frames start on a fixed cadence using a hybrid
+//              sleep-then-spin wait on the monotonic clock
+//   latelatch  like cap, but the frame start (input poll + time sample) is delayed until
+//              just before the predicted submit time, trading headroom for latency
+//
+// Latency is estimated as input-poll-to-present time, including any pacing wait after
+// the poll, plus half a frame interval, the mean time an input event waits for the
+// next poll.
+
+enum PacingMode
+{
+    PacingVsync,
+    PacingUncapped,
+    PacingCapped,
+    PacingLateLatch,
+    PacingModeCount
+};
+
+struct PacingStats
+{
+    float avgFrameMs = 0.0f;    // present-to-present
+    float jitterMs = 0.0f;      // standard deviation of the present interval
+    float maxFrameMs = 0.0f;
+    float latencyMs = 0.0f;     // estimated input-to-present
+    float sleepOvershootMs = 0.0f;
+    float predictedWorkMs = 0.0f;
+};
+
+const char* PacingModeName(PacingMode mode);
+bool ParsePacingMode(const char* name, PacingMode& mode);
+
+// targetHz is used by cap and latelatch
+void PacerSetMode(PacingMode mode, double targetHz);
+PacingMode PacerMode();
+double PacerTargetHz();
+
+// blocks until the frame should start, polls input and returns the time (seconds since
+// the first call) the frame should animate with
+double PacerBeginFrame();
+// same clock as PacerBeginFrame without waiting, for frames drawn outside the loop
+double PacerNow();
+// call right after the buffers were swapped
+void PacerEndFrame();
+
+const PacingStats& PacerStats();
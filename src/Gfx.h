@@ -0,0 +1,83 @@
+#pragma once
+#include <glad/glad.h>
+#include "Capture.h"
+#include "Profiler.h"
+
+// Thin wrappers over the GL calls the renderer issues per frame.
+// They exist so draws and state changes can be counted in one place instead of at
+// every call site. When a capture is running the same calls are appended to it.
+
+// which window's context is current (0 = primary), maintained by MakeWindowCurrent
+extern int gGfxContextIndex;
+// the contexts are OpenGL ES 3.1 instead of desktop 4.3 core, set by CreateWindow
+extern bool gGfxGles;
+// GPU timestamp / elapsed time queries work; on ES they need EXT_disjoint_timer_query
+extern bool gGfxTimerQueries;
+
+inline void GfxClear(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+{
+    glClearColor(r, g, b, a);
+    glClear(GL_COLOR_BUFFER_BIT);
+    if (gCaptureActive) CaptureClear(r, g, b, a);
+}
+
+inline void GfxUseProgram(GLuint program)
+{
+    glUseProgram(program);
+    gFrameCounters.programBinds++;
+    if (gCaptureActive) CaptureUseProgram(program);
+}
+
+inline void GfxBindVertexArray(GLuint vao)
+{
+    glBindVertexArray(vao);
+    gFrameCounters.vaoBinds++;
+    if (gCaptureActive) CaptureBindVertexArray(vao);
+}
+
+// the pulled path's per-draw geometry switch, so it counts with the VAO binds
+inline void GfxBindStorageBuffer(GLuint binding, GLuint buffer)
+{
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+    gFrameCounters.vaoBinds++;
+}
+
+inline void GfxUniform1i(GLint location, GLint v)
+{
+    glUniform1i(location, v);
+    gFrameCounters.uniformSets++;
+    if (gCaptureActive) CaptureUniform1i(location, v);
+}
+
+inline void GfxUniform1f(GLint location, GLfloat v)
+{
+    glUniform1f(location, v);
+    gFrameCounters.uniformSets++;
+    if (gCaptureActive) CaptureUniform1f(location, v);
+}
+
+inline void GfxUniform2f(GLint location, GLfloat x, GLfloat y)
+{
+    glUniform2f(location, x, y);
+    gFrameCounters.uniformSets++;
+    if (gCaptureActive) CaptureUniform2f(location, x, y);
+}
+
+inline void GfxDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+    glDrawArrays(mode, first, count);
+    gFrameCounters.drawCalls++;
+    gFrameCounters.vertices += (uint32_t)count;
+    if (gCaptureActive) CaptureDraw(mode, first, count);
+}
+
+// End of the frame's pass on the default framebuffer: depth and stencil are not needed
+// past it, so a tile-based GPU can drop them instead of writing them back to memory.
+// Anything that reads the backbuffer does so after this, never mid-frame: a read forces
+// a tiler to flush the pass and load it back for the draws that follow.
+inline void GfxEndBackbufferPass()
+{
+    static const GLenum attachments[] = { GL_DEPTH, GL_STENCIL };
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glInvalidateFramebuffer(GL_DRAW_FRAMEBUFFER, 2, attachments);
+}
@@ -0,0 +1,151 @@
+#include "Gles.h"
+#include "Gfx.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    // Fragment shaders here compute colors, which half floats hold fine, and on mobile
+    // GPUs mediump halves register use and the bandwidth of texture results. A shader
+    // whose values need the range asks for highp itself. Float samplers in fragment
+    // shaders read color textures.
+    const char* kFragmentPrecision =
+        "precision mediump float;\n"
+        "precision mediump sampler2D;\n"
+        "precision mediump sampler2DArray;\n"
+        "precision mediump sampler3D;\n"
+        "precision mediump samplerCube;\n";
+
+    // positions, sample values and everything compute touches
+    const char* kFullPrecision =
+        "precision highp float;\n"
+        "precision highp sampler2D;\n"
+        "precision highp sampler2DArray;\n"
+        "precision highp sampler3D;\n"
+        "precision highp samplerCube;\n";
+
+    // integers are indices, ids, counters and times (ES fragment shaders default to
+    // 16 bits), integer textures and images hold data
+    const char* kIntegerPrecision =
+        "precision highp int;\n"
+        "precision highp isampler2D;\n"
+        "precision highp isampler2DArray;\n"
+        "precision highp usampler2D;\n"
+        "precision highp usampler2DArray;\n"
+        "precision highp image2D;\n"
+        "precision highp iimage2D;\n"
+        "precision highp uimage2D;\n";
+
+    bool HasExtension(const char* name)
+    {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i)
+        {
+            const GLubyte* e = glGetStringi(GL_EXTENSIONS, (GLuint)i);
+            if (e && !strcmp((const char*)e, name))
+                return true;
+        }
+        return false;
+    }
+
+    template <typename T>
+    void Load(T& slot, GLADloadproc load, const char* name, const char*& missing)
+    {
+        slot = (T)load(name);
+        if (!slot && !missing)
+            missing = name;
+    }
+}
+
+#define GLES_LOAD(name) Load(glad_##name, load, #name, missing)
+
+bool LoadGlesFunctions(GLADloadproc load, std::string& errorOut)
+{
+    const char* missing = nullptr;
+    // desktop 3.2: sync objects, 64-bit queries, multisample textures
+    GLES_LOAD(glFenceSync); GLES_LOAD(glIsSync); GLES_LOAD(glDeleteSync); GLES_LOAD(glClientWaitSync);
+    GLES_LOAD(glWaitSync); GLES_LOAD(glGetInteger64v); GLES_LOAD(glGetSynciv); GLES_LOAD(glGetInteger64i_v);
+    GLES_LOAD(glGetBufferParameteri64v); GLES_LOAD(glGetMultisamplefv); GLES_LOAD(glSampleMaski);
+    // 3.3: samplers, instancing
+    GLES_LOAD(glGenSamplers); GLES_LOAD(glDeleteSamplers); GLES_LOAD(glIsSampler); GLES_LOAD(glBindSampler);
+    GLES_LOAD(glSamplerParameteri); GLES_LOAD(glSamplerParameteriv); GLES_LOAD(glSamplerParameterf);
+    GLES_LOAD(glSamplerParameterfv); GLES_LOAD(glGetSamplerParameteriv); GLES_LOAD(glGetSamplerParameterfv);
+    GLES_LOAD(glVertexAttribDivisor);
+    // 4.0: transform feedback objects, indirect draws
+    GLES_LOAD(glBindTransformFeedback); GLES_LOAD(glDeleteTransformFeedbacks); GLES_LOAD(glGenTransformFeedbacks);
+    GLES_LOAD(glIsTransformFeedback); GLES_LOAD(glPauseTransformFeedback); GLES_LOAD(glResumeTransformFeedback);
+    GLES_LOAD(glDrawArraysIndirect); GLES_LOAD(glDrawElementsIndirect);
+    // 4.1: ES compatibility, program binaries, separate programs
+    GLES_LOAD(glReleaseShaderCompiler); GLES_LOAD(glShaderBinary); GLES_LOAD(glGetShaderPrecisionFormat);
+    GLES_LOAD(glDepthRangef); GLES_LOAD(glClearDepthf); GLES_LOAD(glGetProgramBinary); GLES_LOAD(glProgramBinary);
+    GLES_LOAD(glProgramParameteri); GLES_LOAD(glUseProgramStages); GLES_LOAD(glActiveShaderProgram);
+    GLES_LOAD(glCreateShaderProgramv); GLES_LOAD(glBindProgramPipeline); GLES_LOAD(glDeleteProgramPipelines);
+    GLES_LOAD(glGenProgramPipelines); GLES_LOAD(glIsProgramPipeline); GLES_LOAD(glGetProgramPipelineiv);
+    GLES_LOAD(glValidateProgramPipeline); GLES_LOAD(glGetProgramPipelineInfoLog);
+    GLES_LOAD(glProgramUniform1i); GLES_LOAD(glProgramUniform2i); GLES_LOAD(glProgramUniform3i);
+    GLES_LOAD(glProgramUniform4i); GLES_LOAD(glProgramUniform1ui); GLES_LOAD(glProgramUniform2ui);
+    GLES_LOAD(glProgramUniform3ui); GLES_LOAD(glProgramUniform4ui); GLES_LOAD(glProgramUniform1f);
+    GLES_LOAD(glProgramUniform2f); GLES_LOAD(glProgramUniform3f); GLES_LOAD(glProgramUniform4f);
+    GLES_LOAD(glProgramUniform1iv); GLES_LOAD(glProgramUniform2iv); GLES_LOAD(glProgramUniform3iv);
+    GLES_LOAD(glProgramUniform4iv); GLES_LOAD(glProgramUniform1uiv); GLES_LOAD(glProgramUniform2uiv);
+    GLES_LOAD(glProgramUniform3uiv); GLES_LOAD(glProgramUniform4uiv); GLES_LOAD(glProgramUniform1fv);
+    GLES_LOAD(glProgramUniform2fv); GLES_LOAD(glProgramUniform3fv); GLES_LOAD(glProgramUniform4fv);
+    GLES_LOAD(glProgramUniformMatrix2fv); GLES_LOAD(glProgramUniformMatrix3fv); GLES_LOAD(glProgramUniformMatrix4fv);
+    GLES_LOAD(glProgramUniformMatrix2x3fv); GLES_LOAD(glProgramUniformMatrix3x2fv);
+    GLES_LOAD(glProgramUniformMatrix2x4fv); GLES_LOAD(glProgramUniformMatrix4x2fv);
+    GLES_LOAD(glProgramUniformMatrix3x4fv); GLES_LOAD(glProgramUniformMatrix4x3fv);
+    // 4.2: texture storage, images
+    GLES_LOAD(glGetInternalformativ); GLES_LOAD(glBindImageTexture); GLES_LOAD(glMemoryBarrier);
+    GLES_LOAD(glTexStorage2D); GLES_LOAD(glTexStorage3D);
+    // 4.3: compute, invalidation, program interface queries, vertex attribute bindings
+    GLES_LOAD(glDispatchCompute); GLES_LOAD(glDispatchComputeIndirect); GLES_LOAD(glFramebufferParameteri);
+    GLES_LOAD(glGetFramebufferParameteriv); GLES_LOAD(glInvalidateFramebuffer); GLES_LOAD(glInvalidateSubFramebuffer);
+    GLES_LOAD(glGetProgramInterfaceiv); GLES_LOAD(glGetProgramResourceIndex); GLES_LOAD(glGetProgramResourceName);
+    GLES_LOAD(glGetProgramResourceiv); GLES_LOAD(glGetProgramResourceLocation); GLES_LOAD(glTexStorage2DMultisample);
+    GLES_LOAD(glBindVertexBuffer); GLES_LOAD(glVertexAttribFormat); GLES_LOAD(glVertexAttribIFormat);
+    GLES_LOAD(glVertexAttribBinding); GLES_LOAD(glVertexBindingDivisor); GLES_LOAD(glGetBooleani_v);
+    // 4.5
+    GLES_LOAD(glMemoryBarrierByRegion);
+    if (missing)
+    {
+        errorOut = std::string("the OpenGL ES context has no ") + missing;
+        return false;
+    }
+
+    // desktop 3.3 timer queries; the ES extension has them under suffixed names
+    gGfxTimerQueries = false;
+    if (HasExtension("GL_EXT_disjoint_timer_query"))
+    {
+        Load(glad_glQueryCounter, load, "glQueryCounterEXT", missing);
+        Load(glad_glGetQueryObjectiv, load, "glGetQueryObjectivEXT", missing);
+        Load(glad_glGetQueryObjectui64v, load, "glGetQueryObjectui64vEXT", missing);
+        gGfxTimerQueries = !missing;
+    }
+    return true;
+}
+
+#undef GLES_LOAD
+
+std::string TranslateShaderToGles(const char* source, GLenum stage)
+{
+    std::string src(source);
+    size_t version = src.find("#version");
+    if (version == std::string::npos)
+        return src;
+    size_t body = src.find('\n', version);
+    body = body == std::string::npos ? src.size() : body + 1;
+    // the preamble replaces one line, #line puts the rest back where it was
+    int bodyLine = 1 + (int)std::count(src.begin(), src.begin() + body, '\n');
+
+    std::string out = src.substr(0, version);
+    out += "#version 310 es\n";
+    // 4.3 has image atomics in core
+    if (src.find("imageAtomic") != std::string::npos)
+        out += "#extension GL_OES_shader_image_atomic : require\n";
+    out += stage == GL_FRAGMENT_SHADER ? kFragmentPrecision : kFullPrecision;
+    out += kIntegerPrecision;
+    out += "#line " + std::to_string(bodyLine) + "\n";
+    out += src.substr(body);
+    return out;
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include <glad/glad.h>
+#include <string>
+
+// What the OpenGL ES 3.1 backend needs on top of the desktop code. The renderer uses
+// the calls and GLSL that ES 3.1 shares with GL 4.3, except that some paths read
+// storage buffers in the vertex stage (vertex pulling, instances, time series lines,
+// points) or a storage buffer and an image in the fragment stage (point splat
+// resolve). ES 3.1 allows 0 of those; GpuCaps has the limits and those paths fail
+// their init, or fall back, when they are 0. Otherwise it runs unchanged:
+//  - glad files functions under the desktop version that introduced them and loads
+//    none past the 3.x an ES context reports, so the ES 3.1 ones from desktop 3.2 .. 4.5
+//    (compute, images, texture storage, sync, program binaries, ...) are fetched here
+//  - shaders are written for #version 430 core and get an ES preamble when they are
+//    compiled: default precisions, and the extensions ES needs for what 4.3 has in core
+//  - GPU timers come from EXT_disjoint_timer_query, when the driver has it
+
+// call after gladLoadGLLoader on an ES context; fails if a core ES 3.1 function is
+// missing. Also sets gGfxTimerQueries.
+bool LoadGlesFunctions(GLADloadproc load, std::string& errorOut);
+
+// the ES version of a desktop shader; stage is GL_VERTEX_SHADER, GL_FRAGMENT_SHADER or
+// GL_COMPUTE_SHADER. Line numbers in compile errors still match the original source.
+std::string TranslateShaderToGles(const char* source, GLenum stage);
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Dense pool of records addressed by 32-bit generational handles: the low 20 bits
+// pick a slot, the high 12 bits must match the slot's generation. Destroying a record
+// bumps the generation, so stale copies of its handle fail Get() instead of reaching
+// whatever reuses the slot. Records are kept contiguous (the last one moves into a
+// destroyed record's place), create and destroy are O(1) with a free list of slots.
+// Handle 0 is never valid.
+template <typename T>
+class HandlePool
+{
+public:
+    static const uint32_t kIndexBits = 20;
+    static const uint32_t kIndexMask = (1u << kIndexBits) - 1;
+    static const uint32_t kMaxRecords = kIndexMask;
+    static const uint32_t kGenerationMask = 0xfffu;
+
+    // returns 0 when the pool is full
+    uint32_t Create(const T& record)
+    {
+        uint32_t slot;
+        if (!freeSlots.empty())
+        {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            if (slots.size() >= kMaxRecords)
+                return 0;
+            slot = (uint32_t)slots.size();
+            slots.push_back(Slot());
+        }
+        slots[slot].dense = (uint32_t)records.size();
+        records.push_back(record);
+        denseSlots.push_back(slot);
+        return MakeHandle(slot, slots[slot].generation);
+    }
+
+    // false for stale or invalid handles
+    bool Destroy(uint32_t handle)
+    {
+        Slot* s = Find(handle);
+        if (!s)
+            return false;
+        uint32_t slot = handle & kIndexMask;
+        uint32_t hole = s->dense;
+        uint32_t last = (uint32_t)records.size() - 1;
+        if (hole != last)
+        {
+            records[hole] = records[last];
+            denseSlots[hole] = denseSlots[last];
+            slots[denseSlots[hole]].dense = hole;
+        }
+        records.pop_back();
+        denseSlots.pop_back();
+
+        // generation 0 is skipped so no handle is ever 0
+        s->generation = (s->generation + 1) & kGenerationMask;
+        if (s->generation == 0) s->generation = 1;
+        s->dense = kInvalidDense;
+        freeSlots.push_back(slot);
+        return true;
+    }
+
+    T* Get(uint32_t handle)
+    {
+        Slot* s = Find(handle);
+        return s ? &records[s->dense] : nullptr;
+    }
+
+    const T* Get(uint32_t handle) const
+    {
+        return const_cast<HandlePool*>(this)->Get(handle);
+    }
+
+    // live records, contiguous, in no particular order
+    size_t Size() const { return records.size(); }
+    size_t SlotCount() const { return slots.size(); }
+    T* Data() { return records.data(); }
+    const T* Data() const { return records.data(); }
+    uint32_t HandleAt(size_t denseIndex) const
+    {
+        uint32_t slot = denseSlots[denseIndex];
+        return MakeHandle(slot, slots[slot].generation);
+    }
+
+private:
+    static const uint32_t kInvalidDense = 0xffffffffu;
+
+    struct Slot
+    {
+        uint32_t dense = kInvalidDense;
+        uint32_t generation = 1;
+    };
+
+    static uint32_t MakeHandle(uint32_t slot, uint32_t generation)
+    {
+        return (generation << kIndexBits) | slot;
+    }
+
+    Slot* Find(uint32_t handle)
+    {
+        uint32_t slot = handle & kIndexMask;
+        if (handle == 0 || slot >= slots.size())
+            return nullptr;
+        Slot& s = slots[slot];
+        if (s.dense == kInvalidDense || s.generation != (handle >> kIndexBits))
+            return nullptr;
+        return &s;
+    }
+
+    std::vector<T> records;
+    std::vector<uint32_t> denseSlots;   // record index -> slot
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+};
@@ -0,0 +1,273 @@
+#include "Hud.h"
+#include "FramePacer.h"
+#include "Gfx.h"
+#include "Instances.h"
+#include "Profiler.h"
+#include "Shader.h"
+#include "Pipeline.h"
+#include "VertexFormat.h"
+#include "Warmup.h"
+#include "World.h"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+    struct HudVertex
+    {
+        float x, y;     // pixels, origin top-left
+        uint32_t color; // 0xAABBGGRR
+    };
+
+    // 3x5 glyphs for ASCII 32..95, 15 bits row-major with bit 14 the top-left pixel.
+    // lowercase is folded to uppercase, anything unknown renders as a filled block
+    const uint16_t kFont[64] = {
+        0x0000, 0x2482, 0x7FFF, 0x5F7D, 0x7FFF, 0x52A5, 0x7FFF, 0x7FFF,  // space ! " # $ % & '
+        0x2922, 0x224A, 0x0AA8, 0x05D0, 0x0014, 0x01C0, 0x0002, 0x12A4,  // ( ) * + , - . /
+        0x7B6F, 0x2C97, 0x73E7, 0x72CF, 0x5BC9, 0x79CF, 0x79EF, 0x7252,  // 0-7
+        0x7BEF, 0x7BCF, 0x0410, 0x7FFF, 0x1511, 0x0E38, 0x4454, 0x6282,  // 8 9 : ; < = > ?
+        0x7FFF, 0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B,  // @ A-G
+        0x5BED, 0x7497, 0x126A, 0x5BAD, 0x4927, 0x5FED, 0x6B6D, 0x2B6A,  // H-O
+        0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, 0x5B6F, 0x5B6A, 0x5BFD,  // P-W
+        0x5AAD, 0x5A92, 0x72A7, 0x6926, 0x7FFF, 0x324B, 0x7FFF, 0x0007,  // X Y Z [ \ ] ^ _
+    };
+
+    const int kGlyphScale = 2;                        // screen pixels per font pixel
+    const int kGlyphAdvance = 4 * kGlyphScale;
+    const int kLineHeight = 7 * kGlyphScale;
+    const int kGraphHeight = 80;
+    const float kGraphMaxMs = 33.3f;
+
+    const uint32_t kColorText = 0xFFFFFFFF;
+    const uint32_t kColorPanel = 0xB0000000;
+    const uint32_t kColorFrame = 0xFF40C0FF;  // orange-ish
+    const uint32_t kColorCpu = 0xFF60FF60;
+    const uint32_t kColorGpu = 0xFFFF8040;
+    const uint32_t kColorTarget = 0x80FFFFFF;
+
+    const char* hudVertexSrc = R"(
+#version 430 core
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec4 aColor;
+uniform vec2 viewport;
+out vec4 vColor;
+void main()
+{
+    vec2 ndc = aPos / viewport * 2.0 - 1.0;
+    gl_Position = vec4(ndc.x, -ndc.y, 0.0, 1.0);
+    vColor = aColor;
+}
+)";
+
+    const char* hudFragmentSrc = R"(
+#version 430 core
+in vec4 vColor;
+out vec4 FragColor;
+void main()
+{
+    FragColor = vColor;
+}
+)";
+
+    struct HudState
+    {
+        Shader shader;
+        PipelineId pipeline = 0;
+        GLint locViewport = -1;
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        size_t vboBytes = 0;
+        bool visible = true;
+        std::vector<HudVertex> verts;
+    } gHud;
+
+    void Quad(float x0, float y0, float x1, float y1, uint32_t color)
+    {
+        std::vector<HudVertex>& v = gHud.verts;
+        v.push_back({ x0, y0, color });
+        v.push_back({ x1, y0, color });
+        v.push_back({ x1, y1, color });
+        v.push_back({ x0, y0, color });
+        v.push_back({ x1, y1, color });
+        v.push_back({ x0, y1, color });
+    }
+
+    void Text(float x, float y, const char* str, uint32_t color)
+    {
+        for (; *str; ++str, x += kGlyphAdvance)
+        {
+            int c = (unsigned char)*str;
+            if (c >= 'a' && c <= 'z') c -= 32;
+            uint16_t bits = (c >= 32 && c < 96) ? kFont[c - 32] : 0x7FFF;
+            for (int row = 0; row < 5; ++row)
+            {
+                for (int col = 0; col < 3; ++col)
+                {
+                    if (bits & (1 << (14 - (row * 3 + col))))
+                    {
+                        float px = x + col * kGlyphScale;
+                        float py = y + row * kGlyphScale;
+                        Quad(px, py, px + kGlyphScale, py + kGlyphScale, color);
+                    }
+                }
+            }
+        }
+    }
+
+    // one series of the rolling graph, oldest sample on the left
+    void Graph(float x, float y, const float* samples, int head, uint32_t color)
+    {
+        for (int i = 0; i < kProfilerHistory; ++i)
+        {
+            float ms = samples[(head + 1 + i) % kProfilerHistory];
+            if (ms <= 0.0f) continue;
+            float h = ms / kGraphMaxMs * kGraphHeight;
+            if (h > kGraphHeight) h = (float)kGraphHeight;
+            Quad(x + i, y + kGraphHeight - h, x + i + 1, y + kGraphHeight - h + 2, color);
+        }
+    }
+
+    float Average(const float* samples)
+    {
+        float sum = 0.0f;
+        int n = 0;
+        for (int i = 0; i < kProfilerHistory; ++i)
+        {
+            if (samples[i] > 0.0f) { sum += samples[i]; n++; }
+        }
+        return n ? sum / n : 0.0f;
+    }
+}
+
+bool HudInit(std::string& errorOut)
+{
+    if (!gHud.shader.CreateFromSource(hudVertexSrc, hudFragmentSrc, errorOut))
+        return false;
+    gHud.locViewport = glGetUniformLocation(gHud.shader.GetID(), "viewport");
+
+    glGenVertexArrays(1, &gHud.vao);
+    glGenBuffers(1, &gHud.vbo);
+
+    glBindVertexArray(gHud.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, gHud.vbo);
+    ApplyVertexFormat(PackedColorVertexFormat());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    gHud.verts.reserve(16384);
+    PipelineDesc desc;
+    desc.program = gHud.shader.GetID();
+    desc.format = PackedColorVertexFormat();
+    desc.blend = BlendAlpha;
+    gHud.pipeline = CreatePipeline(desc);
+    WarmupRegister("hud", gHud.pipeline, GL_TRIANGLES);
+    return true;
+}
+
+void HudShutdown()
+{
+    if (gHud.vbo) { glDeleteBuffers(1, &gHud.vbo); gHud.vbo = 0; }
+    if (gHud.vao) { glDeleteVertexArrays(1, &gHud.vao); gHud.vao = 0; }
+    ProfilerTrackGpuBytes(-(int64_t)gHud.vboBytes);
+    gHud.vboBytes = 0;
+    WarmupUnregister(gHud.pipeline);
+    DestroyPipeline(gHud.pipeline);
+    gHud.pipeline = 0;
+    gHud.shader.Destroy();
+}
+
+void HudToggle()
+{
+    gHud.visible = !gHud.visible;
+}
+
+bool HudIsVisible()
+{
+    return gHud.visible;
+}
+
+void HudDraw(int framebufferWidth, int framebufferHeight)
+{
+    if (!gHud.visible || !gHud.vao || framebufferWidth <= 0 || framebufferHeight <= 0)
+        return;
+
+    ProfilerBeginHud();
+
+    const FrameTimings& t = ProfilerTimings();
+    const FrameCounters& c = t.lastCounters;
+    const ShaderStats& ss = Shader::GetStats();
+    gHud.verts.clear();
+
+    const float x = 8.0f;
+    float y = 8.0f;
+    const float panelW = (float)kProfilerHistory + 16.0f;
+    const bool instances = InstancesReady();
+    const bool world = WorldIsOpen();
+    const int lines = 8 + (instances ? 1 : 0) + (world ? 1 : 0);
+    Quad(x - 4, y - 4, x - 4 + panelW, y + lines * kLineHeight + kGraphHeight + 8, kColorPanel);
+
+    char buf[128];
+    float frameAvg = Average(t.frameMs);
+    snprintf(buf, sizeof(buf), "FRAME %.2f MS  %.0f FPS", frameAvg, frameAvg > 0.0f ? 1000.0f / frameAvg : 0.0f);
+    Text(x, y, buf, kColorFrame); y += kLineHeight;
+    snprintf(buf, sizeof(buf), "CPU %.2f MS  GPU %.2f MS", Average(t.cpuMs), Average(t.gpuMs));
+    Text(x, y, buf, kColorText); y += kLineHeight;
+    snprintf(buf, sizeof(buf), "DRAWS %u  VERTS %u", c.drawCalls, c.vertices);
+    Text(x, y, buf, kColorText); y += kLineHeight;
+    snprintf(buf, sizeof(buf), "STATE %u  PRG %u VAO %u UNI %u FIX %u", c.StateChanges(), c.programBinds, c.vaoBinds,
+        c.uniformSets, c.renderStates);
+    Text(x, y, buf, kColorText); y += kLineHeight;
+    snprintf(buf, sizeof(buf), "MEM %.1f MB  GPU BUF %.2f MB",
+        ProcessMemoryBytes() / (1024.0 * 1024.0), ProfilerGpuBytes() / (1024.0 * 1024.0));
+    Text(x, y, buf, kColorText); y += kLineHeight;
+    snprintf(buf, sizeof(buf), "SHADERS %u  FAIL %u  BUILD %.1f MS", ss.programsLinked, ss.failures, ss.buildMs);
+    Text(x, y, buf, kColorText); y += kLineHeight;
+    const PacingStats& ps = PacerStats();
+    snprintf(buf, sizeof(buf), "PACE %s %.0fHZ JIT %.2f LAT %.1f [F2]", PacingModeName(PacerMode()),
+        PacerTargetHz(), ps.jitterMs, ps.latencyMs);
+    Text(x, y, buf, kColorText); y += kLineHeight;
+    if (instances)
+    {
+        InstanceStats is = GetInstanceStats();
+        snprintf(buf, sizeof(buf), "INST %u/%u  FRAG %.0f%%  COMPACT %u %.2f MS", is.live, is.drawn,
+            is.fragmentation * 100.0f, is.compactions, is.compactGpuMs);
+        Text(x, y, buf, kColorText); y += kLineHeight;
+    }
+    if (world)
+    {
+        WorldStats ws = GetWorldStats();
+        snprintf(buf, sizeof(buf), "WORLD %u/%u  %.1f MB  Q %u  MISS %u  POP %u", ws.resident, ws.chunks,
+            ws.residentBytes / (1024.0 * 1024.0), ws.loading, ws.missingVisible, (unsigned)ws.popIns);
+        Text(x, y, buf, kColorText); y += kLineHeight;
+    }
+    snprintf(buf, sizeof(buf), "HUD CPU %.3f GPU %.3f MS  [F1]", Average(t.hudCpuMs), Average(t.hudGpuMs));
+    Text(x, y, buf, kColorText); y += kLineHeight;
+
+    // graphs share one axis, the line marks a 60 Hz frame budget
+    float targetY = y + kGraphHeight - 16.6f / kGraphMaxMs * kGraphHeight;
+    Quad(x, targetY, x + kProfilerHistory, targetY + 1, kColorTarget);
+    Graph(x, y, t.frameMs, t.head, kColorFrame);
+    Graph(x, y, t.cpuMs, t.head, kColorCpu);
+    Graph(x, y, t.gpuMs, t.head, kColorGpu);
+
+    size_t bytes = gHud.verts.size() * sizeof(HudVertex);
+    glBindBuffer(GL_ARRAY_BUFFER, gHud.vbo);
+    if (bytes > gHud.vboBytes)
+    {
+        ProfilerTrackGpuBytes((int64_t)(bytes * 2) - (int64_t)gHud.vboBytes);
+        gHud.vboBytes = bytes * 2;
+    }
+    // orphan then fill, the driver hands us fresh storage instead of syncing
+    glBufferData(GL_ARRAY_BUFFER, gHud.vboBytes, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, gHud.verts.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    BindPipeline(gHud.pipeline);
+    GfxUniform2f(gHud.locViewport, (float)framebufferWidth, (float)framebufferHeight);
+    GfxBindVertexArray(gHud.vao);
+    GfxDrawArrays(GL_TRIANGLES, 0, (GLsizei)gHud.verts.size());
+    GfxBindVertexArray(0);
+
+    ProfilerEndHud();
+}
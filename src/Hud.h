@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+
+// On-screen performance overlay: frame-time graphs, draw/state counters, memory and
+// shader stats. Everything is built on the CPU into one vertex buffer and drawn with a
+// single draw call using a built-in 3x5 bitmap font. The HUD's own CPU/GPU cost is
+// measured through ProfilerBeginHud/EndHud and shown on the last line.
+
+bool HudInit(std::string& errorOut);
+void HudShutdown();
+
+void HudToggle();
+bool HudIsVisible();
+
+// call after the scene is drawn and before ProfilerEndFrame()
+void HudDraw(int framebufferWidth, int framebufferHeight);
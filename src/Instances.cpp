@@ -0,0 +1,441 @@
+#include "Instances.h"
+#include "Caps.h"
+#include "DeferredDelete.h"
+#include "Gfx.h"
+#include "HandlePool.h"
+#include "Mesh.h"
+#include "Pipeline.h"
+#include "Shader.h"
+#include "Warmup.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace
+{
+    static_assert(sizeof(InstanceData) == 48, "InstanceData must match the std430 struct in the shaders");
+
+    const GLuint kInstanceBinding = 1;
+    const GLuint kMoveBinding = 2;
+    const uint32_t kInitialCapacity = 4096;
+    // compact once this share of the draw is holes, but not for a handful of them
+    const float kCompactFragmentation = 0.25f;
+    const uint32_t kCompactMinHoles = 256;
+
+    const char* instanceVertexSrc = R"(
+#version 430 core
+struct Instance
+{
+    float cx, cy, size, speed, amplitude, phase;
+    uint mode, reserved;
+    uint colors[3];
+    uint pad;
+};
+layout(std430, binding = 1) readonly buffer Instances { Instance instances[]; };
+
+uniform float time;
+uniform vec2 viewScale;
+// instance centers are float world coordinates, so they use the float camera center
+layout(std140, binding = 0) uniform Camera { vec4 cameraTransform; vec2 cameraCenter; };
+
+out vec3 vColor;
+flat out uint vMode;
+
+void main()
+{
+    Instance inst = instances[gl_InstanceID];
+    float a = 1.5707963 + float(gl_VertexID) * 2.0943951;
+    vec2 center = vec2(inst.cx, inst.cy);
+    vec2 pos = center + vec2(cos(a), sin(a)) * inst.size;
+
+    // same animation as the scene shader (see EvaluateObject)
+    float t = time * inst.speed + inst.phase;
+    if (inst.mode == 3u)
+        pos.x += sin(t) * inst.amplitude;
+    else if (inst.mode == 4u)
+    {
+        vec2 p = pos - center;
+        float s = sin(t);
+        float c = cos(t);
+        pos = vec2(c * p.x - s * p.y, s * p.x + c * p.y) + center;
+    }
+
+    vec2 view = mat2(cameraTransform.xy, cameraTransform.zw) * (pos - cameraCenter);
+    gl_Position = vec4(view * viewScale, 0.0, 1.0);
+    vColor = unpackUnorm4x8(inst.colors[gl_VertexID]).rgb;
+    vMode = inst.mode;
+}
+)";
+
+    const char* instanceFragmentSrc = R"(
+#version 430 core
+in vec3 vColor;
+flat in uint vMode;
+uniform highp float time;  // seconds since start, mediump would lose the pulse within minutes
+out vec4 FragColor;
+void main()
+{
+    vec3 color = vColor;
+    if (vMode == 2u)
+        color *= 0.25 + 0.75 * (0.5 + 0.5 * sin(time * 2.0));
+    FragColor = vec4(color, 1.0);
+}
+)";
+
+    // moves[i] = (from, to); sources are all at or past the new end and targets all
+    // before it, so no invocation reads a record another one writes
+    const char* compactSrc = R"(
+#version 430 core
+layout(local_size_x = 64) in;
+struct Instance
+{
+    float cx, cy, size, speed, amplitude, phase;
+    uint mode, reserved;
+    uint colors[3];
+    uint pad;
+};
+layout(std430, binding = 1) buffer Instances { Instance instances[]; };
+layout(std430, binding = 2) readonly buffer Moves { uvec2 moves[]; };
+uniform uint moveCount;
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= moveCount)
+        return;
+    uvec2 m = moves[i];
+    instances[m.y] = instances[m.x];
+}
+)";
+
+    struct InstanceRecord
+    {
+        uint32_t slot;
+    };
+
+    struct InstanceState
+    {
+        bool ready = false;
+        Shader program;
+        PipelineId pipeline = 0;
+        GLint locTime = -1;
+        GLint locViewScale = -1;
+        Shader compact;
+        GLint locMoveCount = -1;
+
+        GLuint buffer = 0;
+        GLuint moveBuffer = 0;
+        size_t moveCapacity = 0;        // in moves
+        uint32_t capacity = 0;
+
+        // CPU copy of every slot, the source of partial uploads
+        std::vector<InstanceData> shadow;
+        // indirection table: handle -> slot, and slot -> handle for compaction
+        HandlePool<InstanceRecord> handles;
+        std::vector<InstanceHandle> owner;
+        std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> freeSlots;
+        uint32_t extent = 0;            // slots handed out since the last compaction
+        uint32_t drawn = 0;             // highest live slot + 1
+        uint32_t dirtyBegin = UINT32_MAX;
+        uint32_t dirtyEnd = 0;
+
+        GLuint timeQuery = 0;
+        bool queryPending = false;
+        double cpuMsTotal = 0.0;
+        double gpuMsTotal = 0.0;
+        unsigned gpuSamples = 0;
+        InstanceStats stats;
+    } gInstances;
+
+    void MarkDirty(uint32_t slot)
+    {
+        InstanceState& s = gInstances;
+        s.dirtyBegin = std::min(s.dirtyBegin, slot);
+        s.dirtyEnd = std::max(s.dirtyEnd, slot + 1);
+    }
+
+    void Grow(uint32_t needed)
+    {
+        InstanceState& s = gInstances;
+        uint32_t capacity = s.capacity ? s.capacity : kInitialCapacity;
+        while (capacity < needed) capacity *= 2;
+        if (capacity == s.capacity)
+            return;
+
+        GLuint buffer = 0;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, (GLsizeiptr)capacity * sizeof(InstanceData), nullptr, GL_DYNAMIC_DRAW);
+        if (s.buffer)
+        {
+            // keep the GPU copy, it may hold compacted records the upload range does not cover
+            glBindBuffer(GL_COPY_READ_BUFFER, s.buffer);
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0,
+                (GLsizeiptr)s.capacity * sizeof(InstanceData));
+            glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            DeferDelete(DeferBuffer, s.buffer);
+        }
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        ProfilerTrackGpuBytes((int64_t)(capacity - s.capacity) * (int64_t)sizeof(InstanceData));
+        s.buffer = buffer;
+        s.capacity = capacity;
+        s.shadow.resize(capacity);
+        s.owner.resize(capacity, 0);
+    }
+
+    void PollCompactionTime()
+    {
+        InstanceState& s = gInstances;
+        if (!s.queryPending)
+            return;
+        GLint available = 0;
+        glGetQueryObjectiv(s.timeQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            return;
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(s.timeQuery, GL_QUERY_RESULT, &ns);
+        s.gpuMsTotal += ns * 1e-6;
+        s.gpuSamples++;
+        s.queryPending = false;
+    }
+
+    void Compact()
+    {
+        InstanceState& s = gInstances;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const uint32_t live = (uint32_t)s.handles.Size();
+
+        // pair every hole below the new end with a live record at or past it
+        std::vector<uint32_t> moves;
+        uint32_t from = s.drawn;
+        for (uint32_t to = 0; to < live; ++to)
+        {
+            if (s.owner[to]) continue;
+            do { --from; } while (!s.owner[from]);
+            moves.push_back(from);
+            moves.push_back(to);
+
+            InstanceHandle h = s.owner[from];
+            s.handles.Get(h)->slot = to;
+            s.owner[to] = h;
+            s.owner[from] = 0;
+            s.shadow[to] = s.shadow[from];
+            s.shadow[from] = InstanceData();
+        }
+
+        const uint32_t moveCount = (uint32_t)(moves.size() / 2);
+        if (moveCount)
+        {
+            if (moveCount > s.moveCapacity)
+            {
+                if (s.moveBuffer) DeferDelete(DeferBuffer, s.moveBuffer);
+                glGenBuffers(1, &s.moveBuffer);
+                s.moveCapacity = std::max<size_t>(moveCount, 1024);
+                glBindBuffer(GL_SHADER_STORAGE_BUFFER, s.moveBuffer);
+                glBufferData(GL_SHADER_STORAGE_BUFFER, s.moveCapacity * 8, nullptr, GL_STREAM_DRAW);
+            }
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, s.moveBuffer);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)moves.size() * sizeof(uint32_t), moves.data());
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+            bool timed = gGfxTimerQueries && !s.queryPending;
+            if (timed) glBeginQuery(GL_TIME_ELAPSED, s.timeQuery);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kInstanceBinding, s.buffer);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kMoveBinding, s.moveBuffer);
+            // raw bind: the next BindPipeline must not assume its program is still current
+            glUseProgram(s.compact.GetID());
+            glUniform1ui(s.locMoveCount, moveCount);
+            glDispatchCompute((moveCount + 63) / 64, 1, 1);
+            // the draws read the records as storage; uploads and the copy in Grow write
+            // the buffer through GL calls and must not overtake the compaction
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+            InvalidatePipelineState();
+            if (timed)
+            {
+                glEndQuery(GL_TIME_ELAPSED);
+                s.queryPending = true;
+            }
+        }
+
+        // everything past the end is free now and gets handed out in order again
+        s.freeSlots = decltype(s.freeSlots)();
+        s.extent = live;
+        s.drawn = live;
+        s.stats.compactions++;
+        s.stats.moved += moveCount;
+        s.cpuMsTotal += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+bool InstancesInit(std::string& errorOut)
+{
+    InstanceState& s = gInstances;
+    if (s.ready) return true;
+    if (GetGpuCaps().maxVertexStorageBlocks < 1)
+    {
+        errorOut = "instances are read from a storage buffer in the vertex stage, GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS is 0";
+        return false;
+    }
+    if (!s.program.CreateFromSource(instanceVertexSrc, instanceFragmentSrc, errorOut))
+        return false;
+    if (!s.compact.CreateComputeFromSource(compactSrc, errorOut))
+    {
+        s.program.Destroy();
+        return false;
+    }
+    s.locTime = glGetUniformLocation(s.program.GetID(), "time");
+    s.locViewScale = glGetUniformLocation(s.program.GetID(), "viewScale");
+    s.locMoveCount = glGetUniformLocation(s.compact.GetID(), "moveCount");
+
+    PipelineDesc desc;
+    desc.program = s.program.GetID();
+    s.pipeline = CreatePipeline(desc);
+    WarmupRegister("instances", s.pipeline, GL_TRIANGLES);
+
+    glGenQueries(1, &s.timeQuery);
+    Grow(kInitialCapacity);
+    s.ready = true;
+    return true;
+}
+
+void InstancesShutdown()
+{
+    InstanceState& s = gInstances;
+    if (!s.ready) return;
+    if (s.queryPending)
+    {
+        // the result is not needed, but the query must not be deleted mid-flight
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(s.timeQuery, GL_QUERY_RESULT, &ns);
+    }
+    glDeleteQueries(1, &s.timeQuery);
+    DeferDelete(DeferBuffer, s.buffer);
+    DeferDelete(DeferBuffer, s.moveBuffer);
+    ProfilerTrackGpuBytes(-(int64_t)s.capacity * (int64_t)sizeof(InstanceData));
+    WarmupUnregister(s.pipeline);
+    DestroyPipeline(s.pipeline);
+    s.program.Destroy();
+    s.compact.Destroy();
+    gInstances = InstanceState();
+}
+
+bool InstancesReady()
+{
+    return gInstances.ready;
+}
+
+InstanceHandle SpawnInstance(const InstanceData& data)
+{
+    InstanceState& s = gInstances;
+    if (!s.ready) return 0;
+
+    uint32_t slot;
+    if (!s.freeSlots.empty())
+    {
+        slot = s.freeSlots.top();
+        s.freeSlots.pop();
+    }
+    else
+    {
+        slot = s.extent++;
+        if (slot >= s.capacity)
+            Grow(slot + 1);
+    }
+    InstanceHandle h = s.handles.Create({ slot });
+    if (!h)
+    {
+        s.freeSlots.push(slot);
+        return 0;
+    }
+    s.owner[slot] = h;
+    s.shadow[slot] = data;
+    s.drawn = std::max(s.drawn, slot + 1);
+    MarkDirty(slot);
+    s.stats.spawned++;
+    return h;
+}
+
+void DespawnInstance(InstanceHandle h)
+{
+    InstanceState& s = gInstances;
+    InstanceRecord* r = s.handles.Get(h);
+    if (!r) return;
+    uint32_t slot = r->slot;
+    s.handles.Destroy(h);
+    s.owner[slot] = 0;
+    // zero size draws nothing until the slot is reused or compacted away
+    s.shadow[slot] = InstanceData();
+    MarkDirty(slot);
+    s.freeSlots.push(slot);
+    while (s.drawn > 0 && !s.owner[s.drawn - 1])
+        --s.drawn;
+    s.stats.despawned++;
+}
+
+InstanceData* EditInstance(InstanceHandle h)
+{
+    InstanceState& s = gInstances;
+    InstanceRecord* r = s.handles.Get(h);
+    if (!r) return nullptr;
+    MarkDirty(r->slot);
+    return &s.shadow[r->slot];
+}
+
+void ClearInstances()
+{
+    InstanceState& s = gInstances;
+    while (s.handles.Size())
+        DespawnInstance(s.handles.HandleAt(s.handles.Size() - 1));
+}
+
+void InstancesUpdate()
+{
+    InstanceState& s = gInstances;
+    if (!s.ready) return;
+    PollCompactionTime();
+
+    if (s.dirtyBegin < s.dirtyEnd)
+    {
+        // one contiguous range; scattered edits re-send the records in between, which
+        // is still far cheaper than a call per record
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, s.buffer);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, (GLintptr)s.dirtyBegin * sizeof(InstanceData),
+            (GLsizeiptr)(s.dirtyEnd - s.dirtyBegin) * sizeof(InstanceData), &s.shadow[s.dirtyBegin]);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        s.dirtyBegin = UINT32_MAX;
+        s.dirtyEnd = 0;
+    }
+
+    uint32_t holes = s.drawn - (uint32_t)s.handles.Size();
+    if (holes >= kCompactMinHoles && holes >= kCompactFragmentation * s.drawn)
+        Compact();
+}
+
+void DrawInstances(const float* viewScale, float time)
+{
+    InstanceState& s = gInstances;
+    if (!s.ready || s.drawn == 0) return;
+    BindPipeline(s.pipeline);
+    GfxUniform1f(s.locTime, time);
+    GfxUniform2f(s.locViewScale, viewScale[0], viewScale[1]);
+    GfxBindVertexArray(EmptyVertexArray());
+    GfxBindStorageBuffer(kInstanceBinding, s.buffer);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 3, (GLsizei)s.drawn);
+    gFrameCounters.drawCalls++;
+    gFrameCounters.vertices += 3 * s.drawn;
+    GfxBindVertexArray(0);
+}
+
+InstanceStats GetInstanceStats()
+{
+    const InstanceState& s = gInstances;
+    InstanceStats out = s.stats;
+    out.live = (unsigned)s.handles.Size();
+    out.drawn = s.drawn;
+    out.capacity = s.capacity;
+    out.fragmentation = s.drawn ? (float)(s.drawn - out.live) / (float)s.drawn : 0.0f;
+    out.compactCpuMs = out.compactions ? s.cpuMsTotal / out.compactions : 0.0;
+    out.compactGpuMs = s.gpuSamples ? s.gpuMsTotal / s.gpuSamples : 0.0;
+    return out;
+}
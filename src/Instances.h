@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Dynamic instances: small shapes spawned and despawned at runtime, all drawn with one
+// instanced draw from a storage buffer of fixed-size records. Freed slots go back to a
+// free list and the lowest one is reused first. Slots freed below the highest live
+// slot still cost a degenerate instance in the draw, so when they make up too much of
+// it a compute pass moves live records from the tail into the holes. Handles go
+// through an indirection table, so they stay valid across compaction.
+
+// one GPU record, std430 layout (12 words)
+struct InstanceData
+{
+    float center[2];
+    float size = 0.0f;      // circumradius in NDC; 0 for a free slot
+    float speed = 1.0f;
+    float amplitude = 0.0f;
+    float phase = 0.0f;
+    uint32_t mode = 0;      // SceneMode
+    uint32_t reserved = 0;
+    uint32_t colors[3];     // RGBA8 per vertex, same packing as DebugColor
+    uint32_t pad = 0;
+};
+
+// 0 is never a live instance
+typedef uint32_t InstanceHandle;
+
+struct InstanceStats
+{
+    unsigned live = 0;
+    unsigned drawn = 0;             // slots covered by the draw (highest live slot + 1)
+    unsigned capacity = 0;
+    float fragmentation = 0.0f;     // share of drawn slots that are free
+    uint64_t spawned = 0;
+    uint64_t despawned = 0;
+    unsigned compactions = 0;
+    uint64_t moved = 0;             // records moved by all compactions
+    double compactCpuMs = 0.0;      // mean per compaction, planning + dispatch
+    double compactGpuMs = 0.0;      // mean per compaction, compute pass on the GPU
+};
+
+bool InstancesInit(std::string& errorOut);
+void InstancesShutdown();
+bool InstancesReady();
+
+// returns 0 when not initialized
+InstanceHandle SpawnInstance(const InstanceData& data);
+// stale handles are ignored
+void DespawnInstance(InstanceHandle h);
+// the record to modify in place; uploaded before the next draw. nullptr for stale handles
+InstanceData* EditInstance(InstanceHandle h);
+void ClearInstances();
+
+// uploads edits and compacts when needed; once per frame on the primary context,
+// before the first DrawInstances
+void InstancesUpdate();
+void DrawInstances(const float* viewScale, float time);
+
+InstanceStats GetInstanceStats();
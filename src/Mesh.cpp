@@ -0,0 +1,229 @@
+#include "Mesh.h"
+#include "Capture.h"
+#include "DeferredDelete.h"
+#include "Gfx.h"
+#include "HandlePool.h"
+#include "Profiler.h"
+#include "VertexFormat.h"
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace
+{
+    // GL objects of one mesh; vao is 0 for packed meshes
+    struct MeshRecord
+    {
+        GLuint vao = 0;
+        GLuint vbo = 0;
+        size_t bytes = 0;
+    };
+
+    HandlePool<MeshRecord> gMeshes;
+    size_t gMeshBytes = 0;
+
+    struct ContextVertexArrays
+    {
+        std::unordered_map<GLuint, GLuint> byVbo;   // shared vbo -> this context's vao
+        std::vector<GLuint> orphaned;               // to delete when the context is current
+        GLuint empty = 0;                           // EmptyVertexArray()
+    };
+
+    // indexed by gGfxContextIndex, slot 0 only holds the primary's empty VAO
+    // (its mesh VAOs are MeshRecord::vao)
+    std::vector<ContextVertexArrays> gContextVaos;
+
+    void SetupLayout()
+    {
+        ApplyVertexFormat(MeshVertexFormat());
+    }
+
+    MeshHandle AddMesh(const MeshRecord& m)
+    {
+        MeshHandle h;
+        h.id = gMeshes.Create(m);
+        if (!h.id)
+        {
+            // pool exhausted: nothing refers to the objects yet, drop them right away
+            ProfilerTrackGpuBytes(-(int64_t)m.bytes);
+            if (m.vao) glDeleteVertexArrays(1, &m.vao);
+            if (m.vbo) glDeleteBuffers(1, &m.vbo);
+            return h;
+        }
+        gMeshBytes += m.bytes;
+        return h;
+    }
+
+    inline uint32_t PackSnorm16(float v)
+    {
+        v = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+        return (uint32_t)(int32_t)lroundf(v * 32767.0f) & 0xffff;
+    }
+
+    inline uint32_t PackUnorm8(float v)
+    {
+        v = v < 0.0f ? 0.0f : (v > 1.0f ? 1.0f : v);
+        return (uint32_t)(v * 255.0f + 0.5f);
+    }
+}
+
+MeshHandle CreateTriangle(const std::vector<float>& interleavedData)
+{
+    return CreateTriangle(interleavedData.data(), interleavedData.size());
+}
+
+MeshHandle CreateTriangle(const float* interleavedData, size_t floatCount)
+{
+    MeshRecord m;
+    glGenVertexArrays(1, &m.vao);
+    glGenBuffers(1, &m.vbo);
+
+    glBindVertexArray(m.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m.vbo);
+    m.bytes = floatCount * sizeof(float);
+    glBufferData(GL_ARRAY_BUFFER, m.bytes, interleavedData, GL_STATIC_DRAW);
+    ProfilerTrackGpuBytes((int64_t)m.bytes);
+
+    SetupLayout();
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    if (gCaptureActive)
+        CaptureCreateMesh(m.vao, interleavedData, floatCount);
+    return AddMesh(m);
+}
+
+MeshHandle CreatePackedTriangle(const float* interleavedData, size_t floatCount)
+{
+    size_t vertexCount = floatCount / 5;
+    std::vector<uint32_t> packed(vertexCount * 2);
+    for (size_t i = 0; i < vertexCount; ++i)
+    {
+        const float* v = interleavedData + i * 5;
+        // positions leave [-1,1] when objects sit near the edge, hence the halving
+        packed[i * 2] = PackSnorm16(v[0] * 0.5f) | (PackSnorm16(v[1] * 0.5f) << 16);
+        packed[i * 2 + 1] = PackUnorm8(v[2]) | (PackUnorm8(v[3]) << 8) | (PackUnorm8(v[4]) << 16) | 0xff000000u;
+    }
+
+    MeshRecord m;
+    glGenBuffers(1, &m.vbo);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m.vbo);
+    m.bytes = packed.size() * sizeof(uint32_t);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, m.bytes, packed.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    ProfilerTrackGpuBytes((int64_t)m.bytes);
+    return AddMesh(m);
+}
+
+void DestroyTriangle(MeshHandle& h)
+{
+    uint32_t id = h.id;
+    h.id = 0;
+    MeshRecord* m = gMeshes.Get(id);
+    if (!m)
+        return;
+    if (gCaptureActive && m->vao)
+        CaptureDestroyMesh(m->vao);
+    for (ContextVertexArrays& ctx : gContextVaos)
+    {
+        auto it = ctx.byVbo.find(m->vbo);
+        if (it == ctx.byVbo.end()) continue;
+        ctx.orphaned.push_back(it->second);
+        ctx.byVbo.erase(it);
+    }
+    ProfilerTrackGpuBytes(-(int64_t)m->bytes);
+    gMeshBytes -= m->bytes;
+    // earlier frames may still be drawing it
+    DeferDelete(DeferVertexArray, m->vao);
+    DeferDelete(DeferBuffer, m->vbo);
+    gMeshes.Destroy(id);
+}
+
+bool MeshIsAlive(MeshHandle h)
+{
+    return gMeshes.Get(h.id) != nullptr;
+}
+
+void UpdateTriangle(MeshHandle h, const float* interleavedData, size_t floatCount)
+{
+    const MeshRecord* m = gMeshes.Get(h.id);
+    size_t bytes = floatCount * sizeof(float);
+    if (!m || !m->vbo || bytes > m->bytes) return;
+    glBindBuffer(GL_ARRAY_BUFFER, m->vbo);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr)bytes, interleavedData);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+GLuint MeshBuffer(MeshHandle h)
+{
+    const MeshRecord* m = gMeshes.Get(h.id);
+    return m ? m->vbo : 0;
+}
+
+size_t MeshBytes(MeshHandle h)
+{
+    const MeshRecord* m = gMeshes.Get(h.id);
+    return m ? m->bytes : 0;
+}
+
+MeshPoolStats GetMeshPoolStats()
+{
+    MeshPoolStats s;
+    s.live = (unsigned)gMeshes.Size();
+    s.slots = (unsigned)gMeshes.SlotCount();
+    s.bytes = gMeshBytes;
+    return s;
+}
+
+GLuint MeshVertexArray(MeshHandle h)
+{
+    const MeshRecord* m = gMeshes.Get(h.id);
+    if (!m)
+        return 0;
+    if (gGfxContextIndex == 0 || !m->vbo)
+        return m->vao;
+    if ((int)gContextVaos.size() <= gGfxContextIndex)
+        gContextVaos.resize(gGfxContextIndex + 1);
+
+    ContextVertexArrays& ctx = gContextVaos[gGfxContextIndex];
+    auto it = ctx.byVbo.find(m->vbo);
+    if (it != ctx.byVbo.end())
+        return it->second;
+
+    GLuint vao = 0;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m->vbo);
+    SetupLayout();
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+    ctx.byVbo[m->vbo] = vao;
+    return vao;
+}
+
+GLuint EmptyVertexArray()
+{
+    if ((int)gContextVaos.size() <= gGfxContextIndex)
+        gContextVaos.resize(gGfxContextIndex + 1);
+    ContextVertexArrays& ctx = gContextVaos[gGfxContextIndex];
+    if (!ctx.empty)
+        glGenVertexArrays(1, &ctx.empty);
+    return ctx.empty;
+}
+
+void CollectContextVertexArrays()
+{
+    if (gGfxContextIndex == 0 || (int)gContextVaos.size() <= gGfxContextIndex)
+        return;
+    std::vector<GLuint>& orphaned = gContextVaos[gGfxContextIndex].orphaned;
+    if (!orphaned.empty())
+        glDeleteVertexArrays((GLsizei)orphaned.size(), orphaned.data());
+    orphaned.clear();
+}
+
+void ForgetContextVertexArrays(int contextIndex)
+{
+    if (contextIndex > 0 && contextIndex < (int)gContextVaos.size())
+        gContextVaos[contextIndex] = ContextVertexArrays();
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Meshes live in a HandlePool. A MeshHandle copied around the scene is only a 32-bit
+// index + generation, so a stale copy of a destroyed mesh fails every lookup instead
+// of deleting or drawing whatever reused its slot. The GL objects of a destroyed mesh
+// are released through DeferredDelete once the frames that may still draw it are done.
+struct MeshHandle
+{
+    uint32_t id = 0;    // 0 is never a live mesh
+};
+
+// interleaved pos.x, pos.y, r, g, b per vertex; any multiple of 3 vertices works
+MeshHandle CreateTriangle(const std::vector<float>& interleavedData);
+MeshHandle CreateTriangle(const float* interleavedData, size_t floatCount);
+// for vertex pulling: 8 bytes per vertex, position as snorm16x2 over [-2,2] and color
+// as unorm8x4 (alpha 1). Has no VAO and is not recorded by captures.
+MeshHandle CreatePackedTriangle(const float* interleavedData, size_t floatCount);
+// resets h; stale and empty handles are ignored
+void DestroyTriangle(MeshHandle& h);
+bool MeshIsAlive(MeshHandle h);
+// overwrite vertex data in place (at most the mesh's size); not recorded by captures
+void UpdateTriangle(MeshHandle h, const float* interleavedData, size_t floatCount);
+// the mesh's vertex buffer, what the pulled path binds as a storage buffer
+GLuint MeshBuffer(MeshHandle h);
+// size of that buffer on the GPU, 0 for stale handles
+size_t MeshBytes(MeshHandle h);
+
+struct MeshPoolStats
+{
+    unsigned live = 0;
+    unsigned slots = 0;     // high-water mark of the pool
+    size_t bytes = 0;       // vertex data of live meshes
+};
+MeshPoolStats GetMeshPoolStats();
+
+// VAOs are per-context; secondary windows get their own VAO over the shared VBO,
+// created on first use. Returns 0 for stale handles.
+GLuint MeshVertexArray(MeshHandle h);
+// a VAO without attributes for the current context, for draws that fetch their
+// vertices from storage buffers
+GLuint EmptyVertexArray();
+// deletes VAOs of destroyed meshes that belong to the current (secondary) context
+void CollectContextVertexArrays();
+// drop the table of a context that was destroyed (its VAOs died with it)
+void ForgetContextVertexArrays(int contextIndex);
@@ -0,0 +1,249 @@
+#include "MicroBench.h"
+#include "Benchmark.h"
+#include "DeferredDelete.h"
+#include "Gfx.h"
+#include "Scene.h"
+#include "Window.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // what one iteration of a case processes, for throughput columns
+    struct MicroResult
+    {
+        double bytesPerIter = 0.0;
+        double itemsPerIter = 1.0;
+    };
+
+    // runs `iterations` iterations and returns what one iteration processed
+    typedef MicroResult (*MicroFn)(long long iterations, void* arg);
+
+    struct MicroCase
+    {
+        std::string name;
+        MicroFn fn;
+        void* arg;
+    };
+
+    // fixtures shared by the cases, created once per run
+    struct MicroFixture
+    {
+        SceneProgram program;
+        MeshHandle vaoA;
+        MeshHandle vaoB;
+        GLuint buffer = 0;
+        std::vector<char> uploadData;
+    } gMicro;
+
+    // results of pure lookups land here so the calls cannot be dropped
+    volatile GLint gMicroSink = 0;
+
+    const float kTriangle[15] = {
+        -0.5f, -0.5f, 1.0f, 0.0f, 0.0f,
+         0.5f, -0.5f, 0.0f, 1.0f, 0.0f,
+         0.0f,  0.5f, 0.0f, 0.0f, 1.0f,
+    };
+
+    MicroResult BufferUpload(long long iterations, void* arg)
+    {
+        size_t size = (size_t)(uintptr_t)arg;
+        glBindBuffer(GL_ARRAY_BUFFER, gMicro.buffer);
+        glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+        for (long long i = 0; i < iterations; ++i)
+        {
+            // orphan + fill, the pattern the streamed buffers use
+            glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, size, gMicro.uploadData.data());
+        }
+        glFinish(); // the copy is only done once the driver consumed it
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        MicroResult r;
+        r.bytesPerIter = (double)size;
+        return r;
+    }
+
+    MicroResult CreateDestroyTriangle(long long iterations, void*)
+    {
+        for (long long i = 0; i < iterations; ++i)
+        {
+            MeshHandle h = CreateTriangle(kTriangle, 15);
+            DestroyTriangle(h);
+        }
+        // the GL objects are only queued by DestroyTriangle, count their deletion too
+        DeferredDeleteFlush();
+        MicroResult r;
+        r.bytesPerIter = sizeof(kTriangle);
+        return r;
+    }
+
+    MicroResult ShaderBuild(long long iterations, void*)
+    {
+        std::string err;
+        for (long long i = 0; i < iterations; ++i)
+        {
+            Shader s;
+            s.CreateFromSource(SceneVertexSource(), SceneFragmentSource(), err);
+            s.Destroy();
+        }
+        glFinish();
+        return MicroResult();
+    }
+
+    MicroResult UniformLookup(long long iterations, void*)
+    {
+        static const char* names[] = { "mode", "time", "offset", "angle", "center" };
+        GLuint id = gMicro.program.shader.GetID();
+        GLint sink = 0;
+        for (long long i = 0; i < iterations; ++i)
+            sink += glGetUniformLocation(id, names[i % 5]);
+        gMicroSink = sink;
+        return MicroResult();
+    }
+
+    MicroResult UniformSet(long long iterations, void*)
+    {
+        gMicro.program.shader.Use();
+        for (long long i = 0; i < iterations; ++i)
+            glUniform1f(gMicro.program.locTime, (float)i);
+        glFinish();
+        return MicroResult();
+    }
+
+    MicroResult VaoBind(long long iterations, void*)
+    {
+        for (long long i = 0; i < iterations; ++i)
+            glBindVertexArray(i & 1 ? MeshVertexArray(gMicro.vaoB) : MeshVertexArray(gMicro.vaoA));
+        glBindVertexArray(0);
+        return MicroResult();
+    }
+
+    MicroResult DrawSubmit(long long iterations, void* arg)
+    {
+        // arg: 0 = same state every call, 1 = rebinding the VAO and mode per call like DrawScene
+        bool stateChange = arg != nullptr;
+        gMicro.program.shader.Use();
+        glUniform1i(gMicro.program.locMode, 0);
+        glBindVertexArray(MeshVertexArray(gMicro.vaoA));
+        for (long long i = 0; i < iterations; ++i)
+        {
+            if (stateChange)
+            {
+                glUniform1i(gMicro.program.locMode, (GLint)(i % 3));
+                glBindVertexArray(i & 1 ? MeshVertexArray(gMicro.vaoB) : MeshVertexArray(gMicro.vaoA));
+            }
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+        }
+        glBindVertexArray(0);
+        // drain inside the timing, so a batch's draws cannot spill into the next batch
+        glFinish();
+        return MicroResult();
+    }
+
+    double RunBatch(const MicroCase& c, long long iterations, MicroResult& result)
+    {
+        Clock::time_point start = Clock::now();
+        result = c.fn(iterations, c.arg);
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void FormatRate(char* buf, size_t size, double perSec, const char* unit)
+    {
+        const char* prefix[] = { "", "k", "M", "G", "T" };
+        int p = 0;
+        while (perSec >= 1000.0 && p < 4) { perSec /= 1000.0; ++p; }
+        snprintf(buf, size, "%.2f %s%s/s", perSec, prefix[p], unit);
+    }
+}
+
+int RunMicroBenchmarks(const MicroBenchOptions& options)
+{
+    if (!CreateWindow(64, 64, "Microbenchmarks", false))
+        return -1;
+    SetSwapInterval(0);
+
+    std::string err;
+    CameraInit();
+    if (!CreateSceneProgram(gMicro.program, err))
+    {
+        fprintf(stderr, "microbench: scene shader failed:\n%s\n", err.c_str());
+        CameraShutdown();
+        DestroyWindow();
+        return -1;
+    }
+    gMicro.vaoA = CreateTriangle(kTriangle, 15);
+    gMicro.vaoB = CreateTriangle(kTriangle, 15);
+    glGenBuffers(1, &gMicro.buffer);
+    gMicro.uploadData.assign(16 << 20, 0x5a);
+
+    std::vector<MicroCase> cases;
+    const size_t uploadSizes[] = { 1 << 10, 64 << 10, 1 << 20, 16 << 20 };
+    for (size_t size : uploadSizes)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "BufferUpload/%zuKB", size >> 10);
+        cases.push_back({ name, BufferUpload, (void*)(uintptr_t)size });
+    }
+    cases.push_back({ "CreateDestroyTriangle", CreateDestroyTriangle, nullptr });
+    cases.push_back({ "ShaderBuild", ShaderBuild, nullptr });
+    cases.push_back({ "UniformLookup", UniformLookup, nullptr });
+    cases.push_back({ "UniformSet", UniformSet, nullptr });
+    cases.push_back({ "VaoBind", VaoBind, nullptr });
+    cases.push_back({ "DrawSubmit/SameState", DrawSubmit, nullptr });
+    cases.push_back({ "DrawSubmit/StateChange", DrawSubmit, (void*)1 });
+
+    printf("microbench: %s / %s\n", (const char*)glGetString(GL_RENDERER), (const char*)glGetString(GL_VERSION));
+    printf("%-26s %14s %12s %16s\n", "case", "ns/iter", "iterations", "throughput");
+
+    std::vector<BenchCase> results;
+    for (const MicroCase& c : cases)
+    {
+        if (options.filter && !strstr(c.name.c_str(), options.filter))
+            continue;
+
+        // calibrate like Google Benchmark: grow until one batch is long enough to time
+        MicroResult result;
+        long long iterations = 1;
+        double elapsed = RunBatch(c, iterations, result);
+        while (elapsed < options.minTimeSec && iterations < (1LL << 40))
+        {
+            double scale = elapsed > 0.0 ? options.minTimeSec / elapsed * 1.4 : 10.0;
+            iterations = std::max(iterations + 1, (long long)(iterations * std::min(scale, 10.0)));
+            elapsed = RunBatch(c, iterations, result);
+        }
+
+        BenchCase bc;
+        bc.name = c.name;
+        bc.unit = "ns";
+        for (int rep = 0; rep < options.repetitions; ++rep)
+            bc.samples.push_back(RunBatch(c, iterations, result) * 1.0e9 / (double)iterations);
+
+        std::vector<double> sorted = bc.samples;
+        std::sort(sorted.begin(), sorted.end());
+        double ns = sorted[sorted.size() / 2];
+
+        char rate[64];
+        if (result.bytesPerIter > 0.0) FormatRate(rate, sizeof(rate), result.bytesPerIter * 1.0e9 / ns, "B");
+        else FormatRate(rate, sizeof(rate), result.itemsPerIter * 1.0e9 / ns, "op");
+        printf("%-26s %14.1f %12lld %16s\n", c.name.c_str(), ns, iterations, rate);
+        results.push_back(bc);
+    }
+
+    if (options.outputPath && !WriteBenchJson(options.outputPath, results))
+        fprintf(stderr, "microbench: cannot write %s\n", options.outputPath);
+
+    glDeleteBuffers(1, &gMicro.buffer);
+    DestroyTriangle(gMicro.vaoA);
+    DestroyTriangle(gMicro.vaoB);
+    DestroySceneProgram(gMicro.program);
+    CameraShutdown();
+    gMicro.uploadData.clear();
+    DeferredDeleteFlush();
+    DestroyWindow();
+    return 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+struct MicroBenchOptions
+{
+    // each case grows its iteration count until a batch takes this long, aiming 1.4x past
+    // it from the last batch's time and by at most 10x per step
+    double minTimeSec = 0.2;
+    int repetitions = 5;            // measured batches, each one sample in the JSON output
+    const char* filter = nullptr;   // only cases whose name contains this
+    const char* outputPath = nullptr;
+};
+
+// CPU-side microbenchmarks of the renderer's hot paths (buffer upload, CreateTriangle,
+// shader build, uniform lookup/set, VAO bind, draw submission) against a hidden window.
+// Modeled on Google Benchmark's auto-calibrated loops; prints ns/iteration and
+// throughput and optionally writes the samples in the --bench JSON format.
+int RunMicroBenchmarks(const MicroBenchOptions& options);
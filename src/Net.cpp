@@ -0,0 +1,325 @@
+#include "Net.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+typedef int socklen_t;
+typedef SOCKET RawSocket;
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cerrno>
+typedef int RawSocket;
+#endif
+
+namespace
+{
+    void CloseRaw(NetSocket s)
+    {
+#ifdef _WIN32
+        closesocket((SOCKET)s);
+#else
+        close((int)s);
+#endif
+    }
+
+    // splits "tcp:host:port"; false for anything else
+    bool ParseTcp(const char* address, std::string& host, std::string& port)
+    {
+        if (strncmp(address, "tcp:", 4) != 0) return false;
+        const char* rest = address + 4;
+        const char* colon = strrchr(rest, ':');
+        if (!colon) return false;
+        host.assign(rest, colon - rest);
+        port.assign(colon + 1);
+        if (host.empty()) host = "127.0.0.1";
+        return true;
+    }
+
+    void SetNoDelay(NetSocket s)
+    {
+        int one = 1;
+        setsockopt((RawSocket)s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+    }
+}
+
+bool NetInit()
+{
+#ifdef _WIN32
+    WSADATA data;
+    return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+#else
+    // a peer going away must show up as a send error, not kill the process
+    signal(SIGPIPE, SIG_IGN);
+    return true;
+#endif
+}
+
+void NetShutdown()
+{
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+const char* NetDefaultLocalTransport()
+{
+#ifdef _WIN32
+    return "tcp";
+#else
+    return "unix";
+#endif
+}
+
+NetSocket NetListen(const char* address, std::string& boundAddress)
+{
+    std::string host, port;
+#ifndef _WIN32
+    if (!strncmp(address, "unix:", 5))
+    {
+        const char* path = address + 5;
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(path) >= sizeof(addr.sun_path)) return kInvalidSocket;
+        strcpy(addr.sun_path, path);
+        unlink(path);
+
+        int s = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (s < 0) return kInvalidSocket;
+        if (bind(s, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, 64) != 0)
+        {
+            close(s);
+            return kInvalidSocket;
+        }
+        boundAddress = address;
+        return s;
+    }
+#endif
+    if (!ParseTcp(address, host, port))
+        return kInvalidSocket;
+
+    // resolved the same way NetConnect does, so both accept host names
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0 || !result)
+        return kInvalidSocket;
+
+    NetSocket found = kInvalidSocket;
+    for (addrinfo* ai = result; ai; ai = ai->ai_next)
+    {
+        auto s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if ((NetSocket)s == kInvalidSocket) continue;
+        int one = 1;
+        setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one));
+        if (bind(s, ai->ai_addr, (socklen_t)ai->ai_addrlen) == 0 && listen(s, 64) == 0)
+        {
+            found = (NetSocket)s;
+            break;
+        }
+        CloseRaw((NetSocket)s);
+    }
+    freeaddrinfo(result);
+    if (found == kInvalidSocket)
+        return kInvalidSocket;
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    RawSocket s = (RawSocket)found;
+    socklen_t len = sizeof(addr);
+    getsockname(s, (sockaddr*)&addr, &len);
+    boundAddress = "tcp:" + host + ":" + std::to_string((unsigned)ntohs(addr.sin_port));
+    return found;
+}
+
+NetSocket NetAccept(NetSocket listener)
+{
+    auto s = accept((RawSocket)listener, nullptr, nullptr);
+    if ((NetSocket)s == kInvalidSocket) return kInvalidSocket;
+    SetNoDelay((NetSocket)s);
+    return (NetSocket)s;
+}
+
+NetSocket NetConnect(const char* address)
+{
+    std::string host, port;
+#ifndef _WIN32
+    if (!strncmp(address, "unix:", 5))
+    {
+        sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (strlen(address + 5) >= sizeof(addr.sun_path)) return kInvalidSocket;
+        strcpy(addr.sun_path, address + 5);
+        int s = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (s < 0) return kInvalidSocket;
+        if (connect(s, (sockaddr*)&addr, sizeof(addr)) != 0)
+        {
+            close(s);
+            return kInvalidSocket;
+        }
+        return s;
+    }
+#endif
+    if (!ParseTcp(address, host, port))
+        return kInvalidSocket;
+
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0 || !result)
+        return kInvalidSocket;
+
+    NetSocket found = kInvalidSocket;
+    for (addrinfo* ai = result; ai; ai = ai->ai_next)
+    {
+        auto s = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if ((NetSocket)s == kInvalidSocket) continue;
+        if (connect(s, ai->ai_addr, (socklen_t)ai->ai_addrlen) == 0)
+        {
+            found = (NetSocket)s;
+            break;
+        }
+        CloseRaw((NetSocket)s);
+    }
+    freeaddrinfo(result);
+    if (found != kInvalidSocket)
+        SetNoDelay(found);
+    return found;
+}
+
+void NetClose(NetSocket socket)
+{
+    if (socket != kInvalidSocket)
+        CloseRaw(socket);
+}
+
+bool NetSendAll(NetSocket s, const void* data, size_t size)
+{
+    const char* p = (const char*)data;
+    while (size > 0)
+    {
+        int chunk = size > (1u << 30) ? (1 << 30) : (int)size;
+#ifdef _WIN32
+        int n = send((SOCKET)s, p, chunk, 0);
+#else
+        ssize_t n = send((int)s, p, (size_t)chunk, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n <= 0) return false;
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+bool NetRecvAll(NetSocket s, void* data, size_t size)
+{
+    char* p = (char*)data;
+    while (size > 0)
+    {
+        int chunk = size > (1u << 30) ? (1 << 30) : (int)size;
+#ifdef _WIN32
+        int n = recv((SOCKET)s, p, chunk, 0);
+#else
+        ssize_t n = recv((int)s, p, (size_t)chunk, 0);
+        if (n < 0 && errno == EINTR) continue;
+#endif
+        if (n <= 0) return false;
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+bool NetPoll(NetSocket s, int timeoutMs)
+{
+#ifdef _WIN32
+    WSAPOLLFD pfd;
+    pfd.fd = (SOCKET)s;
+    pfd.events = POLLRDNORM;
+    pfd.revents = 0;
+    return WSAPoll(&pfd, 1, timeoutMs) > 0;
+#else
+    pollfd pfd;
+    pfd.fd = (int)s;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    return poll(&pfd, 1, timeoutMs) > 0;
+#endif
+}
+
+void NetSetNonBlocking(NetSocket s, bool nonBlocking)
+{
+#ifdef _WIN32
+    u_long mode = nonBlocking ? 1 : 0;
+    ioctlsocket((SOCKET)s, FIONBIO, &mode);
+#else
+    int flags = fcntl((int)s, F_GETFL, 0);
+    fcntl((int)s, F_SETFL, nonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+#endif
+}
+
+long long NetSendSome(NetSocket s, const void* data, size_t size)
+{
+    int chunk = size > (1u << 30) ? (1 << 30) : (int)size;
+#ifdef _WIN32
+    int n = send((SOCKET)s, (const char*)data, chunk, 0);
+    if (n < 0) return WSAGetLastError() == WSAEWOULDBLOCK ? 0 : -1;
+#else
+    ssize_t n = send((int)s, data, (size_t)chunk, MSG_NOSIGNAL);
+    if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+#endif
+    return n;
+}
+
+long long NetRecvSome(NetSocket s, void* data, size_t size)
+{
+    int chunk = size > (1u << 30) ? (1 << 30) : (int)size;
+#ifdef _WIN32
+    int n = recv((SOCKET)s, (char*)data, chunk, 0);
+    if (n < 0) return WSAGetLastError() == WSAEWOULDBLOCK ? 0 : -1;
+#else
+    ssize_t n = recv((int)s, data, (size_t)chunk, 0);
+    if (n < 0) return (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+#endif
+    return n == 0 ? -1 : n;
+}
+
+bool NetSendMessage(NetSocket socket, uint32_t type, const void* payload, uint32_t size)
+{
+    uint32_t header[2] = { type, size };
+    return NetSendAll(socket, header, sizeof(header)) && (size == 0 || NetSendAll(socket, payload, size));
+}
+
+bool NetRecvMessage(NetSocket socket, uint32_t& type, std::string& payload, size_t maxBytes)
+{
+    uint32_t header[2];
+    if (!NetRecvAll(socket, header, sizeof(header)))
+        return false;
+    type = header[0];
+    if (header[1] > maxBytes)
+        return false;
+    payload.resize(header[1]);
+    return header[1] == 0 || NetRecvAll(socket, &payload[0], header[1]);
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Minimal blocking stream sockets for the local multi-process tools.
+// Addresses are "unix:/path/to/socket" (POSIX only) or "tcp:host:port"; listening on
+// port 0 picks a free port and the bound address is returned so it can be handed to
+// the peer process.
+
+typedef intptr_t NetSocket;
+static const NetSocket kInvalidSocket = -1;
+
+bool NetInit();
+void NetShutdown();
+
+NetSocket NetListen(const char* address, std::string& boundAddress);
+NetSocket NetAccept(NetSocket listener);
+NetSocket NetConnect(const char* address);
+void NetClose(NetSocket socket);
+
+// loop until everything was transferred; false on error or closed connection
+bool NetSendAll(NetSocket socket, const void* data, size_t size);
+bool NetRecvAll(NetSocket socket, void* data, size_t size);
+
+// true if a recv would not block (data or EOF pending), waits up to timeoutMs
+bool NetPoll(NetSocket socket, int timeoutMs);
+void NetSetNonBlocking(NetSocket socket, bool nonBlocking);
+// send / receive as much as possible without blocking on a non-blocking socket;
+// returns the bytes transferred (0 if it would block), -1 on error or closed connection
+long long NetSendSome(NetSocket socket, const void* data, size_t size);
+long long NetRecvSome(NetSocket socket, void* data, size_t size);
+
+// length-prefixed messages: u32 type, u32 size, payload. The receive fails on a
+// payload larger than maxBytes instead of allocating what the peer announced.
+bool NetSendMessage(NetSocket socket, uint32_t type, const void* payload, uint32_t size);
+bool NetRecvMessage(NetSocket socket, uint32_t& type, std::string& payload, size_t maxBytes);
+
+// platform default for local IPC: unix sockets where available, loopback TCP otherwise
+const char* NetDefaultLocalTransport();
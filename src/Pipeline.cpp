@@ -0,0 +1,292 @@
+#include "Pipeline.h"
+#include "Gfx.h"
+#include "Shader.h"
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    struct PipelineRecord
+    {
+        PipelineDesc desc;
+        uint64_t hash = 0;
+        unsigned refs = 0;
+    };
+
+    // what one context currently has applied
+    struct ContextPipelineState
+    {
+        bool known = false;
+        PipelineId bound = 0;
+        PipelineDesc applied;
+    };
+
+    struct PipelineRegistry
+    {
+        std::vector<PipelineRecord> records;    // id - 1
+        std::vector<PipelineId> freeIds;
+        std::unordered_multimap<uint64_t, PipelineId> byHash;
+        std::vector<ContextPipelineState> contexts;     // indexed by gGfxContextIndex
+        PipelineStats stats;
+    } gPipelines;
+
+    inline uint64_t HashValue(uint64_t h, uint32_t v)
+    {
+        return HashBytes(h, &v, sizeof(v));
+    }
+
+    ContextPipelineState& CurrentContext()
+    {
+        if ((int)gPipelines.contexts.size() <= gGfxContextIndex)
+            gPipelines.contexts.resize(gGfxContextIndex + 1);
+        return gPipelines.contexts[gGfxContextIndex];
+    }
+
+    inline void SetCapability(GLenum cap, bool enabled)
+    {
+        if (enabled) glEnable(cap);
+        else glDisable(cap);
+        gFrameCounters.renderStates++;
+    }
+
+    // false for BlendOpaque
+    bool BlendFactors(BlendMode mode, GLenum& src, GLenum& dst)
+    {
+        switch (mode)
+        {
+        case BlendAlpha: src = GL_SRC_ALPHA; dst = GL_ONE_MINUS_SRC_ALPHA; return true;
+        case BlendPremultiplied: src = GL_ONE; dst = GL_ONE_MINUS_SRC_ALPHA; return true;
+        case BlendAdditive: src = GL_SRC_ALPHA; dst = GL_ONE; return true;
+        default: src = GL_ONE; dst = GL_ZERO; return false;
+        }
+    }
+
+    void ApplyBlendFunc(BlendMode mode)
+    {
+        GLenum src, dst;
+        if (!BlendFactors(mode, src, dst)) return;
+        glBlendFunc(src, dst);
+        gFrameCounters.renderStates++;
+    }
+
+    // prev is null when nothing is known about the context
+    void ApplyDiff(const PipelineDesc* prev, const PipelineDesc& d)
+    {
+        if (!prev || prev->program != d.program)
+            GfxUseProgram(d.program);
+
+        bool blend = d.blend != BlendOpaque;
+        bool blendChanged = !prev || prev->blend != d.blend;
+        if (!prev || (prev->blend != BlendOpaque) != blend)
+            SetCapability(GL_BLEND, blend);
+        // the function is left alone while blending is off
+        if (blend && blendChanged)
+            ApplyBlendFunc(d.blend);
+        if (blendChanged && gCaptureActive)
+        {
+            GLenum src, dst;
+            CaptureBlend(BlendFactors(d.blend, src, dst), src, dst);
+        }
+
+        if (!prev || prev->depthTest != d.depthTest)
+            SetCapability(GL_DEPTH_TEST, d.depthTest);
+        if (!prev || prev->depthWrite != d.depthWrite)
+        {
+            glDepthMask(d.depthWrite ? GL_TRUE : GL_FALSE);
+            gFrameCounters.renderStates++;
+        }
+        if (d.depthTest && (!prev || prev->depthFunc != d.depthFunc))
+        {
+            glDepthFunc(d.depthFunc);
+            gFrameCounters.renderStates++;
+        }
+
+        if (!prev || prev->stencilTest != d.stencilTest)
+            SetCapability(GL_STENCIL_TEST, d.stencilTest);
+        if (d.stencilTest)
+        {
+            if (!prev || prev->stencilFunc != d.stencilFunc || prev->stencilRef != d.stencilRef ||
+                prev->stencilReadMask != d.stencilReadMask)
+            {
+                glStencilFunc(d.stencilFunc, d.stencilRef, d.stencilReadMask);
+                gFrameCounters.renderStates++;
+            }
+            if (!prev || prev->stencilFail != d.stencilFail || prev->stencilDepthFail != d.stencilDepthFail ||
+                prev->stencilPass != d.stencilPass)
+            {
+                glStencilOp(d.stencilFail, d.stencilDepthFail, d.stencilPass);
+                gFrameCounters.renderStates++;
+            }
+        }
+        // the write mask applies to clears too, so it follows the pipeline even with the test off
+        if (!prev || prev->stencilWriteMask != d.stencilWriteMask)
+        {
+            glStencilMask(d.stencilWriteMask);
+            gFrameCounters.renderStates++;
+        }
+
+        if (!prev || (prev->cull != CullNone) != (d.cull != CullNone))
+            SetCapability(GL_CULL_FACE, d.cull != CullNone);
+        if (d.cull != CullNone && (!prev || prev->cull != d.cull))
+        {
+            glCullFace(d.cull == CullFront ? GL_FRONT : GL_BACK);
+            gFrameCounters.renderStates++;
+        }
+
+        if (!prev || prev->scissorTest != d.scissorTest)
+            SetCapability(GL_SCISSOR_TEST, d.scissorTest);
+    }
+}
+
+bool PipelineDesc::operator==(const PipelineDesc& o) const
+{
+    return program == o.program && format == o.format && blend == o.blend &&
+        depthTest == o.depthTest && depthWrite == o.depthWrite && depthFunc == o.depthFunc &&
+        stencilTest == o.stencilTest && stencilFunc == o.stencilFunc && stencilRef == o.stencilRef &&
+        stencilReadMask == o.stencilReadMask && stencilWriteMask == o.stencilWriteMask &&
+        stencilFail == o.stencilFail && stencilDepthFail == o.stencilDepthFail && stencilPass == o.stencilPass &&
+        cull == o.cull && scissorTest == o.scissorTest;
+}
+
+uint64_t PipelineDesc::Hash() const
+{
+    // field by field so struct padding never leaks into the key
+    uint64_t h = kFnvOffset;
+    h = HashValue(h, program);
+    h = HashValue(h, (uint32_t)format.count);
+    h = HashValue(h, (uint32_t)format.stride);
+    for (int i = 0; i < format.count; ++i)
+    {
+        const VertexAttribute& a = format.attributes[i];
+        h = HashValue(h, a.location);
+        h = HashValue(h, (uint32_t)a.components);
+        h = HashValue(h, a.type);
+        h = HashValue(h, a.normalized);
+        h = HashValue(h, a.offset);
+    }
+    h = HashValue(h, (uint32_t)blend);
+    h = HashValue(h, (uint32_t)depthTest | ((uint32_t)depthWrite << 1) | ((uint32_t)stencilTest << 2) |
+        ((uint32_t)scissorTest << 3) | ((uint32_t)cull << 4));
+    h = HashValue(h, depthFunc);
+    h = HashValue(h, stencilFunc);
+    h = HashValue(h, (uint32_t)stencilRef);
+    h = HashValue(h, stencilReadMask);
+    h = HashValue(h, stencilWriteMask);
+    h = HashValue(h, stencilFail);
+    h = HashValue(h, stencilDepthFail);
+    h = HashValue(h, stencilPass);
+    return h;
+}
+
+PipelineId CreatePipeline(const PipelineDesc& desc)
+{
+    uint64_t hash = desc.Hash();
+    auto range = gPipelines.byHash.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        PipelineRecord& r = gPipelines.records[it->second - 1];
+        if (r.desc == desc)
+        {
+            r.refs++;
+            gPipelines.stats.shared++;
+            return it->second;
+        }
+    }
+
+    PipelineId id;
+    if (!gPipelines.freeIds.empty())
+    {
+        id = gPipelines.freeIds.back();
+        gPipelines.freeIds.pop_back();
+    }
+    else
+    {
+        gPipelines.records.push_back(PipelineRecord());
+        id = (PipelineId)gPipelines.records.size();
+    }
+    PipelineRecord& r = gPipelines.records[id - 1];
+    r.desc = desc;
+    r.hash = hash;
+    r.refs = 1;
+    gPipelines.byHash.insert(std::make_pair(hash, id));
+    gPipelines.stats.created++;
+    gPipelines.stats.live++;
+    return id;
+}
+
+void DestroyPipeline(PipelineId id)
+{
+    if (id == 0 || id > gPipelines.records.size())
+        return;
+    PipelineRecord& r = gPipelines.records[id - 1];
+    if (r.refs == 0 || --r.refs > 0)
+        return;
+
+    auto range = gPipelines.byHash.equal_range(r.hash);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == id)
+        {
+            gPipelines.byHash.erase(it);
+            break;
+        }
+    }
+    // the id may be reused for a different description, so it can't stand for the
+    // applied state anymore; the applied state itself is still what the context has
+    for (ContextPipelineState& c : gPipelines.contexts)
+    {
+        if (c.bound == id)
+            c.bound = 0;
+    }
+    gPipelines.freeIds.push_back(id);
+    gPipelines.stats.live--;
+}
+
+const PipelineDesc& GetPipelineDesc(PipelineId id)
+{
+    static const PipelineDesc none;
+    if (id == 0 || id > gPipelines.records.size())
+        return none;
+    return gPipelines.records[id - 1].desc;
+}
+
+uint64_t PipelineSortKey(PipelineId id)
+{
+    const PipelineDesc& d = GetPipelineDesc(id);
+    uint64_t blended = d.blend != BlendOpaque ? 1 : 0;
+    return (blended << 63) | ((uint64_t)(d.program & 0x7fffffff) << 32) | id;
+}
+
+void BindPipeline(PipelineId id)
+{
+    if (id == 0 || id > gPipelines.records.size())
+        return;
+    gFrameCounters.pipelineBinds++;
+    ContextPipelineState& c = CurrentContext();
+    if (c.known && c.bound == id)
+        return;
+
+    const PipelineDesc& d = gPipelines.records[id - 1].desc;
+    ApplyDiff(c.known ? &c.applied : nullptr, d);
+    c.applied = d;
+    c.bound = id;
+    c.known = true;
+}
+
+void InvalidatePipelineState()
+{
+    ContextPipelineState& c = CurrentContext();
+    c.known = false;
+    c.bound = 0;
+}
+
+void ForgetContextPipelineState(int contextIndex)
+{
+    if (contextIndex >= 0 && contextIndex < (int)gPipelines.contexts.size())
+        gPipelines.contexts[contextIndex] = ContextPipelineState();
+}
+
+const PipelineStats& GetPipelineStats()
+{
+    return gPipelines.stats;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include "VertexFormat.h"
+#include <glad/glad.h>
+#include <cstdint>
+
+// Immutable pipeline state objects: a program, the vertex format its VAOs use and the
+// fixed-function state it draws with. Identical descriptions share one pipeline.
+// BindPipeline compares against what the current context last had applied and only
+// issues the GL calls for what differs, so switching between similar pipelines is cheap.
+// Code that changes any of this state with raw GL calls must call
+// InvalidatePipelineState() before the next BindPipeline.
+
+enum BlendMode
+{
+    BlendOpaque = 0,
+    BlendAlpha,             // src * a + dst * (1 - a)
+    BlendPremultiplied,     // src + dst * (1 - a)
+    BlendAdditive,          // src * a + dst
+};
+
+enum CullMode
+{
+    CullNone = 0,
+    CullBack,
+    CullFront,
+};
+
+struct PipelineDesc
+{
+    GLuint program = 0;
+    // layout of the VAOs drawn with this pipeline; the VAO itself is bound per draw
+    VertexFormat format;
+    BlendMode blend = BlendOpaque;
+
+    bool depthTest = false;
+    bool depthWrite = true;
+    GLenum depthFunc = GL_LESS;
+
+    bool stencilTest = false;
+    GLenum stencilFunc = GL_ALWAYS;
+    GLint stencilRef = 0;
+    GLuint stencilReadMask = 0xff;
+    GLuint stencilWriteMask = 0xff;
+    GLenum stencilFail = GL_KEEP;
+    GLenum stencilDepthFail = GL_KEEP;
+    GLenum stencilPass = GL_KEEP;
+
+    CullMode cull = CullNone;   // counter-clockwise is front facing
+    // the rectangle is dynamic state, set with glScissor while the pipeline is bound
+    bool scissorTest = false;
+
+    bool operator==(const PipelineDesc& other) const;
+    uint64_t Hash() const;
+};
+
+// 0 is never a valid pipeline
+typedef uint32_t PipelineId;
+
+struct PipelineStats
+{
+    unsigned created = 0;       // distinct pipelines built
+    unsigned shared = 0;        // CreatePipeline calls answered with an existing one
+    unsigned live = 0;
+};
+
+// returns the existing pipeline when an identical one is alive (and takes a reference)
+PipelineId CreatePipeline(const PipelineDesc& desc);
+void DestroyPipeline(PipelineId id);
+const PipelineDesc& GetPipelineDesc(PipelineId id);
+
+// orders draws so each program's draws are adjacent and blended pipelines come last
+uint64_t PipelineSortKey(PipelineId id);
+
+// applies the pipeline to the current context, skipping state that is already set
+void BindPipeline(PipelineId id);
+// forget what the current context has applied; the next bind sets everything
+void InvalidatePipelineState();
+// drop the record of a context that was destroyed
+void ForgetContextPipelineState(int contextIndex);
+
+const PipelineStats& GetPipelineStats();
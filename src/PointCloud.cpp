@@ -0,0 +1,544 @@
+#include "PointCloud.h"
+#include "Caps.h"
+#include "DeferredDelete.h"
+#include "Gfx.h"
+#include "Mesh.h"
+#include "Pipeline.h"
+#include "SceneGen.h"
+#include "Shader.h"
+#include "Warmup.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    const GLuint kPositionBinding = 1;
+    const GLuint kValueBinding = 2;
+    const GLuint kPeakBinding = 3;
+    const GLuint kSplatImageUnit = 0;
+    const int kSplatGroup = 256;
+    const int kReduceGroup = 16;
+    const uint32_t kNearestEmpty = 0xffffffffu;
+    const int kClusters = 16;
+
+    // one invocation per point, no triangle setup: project, then one atomic on the pixel
+    const char* splatSrc = R"(
+#version 430 core
+layout(local_size_x = 256) in;
+layout(std140, binding = 0) uniform Camera { vec4 cameraTransform; vec2 cameraCenter; };
+layout(std430, binding = 1) readonly buffer Positions { vec2 positions[]; };
+layout(std430, binding = 2) readonly buffer Values { float values[]; };
+layout(r32ui, binding = 0) uniform uimage2D target;
+uniform uint count;
+uniform vec2 cloudOrigin;       // relative to the camera, rebased in double on the CPU
+uniform vec2 viewScale;
+uniform int mode;               // 0 density, 1 nearest
+uniform vec2 valueRange;
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= count)
+        return;
+    vec2 view = mat2(cameraTransform.xy, cameraTransform.zw) * (cloudOrigin + positions[i]);
+    ivec2 size = imageSize(target);
+    ivec2 p = ivec2(floor((view * viewScale * 0.5 + 0.5) * vec2(size)));
+    if (any(lessThan(p, ivec2(0))) || any(greaterThanEqual(p, size)))
+        return;
+    if (mode == 0)
+    {
+        imageAtomicAdd(target, p, 1u);
+        return;
+    }
+    // depth key below the empty marker, the smallest wins
+    float depth = clamp((values[i] - valueRange.x) / (valueRange.y - valueRange.x), 0.0, 1.0);
+    imageAtomicMin(target, p, uint(depth * 4294967040.0));
+}
+)";
+
+    // the busiest pixel, so density can be normalized without a CPU readback
+    const char* reduceSrc = R"(
+#version 430 core
+layout(local_size_x = 16, local_size_y = 16) in;
+layout(r32ui, binding = 0) readonly uniform uimage2D target;
+layout(std430, binding = 3) buffer Peak { uint peak; };
+shared uint groupPeak;
+void main()
+{
+    if (gl_LocalInvocationIndex == 0u)
+        groupPeak = 0u;
+    barrier();
+    ivec2 p = ivec2(gl_GlobalInvocationID.xy);
+    if (all(lessThan(p, imageSize(target))))
+        atomicMax(groupPeak, imageLoad(target, p).r);
+    barrier();
+    if (gl_LocalInvocationIndex == 0u)
+        atomicMax(peak, groupPeak);
+}
+)";
+
+    const char* resolveVertexSrc = R"(
+#version 430 core
+void main()
+{
+    // one triangle covering the viewport
+    vec2 p = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));
+    gl_Position = vec4(p * 2.0 - 1.0, 0.0, 1.0);
+}
+)";
+
+    // reads each pixel once and leaves it cleared for the next frame's splat
+    const char* resolveFragmentSrc = R"(
+#version 430 core
+// the colormap polynomial cancels large terms, half floats would band
+precision highp float;
+layout(r32ui, binding = 0) uniform uimage2D target;
+layout(std430, binding = 3) readonly buffer Peak { uint peak; };
+uniform int mode;
+out vec4 FragColor;
+
+// polynomial fit of viridis
+vec3 Colormap(float t)
+{
+    const vec3 c0 = vec3(0.2777273272234177, 0.005407344544966578, 0.3340998053353061);
+    const vec3 c1 = vec3(0.1050930431085774, 1.404613529898575, 1.384590162594685);
+    const vec3 c2 = vec3(-0.3308618287255563, 0.214847559468213, 0.09509516302823659);
+    const vec3 c3 = vec3(-4.634230498983486, -5.799100973351585, -19.33244095627987);
+    const vec3 c4 = vec3(6.228269936347081, 14.17993336680509, 56.69055260068105);
+    const vec3 c5 = vec3(4.776384997670288, -13.74514537774601, -65.35303263337234);
+    const vec3 c6 = vec3(-5.435455855934631, 4.645852612178535, 26.3124352495832);
+    return c0 + t * (c1 + t * (c2 + t * (c3 + t * (c4 + t * (c5 + t * c6)))));
+}
+
+void main()
+{
+    ivec2 p = ivec2(gl_FragCoord.xy);
+    uint v = imageLoad(target, p).r;
+    imageStore(target, p, uvec4(mode == 0 ? 0u : 0xffffffffu));
+    float t;
+    if (mode == 0)
+    {
+        if (v == 0u) discard;
+        // log scale, a lone point still shows against the densest pixel
+        t = 0.15 + 0.85 * log(float(v) + 1.0) / log(float(max(peak, 1u)) + 1.0);
+    }
+    else
+    {
+        if (v == 0xffffffffu) discard;
+        t = 1.0 - float(v) / 4294967040.0;  // near is bright
+    }
+    FragColor = vec4(Colormap(clamp(t, 0.0, 1.0)), 1.0);
+}
+)";
+
+    // the fixed-pipeline comparison: same buffers, one pixel per point, additive
+    const char* pointVertexSrc = R"(
+#version 430 core
+layout(std140, binding = 0) uniform Camera { vec4 cameraTransform; vec2 cameraCenter; };
+layout(std430, binding = 1) readonly buffer Positions { vec2 positions[]; };
+uniform vec2 cloudOrigin;
+uniform vec2 viewScale;
+uniform vec2 pixelSize;     // in clip space
+uniform int quads;          // 1: instanced 4-vertex strips, 0: GL_POINTS
+void main()
+{
+    vec2 offset = vec2(0.0);
+    vec2 position;
+    if (quads != 0)
+    {
+        position = positions[gl_InstanceID];
+        offset = (vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) - 0.5) * pixelSize;
+    }
+    else
+        position = positions[gl_VertexID];
+    vec2 view = mat2(cameraTransform.xy, cameraTransform.zw) * (cloudOrigin + position);
+    gl_Position = vec4(view * viewScale + offset, 0.0, 1.0);
+    gl_PointSize = 1.0;     // ES has no default size
+}
+)";
+
+    const char* pointFragmentSrc = R"(
+#version 430 core
+out vec4 FragColor;
+void main()
+{
+    FragColor = vec4(0.1, 0.3, 0.6, 0.25);
+}
+)";
+
+    // per context: windows differ in size and must not share an image mid-frame
+    struct SplatTarget
+    {
+        GLuint image = 0;       // R32UI, the window's size
+        GLuint peak = 0;        // one uint
+        int width = 0;
+        int height = 0;
+        int clearedFor = -1;    // the mode whose empty value the image holds
+    };
+
+    struct PointCloudState
+    {
+        bool ready = false;
+        Shader splat;
+        GLint locCount = -1;
+        GLint locCloudOrigin = -1;
+        GLint locViewScale = -1;
+        GLint locMode = -1;
+        GLint locValueRange = -1;
+        Shader reduce;
+
+        Shader resolve;
+        PipelineId resolvePipeline = 0;
+        GLint locResolveMode = -1;
+
+        Shader points;
+        PipelineId pointPipeline = 0;
+        GLint locPointOrigin = -1;
+        GLint locPointViewScale = -1;
+        GLint locPixelSize = -1;
+        GLint locQuads = -1;
+
+        // points per storage range: within the guaranteed block size, aligned for both buffers
+        uint64_t batch = 0;
+        std::vector<SplatTarget> targets;
+    } gPointCloud;
+
+
+    float Unit(uint32_t h)
+    {
+        return ((h >> 8) + 0.5f) * (1.0f / 16777216.0f);
+    }
+
+    void ClearImage(SplatTarget& t, int mode)
+    {
+        std::vector<uint32_t> empty((size_t)t.width * t.height, mode == SplatDensity ? 0u : kNearestEmpty);
+        glBindTexture(GL_TEXTURE_2D, t.image);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, t.width, t.height, GL_RED_INTEGER, GL_UNSIGNED_INT, empty.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+        t.clearedFor = mode;
+    }
+
+    SplatTarget& Target(int width, int height, int mode)
+    {
+        PointCloudState& s = gPointCloud;
+        const size_t ctx = (size_t)gGfxContextIndex;
+        if (s.targets.size() <= ctx)
+            s.targets.resize(ctx + 1);
+        SplatTarget& t = s.targets[ctx];
+        if (t.width != width || t.height != height)
+        {
+            if (t.image)
+            {
+                DeferDelete(DeferTexture, t.image);
+                ProfilerTrackGpuBytes(-(int64_t)t.width * t.height * 4);
+            }
+            glGenTextures(1, &t.image);
+            glBindTexture(GL_TEXTURE_2D, t.image);
+            glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32UI, width, height);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            ProfilerTrackGpuBytes((int64_t)width * height * 4);
+            t.width = width;
+            t.height = height;
+            t.clearedFor = -1;
+        }
+        if (!t.peak)
+        {
+            glGenBuffers(1, &t.peak);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, t.peak);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+        }
+        if (t.clearedFor != mode)
+            ClearImage(t, mode);
+        return t;
+    }
+
+    void BindRange(GLuint binding, GLuint buffer, uint64_t first, uint64_t count, size_t stride)
+    {
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, buffer, (GLintptr)(first * stride), (GLsizeiptr)(count * stride));
+    }
+
+    void Splat(const PointCloud& cloud, const Camera2D& camera, const float* viewScale, int width, int height,
+        PointSplatMode mode)
+    {
+        PointCloudState& s = gPointCloud;
+        SplatTarget& t = Target(width, height, mode);
+        float origin[2];
+        CameraRelative(camera, cloud.origin, origin);
+
+        // the previous resolve cleared the image with stores
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        glBindImageTexture(kSplatImageUnit, t.image, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+        // raw bind: the next BindPipeline must not assume its program is still current
+        glUseProgram(s.splat.GetID());
+        glUniform2f(s.locCloudOrigin, origin[0], origin[1]);
+        glUniform2f(s.locViewScale, viewScale[0], viewScale[1]);
+        glUniform1i(s.locMode, mode);
+        glUniform2f(s.locValueRange, cloud.valueRange[0], cloud.valueRange[1]);
+        for (uint64_t first = 0; first < cloud.count; first += s.batch)
+        {
+            uint64_t n = std::min(s.batch, cloud.count - first);
+            BindRange(kPositionBinding, cloud.positions, first, n, 2 * sizeof(float));
+            BindRange(kValueBinding, cloud.values, first, n, sizeof(float));
+            glUniform1ui(s.locCount, (GLuint)n);
+            glDispatchCompute((GLuint)((n + kSplatGroup - 1) / kSplatGroup), 1, 1);
+        }
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        if (mode == SplatDensity)
+        {
+            const GLuint zero = 0;
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, t.peak);
+            // glClearBufferData is desktop only, and this is one uint
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), &zero);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kPeakBinding, t.peak);
+            glUseProgram(s.reduce.GetID());
+            glDispatchCompute((width + kReduceGroup - 1) / kReduceGroup, (height + kReduceGroup - 1) / kReduceGroup, 1);
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        }
+        InvalidatePipelineState();
+
+        BindPipeline(s.resolvePipeline);
+        GfxUniform1i(s.locResolveMode, mode);
+        GfxBindStorageBuffer(kPeakBinding, t.peak);
+        GfxBindVertexArray(EmptyVertexArray());
+        GfxDrawArrays(GL_TRIANGLES, 0, 3);
+        GfxBindVertexArray(0);
+    }
+
+    void DrawFixed(const PointCloud& cloud, const Camera2D& camera, const float* viewScale, int width, int height,
+        bool quads)
+    {
+        PointCloudState& s = gPointCloud;
+        float origin[2];
+        CameraRelative(camera, cloud.origin, origin);
+        BindPipeline(s.pointPipeline);
+        GfxUniform2f(s.locPointOrigin, origin[0], origin[1]);
+        GfxUniform2f(s.locPointViewScale, viewScale[0], viewScale[1]);
+        GfxUniform2f(s.locPixelSize, 2.0f / width, 2.0f / height);
+        GfxUniform1i(s.locQuads, quads ? 1 : 0);
+        GfxBindVertexArray(EmptyVertexArray());
+        for (uint64_t first = 0; first < cloud.count; first += s.batch)
+        {
+            uint64_t n = std::min(s.batch, cloud.count - first);
+            BindRange(kPositionBinding, cloud.positions, first, n, 2 * sizeof(float));
+            if (quads)
+            {
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)n);
+                gFrameCounters.drawCalls++;
+                gFrameCounters.vertices += (uint32_t)(4 * n);
+            }
+            else
+                GfxDrawArrays(GL_POINTS, 0, (GLsizei)n);
+        }
+        GfxBindVertexArray(0);
+    }
+}
+
+bool PointCloudInit(std::string& errorOut)
+{
+    PointCloudState& s = gPointCloud;
+    if (s.ready) return true;
+    // the resolve reads the splat image and the peak in the fragment stage, the point
+    // path reads positions in the vertex stage
+    const GpuCaps& caps = GetGpuCaps();
+    const char* missing = caps.maxFragmentImageUniforms < 1 ? "GL_MAX_FRAGMENT_IMAGE_UNIFORMS"
+        : caps.maxFragmentStorageBlocks < 1 ? "GL_MAX_FRAGMENT_SHADER_STORAGE_BLOCKS"
+        : caps.maxVertexStorageBlocks < 1 ? "GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS" : nullptr;
+    if (missing)
+    {
+        errorOut = std::string("point clouds need images and storage buffers outside compute, ") + missing + " is 0";
+        return false;
+    }
+    if (!s.splat.CreateComputeFromSource(splatSrc, errorOut))
+        return false;
+    if (!s.reduce.CreateComputeFromSource(reduceSrc, errorOut) ||
+        !s.resolve.CreateFromSource(resolveVertexSrc, resolveFragmentSrc, errorOut) ||
+        !s.points.CreateFromSource(pointVertexSrc, pointFragmentSrc, errorOut))
+    {
+        s.splat.Destroy();
+        s.reduce.Destroy();
+        s.resolve.Destroy();
+        s.points.Destroy();
+        return false;
+    }
+    GLuint id = s.splat.GetID();
+    s.locCount = glGetUniformLocation(id, "count");
+    s.locCloudOrigin = glGetUniformLocation(id, "cloudOrigin");
+    s.locViewScale = glGetUniformLocation(id, "viewScale");
+    s.locMode = glGetUniformLocation(id, "mode");
+    s.locValueRange = glGetUniformLocation(id, "valueRange");
+    s.locResolveMode = glGetUniformLocation(s.resolve.GetID(), "mode");
+    id = s.points.GetID();
+    s.locPointOrigin = glGetUniformLocation(id, "cloudOrigin");
+    s.locPointViewScale = glGetUniformLocation(id, "viewScale");
+    s.locPixelSize = glGetUniformLocation(id, "pixelSize");
+    s.locQuads = glGetUniformLocation(id, "quads");
+
+    PipelineDesc desc;
+    desc.program = s.resolve.GetID();
+    s.resolvePipeline = CreatePipeline(desc);
+    WarmupRegister("point splat resolve", s.resolvePipeline, GL_TRIANGLES);
+    desc.program = s.points.GetID();
+    desc.blend = BlendAdditive;
+    s.pointPipeline = CreatePipeline(desc);
+    WarmupRegister("points", s.pointPipeline, GL_POINTS, s.locQuads, 2);
+
+    // storage blocks are only guaranteed 16 MB, so large clouds are bound a range at a time
+    GLint maxBlock = 0, alignment = 0, maxGroups = 0;
+    glGetIntegerv(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &maxBlock);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    glGetIntegeri_v(GL_MAX_COMPUTE_WORK_GROUP_COUNT, 0, &maxGroups);
+    const uint64_t step = std::max<uint64_t>(kSplatGroup, (uint64_t)std::max(alignment, 4) / sizeof(float));
+    uint64_t batch = std::min<uint64_t>((uint64_t)std::max(maxBlock, 1 << 24) / (2 * sizeof(float)),
+        (uint64_t)std::max(maxGroups, 65535) * kSplatGroup);
+    s.batch = std::max(step, batch / step * step);
+    s.ready = true;
+    return true;
+}
+
+void PointCloudShutdown()
+{
+    PointCloudState& s = gPointCloud;
+    if (!s.ready) return;
+    for (SplatTarget& t : s.targets)
+    {
+        if (t.image)
+        {
+            DeferDelete(DeferTexture, t.image);
+            ProfilerTrackGpuBytes(-(int64_t)t.width * t.height * 4);
+        }
+        if (t.peak) DeferDelete(DeferBuffer, t.peak);
+    }
+    WarmupUnregister(s.resolvePipeline);
+    WarmupUnregister(s.pointPipeline);
+    DestroyPipeline(s.resolvePipeline);
+    DestroyPipeline(s.pointPipeline);
+    s.splat.Destroy();
+    s.reduce.Destroy();
+    s.resolve.Destroy();
+    s.points.Destroy();
+    gPointCloud = PointCloudState();
+}
+
+bool CreatePointCloud(PointCloud& cloud, uint64_t capacity, std::string& errorOut)
+{
+    if (capacity == 0)
+    {
+        errorOut = "empty point cloud";
+        return false;
+    }
+    while (glGetError() != GL_NO_ERROR) {}
+    GLuint buffers[2] = { 0, 0 };
+    glGenBuffers(2, buffers);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[0]);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)(capacity * 2 * sizeof(float)), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffers[1]);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)(capacity * sizeof(float)), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    if (glGetError() != GL_NO_ERROR)
+    {
+        glDeleteBuffers(2, buffers);
+        errorOut = "cannot allocate " + std::to_string(capacity * 3 * sizeof(float) >> 20) + " MB of point buffers";
+        return false;
+    }
+    cloud.positions = buffers[0];
+    cloud.values = buffers[1];
+    cloud.count = 0;
+    cloud.capacity = capacity;
+    cloud.bytes = (int64_t)(capacity * 3 * sizeof(float));
+    ProfilerTrackGpuBytes(cloud.bytes);
+    return true;
+}
+
+void DestroyPointCloud(PointCloud& cloud)
+{
+    if (cloud.positions) DeferDelete(DeferBuffer, cloud.positions);
+    if (cloud.values) DeferDelete(DeferBuffer, cloud.values);
+    ProfilerTrackGpuBytes(-cloud.bytes);
+    cloud = PointCloud();
+}
+
+void PointCloudAppend(PointCloud& cloud, const float* positions, const float* values, size_t count)
+{
+    count = (size_t)std::min<uint64_t>(count, cloud.capacity - cloud.count);
+    if (!cloud.positions || count == 0)
+        return;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, cloud.positions);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, (GLintptr)(cloud.count * 2 * sizeof(float)),
+        (GLsizeiptr)(count * 2 * sizeof(float)), positions);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, cloud.values);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, (GLintptr)(cloud.count * sizeof(float)),
+        (GLsizeiptr)(count * sizeof(float)), values);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    cloud.count += count;
+}
+
+void DrawPointCloud(const PointCloud& cloud, const Camera2D& camera, const float* viewScale, int width, int height,
+    PointSplatMode mode, PointDrawPath path)
+{
+    if (!gPointCloud.ready || cloud.count == 0 || width <= 0 || height <= 0)
+        return;
+    if (path == PointPathCompute)
+        Splat(cloud, camera, viewScale, width, height, mode);
+    else
+        DrawFixed(cloud, camera, viewScale, width, height, path == PointPathQuads);
+}
+
+const char* PointSplatModeName(PointSplatMode mode)
+{
+    switch (mode)
+    {
+    case SplatDensity: return "density";
+    case SplatNearest: return "nearest";
+    default: return "?";
+    }
+}
+
+const char* PointDrawPathName(PointDrawPath path)
+{
+    switch (path)
+    {
+    case PointPathCompute: return "compute";
+    case PointPathPoints: return "points";
+    case PointPathQuads: return "quads";
+    default: return "?";
+    }
+}
+
+void GenerateScatterPoints(uint64_t first, size_t count, uint32_t seed, float* positions, float* values)
+{
+    // cluster k: center, spread, stretch and base depth; low k get most of the points
+    float cluster[kClusters][5];
+    for (int k = 0; k < kClusters; ++k)
+    {
+        cluster[k][0] = Unit(HashIndex(k, seed)) * 1.6f - 0.8f;
+        cluster[k][1] = Unit(HashIndex(k + 100, seed)) * 1.6f - 0.8f;
+        cluster[k][2] = 0.01f + 0.12f * Unit(HashIndex(k + 200, seed));
+        cluster[k][3] = 0.4f + 1.2f * Unit(HashIndex(k + 300, seed));
+        cluster[k][4] = Unit(HashIndex(k + 400, seed));
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint64_t index = first + i;
+        uint32_t h = HashIndex(index, seed);
+        float* p = positions + 2 * i;
+        if (h % 10 == 0)
+        {
+            // sparse background
+            p[0] = Unit(HashIndex(index, seed + 1)) * 2.0f - 1.0f;
+            p[1] = Unit(HashIndex(index, seed + 2)) * 2.0f - 1.0f;
+            values[i] = Unit(HashIndex(index, seed + 3));
+            continue;
+        }
+        int k = (int)std::min((h >> 4) % kClusters, (h >> 12) % kClusters);
+        // Box-Muller
+        float r = sqrtf(-2.0f * logf(Unit(HashIndex(index, seed + 1))));
+        float a = 6.2831853f * Unit(HashIndex(index, seed + 2));
+        float gx = r * cosf(a), gy = r * sinf(a);
+        p[0] = cluster[k][0] + gx * cluster[k][2] * cluster[k][3];
+        p[1] = cluster[k][1] + gy * cluster[k][2] / cluster[k][3];
+        values[i] = std::min(1.0f, std::max(0.0f, cluster[k][4] + 0.15f * gx));
+    }
+}
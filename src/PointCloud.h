@@ -0,0 +1,60 @@
+#pragma once
+#include "Camera.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Scatter plots and density maps of far more points than pixels. Instead of a triangle
+// setup per point, a compute shader projects each point and rasterizes it into an R32UI
+// image with one atomic: a count per pixel (density) or the smallest depth key (the
+// nearest point wins). A full-screen pass then maps the image through a colormap and
+// clears it for the next frame. The GL_POINTS and instanced-quad paths draw the same
+// buffers through the fixed pipeline, as a comparison.
+
+enum PointSplatMode
+{
+    SplatDensity = 0,   // points per pixel, log-scaled against the frame's busiest pixel
+    SplatNearest,       // the smallest value per pixel, values are depths in valueRange
+    PointSplatModeCount
+};
+
+enum PointDrawPath
+{
+    PointPathCompute = 0,
+    PointPathPoints,        // GL_POINTS, one pixel each, additive
+    PointPathQuads,         // instanced one-pixel quads, additive
+    PointDrawPathCount
+};
+
+struct PointCloud
+{
+    GLuint positions = 0;       // vec2 per point, relative to origin
+    GLuint values = 0;          // float per point
+    uint64_t count = 0;         // points uploaded so far
+    uint64_t capacity = 0;
+    double origin[2] = { 0.0, 0.0 };
+    float valueRange[2] = { 0.0f, 1.0f };
+    int64_t bytes = 0;
+};
+
+// the shared programs and per-window splat images; clouds are created separately
+bool PointCloudInit(std::string& errorOut);
+void PointCloudShutdown();
+
+// fails if the driver cannot hold the buffers
+bool CreatePointCloud(PointCloud& cloud, uint64_t capacity, std::string& errorOut);
+void DestroyPointCloud(PointCloud& cloud);
+// appends count points: positions are x, y pairs
+void PointCloudAppend(PointCloud& cloud, const float* positions, const float* values, size_t count);
+
+// width/height: the framebuffer the cloud is drawn into, in pixels
+void DrawPointCloud(const PointCloud& cloud, const Camera2D& camera, const float* viewScale, int width, int height,
+    PointSplatMode mode, PointDrawPath path);
+
+const char* PointSplatModeName(PointSplatMode mode);
+const char* PointDrawPathName(PointDrawPath path);
+
+// deterministic test cloud for points [first, first + count): gaussian clusters of
+// different spread and density over a sparse uniform background, in [-1, 1]; the value
+// is a depth that varies across each cluster
+void GenerateScatterPoints(uint64_t first, size_t count, uint32_t seed, float* positions, float* values);
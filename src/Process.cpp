@@ -0,0 +1,108 @@
+#include "Process.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+extern char** environ;
+#endif
+
+namespace
+{
+    std::string gExecutablePath;
+}
+
+void SetExecutablePath(const char* argv0)
+{
+#ifdef _WIN32
+    char path[MAX_PATH];
+    DWORD n = GetModuleFileNameA(NULL, path, MAX_PATH);
+    gExecutablePath = n > 0 && n < MAX_PATH ? std::string(path, n) : std::string(argv0 ? argv0 : "");
+#else
+    gExecutablePath = argv0 ? argv0 : "";
+#endif
+}
+
+const char* ExecutablePath()
+{
+    return gExecutablePath.c_str();
+}
+
+int CurrentProcessId()
+{
+#ifdef _WIN32
+    return (int)GetCurrentProcessId();
+#else
+    return (int)getpid();
+#endif
+}
+
+double ProcessCpuSeconds()
+{
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user))
+        return 0.0;
+    auto toSeconds = [](const FILETIME& t) {
+        return (double)(((uint64_t)t.dwHighDateTime << 32) | t.dwLowDateTime) * 1e-7;
+    };
+    return toSeconds(kernel) + toSeconds(user);
+#else
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0.0;
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+ProcessHandle SpawnSelf(const std::vector<std::string>& args)
+{
+#ifdef _WIN32
+    std::string cmd = "\"" + gExecutablePath + "\"";
+    for (const std::string& a : args)
+        cmd += " \"" + a + "\"";
+    STARTUPINFOA si;
+    PROCESS_INFORMATION pi;
+    ZeroMemory(&si, sizeof(si));
+    si.cb = sizeof(si);
+    ZeroMemory(&pi, sizeof(pi));
+    if (!CreateProcessA(gExecutablePath.c_str(), &cmd[0], NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi))
+        return kInvalidProcess;
+    CloseHandle(pi.hThread);
+    return (ProcessHandle)pi.hProcess;
+#else
+    std::vector<char*> argv;
+    argv.push_back(const_cast<char*>(gExecutablePath.c_str()));
+    for (const std::string& a : args)
+        argv.push_back(const_cast<char*>(a.c_str()));
+    argv.push_back(nullptr);
+    pid_t pid = 0;
+    if (posix_spawn(&pid, gExecutablePath.c_str(), nullptr, nullptr, argv.data(), environ) != 0)
+        return kInvalidProcess;
+    return (ProcessHandle)pid;
+#endif
+}
+
+int WaitProcess(ProcessHandle process)
+{
+    if (process == kInvalidProcess)
+        return -1;
+#ifdef _WIN32
+    HANDLE h = (HANDLE)process;
+    WaitForSingleObject(h, INFINITE);
+    DWORD code = 0;
+    GetExitCodeProcess(h, &code);
+    CloseHandle(h);
+    return (int)code;
+#else
+    int status = 0;
+    if (waitpid((pid_t)process, &status, 0) < 0)
+        return -1;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Spawning helper processes of this executable (cluster workers, benchmark peers).
+
+typedef intptr_t ProcessHandle;
+static const ProcessHandle kInvalidProcess = -1;
+
+// remember argv[0] so tools can re-launch the executable in another mode
+void SetExecutablePath(const char* argv0);
+const char* ExecutablePath();
+int CurrentProcessId();
+// user + kernel CPU time consumed by this process so far
+double ProcessCpuSeconds();
+
+// runs ExecutablePath() with the given arguments (argv[0] is added automatically)
+ProcessHandle SpawnSelf(const std::vector<std::string>& args);
+// waits for exit and returns the exit code, -1 on failure
+int WaitProcess(ProcessHandle process);
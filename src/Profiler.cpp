@@ -0,0 +1,190 @@
+#include "Profiler.h"
+#include "Gfx.h"
+#include <glad/glad.h>
+#include <chrono>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <cstdio>
+#include <unistd.h>
+#endif
+
+FrameCounters gFrameCounters;
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // timestamps are read back this many frames late so we never stall on the GPU
+    static const int kQueryLatency = 4;
+    // GL_GPU_DISJOINT_EXT from EXT_disjoint_timer_query, not in the desktop headers
+    static const GLenum kGpuDisjoint = 0x8FBB;
+
+    enum QuerySlot
+    {
+        QueryFrameBegin,
+        QueryFrameEnd,
+        QueryHudBegin,
+        QueryHudEnd,
+        QueryCount
+    };
+
+    struct ProfilerState
+    {
+        GLuint queries[kQueryLatency][QueryCount] = {};
+        bool issued[kQueryLatency] = {};
+        bool hudIssued[kQueryLatency] = {};
+        int frameIndex = 0;
+
+        Clock::time_point frameBegin;
+        Clock::time_point lastFrameBegin;
+        Clock::time_point hudBegin;
+        float hudCpuMs = 0.0f;
+        bool hasLastFrame = false;
+
+        int64_t gpuBytes = 0;
+        FrameTimings timings;
+    } gProfiler;
+
+    float MsBetween(Clock::time_point a, Clock::time_point b)
+    {
+        return std::chrono::duration<float, std::milli>(b - a).count();
+    }
+
+    float QueryMs(GLuint begin, GLuint end)
+    {
+        GLuint64 t0 = 0, t1 = 0;
+        glGetQueryObjectui64v(begin, GL_QUERY_RESULT, &t0);
+        glGetQueryObjectui64v(end, GL_QUERY_RESULT, &t1);
+        return t1 > t0 ? (float)(t1 - t0) / 1.0e6f : 0.0f;
+    }
+}
+
+bool ProfilerInit()
+{
+    for (int i = 0; i < kQueryLatency; ++i)
+        glGenQueries(QueryCount, gProfiler.queries[i]);
+    return true;
+}
+
+void ProfilerShutdown()
+{
+    for (int i = 0; i < kQueryLatency; ++i)
+    {
+        glDeleteQueries(QueryCount, gProfiler.queries[i]);
+        gProfiler.issued[i] = false;
+        gProfiler.hudIssued[i] = false;
+    }
+}
+
+void ProfilerBeginFrame()
+{
+    Clock::time_point now = Clock::now();
+    FrameTimings& t = gProfiler.timings;
+    t.head = (t.head + 1) % kProfilerHistory;
+    t.frameMs[t.head] = gProfiler.hasLastFrame ? MsBetween(gProfiler.lastFrameBegin, now) : 0.0f;
+    t.cpuMs[t.head] = 0.0f;
+    t.gpuMs[t.head] = 0.0f;
+    t.hudCpuMs[t.head] = 0.0f;
+    t.hudGpuMs[t.head] = 0.0f;
+    gProfiler.lastFrameBegin = now;
+    gProfiler.hasLastFrame = true;
+    gProfiler.frameBegin = now;
+    gProfiler.hudCpuMs = 0.0f;
+
+    gFrameCounters = FrameCounters();
+
+    // the oldest slot is about to be reused, its results are kQueryLatency frames old
+    int slot = gProfiler.frameIndex % kQueryLatency;
+    if (gProfiler.issued[slot])
+    {
+        GLuint* q = gProfiler.queries[slot];
+        GLint available = 0;
+        glGetQueryObjectiv(q[QueryFrameEnd], GL_QUERY_RESULT_AVAILABLE, &available);
+        // on ES the GPU clock can jump (power management); such timings are dropped
+        GLint disjoint = 0;
+        if (available && gGfxGles)
+            glGetIntegerv(kGpuDisjoint, &disjoint);
+        if (disjoint)
+            available = 0;
+        // write into the history entry that belongs to that frame
+        int past = (t.head - kQueryLatency + kProfilerHistory) % kProfilerHistory;
+        if (available)
+        {
+            t.gpuMs[past] = QueryMs(q[QueryFrameBegin], q[QueryFrameEnd]);
+            if (gProfiler.hudIssued[slot])
+                t.hudGpuMs[past] = QueryMs(q[QueryHudBegin], q[QueryHudEnd]);
+        }
+        gProfiler.issued[slot] = false;
+        gProfiler.hudIssued[slot] = false;
+    }
+    if (gGfxTimerQueries)
+        glQueryCounter(gProfiler.queries[slot][QueryFrameBegin], GL_TIMESTAMP);
+}
+
+void ProfilerEndFrame()
+{
+    int slot = gProfiler.frameIndex % kQueryLatency;
+    if (gGfxTimerQueries)
+        glQueryCounter(gProfiler.queries[slot][QueryFrameEnd], GL_TIMESTAMP);
+    gProfiler.issued[slot] = gGfxTimerQueries;
+    gProfiler.frameIndex++;
+
+    FrameTimings& t = gProfiler.timings;
+    t.cpuMs[t.head] = MsBetween(gProfiler.frameBegin, Clock::now());
+    t.hudCpuMs[t.head] = gProfiler.hudCpuMs;
+    t.lastCounters = gFrameCounters;
+}
+
+void ProfilerBeginHud()
+{
+    int slot = gProfiler.frameIndex % kQueryLatency;
+    if (gGfxTimerQueries)
+        glQueryCounter(gProfiler.queries[slot][QueryHudBegin], GL_TIMESTAMP);
+    gProfiler.hudBegin = Clock::now();
+}
+
+void ProfilerEndHud()
+{
+    int slot = gProfiler.frameIndex % kQueryLatency;
+    if (gGfxTimerQueries)
+        glQueryCounter(gProfiler.queries[slot][QueryHudEnd], GL_TIMESTAMP);
+    gProfiler.hudIssued[slot] = gGfxTimerQueries;
+    gProfiler.hudCpuMs += MsBetween(gProfiler.hudBegin, Clock::now());
+}
+
+const FrameTimings& ProfilerTimings()
+{
+    return gProfiler.timings;
+}
+
+size_t ProcessMemoryBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return (size_t)pmc.WorkingSetSize;
+    return 0;
+#else
+    long pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    int read = fscanf(f, "%ld %ld", &pages, &resident);
+    fclose(f);
+    return read == 2 ? (size_t)resident * (size_t)sysconf(_SC_PAGESIZE) : 0;
+#endif
+}
+
+void ProfilerTrackGpuBytes(int64_t delta)
+{
+    gProfiler.gpuBytes += delta;
+}
+
+int64_t ProfilerGpuBytes()
+{
+    return gProfiler.gpuBytes;
+}
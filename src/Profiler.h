@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// per-frame counters, incremented by the Gfx* wrappers and reset by ProfilerBeginFrame()
+struct FrameCounters
+{
+    uint32_t drawCalls = 0;
+    uint32_t vertices = 0;
+    uint32_t programBinds = 0;
+    uint32_t vaoBinds = 0;
+    uint32_t uniformSets = 0;
+    uint32_t pipelineBinds = 0;     // BindPipeline calls, most of which change nothing
+    uint32_t renderStates = 0;      // fixed-function GL calls issued by pipeline binds
+    uint32_t StateChanges() const { return programBinds + vaoBinds + uniformSets + renderStates; }
+};
+
+extern FrameCounters gFrameCounters;
+
+// rolling history of frame timings in milliseconds
+static const int kProfilerHistory = 240;
+
+struct FrameTimings
+{
+    float frameMs[kProfilerHistory] = {};   // begin-to-begin interval
+    float cpuMs[kProfilerHistory] = {};     // begin-to-end work on the render thread
+    float gpuMs[kProfilerHistory] = {};     // GPU time between the frame timestamps
+    float hudCpuMs[kProfilerHistory] = {};
+    float hudGpuMs[kProfilerHistory] = {};
+    int head = 0;                           // index of the most recent sample
+    FrameCounters lastCounters;             // counters of the last completed frame
+};
+
+bool ProfilerInit();
+void ProfilerShutdown();
+
+// bracket the frame on the render thread; GPU results are read back a few frames later
+void ProfilerBeginFrame();
+void ProfilerEndFrame();
+
+// bracket the HUD's own work so its cost can be reported separately
+void ProfilerBeginHud();
+void ProfilerEndHud();
+
+const FrameTimings& ProfilerTimings();
+
+// resident memory of the process, 0 if unavailable
+size_t ProcessMemoryBytes();
+
+// bytes of GPU buffer storage allocated through the renderer
+void ProfilerTrackGpuBytes(int64_t delta);
+int64_t ProfilerGpuBytes();
@@ -0,0 +1,95 @@
+#include "Readback.h"
+#include "Gfx.h"
+
+uint32_t ReadbackQueue(ReadbackRing& ring, int width, int height)
+{
+    // callers drain first, this only protects the ring from misuse
+    ReadbackFrame discard;
+    while (ReadbackFull(ring) && ReadbackMapOldest(ring, true, discard))
+        ReadbackUnmapOldest(ring);
+
+    ReadbackSlot& slot = ring.slots[(ring.oldest + ring.count) % kReadbackSlots];
+    const size_t bytes = (size_t)width * height * 4;
+    if (!slot.pbo) glGenBuffers(1, &slot.pbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    if (bytes > slot.capacity)
+    {
+        glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        slot.capacity = bytes;
+    }
+    // the read flushes the pass, drop depth and stencil before it writes them out
+    GfxEndBackbufferPass();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadBuffer(GL_BACK);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.width = width;
+    slot.height = height;
+    slot.frame = ring.frameCounter++;
+    ++ring.count;
+    return slot.frame;
+}
+
+bool ReadbackFull(const ReadbackRing& ring)
+{
+    return ring.count == kReadbackSlots;
+}
+
+bool ReadbackMapOldest(ReadbackRing& ring, bool wait, ReadbackFrame& out)
+{
+    if (ring.count == 0 || ring.mapped)
+        return false;
+    ReadbackSlot& slot = ring.slots[ring.oldest];
+    if (slot.fence)
+    {
+        GLenum r = wait ? glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull)
+            : glClientWaitSync(slot.fence, 0, 0);
+        if (r == GL_TIMEOUT_EXPIRED)
+            return false;
+        glDeleteSync(slot.fence);
+        slot.fence = nullptr;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    const void* src = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (size_t)slot.width * slot.height * 4, GL_MAP_READ_BIT);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    if (!src)
+    {
+        // keep the ring moving even if the map failed
+        ring.oldest = (ring.oldest + 1) % kReadbackSlots;
+        --ring.count;
+        return false;
+    }
+    ring.mapped = true;
+    out.pixels = (const uint8_t*)src;
+    out.width = slot.width;
+    out.height = slot.height;
+    out.frame = slot.frame;
+    return true;
+}
+
+void ReadbackUnmapOldest(ReadbackRing& ring)
+{
+    if (!ring.mapped) return;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, ring.slots[ring.oldest].pbo);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    ring.mapped = false;
+    ring.oldest = (ring.oldest + 1) % kReadbackSlots;
+    --ring.count;
+}
+
+void ReadbackDestroy(ReadbackRing& ring)
+{
+    ReadbackUnmapOldest(ring);
+    for (ReadbackSlot& slot : ring.slots)
+    {
+        if (slot.fence) glDeleteSync(slot.fence);
+        if (slot.pbo) glDeleteBuffers(1, &slot.pbo);
+        slot = ReadbackSlot();
+    }
+    ring.oldest = 0;
+    ring.count = 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+
+// Asynchronous framebuffer readback through a small ring of pixel pack buffers. A
+// queued read completes a few frames later without stalling the render thread;
+// frames are handed back oldest first.
+//
+//     ReadbackFrame f;
+//     while (ReadbackMapOldest(ring, ReadbackFull(ring), f)) { use f.pixels; ReadbackUnmapOldest(ring); }
+//     ReadbackQueue(ring, width, height);
+
+static const int kReadbackSlots = 3;
+
+struct ReadbackSlot
+{
+    GLuint pbo = 0;
+    GLsync fence = nullptr;
+    size_t capacity = 0;
+    int width = 0;
+    int height = 0;
+    uint32_t frame = 0;
+};
+
+struct ReadbackRing
+{
+    ReadbackSlot slots[kReadbackSlots];
+    int oldest = 0;
+    int count = 0;
+    bool mapped = false;
+    uint32_t frameCounter = 0;
+};
+
+struct ReadbackFrame
+{
+    const uint8_t* pixels = nullptr;    // tightly packed RGBA8, bottom-up rows
+    int width = 0;
+    int height = 0;
+    uint32_t frame = 0;                 // sequence number assigned by ReadbackQueue
+};
+
+// reads the back buffer of the current context once its last draw was issued, which
+// ends the frame's pass (see GfxEndBackbufferPass); returns the frame number
+uint32_t ReadbackQueue(ReadbackRing& ring, int width, int height);
+bool ReadbackFull(const ReadbackRing& ring);
+// maps the oldest pending read if the GPU finished it (or waits when wait is set)
+bool ReadbackMapOldest(ReadbackRing& ring, bool wait, ReadbackFrame& out);
+void ReadbackUnmapOldest(ReadbackRing& ring);
+void ReadbackDestroy(ReadbackRing& ring);
@@ -0,0 +1,192 @@
+#include "RenderTarget.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    // dimensions round up to multiples of this
+    const int kSizeClass = 256;
+    // a pooled target is only reused if the request covers at least this share of it
+    const float kMinFill = 0.5f;
+    // unused targets are freed after this many frames
+    const uint64_t kIdleFrames = 120;
+
+    struct PoolState
+    {
+        std::vector<std::unique_ptr<RenderTarget>> targets;
+        uint64_t frame = 0;
+        RenderTargetStats stats;
+    } gPool;
+
+    int RoundUp(int v)
+    {
+        return ((v + kSizeClass - 1) / kSizeClass) * kSizeClass;
+    }
+
+    int64_t TargetBytes(const RenderTarget& t)
+    {
+        // the resolve texture plus the samples
+        return (int64_t)t.allocWidth * t.allocHeight * 4 * (1 + t.samples);
+    }
+
+    void FreeTarget(RenderTarget& t)
+    {
+        if (t.fbo && t.fbo != t.resolveFbo) glDeleteFramebuffers(1, &t.fbo);
+        if (t.resolveFbo) glDeleteFramebuffers(1, &t.resolveFbo);
+        if (t.msaaColor) glDeleteRenderbuffers(1, &t.msaaColor);
+        if (t.color) glDeleteTextures(1, &t.color);
+        gPool.stats.bytes -= TargetBytes(t);
+        ProfilerTrackGpuBytes(-TargetBytes(t));
+        gPool.stats.frees++;
+        t.fbo = t.resolveFbo = t.msaaColor = t.color = 0;
+    }
+}
+
+RenderTarget* AcquireRenderTarget(int width, int height, int samples)
+{
+    if (width <= 0 || height <= 0)
+        return nullptr;
+    if (samples > 1)
+    {
+        GLint maxSamples = 0;
+        glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+        samples = std::min(samples, (int)maxSamples);
+    }
+    if (samples <= 1)
+        samples = 0;
+
+    // best fit: the smallest free target that holds the request without being too big
+    RenderTarget* best = nullptr;
+    for (auto& t : gPool.targets)
+    {
+        if (t->inUse || t->samples != samples || t->allocWidth < width || t->allocHeight < height)
+            continue;
+        if (width < t->allocWidth * kMinFill || height < t->allocHeight * kMinFill)
+            continue;
+        if (!best || TargetBytes(*t) < TargetBytes(*best))
+            best = t.get();
+    }
+
+    if (best)
+    {
+        gPool.stats.reuses++;
+    }
+    else
+    {
+        std::unique_ptr<RenderTarget> t(new RenderTarget());
+        t->allocWidth = RoundUp(width);
+        t->allocHeight = RoundUp(height);
+        t->samples = samples;
+
+        glGenTextures(1, &t->color);
+        glBindTexture(GL_TEXTURE_2D, t->color);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, t->allocWidth, t->allocHeight);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &t->resolveFbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, t->resolveFbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, t->color, 0);
+        GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        t->fbo = t->resolveFbo;
+
+        if (samples && status == GL_FRAMEBUFFER_COMPLETE)
+        {
+            glGenRenderbuffers(1, &t->msaaColor);
+            glBindRenderbuffer(GL_RENDERBUFFER, t->msaaColor);
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, t->allocWidth, t->allocHeight);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+            glGenFramebuffers(1, &t->fbo);
+            glBindFramebuffer(GL_FRAMEBUFFER, t->fbo);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, t->msaaColor);
+            status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        gPool.stats.allocations++;
+        gPool.stats.bytes += TargetBytes(*t);
+        ProfilerTrackGpuBytes(TargetBytes(*t));
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+        {
+            FreeTarget(*t);
+            return nullptr;
+        }
+        best = t.get();
+        gPool.targets.push_back(std::move(t));
+    }
+
+    best->inUse = true;
+    best->width = width;
+    best->height = height;
+    best->lastUsedFrame = gPool.frame;
+    return best;
+}
+
+void ReleaseRenderTarget(RenderTarget* target)
+{
+    if (target)
+    {
+        target->inUse = false;
+        target->lastUsedFrame = gPool.frame;
+    }
+}
+
+void RenderTargetPoolEndFrame()
+{
+    gPool.frame++;
+    auto& targets = gPool.targets;
+    for (size_t i = 0; i < targets.size();)
+    {
+        RenderTarget& t = *targets[i];
+        if (!t.inUse && gPool.frame - t.lastUsedFrame > kIdleFrames)
+        {
+            FreeTarget(t);
+            targets[i] = std::move(targets.back());
+            targets.pop_back();
+            continue;
+        }
+        ++i;
+    }
+}
+
+void RenderTargetPoolShutdown()
+{
+    for (auto& t : gPool.targets)
+        FreeTarget(*t);
+    gPool.targets.clear();
+}
+
+const RenderTargetStats& RenderTargetPoolStats()
+{
+    return gPool.stats;
+}
+
+void ResolveRenderTarget(const RenderTarget& target)
+{
+    if (!target.msaaColor)
+        return;
+    static const GLenum samples[] = { GL_COLOR_ATTACHMENT0 };
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target.fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target.resolveFbo);
+    glBlitFramebuffer(0, 0, target.width, target.height, 0, 0, target.width, target.height,
+        GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    // every pass starts with a clear, the samples are dead once resolved
+    glInvalidateFramebuffer(GL_READ_FRAMEBUFFER, 1, samples);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void BlitToBackbuffer(const RenderTarget& target, int backbufferWidth, int backbufferHeight)
+{
+    static const GLenum backbufferColor[] = { GL_COLOR };
+    ResolveRenderTarget(target);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, target.resolveFbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    // the blit covers all of it; a tile-based GPU would otherwise load the old frame
+    glInvalidateFramebuffer(GL_DRAW_FRAMEBUFFER, 1, backbufferColor);
+    glBlitFramebuffer(0, 0, target.width, target.height, 0, 0, backbufferWidth, backbufferHeight,
+        GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
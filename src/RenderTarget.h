@@ -0,0 +1,52 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstdint>
+
+// Pooled offscreen color targets. Requests are rounded up to a size class and served
+// from an existing allocation when one is large enough and not wastefully oversized,
+// so a continuous resize drag reuses a handful of textures instead of reallocating on
+// every event. Only the requested width x height region is rendered/read.
+//
+// Multisampled targets draw into a renderbuffer and resolve into the color texture at
+// the end of the pass; the samples are invalidated right after, so a tile-based GPU
+// does not have to keep them.
+struct RenderTarget
+{
+    GLuint fbo = 0;         // what the pass draws into
+    GLuint color = 0;       // the (resolved) single-sampled image
+    GLuint resolveFbo = 0;  // framebuffer around color; fbo itself without MSAA
+    GLuint msaaColor = 0;   // multisampled renderbuffer behind fbo, 0 without MSAA
+    int samples = 0;
+    int allocWidth = 0;     // texture size (size class)
+    int allocHeight = 0;
+    int width = 0;          // size requested by the current user
+    int height = 0;
+    bool inUse = false;
+    uint64_t lastUsedFrame = 0;
+};
+
+struct RenderTargetStats
+{
+    unsigned allocations = 0;
+    unsigned reuses = 0;
+    unsigned frees = 0;
+    int64_t bytes = 0;
+};
+
+// returns nullptr if the framebuffer could not be created; samples above the driver's
+// limit are clamped, 0 or 1 means no MSAA
+RenderTarget* AcquireRenderTarget(int width, int height, int samples = 0);
+void ReleaseRenderTarget(RenderTarget* target);
+
+// frees targets that were not used for a while; call once per frame
+void RenderTargetPoolEndFrame();
+void RenderTargetPoolShutdown();
+const RenderTargetStats& RenderTargetPoolStats();
+
+// ends the pass on a multisampled target: resolves the used region into color and drops
+// the samples; nothing for single-sampled targets
+void ResolveRenderTarget(const RenderTarget& target);
+
+// resolves the target and copies its used region over the whole default framebuffer,
+// whose previous contents are discarded rather than loaded
+void BlitToBackbuffer(const RenderTarget& target, int backbufferWidth, int backbufferHeight);
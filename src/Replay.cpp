@@ -0,0 +1,319 @@
+#include "Replay.h"
+#include "Camera.h"
+#include "Capture.h"
+#include "DeferredDelete.h"
+#include "Gfx.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "Stats.h"
+#include "Window.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    // bounds-checked little-endian reader over the whole file
+    struct Reader
+    {
+        const uint8_t* p = nullptr;
+        const uint8_t* end = nullptr;
+        bool ok = true;
+
+        template <typename T>
+        T Get()
+        {
+            T v = T();
+            if (end - p < (ptrdiff_t)sizeof(T)) { ok = false; p = end; return v; }
+            memcpy(&v, p, sizeof(T));
+            p += sizeof(T);
+            return v;
+        }
+
+        const uint8_t* Bytes(uint32_t& size)
+        {
+            size = Get<uint32_t>();
+            if (!ok || (uint32_t)(end - p) < size) { ok = false; p = end; size = 0; return nullptr; }
+            const uint8_t* data = p;
+            p += size;
+            return data;
+        }
+
+        std::string String()
+        {
+            uint32_t size = 0;
+            const uint8_t* data = Bytes(size);
+            return data ? std::string((const char*)data, size) : std::string();
+        }
+    };
+
+    struct ReplayProgram
+    {
+        Shader shader;
+        std::unordered_map<GLint, GLint> locations; // recorded -> live
+    };
+
+    struct ReplayState
+    {
+        std::map<uint32_t, ReplayProgram> programs;
+        std::unordered_map<uint32_t, MeshHandle> meshes;
+        ReplayProgram* current = nullptr;
+
+        GLint Remap(GLint recorded) const
+        {
+            if (!current) return -1;
+            auto it = current->locations.find(recorded);
+            return it != current->locations.end() ? it->second : -1;
+        }
+
+        void Clear()
+        {
+            for (auto& m : meshes) DestroyTriangle(m.second);
+            meshes.clear();
+            for (auto& p : programs) p.second.shader.Destroy();
+            programs.clear();
+            current = nullptr;
+            // a stream starts from default GL state, blending off
+            glDisable(GL_BLEND);
+        }
+    };
+
+    bool ReadFile(const char* path, std::vector<uint8_t>& out)
+    {
+        FILE* f = fopen(path, "rb");
+        if (!f) return false;
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        out.resize(size > 0 ? (size_t)size : 0);
+        size_t read = out.empty() ? 0 : fread(out.data(), 1, out.size(), f);
+        fclose(f);
+        return read == out.size();
+    }
+
+    // executes one pass over the stream, appending one frame time per CapFrame
+    bool PlayStream(Reader r, ReplayState& state, bool paced, std::vector<float>& frameMs)
+    {
+        Clock::time_point start = Clock::now();
+        Clock::time_point frameStart = start;
+        std::string err;
+
+        while (r.ok && r.p < r.end)
+        {
+            uint8_t op = r.Get<uint8_t>();
+            switch (op)
+            {
+            case CapCreateProgram:
+            {
+                uint32_t id = r.Get<uint32_t>();
+                std::string vs = r.String();
+                std::string fs = r.String();
+                ReplayProgram& prog = state.programs[id];
+                if (!prog.shader.CreateFromSource(vs.c_str(), fs.c_str(), err))
+                {
+                    fprintf(stderr, "replay: program %u failed to build:\n%s\n", id, err.c_str());
+                    return false;
+                }
+                uint32_t n = r.Get<uint32_t>();
+                for (uint32_t i = 0; i < n && r.ok; ++i)
+                {
+                    std::string name = r.String();
+                    GLint recorded = r.Get<int32_t>();
+                    prog.locations[recorded] = glGetUniformLocation(prog.shader.GetID(), name.c_str());
+                }
+                break;
+            }
+            case CapCreateMesh:
+            {
+                uint32_t id = r.Get<uint32_t>();
+                uint32_t size = 0;
+                const uint8_t* data = r.Bytes(size);
+                // copy out, the blob is not guaranteed to be float aligned
+                std::vector<float> floats(size / sizeof(float));
+                if (data && size) memcpy(floats.data(), data, floats.size() * sizeof(float));
+                state.meshes[id] = CreateTriangle(floats);
+                break;
+            }
+            case CapDestroyMesh:
+            {
+                auto it = state.meshes.find(r.Get<uint32_t>());
+                if (it != state.meshes.end())
+                {
+                    DestroyTriangle(it->second);
+                    state.meshes.erase(it);
+                }
+                break;
+            }
+            case CapClear:
+            {
+                float c[4];
+                for (float& v : c) v = r.Get<float>();
+                GfxClear(c[0], c[1], c[2], c[3]);
+                break;
+            }
+            case CapBlend:
+            {
+                bool enabled = r.Get<uint32_t>() != 0;
+                GLenum src = r.Get<uint32_t>();
+                GLenum dst = r.Get<uint32_t>();
+                if (enabled)
+                {
+                    glEnable(GL_BLEND);
+                    glBlendFunc(src, dst);
+                }
+                else glDisable(GL_BLEND);
+                break;
+            }
+            case CapUseProgram:
+            {
+                auto it = state.programs.find(r.Get<uint32_t>());
+                state.current = it != state.programs.end() ? &it->second : nullptr;
+                if (state.current) state.current->shader.Use();
+                break;
+            }
+            case CapBindVertexArray:
+            {
+                uint32_t id = r.Get<uint32_t>();
+                auto it = state.meshes.find(id);
+                GfxBindVertexArray(it != state.meshes.end() ? MeshVertexArray(it->second) : 0);
+                break;
+            }
+            case CapUniform1i:
+            {
+                GLint loc = state.Remap(r.Get<int32_t>());
+                GfxUniform1i(loc, r.Get<int32_t>());
+                break;
+            }
+            case CapUniform1f:
+            {
+                GLint loc = state.Remap(r.Get<int32_t>());
+                GfxUniform1f(loc, r.Get<float>());
+                break;
+            }
+            case CapUniform2f:
+            {
+                GLint loc = state.Remap(r.Get<int32_t>());
+                float x = r.Get<float>();
+                float y = r.Get<float>();
+                GfxUniform2f(loc, x, y);
+                break;
+            }
+            case CapDraw:
+            {
+                GLenum mode = r.Get<uint32_t>();
+                GLint first = r.Get<int32_t>();
+                GLsizei count = r.Get<int32_t>();
+                GfxDrawArrays(mode, first, count);
+                break;
+            }
+            case CapFrame:
+            {
+                r.Get<double>();
+                uint64_t ns = r.Get<uint64_t>();
+                if (paced)
+                    std::this_thread::sleep_until(start + std::chrono::nanoseconds(ns));
+                else
+                    glFinish(); // make the frame time include GPU completion
+                Loop();
+                DeferredDeleteEndFrame();
+                Clock::time_point now = Clock::now();
+                frameMs.push_back(std::chrono::duration<float, std::milli>(now - frameStart).count());
+                frameStart = now;
+                break;
+            }
+            case CapEnd:
+                return true;
+            default:
+                fprintf(stderr, "replay: unknown opcode %u\n", op);
+                return false;
+            }
+        }
+        if (!r.ok)
+            fprintf(stderr, "replay: stream truncated\n");
+        return r.ok;
+    }
+}
+
+int RunReplay(const ReplayOptions& options)
+{
+    std::vector<uint8_t> file;
+    if (!options.path || !ReadFile(options.path, file))
+    {
+        fprintf(stderr, "replay: cannot read '%s'\n", options.path ? options.path : "");
+        return -1;
+    }
+
+    Reader r;
+    r.p = file.data();
+    r.end = file.data() + file.size();
+    if (file.size() < 5 || memcmp(r.p, "GLCAP", 5) != 0)
+    {
+        fprintf(stderr, "replay: '%s' is not a capture file\n", options.path);
+        return -1;
+    }
+    r.p += 5;
+    uint32_t version = r.Get<uint32_t>();
+    uint32_t width = r.Get<uint32_t>();
+    uint32_t height = r.Get<uint32_t>();
+    if (!r.ok)
+    {
+        fprintf(stderr, "replay: '%s' ends inside the capture header\n", options.path);
+        return -1;
+    }
+    if (version < 1 || version > kCaptureVersion)
+    {
+        fprintf(stderr, "replay: unsupported capture version %u (this build reads 1 .. %u)\n", version, kCaptureVersion);
+        return -1;
+    }
+    if (width == 0 || height == 0)
+    {
+        fprintf(stderr, "replay: capture has an empty framebuffer size %ux%u\n", width, height);
+        return -1;
+    }
+
+    if (!CreateWindow((int)width, (int)height, "Replay", false))
+        return -1;
+    SetSwapInterval(0);
+    glViewport(0, 0, (GLsizei)width, (GLsizei)height);
+    // captures are taken with the camera locked, its block is not recorded
+    CameraInit();
+
+    ReplayState state;
+    std::vector<float> frameMs;
+    bool ok = true;
+    for (int loop = 0; loop < std::max(1, options.loops) && ok; ++loop)
+    {
+        ok = PlayStream(r, state, options.paced, frameMs);
+        state.Clear();
+    }
+    CameraShutdown();
+    DeferredDeleteFlush();
+    DestroyWindow();
+
+    if (frameMs.empty())
+    {
+        fprintf(stderr, "replay: no frames in '%s'\n", options.path);
+        return ok ? 0 : -1;
+    }
+
+    // the first frame carries resource creation, report it apart from the steady state
+    std::vector<float> steady(frameMs.begin() + 1, frameMs.end());
+    double sum = 0.0;
+    for (float ms : steady) sum += ms;
+    float avg = steady.empty() ? frameMs[0] : (float)(sum / steady.size());
+    printf("replay %s (%s, %d loop%s): %zu frames\n", options.path, options.paced ? "paced" : "unpaced",
+        options.loops, options.loops == 1 ? "" : "s", frameMs.size());
+    printf("  first %.3f ms  avg %.3f ms (%.1f fps)  min %.3f  p50 %.3f  p95 %.3f  p99 %.3f  max %.3f\n",
+        frameMs[0], avg, avg > 0.0f ? 1000.0f / avg : 0.0f,
+        Percentile(steady, 0.0f), Percentile(steady, 0.5f), Percentile(steady, 0.95f),
+        Percentile(steady, 0.99f), Percentile(steady, 1.0f));
+    return ok ? 0 : -1;
+}
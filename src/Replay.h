@@ -0,0 +1,12 @@
+#pragma once
+
+struct ReplayOptions
+{
+    const char* path = nullptr;
+    bool paced = false;     // sleep to match the recorded frame timestamps
+    int loops = 1;          // play the whole stream this many times
+};
+
+// Plays a capture written by CaptureBegin/CaptureEnd in a hidden window and prints
+// frame-time statistics. Owns the window for its duration; returns a process exit code.
+int RunReplay(const ReplayOptions& options);
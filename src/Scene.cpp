@@ -0,0 +1,377 @@
+#include "Scene.h"
+#include "Caps.h"
+#include "Gfx.h"
+#include "SceneGen.h"
+#include "Warmup.h"
+#include <cmath>
+
+namespace
+{
+    // Vertex inputs, one per VertexFetch. Each provides aPos/aColor and FetchVertex(),
+    // which main() calls before reading them.
+    const char* vertexInputAttributes = R"(
+#version 430 core
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec3 aColor;
+void FetchVertex() {}
+)";
+
+    // the mesh's interleaved floats read straight from its buffer
+    const char* vertexInputPulled = R"(
+#version 430 core
+layout(std430, binding = 0) readonly buffer Vertices { float vertexData[]; };
+vec2 aPos;
+vec3 aColor;
+void FetchVertex()
+{
+    int base = gl_VertexID * 5;
+    aPos = vec2(vertexData[base], vertexData[base + 1]);
+    aColor = vec3(vertexData[base + 2], vertexData[base + 3], vertexData[base + 4]);
+}
+)";
+
+    // 8 bytes per vertex: position as snorm16x2 over [-2,2], color as unorm8x4
+    const char* vertexInputPacked = R"(
+#version 430 core
+layout(std430, binding = 0) readonly buffer Vertices { uvec2 vertexData[]; };
+vec2 aPos;
+vec3 aColor;
+void FetchVertex()
+{
+    uvec2 v = vertexData[gl_VertexID];
+    aPos = unpackSnorm2x16(v.x) * 2.0;
+    aColor = unpackUnorm4x8(v.y).rgb;
+}
+)";
+
+    // Vertex shader - supports position + per-vertex color and simple transforms based on mode
+    const char* vertexBody = R"(
+uniform int mode;      // indicates which triangle behavior to apply
+uniform float time;    // global time
+uniform vec2 offset;   // translation offset for mode 3
+uniform float angle;   // rotation angle for mode 4
+uniform vec2 center;   // center for rotations/translations if needed
+uniform vec2 viewScale; // keeps NDC square when the window is not
+uniform vec2 origin;    // object origin relative to the camera, rebased in double on the CPU
+layout(std140, binding = 0) uniform Camera { vec4 cameraTransform; vec2 cameraCenter; };
+
+out vec3 vColor;
+
+void main()
+{
+    FetchVertex();
+    vec2 pos = aPos;
+
+    if (mode == 3) {
+        // translation triangle: translate by offset
+        pos += offset;
+    }
+    else if (mode == 4) {
+        // rotate about the provided center
+        vec2 p = pos - center;
+        float s = sin(angle);
+        float c = cos(angle);
+        p = vec2(c*p.x - s*p.y, s*p.x + c*p.y);
+        pos = p + center;
+    }
+
+    vec2 view = mat2(cameraTransform.xy, cameraTransform.zw) * (pos + origin);
+    gl_Position = vec4(view * viewScale, 0.0, 1.0);
+    vColor = aColor;
+}
+)";
+
+    // Fragment shader - supports pulsing color when mode==2
+    const char* fragmentSrc = R"(
+#version 430 core
+in vec3 vColor;
+uniform int mode;
+uniform highp float time;  // ES links it only if both stages agree on the precision
+
+out vec4 FragColor;
+
+void main()
+{
+    vec3 color = vColor;
+    if (mode == 2) {
+        // color changes over time (pulse)
+        float t = 0.5 + 0.5 * sin(time * 2.0); // ranges [0,1]
+        color = color * (0.25 + 0.75 * t);
+    }
+    FragColor = vec4(color, 1.0);
+}
+)";
+
+    std::string VertexSource(VertexFetch fetch)
+    {
+        const char* input = vertexInputAttributes;
+        if (fetch == FetchPulled) input = vertexInputPulled;
+        else if (fetch == FetchPulledPacked) input = vertexInputPacked;
+        // skip the input's leading newline so #version stays on the first line
+        return std::string(input + 1) + vertexBody;
+    }
+
+    SceneObject MakeObject(const std::vector<float>& data, int mode, VertexFetch fetch = FetchAttributes)
+    {
+        SceneObject o;
+        if (fetch == FetchPulledPacked) o.mesh = CreatePackedTriangle(data.data(), data.size());
+        else o.mesh = CreateTriangle(data);
+        o.vertexCount = (GLsizei)(data.size() / 5);
+        o.mode = mode;
+        return o;
+    }
+}
+
+uint32_t Scene::TriangleCount() const
+{
+    uint32_t n = 0;
+    for (const SceneObject& o : objects) n += (uint32_t)o.vertexCount / 3;
+    return n;
+}
+
+const char* VertexFetchName(VertexFetch fetch)
+{
+    switch (fetch)
+    {
+    case FetchAttributes: return "attributes";
+    case FetchPulled: return "pulled";
+    case FetchPulledPacked: return "packed";
+    default: return "?";
+    }
+}
+
+const char* SceneVertexSource()
+{
+    static const std::string source = VertexSource(FetchAttributes);
+    return source.c_str();
+}
+
+const char* SceneFragmentSource()
+{
+    return fragmentSrc;
+}
+
+bool CreateSceneProgram(SceneProgram& program, std::string& errorOut, VertexFetch fetch)
+{
+    if (fetch != FetchAttributes && GetGpuCaps().maxVertexStorageBlocks < 1)
+    {
+        errorOut = std::string("vertex fetch '") + VertexFetchName(fetch) + "' needs a storage buffer in the vertex stage, GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS is 0";
+        return false;
+    }
+    std::string vertexSrc = VertexSource(fetch);
+    if (!program.shader.CreateFromSource(vertexSrc.c_str(), fragmentSrc, errorOut))
+        return false;
+    program.fetch = fetch;
+
+    // Get uniform locations
+    GLuint id = program.shader.GetID();
+    program.locMode = glGetUniformLocation(id, "mode");
+    program.locTime = glGetUniformLocation(id, "time");
+    program.locOffset = glGetUniformLocation(id, "offset");
+    program.locAngle = glGetUniformLocation(id, "angle");
+    program.locCenter = glGetUniformLocation(id, "center");
+    program.locViewScale = glGetUniformLocation(id, "viewScale");
+    program.locOrigin = glGetUniformLocation(id, "origin");
+
+    PipelineDesc desc;
+    desc.program = id;
+    // pulled programs read storage buffers and draw with an attribute-less VAO
+    if (fetch == FetchAttributes)
+        desc.format = MeshVertexFormat();
+    program.pipeline = CreatePipeline(desc);
+
+    // every mode branch is a separate path through the shader
+    WarmupRegister("scene", program.pipeline, GL_TRIANGLES, program.locMode, ModeCount);
+    return true;
+}
+
+void SetSceneViewport(SceneProgram& program, int width, int height)
+{
+    ComputeViewScale(width, height, program.viewScale);
+}
+
+void ComputeViewScale(int width, int height, float* scale)
+{
+    // fit the [-1,1] square into the shorter side
+    scale[0] = 1.0f;
+    scale[1] = 1.0f;
+    if (width <= 0 || height <= 0) return;
+    if (width > height) scale[0] = (float)height / (float)width;
+    else scale[1] = (float)width / (float)height;
+}
+
+void DestroySceneProgram(SceneProgram& program)
+{
+    WarmupUnregister(program.pipeline);
+    DestroyPipeline(program.pipeline);
+    program.pipeline = 0;
+    program.shader.Destroy();
+}
+
+void BuildFiveModeScene(Scene& scene)
+{
+    // Triangles will be positioned vertically down the screen so you can see them all:
+    // Top y = 0.75, next 0.35, -0.05, -0.45, -0.85
+    // We'll use small triangles (height ~0.25) so they don't overlap.
+
+    // 1) White triangle (mode 0)
+    std::vector<float> white = {
+        // pos.x, pos.y,  r, g, b
+         -0.2f,  0.85f,  1.0f, 1.0f, 1.0f,
+          0.2f,  0.85f,  1.0f, 1.0f, 1.0f,
+          0.0f,  0.60f,  1.0f, 1.0f, 1.0f
+    };
+
+    // 2) Rainbow triangle (mode 1) - per-vertex color
+    std::vector<float> rainbow = {
+        -0.2f,  0.45f,   1.0f, 0.0f, 0.0f, // red
+         0.2f,  0.45f,   0.0f, 1.0f, 0.0f, // green
+         0.0f,  0.20f,   0.0f, 0.0f, 1.0f  // blue
+    };
+
+    // 3) Pulsing color (mode 2) - base color is magenta
+    std::vector<float> pulsing = {
+        -0.2f, -0.05f,   0.94f, 0.53f, 0.75f, // pastel magenta-ish
+         0.2f, -0.05f,   0.94f, 0.53f, 0.75f,
+         0.0f, -0.30f,   0.94f, 0.53f, 0.75f
+    };
+
+    // 4) Translating triangle (mode 3) - place around y = -0.55
+    // Positions are centered so when offset is applied it moves left-right
+    std::vector<float> translating = {
+        -0.15f, -0.35f,  0.2f, 0.8f, 0.2f, // light green
+         0.15f, -0.35f,  0.2f, 0.8f, 0.2f,
+         0.0f, -0.60f,   0.2f, 0.8f, 0.2f
+    };
+
+    // 5) Rotating triangle (mode 4) - center about its own center near bottom
+    // We'll provide a center uniform so rotation is around the triangle's center
+    std::vector<float> rotating = {
+        -0.25f, -0.75f,  1.0f, 0.6f, 0.2f, // orange
+         0.25f, -0.75f,  1.0f, 0.6f, 0.2f,
+         0.0f,  -0.55f,  1.0f, 0.6f, 0.2f
+    };
+
+    // Create VAOs
+    scene.objects.push_back(MakeObject(white, ModeStatic));
+    scene.objects.push_back(MakeObject(rainbow, ModeRainbow));
+    scene.objects.push_back(MakeObject(pulsing, ModePulse));
+
+    // translating left-right between x = -1 and x = 1
+    // we'll compute offset.x = sin(t) * 0.75 to keep it within bounds
+    SceneObject trans = MakeObject(translating, ModeTranslate);
+    trans.speed = 1.2f; // speed multiplier 1.2
+    trans.amplitude = 0.75f;
+    trans.center[1] = -0.475f; // only used to place the debug arrow
+    scene.objects.push_back(trans);
+
+    // center of rotation = approximate center of the triangle vertices used above
+    // we calculated the triangle roughly centered at x=0, y=-0.68 (est)
+    SceneObject rot = MakeObject(rotating, ModeRotate);
+    rot.speed = 1.0f; // 1 radian per second
+    rot.center[0] = 0.0f;
+    rot.center[1] = -0.68f;
+    scene.objects.push_back(rot);
+}
+
+void BuildStressScene(Scene& scene, int triangleCount, uint32_t seed, VertexFetch fetch)
+{
+    Pcg32 rng(seed);
+    std::vector<float> data;
+    data.reserve(kStressBatch * 15);
+
+    int batch = 0;
+    for (int remaining = triangleCount; remaining > 0; remaining -= kStressBatch, ++batch)
+    {
+        int count = remaining < kStressBatch ? remaining : kStressBatch;
+        int mode = batch % ModeCount;
+        float cx = rng.Range(-0.8f, 0.8f);
+        float cy = rng.Range(-0.8f, 0.8f);
+
+        data.clear();
+        for (int i = 0; i < count; ++i)
+        {
+            float x = rng.Range(-1.0f, 1.0f);
+            float y = rng.Range(-1.0f, 1.0f);
+            float size = rng.Range(0.005f, 0.03f);
+            float r = rng.Range(0.2f, 1.0f);
+            float g = rng.Range(0.2f, 1.0f);
+            float b = rng.Range(0.2f, 1.0f);
+            const float verts[15] = {
+                x - size, y - size, r, g, b,
+                x + size, y - size, g, b, r,
+                x,        y + size, b, r, g,
+            };
+            data.insert(data.end(), verts, verts + 15);
+        }
+
+        SceneObject o = MakeObject(data, mode, fetch);
+        o.center[0] = cx;
+        o.center[1] = cy;
+        o.speed = rng.Range(0.5f, 1.5f);
+        o.amplitude = rng.Range(0.1f, 0.3f);
+        o.phase = rng.Range(0.0f, 6.2831853f);
+        scene.objects.push_back(o);
+    }
+}
+
+void DestroyScene(Scene& scene)
+{
+    for (SceneObject& o : scene.objects)
+        DestroyTriangle(o.mesh);
+    scene.objects.clear();
+}
+
+void EvaluateObject(const SceneObject& object, float t, float& offsetX, float& angle)
+{
+    offsetX = sinf(t * object.speed + object.phase) * object.amplitude;
+    // rotate counter-clockwise: angle increases with time
+    angle = t * object.speed + object.phase;
+}
+
+void DrawScene(const Scene& scene, const SceneProgram& program, float t, const Camera2D& camera)
+{
+    if (scene.objects.empty())
+        return;
+    BindPipeline(program.pipeline);
+    GfxUniform1f(program.locTime, t);
+    GfxUniform2f(program.locViewScale, program.viewScale[0], program.viewScale[1]);
+    const bool pulled = program.fetch != FetchAttributes;
+    if (pulled)
+        GfxBindVertexArray(EmptyVertexArray());
+
+    // most objects share an origin, only send it when it changes
+    float lastOrigin[2] = { 0.0f, 0.0f };
+    bool originSet = false;
+    for (const SceneObject& o : scene.objects)
+    {
+        GfxUniform1i(program.locMode, o.mode);
+        float offsetX = 0.0f, angle = 0.0f;
+        EvaluateObject(o, t, offsetX, angle);
+        if (o.mode == ModeTranslate)
+        {
+            // only x translation needed
+            GfxUniform2f(program.locOffset, offsetX, 0.0f);
+        }
+        else if (o.mode == ModeRotate)
+        {
+            GfxUniform1f(program.locAngle, angle);
+            GfxUniform2f(program.locCenter, o.center[0], o.center[1]);
+        }
+        float origin[2];
+        CameraRelative(camera, o.origin, origin);
+        if (!originSet || origin[0] != lastOrigin[0] || origin[1] != lastOrigin[1])
+        {
+            GfxUniform2f(program.locOrigin, origin[0], origin[1]);
+            lastOrigin[0] = origin[0];
+            lastOrigin[1] = origin[1];
+            originSet = true;
+        }
+        if (pulled) GfxBindStorageBuffer(0, MeshBuffer(o.mesh));
+        else GfxBindVertexArray(MeshVertexArray(o.mesh));
+        GfxDrawArrays(GL_TRIANGLES, 0, o.vertexCount);
+    }
+
+    // unbind VAO
+    GfxBindVertexArray(0);
+}
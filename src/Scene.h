@@ -0,0 +1,95 @@
+#pragma once
+#include "Camera.h"
+#include "Mesh.h"
+#include "Pipeline.h"
+#include "Shader.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// triangle behaviors understood by the scene shader
+enum SceneMode
+{
+    ModeStatic = 0,     // white / flat color
+    ModeRainbow = 1,    // per-vertex color
+    ModePulse = 2,      // color pulses over time
+    ModeTranslate = 3,  // slides left-right
+    ModeRotate = 4,     // spins about center
+    ModeCount
+};
+
+// how the scene vertex shader gets its vertices
+enum VertexFetch
+{
+    FetchAttributes = 0,    // pos2 + color3 attributes from the mesh VAO
+    FetchPulled,            // the same floats read from the mesh buffer as an SSBO by gl_VertexID
+    FetchPulledPacked,      // 8-byte vertices from CreatePackedTriangle, decoded in the shader
+    FetchCount
+};
+
+const char* VertexFetchName(VertexFetch fetch);
+
+// one draw: a mesh and how it animates
+struct SceneObject
+{
+    MeshHandle mesh;
+    GLsizei vertexCount = 0;
+    int mode = ModeStatic;
+    float center[2] = { 0.0f, 0.0f };   // rotation pivot for ModeRotate, object center otherwise
+    float speed = 1.0f;                 // radians per second of the animation
+    float amplitude = 0.75f;            // translation extent for ModeTranslate
+    float phase = 0.0f;
+    // world position of the mesh's local origin; kept in double and rebased against
+    // the camera on the CPU, so the mesh itself stays small and float-precise
+    double origin[2] = { 0.0, 0.0 };
+};
+
+struct Scene
+{
+    std::vector<SceneObject> objects;
+    uint32_t TriangleCount() const;
+};
+
+// the scene shader and its uniform locations
+struct SceneProgram
+{
+    Shader shader;
+    GLint locMode = -1;
+    GLint locTime = -1;
+    GLint locOffset = -1;
+    GLint locAngle = -1;
+    GLint locCenter = -1;
+    GLint locViewScale = -1;
+    GLint locOrigin = -1;
+    float viewScale[2] = { 1.0f, 1.0f };
+    PipelineId pipeline = 0;
+    VertexFetch fetch = FetchAttributes;
+};
+
+// meshes drawn with a FetchPulledPacked program must come from CreatePackedTriangle.
+// Pulled draws bind storage buffers, which captures do not record, and fail here when
+// the vertex stage has none (optional on ES 3.1).
+bool CreateSceneProgram(SceneProgram& program, std::string& errorOut, VertexFetch fetch = FetchAttributes);
+void DestroySceneProgram(SceneProgram& program);
+// aspect correction for a width x height target, applied by DrawScene
+void SetSceneViewport(SceneProgram& program, int width, int height);
+void ComputeViewScale(int width, int height, float* scale);
+
+// shader sources, exposed for benchmarks that time compilation
+const char* SceneVertexSource();
+const char* SceneFragmentSource();
+
+// the five hand-placed triangles, one per mode
+void BuildFiveModeScene(Scene& scene);
+// triangleCount small triangles spread over the screen, batched into objects of
+// up to kStressBatch triangles with the modes assigned round-robin
+static const int kStressBatch = 1024;
+// with FetchPulledPacked the meshes are packed for that program
+void BuildStressScene(Scene& scene, int triangleCount, uint32_t seed, VertexFetch fetch = FetchAttributes);
+void DestroyScene(Scene& scene);
+
+// per-object animation values at time t
+void EvaluateObject(const SceneObject& object, float t, float& offsetX, float& angle);
+
+// the camera must match what was last given to CameraUpload
+void DrawScene(const Scene& scene, const SceneProgram& program, float t, const Camera2D& camera = Camera2D());
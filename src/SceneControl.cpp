@@ -0,0 +1,437 @@
+#include "SceneControl.h"
+#include "Instances.h"
+#include "Net.h"
+#include "SceneGen.h"
+#include "SharedMemory.h"
+#include "Stats.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    static_assert(sizeof(ControlCommand) == 32, "control commands are 32 byte records");
+    static_assert(sizeof(ControlRingHeader) <= kControlHeaderBytes, "ring header grew past its reserved space");
+
+    const uint32_t kControlCapacity = 1u << 16;
+    const uint32_t kMaxCommandsPerFrame = 1u << 15; // bounds the frame time a burst can add
+    const size_t kLatencySamples = 8192;
+
+    ControlCommand* Records(ControlRingHeader* h)
+    {
+        return (ControlCommand*)((uint8_t*)h + kControlHeaderBytes);
+    }
+
+    struct SceneControlState
+    {
+        bool running = false;
+        NetSocket listener = kInvalidSocket;
+        NetSocket controller = kInvalidSocket;
+        SharedMemory shm;
+        ControlRingHeader* ring = nullptr;
+        uint64_t tail = 0;                      // ours; the copy in the ring is only published
+
+        // controller id -> instance
+        std::unordered_map<uint32_t, InstanceHandle> index;
+
+        SceneControlStats stats;
+        double applyMsTotal = 0.0;
+        std::vector<float> latencies;           // ring buffer of the last kLatencySamples
+        size_t latencyNext = 0;
+        Clock::time_point started;
+    } gControl;
+
+    void Despawn(uint32_t id)
+    {
+        SceneControlState& c = gControl;
+        auto it = c.index.find(id);
+        if (it == c.index.end()) return;
+        DespawnInstance(it->second);
+        c.index.erase(it);
+    }
+
+    void DespawnAll()
+    {
+        SceneControlState& c = gControl;
+        for (auto& entry : c.index)
+            DespawnInstance(entry.second);
+        c.index.clear();
+    }
+
+    void Spawn(const ControlCommand& cmd)
+    {
+        SceneControlState& c = gControl;
+        Despawn(cmd.id);
+
+        const ControlSpawn& s = cmd.spawn;
+        InstanceData d;
+        d.center[0] = s.center[0];
+        d.center[1] = s.center[1];
+        d.size = s.size;
+        d.mode = cmd.mode < ModeCount ? cmd.mode : (uint32_t)ModeStatic;
+        for (int v = 0; v < 3; ++v)
+            d.colors[v] = s.colors[v];
+        InstanceHandle h = SpawnInstance(d);
+        if (h)
+            c.index[cmd.id] = h;
+    }
+
+    void Apply(const ControlCommand& cmd)
+    {
+        SceneControlState& c = gControl;
+        if (cmd.op == CtlSpawn) { Spawn(cmd); return; }
+        if (cmd.op == CtlDespawn) { Despawn(cmd.id); return; }
+        if (cmd.op == CtlMark)
+        {
+            float ms = (float)((int64_t)(NowNs() - cmd.mark.timestampNs) * 1e-6);
+            if (c.latencies.size() < kLatencySamples) c.latencies.push_back(ms);
+            else c.latencies[c.latencyNext++ % kLatencySamples] = ms;
+            return;
+        }
+
+        auto it = c.index.find(cmd.id);
+        if (it == c.index.end()) return; // raced with a despawn, harmless
+        InstanceData* d = EditInstance(it->second);
+        if (!d) return;
+        switch (cmd.op)
+        {
+        case CtlSetMode:
+            d->mode = cmd.mode < ModeCount ? cmd.mode : (uint32_t)ModeStatic;
+            break;
+        case CtlSetParams:
+            d->speed = cmd.params.speed;
+            d->amplitude = cmd.params.amplitude;
+            d->phase = cmd.params.phase;
+            d->center[0] = cmd.params.center[0];
+            d->center[1] = cmd.params.center[1];
+            break;
+        case CtlSetColors:
+            for (int v = 0; v < 3; ++v)
+                d->colors[v] = cmd.colors.colors[v];
+            break;
+        default:
+            break;
+        }
+    }
+
+    void DropController()
+    {
+        SceneControlState& c = gControl;
+        NetClose(c.controller);
+        c.controller = kInvalidSocket;
+        SharedMemoryClose(c.shm);
+        c.ring = nullptr;
+    }
+
+    void AcceptController()
+    {
+        SceneControlState& c = gControl;
+        if (c.controller != kInvalidSocket || !NetPoll(c.listener, 0))
+            return;
+        NetSocket s = NetAccept(c.listener);
+        if (s == kInvalidSocket)
+            return;
+
+        std::string err;
+        SharedMemory shm;
+        if (!SharedMemoryCreate(kControlHeaderBytes + (size_t)kControlCapacity * sizeof(ControlCommand), shm, err))
+        {
+            fprintf(stderr, "scene control: %s\n", err.c_str());
+            NetClose(s);
+            return;
+        }
+        ControlRingHeader* h = new (shm.data) ControlRingHeader();
+        memcpy(h->magic, "GLCTRL\0\0", 8);
+        h->version = kControlVersion;
+        h->capacity = kControlCapacity;
+        h->head.store(0, std::memory_order_relaxed);
+        h->tail.store(0, std::memory_order_relaxed);
+        h->closed.store(0, std::memory_order_release);
+        if (!SharedMemorySend(s, shm))
+        {
+            SharedMemoryClose(shm);
+            NetClose(s);
+            return;
+        }
+
+        // a new controller owns all controlled objects
+        DespawnAll();
+        c.controller = s;
+        c.shm = shm;
+        c.ring = h;
+        c.tail = 0;
+    }
+
+    // ---- controller side ----
+
+    struct Controller
+    {
+        ControlRingHeader* ring = nullptr;
+        uint64_t head = 0;          // local, published in batches
+        uint64_t stalls = 0;        // times the ring was full
+
+        void Push(const ControlCommand& cmd, NetSocket s)
+        {
+            int spins = 0;
+            while (head - ring->tail.load(std::memory_order_acquire) >= ring->capacity)
+            {
+                if (spins++ == 0)
+                {
+                    // let the renderer see what we have before waiting for it
+                    ring->head.store(head, std::memory_order_release);
+                    ++stalls;
+                }
+                if (NetPoll(s, 0)) return; // renderer went away
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+            Records(ring)[head & (ring->capacity - 1)] = cmd;
+            ++head;
+        }
+
+        void Publish(NetSocket s)
+        {
+            ControlCommand mark = {};
+            mark.op = CtlMark;
+            mark.mark.timestampNs = NowNs();
+            Push(mark, s);
+            ring->head.store(head, std::memory_order_release);
+        }
+    };
+
+    uint32_t RandomColor(Pcg32& rng)
+    {
+        return (rng.Next() & 0x00ffffffu) | 0xff000000u;
+    }
+
+    ControlCommand RandomSpawn(Pcg32& rng, uint32_t id)
+    {
+        ControlCommand cmd = {};
+        cmd.op = CtlSpawn;
+        cmd.id = id;
+        cmd.mode = (uint8_t)(rng.Next() % ModeCount);
+        cmd.spawn.center[0] = rng.Range(-0.95f, 0.95f);
+        cmd.spawn.center[1] = rng.Range(-0.95f, 0.95f);
+        cmd.spawn.size = rng.Range(0.01f, 0.05f);
+        for (uint32_t& col : cmd.spawn.colors) col = RandomColor(rng);
+        return cmd;
+    }
+}
+
+bool SceneControlStart(const char* address, std::string& errorOut)
+{
+    SceneControlState& c = gControl;
+    if (c.running) return true;
+    if (!InstancesReady())
+    {
+        errorOut = "instances are not initialized";
+        return false;
+    }
+    if (!NetInit())
+    {
+        errorOut = "socket init failed";
+        return false;
+    }
+    std::string bound;
+    c.listener = NetListen(address, bound);
+    if (c.listener == kInvalidSocket)
+    {
+        errorOut = std::string("cannot listen on ") + address;
+        NetShutdown();
+        return false;
+    }
+    printf("scene control on %s\n", bound.c_str());
+    c.stats = SceneControlStats();
+    c.applyMsTotal = 0.0;
+    c.latencies.clear();
+    c.latencyNext = 0;
+    c.started = Clock::now();
+    c.running = true;
+    return true;
+}
+
+bool SceneControlRunning()
+{
+    return gControl.running;
+}
+
+void SceneControlApply()
+{
+    SceneControlState& c = gControl;
+    if (!c.running) return;
+    AcceptController();
+    if (!c.ring) return;
+
+    Clock::time_point start = Clock::now();
+    // the controller can write the whole header, so only our own tail and capacity
+    // address the records and a head it could not have produced ends the session
+    ControlRingHeader* h = c.ring;
+    uint64_t tail = c.tail;
+    uint64_t head = h->head.load(std::memory_order_acquire);
+    if (head < tail || head - tail > kControlCapacity)
+    {
+        fprintf(stderr, "scene control: controller published an invalid head, dropping it\n");
+        DropController();
+        return;
+    }
+    uint64_t end = std::min(head, tail + kMaxCommandsPerFrame);
+    const ControlCommand* records = Records(h);
+    for (uint64_t i = tail; i < end; ++i)
+        Apply(records[i & (kControlCapacity - 1)]);
+    c.tail = end;
+    h->tail.store(end, std::memory_order_release);
+
+    if (end != tail)
+    {
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        c.applyMsTotal += ms;
+        c.stats.maxApplyMs = std::max(c.stats.maxApplyMs, ms);
+        c.stats.commandsApplied += end - tail;
+        c.stats.frames++;
+    }
+    else if (h->closed.load(std::memory_order_acquire) || NetPoll(c.controller, 0))
+    {
+        // drained and the controller is done (or gone); its objects stay on screen
+        if (h->head.load(std::memory_order_acquire) == end)
+            DropController();
+    }
+}
+
+SceneControlStats SceneControlGetStats()
+{
+    SceneControlState& c = gControl;
+    SceneControlStats out = c.stats;
+    out.applyMs = out.frames ? c.applyMsTotal / out.frames : 0.0;
+    out.latencyP50Ms = Percentile(c.latencies, 0.5f);
+    out.latencyP95Ms = Percentile(c.latencies, 0.95f);
+    out.seconds = std::chrono::duration<double>(Clock::now() - c.started).count();
+    return out;
+}
+
+void SceneControlStop()
+{
+    SceneControlState& c = gControl;
+    if (!c.running) return;
+    DropController();
+    NetClose(c.listener);
+    c.listener = kInvalidSocket;
+    DespawnAll();
+    NetShutdown();
+    c.running = false;
+}
+
+int RunSceneController(const char* address, const ControllerOptions& options)
+{
+    if (!NetInit())
+        return -1;
+    NetSocket s = NetConnect(address);
+    SharedMemory shm;
+    std::string err;
+    if (s == kInvalidSocket || !SharedMemoryReceive(s, shm, err))
+    {
+        fprintf(stderr, "controller: cannot attach to %s %s\n", address, err.c_str());
+        NetClose(s);
+        NetShutdown();
+        return -1;
+    }
+    ControlRingHeader* h = (ControlRingHeader*)shm.data;
+    if (memcmp(h->magic, "GLCTRL", 6) != 0 || h->version != kControlVersion || (h->capacity & (h->capacity - 1)))
+    {
+        fprintf(stderr, "controller: not a control ring\n");
+        SharedMemoryClose(shm);
+        NetClose(s);
+        NetShutdown();
+        return -1;
+    }
+
+    Controller ctl;
+    ctl.ring = h;
+    Pcg32 rng(options.seed);
+    const int objects = std::max(1, options.objects);
+    const int batch = std::max(1, options.batch);
+    std::vector<uint8_t> alive(objects, 1);
+
+    // ids are 1..objects; spawn them all up front
+    for (int i = 0; i < objects; ++i)
+    {
+        ctl.Push(RandomSpawn(rng, (uint32_t)(i + 1)), s);
+        if ((i + 1) % batch == 0) ctl.Publish(s);
+    }
+    ctl.Publish(s);
+
+    uint64_t sent = 0;
+    Clock::time_point start = Clock::now();
+    Clock::time_point stop = start + std::chrono::microseconds((int64_t)(options.seconds * 1e6));
+    bool connected = true;
+    while (connected && Clock::now() < stop)
+    {
+        for (int i = 0; i < batch; ++i)
+        {
+            uint32_t slot = rng.Next() % (uint32_t)objects;
+            uint32_t id = slot + 1;
+            uint32_t pick = rng.Next() % 10;
+            ControlCommand cmd = {};
+            cmd.id = id;
+            if (!alive[slot])
+            {
+                cmd = RandomSpawn(rng, id);
+                alive[slot] = 1;
+            }
+            else if (pick == 0)
+            {
+                cmd.op = CtlDespawn;
+                alive[slot] = 0;
+            }
+            else if (pick < 3)
+            {
+                cmd.op = CtlSetMode;
+                cmd.mode = (uint8_t)(rng.Next() % ModeCount);
+            }
+            else if (pick < 5)
+            {
+                cmd.op = CtlSetColors;
+                for (uint32_t& col : cmd.colors.colors) col = RandomColor(rng);
+            }
+            else
+            {
+                cmd.op = CtlSetParams;
+                cmd.params.speed = rng.Range(0.5f, 4.0f);
+                cmd.params.amplitude = rng.Range(0.0f, 0.3f);
+                cmd.params.phase = rng.Range(0.0f, 6.2831853f);
+                cmd.params.center[0] = rng.Range(-0.95f, 0.95f);
+                cmd.params.center[1] = rng.Range(-0.95f, 0.95f);
+            }
+            ctl.Push(cmd, s);
+        }
+        ctl.Publish(s);
+        sent += (uint64_t)batch;
+        connected = !NetPoll(s, 0);
+
+        if (options.rate > 0)
+            std::this_thread::sleep_until(start + std::chrono::microseconds((int64_t)(sent * 1e6 / options.rate)));
+    }
+    h->closed.store(1, std::memory_order_release);
+
+    // wait until the renderer caught up so the reported rate is the applied rate
+    while (connected && h->tail.load(std::memory_order_acquire) < ctl.head)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        connected = !NetPoll(s, 0);
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    printf("controller: %llu commands in %.2f s (%.0f/s), %d objects, %llu ring-full stalls%s\n",
+        (unsigned long long)sent, seconds, sent / std::max(1e-9, seconds), objects,
+        (unsigned long long)ctl.stalls, connected ? "" : ", renderer went away");
+
+    SharedMemoryClose(shm);
+    NetClose(s);
+    NetShutdown();
+    return connected ? 0 : -1;
+}
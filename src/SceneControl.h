@@ -0,0 +1,111 @@
+#pragma once
+#include "Scene.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Lets a controller process add, remove and animate shapes while the renderer runs.
+// Commands are fixed-size records in a single-producer/single-consumer ring in shared
+// memory: the controller writes any number of records and publishes them with one
+// store to head, the renderer applies everything published so far at the start of
+// each frame (up to a per-frame budget) and publishes tail once. No locks and no
+// syscalls per command; the socket is only used to hand over the mapping.
+//
+// Layout, for controllers written against it:
+//   ControlRingHeader at offset 0, capacity ControlCommand records at kControlHeaderBytes
+
+static const uint32_t kControlVersion = 1;
+static const size_t kControlHeaderBytes = 256;
+
+enum ControlOp : uint8_t
+{
+    CtlSpawn = 1,       // new object with the given id (replaces an existing one)
+    CtlDespawn,
+    CtlSetMode,         // mode byte of the command
+    CtlSetParams,       // animation parameters and center
+    CtlSetColors,       // per-vertex colors
+    CtlMark,            // timestamp, measures command latency
+};
+
+struct ControlSpawn
+{
+    float center[2];
+    float size;         // circumradius in NDC
+    uint32_t colors[3]; // RGBA8 per vertex, same packing as DebugColor
+};
+
+struct ControlParams
+{
+    float speed;
+    float amplitude;
+    float phase;
+    float center[2];
+};
+
+struct ControlColors
+{
+    uint32_t colors[3];
+};
+
+struct ControlMark
+{
+    uint64_t timestampNs; // steady clock of the controller at publish
+};
+
+struct ControlCommand
+{
+    uint8_t op;
+    uint8_t mode;
+    uint16_t reserved;
+    uint32_t id;
+    union
+    {
+        ControlSpawn spawn;
+        ControlParams params;
+        ControlColors colors;
+        ControlMark mark;
+    };
+};
+
+struct ControlRingHeader
+{
+    char magic[8];                              // "GLCTRL\0\0"
+    uint32_t version;
+    uint32_t capacity;                          // records, a power of two
+    alignas(64) std::atomic<uint64_t> head;     // records published by the controller
+    alignas(64) std::atomic<uint64_t> tail;     // records consumed by the renderer
+    alignas(64) std::atomic<uint32_t> closed;   // controller is done once the ring drains
+};
+
+struct SceneControlStats
+{
+    uint64_t commandsApplied = 0;
+    uint64_t frames = 0;                // frames that applied at least one command
+    double applyMs = 0.0;               // mean per frame that applied commands
+    double maxApplyMs = 0.0;
+    float latencyP50Ms = 0.0f;          // controller publish to renderer apply (CtlMark)
+    float latencyP95Ms = 0.0f;
+    double seconds = 0.0;
+};
+
+// renderer side; address as for the other local tools ("unix:/path" or "tcp:host:port").
+// Controlled objects are instances (see Instances.h), InstancesInit must have run.
+bool SceneControlStart(const char* address, std::string& errorOut);
+void SceneControlStop();
+bool SceneControlRunning();
+// accept a controller and apply its pending commands; call at frame start
+void SceneControlApply();
+SceneControlStats SceneControlGetStats();
+
+struct ControllerOptions
+{
+    int objects = 2000;         // live objects the controller maintains
+    int rate = 0;               // commands per second, 0 = as fast as the ring drains
+    int batch = 256;            // commands per publish
+    double seconds = 10.0;
+    uint32_t seed = 1;
+};
+
+// synthetic controller: spawns objects, then keeps despawning, respawning, recoloring
+// and re-animating them; reports the achieved command rate
+int RunSceneController(const char* address, const ControllerOptions& options);
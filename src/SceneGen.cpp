@@ -0,0 +1,282 @@
+#include "SceneGen.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    const float kTwoPi = 6.2831853f;
+    const char kSceneMagic[5] = { 'G', 'L', 'S', 'C', 'N' };
+    const uint32_t kSceneVersion = 1;
+
+    int PickMode(Pcg32& rng, const float* weights)
+    {
+        float total = 0.0f;
+        for (int m = 0; m < ModeCount; ++m) total += std::max(0.0f, weights[m]);
+        if (total <= 0.0f) return ModeStatic;
+        float pick = rng.Unit() * total;
+        for (int m = 0; m < ModeCount; ++m)
+        {
+            pick -= std::max(0.0f, weights[m]);
+            if (pick < 0.0f) return m;
+        }
+        return ModeCount - 1;
+    }
+
+    float PolygonArea(float radius, int triangles)
+    {
+        if (triangles < 3)
+            return 1.2990381f * radius * radius * (float)triangles; // equilateral, 3*sqrt(3)/4 r^2 each
+        return 0.5f * triangles * radius * radius * sinf(kTwoPi / triangles);
+    }
+
+    void PushVertex(std::vector<float>& v, float x, float y, const float* c)
+    {
+        v.push_back(x); v.push_back(y);
+        v.push_back(c[0]); v.push_back(c[1]); v.push_back(c[2]);
+    }
+
+    bool ParseFloatList(const char* s, float* out, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            char* end = nullptr;
+            out[i] = strtof(s, &end);
+            if (end == s) return false;
+            s = end;
+            if (i + 1 < count)
+            {
+                if (*s != ',') return false;
+                ++s;
+            }
+        }
+        return *s == '\0';
+    }
+
+    template <typename T>
+    void WritePod(std::string& out, const T& v) { out.append((const char*)&v, sizeof(T)); }
+
+    struct ByteReader
+    {
+        const char* p;
+        const char* end;
+
+        bool Read(void* dst, size_t n)
+        {
+            if ((size_t)(end - p) < n) return false;
+            memcpy(dst, p, n);
+            p += n;
+            return true;
+        }
+
+        template <typename T>
+        bool Pod(T& v) { return Read(&v, sizeof(T)); }
+    };
+}
+
+void GenerateScene(const SceneGenParams& params, GeneratedScene& out)
+{
+    Pcg32 rng(params.seed);
+    const int count = std::max(0, params.objectCount);
+    const int minTris = std::max(1, params.minTriangles);
+    const int maxTris = std::max(minTris, params.maxTriangles);
+    out.objects.clear();
+    out.objects.resize(count);
+
+    // sizes and shapes first so the placement region can be derived from total area
+    std::vector<float> radii(count);
+    std::vector<int> tris(count);
+    float totalArea = 0.0f;
+    for (int i = 0; i < count; ++i)
+    {
+        float u = powf(rng.Unit(), std::max(0.01f, params.sizeSkew));
+        radii[i] = params.minSize + (params.maxSize - params.minSize) * u;
+        tris[i] = rng.Range(minTris, maxTris);
+        totalArea += PolygonArea(radii[i], tris[i]);
+    }
+
+    // overdraw = totalArea / regionArea, region is a centered square clamped to the screen
+    float overdraw = std::max(0.001f, params.overdraw);
+    float extent = std::min(1.0f, 0.5f * sqrtf(totalArea / overdraw));
+
+    for (int i = 0; i < count; ++i)
+    {
+        GeneratedObject& o = out.objects[i];
+        o.mode = PickMode(rng, params.modeWeights);
+        float r = radii[i];
+        float cx = rng.Range(-extent, extent);
+        float cy = rng.Range(-extent, extent);
+        o.center[0] = cx;
+        o.center[1] = cy;
+        o.speed = rng.Range(0.5f, 1.5f);
+        o.amplitude = o.mode == ModeTranslate ? rng.Range(0.05f, 0.3f) : 0.0f;
+        o.phase = rng.Range(0.0f, kTwoPi);
+
+        float base[3] = { rng.Range(0.2f, 1.0f), rng.Range(0.2f, 1.0f), rng.Range(0.2f, 1.0f) };
+        if (o.mode == ModeStatic)
+            base[0] = base[1] = base[2] = 1.0f;
+        const float rainbow[3][3] = { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } };
+        auto color = [&](int k) { return o.mode == ModeRainbow ? rainbow[k % 3] : base; };
+
+        float start = rng.Range(0.0f, kTwoPi);
+        if (tris[i] < 3)
+        {
+            // 1-2 triangles: independent triangles around the center
+            for (int t = 0; t < tris[i]; ++t)
+            {
+                float a = start + t * kTwoPi / 6.0f;
+                for (int k = 0; k < 3; ++k)
+                {
+                    float ak = a + k * kTwoPi / 3.0f;
+                    PushVertex(o.vertices, cx + r * cosf(ak), cy + r * sinf(ak), color(k));
+                }
+            }
+            continue;
+        }
+
+        // fan of tris[i] triangles sharing the center
+        const int segs = tris[i];
+        o.vertices.reserve(segs * 15);
+        for (int s = 0; s < segs; ++s)
+        {
+            float a0 = start + s * kTwoPi / segs;
+            float a1 = start + (s + 1) * kTwoPi / segs;
+            PushVertex(o.vertices, cx, cy, color(0));
+            PushVertex(o.vertices, cx + r * cosf(a0), cy + r * sinf(a0), color(s + 1));
+            PushVertex(o.vertices, cx + r * cosf(a1), cy + r * sinf(a1), color(s + 2));
+        }
+    }
+}
+
+void InstantiateScene(const GeneratedScene& generated, Scene& scene)
+{
+    scene.objects.reserve(scene.objects.size() + generated.objects.size());
+    for (const GeneratedObject& g : generated.objects)
+        InstantiateObject(g, scene);
+}
+
+bool InstantiateObject(const GeneratedObject& generated, Scene& scene)
+{
+    if (generated.vertices.empty()) return false;
+    SceneObject o;
+    o.mesh = CreateTriangle(generated.vertices);
+    o.vertexCount = (GLsizei)(generated.vertices.size() / 5);
+    o.mode = generated.mode;
+    o.center[0] = generated.center[0];
+    o.center[1] = generated.center[1];
+    o.speed = generated.speed;
+    o.amplitude = generated.amplitude;
+    o.phase = generated.phase;
+    scene.objects.push_back(o);
+    return true;
+}
+
+void SerializeScene(const GeneratedScene& generated, std::string& out)
+{
+    out.clear();
+    out.append(kSceneMagic, 5);
+    WritePod(out, kSceneVersion);
+    WritePod(out, (uint32_t)generated.objects.size());
+    for (const GeneratedObject& o : generated.objects)
+    {
+        WritePod(out, (uint8_t)o.mode);
+        WritePod(out, o.center[0]);
+        WritePod(out, o.center[1]);
+        WritePod(out, o.speed);
+        WritePod(out, o.amplitude);
+        WritePod(out, o.phase);
+        WritePod(out, (uint32_t)o.vertices.size());
+        if (!o.vertices.empty())
+            out.append((const char*)o.vertices.data(), o.vertices.size() * sizeof(float));
+    }
+}
+
+bool DeserializeScene(const void* data, size_t size, GeneratedScene& generated)
+{
+    ByteReader r = { (const char*)data, (const char*)data + size };
+    char magic[5];
+    uint32_t version = 0, count = 0;
+    bool ok = r.Read(magic, 5) && !memcmp(magic, kSceneMagic, 5)
+        && r.Pod(version) && version == kSceneVersion && r.Pod(count)
+        && count <= size; // every object takes at least a byte, rejects absurd counts early
+    generated.objects.clear();
+    if (ok) generated.objects.resize(count);
+    for (uint32_t i = 0; ok && i < count; ++i)
+    {
+        GeneratedObject& o = generated.objects[i];
+        uint8_t mode = 0;
+        uint32_t floats = 0;
+        ok = r.Pod(mode) && r.Pod(o.center[0]) && r.Pod(o.center[1])
+            && r.Pod(o.speed) && r.Pod(o.amplitude) && r.Pod(o.phase)
+            && r.Pod(floats) && mode < ModeCount && floats % 15 == 0
+            && (size_t)(r.end - r.p) >= (size_t)floats * sizeof(float);
+        if (!ok) break;
+        o.mode = mode;
+        o.vertices.resize(floats);
+        ok = floats == 0 || r.Read(o.vertices.data(), floats * sizeof(float));
+    }
+    if (!ok) generated.objects.clear();
+    return ok;
+}
+
+bool WriteSceneFile(const char* path, const GeneratedScene& generated)
+{
+    std::string bytes;
+    SerializeScene(generated, bytes);
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    return fclose(f) == 0 && ok;
+}
+
+bool ReadSceneFile(const char* path, GeneratedScene& generated)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    std::string bytes;
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+        bytes.append(chunk, n);
+    fclose(f);
+    return DeserializeScene(bytes.data(), bytes.size(), generated);
+}
+
+bool ParseSceneGenArg(int& i, int argc, char** argv, SceneGenParams& params)
+{
+    const char* arg = argv[i];
+    if (i + 1 >= argc) return false;
+    const char* value = argv[i + 1];
+    float pair[2];
+
+    if (!strcmp(arg, "--seed")) params.seed = (uint32_t)strtoul(value, nullptr, 10);
+    else if (!strcmp(arg, "--objects")) params.objectCount = atoi(value);
+    else if (!strcmp(arg, "--mix")) { if (!ParseFloatList(value, params.modeWeights, ModeCount)) return false; }
+    else if (!strcmp(arg, "--size"))
+    {
+        if (!ParseFloatList(value, pair, 2)) return false;
+        params.minSize = pair[0];
+        params.maxSize = pair[1];
+    }
+    else if (!strcmp(arg, "--skew")) params.sizeSkew = (float)atof(value);
+    else if (!strcmp(arg, "--overdraw")) params.overdraw = (float)atof(value);
+    else if (!strcmp(arg, "--tris"))
+    {
+        if (!ParseFloatList(value, pair, 2)) return false;
+        params.minTriangles = (int)pair[0];
+        params.maxTriangles = (int)pair[1];
+    }
+    else return false;
+
+    ++i;
+    return true;
+}
+
+const char* SceneGenUsage()
+{
+    return "  scene generator options:\n"
+           "    --seed <n>  --objects <n>  --mix <static,rainbow,pulse,translate,rotate weights>\n"
+           "    --size <min,max>  --skew <exponent>  --overdraw <factor>  --tris <min,max>\n";
+}
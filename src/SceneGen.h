@@ -0,0 +1,102 @@
+#pragma once
+#include "Scene.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Reproducible synthetic scenes for scaling studies. The same parameters and seed
+// always produce the same scene, which can be instantiated into the renderer directly
+// or written to a binary scene file and loaded later.
+
+// PCG32 (O'Neill), small state and good enough statistics for scene layout and
+// the other seeded workloads
+struct Pcg32
+{
+    uint64_t state;
+    uint64_t inc;
+
+    explicit Pcg32(uint64_t seed) : state(0), inc((seed << 1u) | 1u)
+    {
+        Next();
+        state += 0x853c49e6748fea9bULL + seed;
+        Next();
+    }
+
+    uint32_t Next()
+    {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        uint32_t xorshifted = (uint32_t)(((old >> 18u) ^ old) >> 27u);
+        uint32_t rot = (uint32_t)(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+
+    float Unit() { return (Next() >> 8) * (1.0f / 16777216.0f); }
+    float Range(float lo, float hi) { return lo + (hi - lo) * Unit(); }
+    int Range(int lo, int hi) { return hi <= lo ? lo : lo + (int)(Next() % (uint32_t)(hi - lo + 1)); }
+};
+
+// stateless integer hash for workloads that derive values from a coordinate or an
+// index instead of drawing them in sequence
+inline uint32_t HashCoords(uint32_t x, uint32_t y, uint32_t seed)
+{
+    uint32_t h = x * 0x8da6b343u ^ y * 0xd8163841u ^ seed * 0xcb1ab31fu;
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    h *= 0x297a2d39u;
+    h ^= h >> 15;
+    return h;
+}
+
+inline uint32_t HashIndex(uint64_t index, uint32_t seed)
+{
+    return HashCoords((uint32_t)index, (uint32_t)(index >> 32), seed);
+}
+
+struct SceneGenParams
+{
+    uint32_t seed = 1;
+    int objectCount = 1000;
+    float modeWeights[ModeCount] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f }; // static, rainbow, pulse, translate, rotate
+    float minSize = 0.01f;          // object radius range in NDC
+    float maxSize = 0.08f;
+    float sizeSkew = 2.0f;          // 1 = uniform, larger values bias towards small objects
+    float overdraw = 1.0f;          // total object area / covered area; objects are packed to hit it
+    int minTriangles = 1;           // mesh complexity per object, 1 = plain triangle,
+    int maxTriangles = 1;           // otherwise a fan of that many triangles
+};
+
+struct GeneratedObject
+{
+    int mode = ModeStatic;
+    float center[2] = { 0.0f, 0.0f };
+    float speed = 1.0f;
+    float amplitude = 0.0f;
+    float phase = 0.0f;
+    std::vector<float> vertices;    // pos2 + color3 interleaved, as CreateTriangle takes
+};
+
+struct GeneratedScene
+{
+    std::vector<GeneratedObject> objects;
+};
+
+void GenerateScene(const SceneGenParams& params, GeneratedScene& out);
+
+// upload into the renderer; appends to scene
+void InstantiateScene(const GeneratedScene& generated, Scene& scene);
+// one object at a time, for uploads spread over several frames; false if it has no vertices
+bool InstantiateObject(const GeneratedObject& generated, Scene& scene);
+
+bool WriteSceneFile(const char* path, const GeneratedScene& generated);
+bool ReadSceneFile(const char* path, GeneratedScene& generated);
+
+// same format as the scene file, for sending a scene to another process
+void SerializeScene(const GeneratedScene& generated, std::string& out);
+bool DeserializeScene(const void* data, size_t size, GeneratedScene& generated);
+
+// consumes one generator option at argv[i] (advancing i past its value);
+// returns false if argv[i] is not a generator option
+bool ParseSceneGenArg(int& i, int argc, char** argv, SceneGenParams& params);
+const char* SceneGenUsage();
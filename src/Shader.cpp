@@ -1,10 +1,52 @@
 #include "Shader.h"
-#include "Shader.h"
+#include "Capture.h"
+#include "Gles.h"
 #include <vector>
 #include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+static ShaderStats gShaderStats;
+static std::string gBinaryCacheDir;
+static std::string gBinaryCacheDriver;
+
+static const uint32_t kBinaryMagic = 0x42504c47; // "GLPB"
+
+uint64_t HashBytes(uint64_t h, const void* data, size_t size)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < size; ++i)
+    {
+        h ^= bytes[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+void Shader::SetBinaryCache(const std::string& dir, const std::string& driverKey)
+{
+    gBinaryCacheDir = dir;
+    gBinaryCacheDriver = driverKey;
+}
+
+const ShaderStats& Shader::GetStats()
+{
+    return gShaderStats;
+}
 
 bool Shader::CompileShader(GLuint shader, const char* src, std::string& errorOut)
 {
+    // sources are written for desktop 4.3; the binary cache and captures keep them as is
+    std::string translated;
+    if (gGfxGles)
+    {
+        GLint stage = 0;
+        glGetShaderiv(shader, GL_SHADER_TYPE, &stage);
+        translated = TranslateShaderToGles(src, (GLenum)stage);
+        src = translated.c_str();
+    }
     glShaderSource(shader, 1, &src, nullptr);
     glCompileShader(shader);
 
@@ -23,6 +65,35 @@ bool Shader::CompileShader(GLuint shader, const char* src, std::string& errorOut
 }
 
 bool Shader::CreateFromSource(const char* vertexSrc, const char* fragmentSrc, std::string& errorOut)
+{
+    auto start = std::chrono::steady_clock::now();
+    bool ok = false;
+    std::string cachePath;
+    if (!gBinaryCacheDir.empty())
+    {
+        // a separator byte keeps "ab"+"c" and "a"+"bc" apart
+        uint64_t h = HashBytes(kFnvOffset, gBinaryCacheDriver.data(), gBinaryCacheDriver.size());
+        h = HashBytes(h, vertexSrc, strlen(vertexSrc) + 1);
+        h = HashBytes(h, fragmentSrc, strlen(fragmentSrc) + 1);
+        char name[32];
+        snprintf(name, sizeof(name), "/%016llx.bin", (unsigned long long)h);
+        cachePath = gBinaryCacheDir + name;
+        ok = LoadBinary(cachePath);
+        if (ok) gShaderStats.binaryHits++;
+    }
+    if (!ok)
+    {
+        ok = Build(vertexSrc, fragmentSrc, errorOut);
+        if (ok && !cachePath.empty()) SaveBinary(cachePath);
+    }
+    gShaderStats.buildMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (ok && gCaptureActive) CaptureCreateProgram(ID, vertexSrc, fragmentSrc);
+    if (ok) gShaderStats.programsLinked++;
+    else gShaderStats.failures++;
+    return ok;
+}
+
+bool Shader::Build(const char* vertexSrc, const char* fragmentSrc, std::string& errorOut)
 {
     GLuint vs = glCreateShader(GL_VERTEX_SHADER);
     if (!CompileShader(vs, vertexSrc, errorOut))
@@ -42,21 +113,12 @@ bool Shader::CreateFromSource(const char* vertexSrc, const char* fragmentSrc, st
     ID = glCreateProgram();
     glAttachShader(ID, vs);
     glAttachShader(ID, fs);
-    glLinkProgram(ID);
-
-    GLint success = 0;
-    glGetProgramiv(ID, GL_LINK_STATUS, &success);
-    if (!success)
+    if (!gBinaryCacheDir.empty())
+        glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    if (!LinkProgram(errorOut))
     {
-        GLint logLen = 0;
-        glGetProgramiv(ID, GL_INFO_LOG_LENGTH, &logLen);
-        std::vector<char> logBuf(logLen ? logLen : 1);
-        glGetProgramInfoLog(ID, logLen, nullptr, logBuf.data());
-        errorOut = std::string(logBuf.data());
         glDeleteShader(vs);
         glDeleteShader(fs);
-        glDeleteProgram(ID);
-        ID = 0;
         return false;
     }
 
@@ -66,4 +128,92 @@ bool Shader::CreateFromSource(const char* vertexSrc, const char* fragmentSrc, st
     glDeleteShader(vs);
     glDeleteShader(fs);
     return true;
-}
\ No newline at end of file
+}
+
+bool Shader::LinkProgram(std::string& errorOut)
+{
+    glLinkProgram(ID);
+
+    GLint success = 0;
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    if (success)
+        return true;
+    GLint logLen = 0;
+    glGetProgramiv(ID, GL_INFO_LOG_LENGTH, &logLen);
+    std::vector<char> logBuf(logLen ? logLen : 1);
+    glGetProgramInfoLog(ID, logLen, nullptr, logBuf.data());
+    errorOut = std::string(logBuf.data());
+    glDeleteProgram(ID);
+    ID = 0;
+    return false;
+}
+
+bool Shader::CreateComputeFromSource(const char* computeSrc, std::string& errorOut)
+{
+    auto start = std::chrono::steady_clock::now();
+    GLuint cs = glCreateShader(GL_COMPUTE_SHADER);
+    bool ok = CompileShader(cs, computeSrc, errorOut);
+    if (ok)
+    {
+        ID = glCreateProgram();
+        glAttachShader(ID, cs);
+        ok = LinkProgram(errorOut);
+        if (ok) glDetachShader(ID, cs);
+    }
+    glDeleteShader(cs);
+    gShaderStats.buildMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (ok) gShaderStats.programsLinked++;
+    else gShaderStats.failures++;
+    return ok;
+}
+
+bool Shader::LoadBinary(const std::string& path)
+{
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    uint32_t header[2] = { 0, 0 };
+    std::vector<char> blob;
+    if (fread(header, sizeof(header), 1, f) == 1 && header[0] == kBinaryMagic)
+    {
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f) - (long)sizeof(header);
+        fseek(f, (long)sizeof(header), SEEK_SET);
+        if (size > 0)
+        {
+            blob.resize((size_t)size);
+            if (fread(blob.data(), 1, blob.size(), f) != blob.size()) blob.clear();
+        }
+    }
+    fclose(f);
+    if (blob.empty()) return false;
+
+    ID = glCreateProgram();
+    glProgramBinary(ID, (GLenum)header[1], blob.data(), (GLsizei)blob.size());
+    GLint success = 0;
+    glGetProgramiv(ID, GL_LINK_STATUS, &success);
+    if (!success)
+    {
+        // driver update or corrupt file; rebuild from source and overwrite it
+        glDeleteProgram(ID);
+        ID = 0;
+        return false;
+    }
+    return true;
+}
+
+void Shader::SaveBinary(const std::string& path) const
+{
+    GLint length = 0;
+    glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+    std::vector<char> blob((size_t)length);
+    GLenum format = 0;
+    glGetProgramBinary(ID, length, nullptr, &format, blob.data());
+
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) return;
+    uint32_t header[2] = { kBinaryMagic, (uint32_t)format };
+    bool ok = fwrite(header, sizeof(header), 1, f) == 1 && fwrite(blob.data(), 1, blob.size(), f) == blob.size();
+    if (fclose(f) != 0 || !ok)
+        remove(path.c_str());
+}
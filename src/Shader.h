@@ -1,6 +1,23 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <glad/glad.h>
+#include "Gfx.h"
+
+// FNV-1a, for in-process and on-disk cache keys (program binaries, pipeline states);
+// start from kFnvOffset and chain calls to hash several fields
+const uint64_t kFnvOffset = 14695981039346656037ull;
+uint64_t HashBytes(uint64_t h, const void* data, size_t size);
+
+// totals across every program built in this process
+struct ShaderStats
+{
+    unsigned programsLinked = 0;
+    unsigned failures = 0;
+    unsigned binaryHits = 0;    // programs loaded from the binary cache instead of compiled
+    double buildMs = 0.0;   // compile + link (or binary load) wall time
+};
 
 class Shader
 {
@@ -8,12 +25,23 @@ public:
     Shader() : ID(0) {}
     // build shader from source strings
     bool CreateFromSource(const char* vertexSrc, const char* fragmentSrc, std::string& errorOut);
-    void Use() const { glUseProgram(ID); }
+    // compute-only program; not binary cached and not recorded by captures
+    bool CreateComputeFromSource(const char* computeSrc, std::string& errorOut);
+    void Use() const { GfxUseProgram(ID); }
     GLuint GetID() const { return ID; }
     void Destroy() { if (ID) { glDeleteProgram(ID); ID = 0; } }
 
+    static const ShaderStats& GetStats();
+    // Cache linked program binaries in dir (which must exist), keyed by the driver string
+    // and the sources. Empty dir turns the cache off, which is the default.
+    static void SetBinaryCache(const std::string& dir, const std::string& driverKey);
+
 private:
     GLuint ID;
     bool CompileShader(GLuint shader, const char* src, std::string& errorOut);
+    bool LinkProgram(std::string& errorOut);
+    bool Build(const char* vertexSrc, const char* fragmentSrc, std::string& errorOut);
+    bool LoadBinary(const std::string& path);
+    void SaveBinary(const std::string& path) const;
 };
 
@@ -0,0 +1,216 @@
+#include "SharedMemory.h"
+#include "Process.h"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace
+{
+    std::atomic<unsigned> gSharedMemoryCounter(0);
+
+#ifndef _WIN32
+    int CreateAnonymousFd(size_t size)
+    {
+        int fd = -1;
+#ifdef __linux__
+        fd = memfd_create("graphics1", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+#else
+        char name[64];
+        snprintf(name, sizeof(name), "/graphics1-%d-%u", CurrentProcessId(), gSharedMemoryCounter++);
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if (fd >= 0) shm_unlink(name);
+#endif
+        if (fd >= 0 && ftruncate(fd, (off_t)size) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+#ifdef __linux__
+        // the peer checks the size once when it maps the fd; sealed, it cannot shrink the
+        // file under either mapping afterwards
+        if (fd >= 0 && fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) != 0)
+        {
+            close(fd);
+            fd = -1;
+        }
+#endif
+        return fd;
+    }
+
+    bool MapFd(int fd, size_t size, SharedMemory& out)
+    {
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED)
+            return false;
+        out.data = p;
+        out.size = size;
+        out.handle = fd;
+        return true;
+    }
+#endif
+}
+
+bool SharedMemoryCreate(size_t size, SharedMemory& out, std::string& errorOut)
+{
+    out = SharedMemory();
+#ifdef _WIN32
+    char name[96];
+    snprintf(name, sizeof(name), "Local\\graphics1-%d-%u", CurrentProcessId(), gSharedMemoryCounter++);
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+        (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xffffffffu), name);
+    if (!mapping)
+    {
+        errorOut = "CreateFileMapping failed";
+        return false;
+    }
+    void* p = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!p)
+    {
+        CloseHandle(mapping);
+        errorOut = "MapViewOfFile failed";
+        return false;
+    }
+    out.data = p;
+    out.size = size;
+    out.handle = (intptr_t)mapping;
+    out.name = name;
+    return true;
+#else
+    int fd = CreateAnonymousFd(size);
+    if (fd < 0)
+    {
+        errorOut = std::string("cannot create shared memory: ") + strerror(errno);
+        return false;
+    }
+    if (!MapFd(fd, size, out))
+    {
+        errorOut = std::string("mmap failed: ") + strerror(errno);
+        close(fd);
+        return false;
+    }
+    return true;
+#endif
+}
+
+void SharedMemoryClose(SharedMemory& shm)
+{
+#ifdef _WIN32
+    if (shm.data) UnmapViewOfFile(shm.data);
+    if (shm.handle != -1) CloseHandle((HANDLE)shm.handle);
+#else
+    if (shm.data) munmap(shm.data, shm.size);
+    if (shm.handle != -1) close((int)shm.handle);
+#endif
+    shm = SharedMemory();
+}
+
+bool SharedMemorySend(NetSocket socket, const SharedMemory& shm)
+{
+    uint64_t size = shm.size;
+#ifdef _WIN32
+    std::string payload((const char*)&size, sizeof(size));
+    payload += shm.name;
+    return NetSendMessage(socket, 0, payload.data(), (uint32_t)payload.size());
+#else
+    // the size travels as ordinary data next to the descriptor
+    iovec iov;
+    iov.iov_base = &size;
+    iov.iov_len = sizeof(size);
+    char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    int fd = (int)shm.handle;
+    memcpy(CMSG_DATA(cmsg), &fd, sizeof(fd));
+    return sendmsg((int)socket, &msg, 0) == (ssize_t)sizeof(size);
+#endif
+}
+
+bool SharedMemoryReceive(NetSocket socket, SharedMemory& out, std::string& errorOut)
+{
+    out = SharedMemory();
+#ifdef _WIN32
+    uint32_t type = 0;
+    std::string payload;
+    if (!NetRecvMessage(socket, type, payload, sizeof(uint64_t) + MAX_PATH) || payload.size() <= sizeof(uint64_t))
+    {
+        errorOut = "no shared memory handle received";
+        return false;
+    }
+    uint64_t size = 0;
+    memcpy(&size, payload.data(), sizeof(size));
+    std::string name = payload.substr(sizeof(size));
+    HANDLE mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+    void* p = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)size) : nullptr;
+    if (!p)
+    {
+        if (mapping) CloseHandle(mapping);
+        errorOut = "cannot open shared memory " + name;
+        return false;
+    }
+    out.data = p;
+    out.size = (size_t)size;
+    out.handle = (intptr_t)mapping;
+    out.name = name;
+    return true;
+#else
+    uint64_t size = 0;
+    iovec iov;
+    iov.iov_base = &size;
+    iov.iov_len = sizeof(size);
+    char control[CMSG_SPACE(sizeof(int))];
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t n;
+    do n = recvmsg((int)socket, &msg, 0); while (n < 0 && errno == EINTR);
+    cmsghdr* cmsg = n == (ssize_t)sizeof(size) ? CMSG_FIRSTHDR(&msg) : nullptr;
+    if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+    {
+        errorOut = "no shared memory descriptor received (unix sockets only)";
+        return false;
+    }
+    int fd = -1;
+    memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+    // the size is only the peer's claim; mapping past the end of the file faults on access
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 0 || (uint64_t)st.st_size < size || size == 0)
+    {
+        errorOut = "shared memory is smaller than announced";
+        close(fd);
+        return false;
+    }
+    if (!MapFd(fd, (size_t)size, out))
+    {
+        errorOut = std::string("mmap failed: ") + strerror(errno);
+        close(fd);
+        return false;
+    }
+    return true;
+#endif
+}
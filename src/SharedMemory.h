@@ -0,0 +1,24 @@
+#pragma once
+#include "Net.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Shared memory between this process and a local peer. The mapping has no name in
+// the filesystem (memfd on Linux, an immediately unlinked shm object on other POSIX
+// systems, a pagefile-backed mapping on Windows); it is handed to the peer over an
+// already connected socket, as a file descriptor (SCM_RIGHTS, unix sockets only) or
+// as the mapping name on Windows.
+struct SharedMemory
+{
+    void* data = nullptr;
+    size_t size = 0;
+    intptr_t handle = -1;   // fd or HANDLE
+    std::string name;       // Windows only
+};
+
+bool SharedMemoryCreate(size_t size, SharedMemory& out, std::string& errorOut);
+void SharedMemoryClose(SharedMemory& shm);
+
+bool SharedMemorySend(NetSocket socket, const SharedMemory& shm);
+bool SharedMemoryReceive(NetSocket socket, SharedMemory& out, std::string& errorOut);
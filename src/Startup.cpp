@@ -0,0 +1,72 @@
+#include "Startup.h"
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    struct PhaseRecord
+    {
+        const char* name;
+        double startMs;
+        double endMs;
+        std::thread::id thread;
+    };
+
+    struct StartupState
+    {
+        Clock::time_point begin = Clock::now();
+        std::thread::id mainThread = std::this_thread::get_id();
+        double firstFrameMs = 0.0;
+        std::mutex mutex;
+        std::vector<PhaseRecord> phases;
+    } gStartup;
+}
+
+void StartupBegin()
+{
+    gStartup.begin = Clock::now();
+    gStartup.mainThread = std::this_thread::get_id();
+    gStartup.firstFrameMs = 0.0;
+    std::lock_guard<std::mutex> lock(gStartup.mutex);
+    gStartup.phases.clear();
+}
+
+double StartupElapsedMs()
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - gStartup.begin).count();
+}
+
+void StartupRecord(const char* phase, double startMs, double endMs)
+{
+    std::lock_guard<std::mutex> lock(gStartup.mutex);
+    gStartup.phases.push_back({ phase, startMs, endMs, std::this_thread::get_id() });
+}
+
+void StartupFirstFrame()
+{
+    if (gStartup.firstFrameMs == 0.0)
+        gStartup.firstFrameMs = StartupElapsedMs();
+}
+
+double StartupTimeToFirstFrameMs()
+{
+    return gStartup.firstFrameMs;
+}
+
+void StartupReport(bool detailed)
+{
+    printf("time to first frame: %.1f ms\n", gStartup.firstFrameMs);
+    if (!detailed)
+        return;
+    std::lock_guard<std::mutex> lock(gStartup.mutex);
+    for (const PhaseRecord& p : gStartup.phases)
+    {
+        printf("  %-24s %8.1f ms  [%7.1f .. %7.1f]%s\n", p.name, p.endMs - p.startMs, p.startMs, p.endMs,
+            p.thread == gStartup.mainThread ? "" : "  (background)");
+    }
+}
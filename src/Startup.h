@@ -0,0 +1,25 @@
+#pragma once
+
+// Startup phase timing. Phases may run on any thread and overlap; the report shows
+// where each one started relative to StartupBegin() so the overlap is visible.
+
+void StartupBegin();
+// time since StartupBegin() in milliseconds
+double StartupElapsedMs();
+void StartupRecord(const char* phase, double startMs, double endMs);
+
+// records the phase from construction to destruction
+struct StartupPhase
+{
+    explicit StartupPhase(const char* name) : name(name), startMs(StartupElapsedMs()) {}
+    ~StartupPhase() { StartupRecord(name, startMs, StartupElapsedMs()); }
+
+    const char* name;
+    double startMs;
+};
+
+// call once after the first frame was presented
+void StartupFirstFrame();
+double StartupTimeToFirstFrameMs();
+// prints time to first frame, and every phase when detailed is set
+void StartupReport(bool detailed);
@@ -0,0 +1,15 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Timing and sample statistics shared by the benchmarks and the live tools.
+
+// steady clock in nanoseconds; the same clock in every process on the machine, so
+// timestamps can be compared across the shared-memory rings
+uint64_t NowNs();
+
+// mean of the two middle samples for an even count; 0 if v is empty
+double Median(std::vector<double> v);
+
+// the sample at fraction p (0 = min, 1 = max) of v, nearest rank; 0 if v is empty
+float Percentile(std::vector<float> v, float p);
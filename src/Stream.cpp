@@ -0,0 +1,688 @@
+#include "Stream.h"
+#include "Net.h"
+#include "Readback.h"
+#include "RenderTarget.h"
+#include "Stats.h"
+#include "Window.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STREAM_SSE2 1
+#endif
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    enum StreamMessage : uint32_t
+    {
+        MsgStreamFrame = 1,     // server -> viewer: FrameHeader, then per dirty tile TileHeader + codec bytes
+        MsgStreamAck,           // viewer -> server: u32 frame number once displayed
+    };
+
+    struct FrameHeader
+    {
+        uint32_t frame;
+        uint32_t width, height;
+        uint32_t tileSize;
+        uint32_t tileCount;     // dirty tiles in this message
+        uint32_t keyframe;      // every tile present, viewer resets its image
+    };
+
+    struct TileHeader
+    {
+        uint16_t tx, ty;
+        uint32_t size;
+    };
+
+    const int kTileSize = 32;
+    const int kLatencyHistory = 256;
+    const size_t kMaxFrameMessage = (size_t)1 << 30;
+    const size_t kLatencySamples = 8192;
+
+    // ---- codec: run-length coding of whole RGBA pixels ----
+    // control byte c: c & 0x80 -> ((c & 0x7f) + 1) copies of the next pixel,
+    // otherwise (c + 1) literal pixels follow. Flat-shaded frames compress very well
+    // and both directions are a single pass with no tables.
+
+    void EncodePixels(const uint32_t* px, size_t n, std::vector<uint8_t>& out)
+    {
+        size_t i = 0;
+        while (i < n)
+        {
+            size_t run = 1;
+            while (i + run < n && run < 128 && px[i + run] == px[i]) ++run;
+            if (run >= 2)
+            {
+                out.push_back((uint8_t)(0x80 | (run - 1)));
+                const uint8_t* b = (const uint8_t*)&px[i];
+                out.insert(out.end(), b, b + 4);
+                i += run;
+                continue;
+            }
+            size_t start = i;
+            while (i < n && i - start < 128 && !(i + 1 < n && px[i + 1] == px[i])) ++i;
+            out.push_back((uint8_t)(i - start - 1));
+            const uint8_t* b = (const uint8_t*)&px[start];
+            out.insert(out.end(), b, b + (i - start) * 4);
+        }
+    }
+
+    bool DecodePixels(const uint8_t* src, size_t size, uint32_t* px, size_t n)
+    {
+        const uint8_t* end = src + size;
+        size_t i = 0;
+        while (src < end && i < n)
+        {
+            uint8_t c = *src++;
+            size_t count = (size_t)(c & 0x7f) + 1;
+            if (count > n - i) return false;
+            if (c & 0x80)
+            {
+                if (end - src < 4) return false;
+                uint32_t v;
+                memcpy(&v, src, 4);
+                src += 4;
+                std::fill(px + i, px + i + count, v);
+            }
+            else
+            {
+                if ((size_t)(end - src) < count * 4) return false;
+                memcpy(px + i, src, count * 4);
+                src += count * 4;
+            }
+            i += count;
+        }
+        return i == n && src == end;
+    }
+
+    // compares one tile of two equally sized frames
+    bool TileEqual(const uint8_t* a, const uint8_t* b, size_t stride, size_t rowBytes, int rows)
+    {
+        for (int y = 0; y < rows; ++y, a += stride, b += stride)
+        {
+#ifdef STREAM_SSE2
+            __m128i diff = _mm_setzero_si128();
+            size_t i = 0;
+            for (; i + 16 <= rowBytes; i += 16)
+            {
+                __m128i x = _mm_loadu_si128((const __m128i*)(a + i));
+                __m128i z = _mm_loadu_si128((const __m128i*)(b + i));
+                diff = _mm_or_si128(diff, _mm_xor_si128(x, z));
+            }
+            if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, _mm_setzero_si128())) != 0xFFFF)
+                return false;
+            if (i < rowBytes && memcmp(a + i, b + i, rowBytes - i) != 0)
+                return false;
+#else
+            if (memcmp(a, b, rowBytes) != 0)
+                return false;
+#endif
+        }
+        return true;
+    }
+
+    struct PendingFrame
+    {
+        std::vector<uint8_t> pixels;
+        int width = 0;
+        int height = 0;
+        uint32_t frame = 0;
+    };
+
+    struct Client
+    {
+        NetSocket socket = kInvalidSocket;
+        // the frame being sent, shared by all clients it went to; a client still sending
+        // one when the next is ready skips that frame and resyncs on a keyframe
+        std::shared_ptr<const std::vector<uint8_t>> out;
+        size_t sent = 0;
+        bool skipped = false;
+        std::vector<uint8_t> in;    // an acknowledgement not received completely yet
+    };
+
+    struct StreamServer
+    {
+        bool running = false;
+        NetSocket listener = kInvalidSocket;
+        std::thread thread;
+        std::vector<std::thread> encoders;
+
+        // render thread -> stream thread handoff, latest frame wins
+        std::mutex mutex;
+        std::condition_variable wake;
+        PendingFrame pending;
+        bool hasPending = false;
+        bool stop = false;
+
+        // render thread only
+        ReadbackRing readback;
+
+        // stream thread only
+        PendingFrame current;
+        std::vector<uint8_t> previous;
+        int prevWidth = 0;
+        int prevHeight = 0;
+        std::vector<Client> clients;
+
+        // encoder pool: one job (a frame) at a time, tiles handed out by an atomic counter
+        std::mutex jobMutex;
+        std::condition_variable jobWake;
+        std::condition_variable jobDone;
+        uint64_t jobGeneration = 0;
+        int jobBusy = 0;
+        std::atomic<int> nextTile;
+        int tilesX = 0;
+        int tilesY = 0;
+        bool keyframe = false;
+        std::vector<std::vector<uint8_t>> tileOut; // empty = unchanged
+        std::vector<uint8_t> tileDirty;
+
+        std::mutex statsMutex;
+        StreamStats stats;
+        Clock::time_point started;
+        Clock::time_point captureTimes[kLatencyHistory];
+        std::vector<float> latencies;   // ring buffer of the last kLatencySamples
+        size_t latencyNext = 0;
+    } gStream;
+
+    void EncodeTiles()
+    {
+        StreamServer& s = gStream;
+        const int width = s.current.width;
+        const int height = s.current.height;
+        const size_t stride = (size_t)width * 4;
+        std::vector<uint32_t> scratch(kTileSize * kTileSize);
+        for (;;)
+        {
+            int t = s.nextTile.fetch_add(1);
+            if (t >= s.tilesX * s.tilesY) break;
+            int tx = t % s.tilesX;
+            int ty = t / s.tilesX;
+            int x0 = tx * kTileSize;
+            int y0 = ty * kTileSize;
+            int w = std::min(kTileSize, width - x0);
+            int h = std::min(kTileSize, height - y0);
+            size_t offset = (size_t)y0 * stride + (size_t)x0 * 4;
+
+            std::vector<uint8_t>& out = s.tileOut[t];
+            out.clear();
+            s.tileDirty[t] = s.keyframe || !TileEqual(&s.current.pixels[offset], &s.previous[offset], stride, (size_t)w * 4, h);
+            if (!s.tileDirty[t]) continue;
+
+            for (int y = 0; y < h; ++y)
+                memcpy(&scratch[(size_t)y * w], &s.current.pixels[offset + y * stride], (size_t)w * 4);
+            EncodePixels(scratch.data(), (size_t)w * h, out);
+        }
+    }
+
+    void EncoderMain()
+    {
+        StreamServer& s = gStream;
+        uint64_t seen = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(s.jobMutex);
+                s.jobWake.wait(lock, [&] { return s.stop || s.jobGeneration != seen; });
+                // finish a job handed out together with the stop, the stream thread waits for it
+                if (s.jobGeneration == seen) return;
+                seen = s.jobGeneration;
+            }
+            EncodeTiles();
+            std::lock_guard<std::mutex> lock(s.jobMutex);
+            if (--s.jobBusy == 0) s.jobDone.notify_one();
+        }
+    }
+
+    // diff + compress the current frame on the stream thread and all encoders
+    void EncodeFrame()
+    {
+        StreamServer& s = gStream;
+        s.keyframe = s.previous.size() != s.current.pixels.size()
+            || s.prevWidth != s.current.width || s.prevHeight != s.current.height;
+        s.tilesX = (s.current.width + kTileSize - 1) / kTileSize;
+        s.tilesY = (s.current.height + kTileSize - 1) / kTileSize;
+        s.tileOut.resize((size_t)s.tilesX * s.tilesY);
+        s.tileDirty.assign(s.tileOut.size(), 0);
+        if (s.keyframe)
+            s.previous.assign(s.current.pixels.size(), 0);
+        s.nextTile.store(0);
+        {
+            std::lock_guard<std::mutex> lock(s.jobMutex);
+            s.jobBusy = (int)s.encoders.size();
+            ++s.jobGeneration;
+        }
+        s.jobWake.notify_all();
+        EncodeTiles();
+        std::unique_lock<std::mutex> lock(s.jobMutex);
+        s.jobDone.wait(lock, [&] { return s.jobBusy == 0; });
+    }
+
+    void RecordLatency(uint32_t frame)
+    {
+        StreamServer& s = gStream;
+        float ms = std::chrono::duration<float, std::milli>(Clock::now() - s.captureTimes[frame % kLatencyHistory]).count();
+        std::lock_guard<std::mutex> lock(s.statsMutex);
+        if (s.latencies.size() < kLatencySamples) s.latencies.push_back(ms);
+        else s.latencies[s.latencyNext++ % kLatencySamples] = ms;
+    }
+
+    // reads the acknowledgements that arrived, in NetSendMessage framing; false if the
+    // viewer is gone or sent anything else
+    bool ReadAcks(Client& c)
+    {
+        const size_t kAckBytes = 8 + sizeof(uint32_t);
+        uint8_t buffer[16 * kAckBytes];
+        for (;;)
+        {
+            long long n = NetRecvSome(c.socket, buffer, sizeof(buffer));
+            if (n < 0) return false;
+            if (n == 0) return true;
+            c.in.insert(c.in.end(), buffer, buffer + n);
+            size_t pos = 0;
+            for (; c.in.size() - pos >= 8; pos += kAckBytes)
+            {
+                uint32_t header[2];
+                memcpy(header, &c.in[pos], sizeof(header));
+                if (header[0] != MsgStreamAck || header[1] != sizeof(uint32_t)) return false;
+                if (c.in.size() - pos < kAckBytes) break;
+                uint32_t frame;
+                memcpy(&frame, &c.in[pos + 8], sizeof(frame));
+                RecordLatency(frame);
+            }
+            c.in.erase(c.in.begin(), c.in.begin() + pos);
+        }
+    }
+
+    // pushes the client's frame as far as its socket takes it; false on error
+    bool FlushClient(Client& c)
+    {
+        while (c.out && c.sent < c.out->size())
+        {
+            long long n = NetSendSome(c.socket, c.out->data() + c.sent, c.out->size() - c.sent);
+            if (n < 0) return false;
+            if (n == 0) return true;
+            c.sent += (size_t)n;
+        }
+        c.out.reset();
+        return true;
+    }
+
+    void ServiceClients()
+    {
+        StreamServer& s = gStream;
+        while (NetPoll(s.listener, 0))
+        {
+            NetSocket c = NetAccept(s.listener);
+            if (c == kInvalidSocket) break;
+            NetSetNonBlocking(c, true);
+            Client client;
+            client.socket = c;
+            s.clients.push_back(client);
+            s.prevWidth = 0; // next frame is a keyframe for everybody
+        }
+
+        for (size_t i = 0; i < s.clients.size();)
+        {
+            Client& c = s.clients[i];
+            if (!ReadAcks(c) || !FlushClient(c))
+            {
+                NetClose(c.socket);
+                s.clients.erase(s.clients.begin() + i);
+                continue;
+            }
+            ++i;
+        }
+    }
+
+    void StreamMain()
+    {
+        StreamServer& s = gStream;
+        for (;;)
+        {
+            // clients with a frame still going out are serviced more often
+            bool sending = false;
+            for (const Client& c : s.clients)
+                sending = sending || c.out;
+            {
+                std::unique_lock<std::mutex> lock(s.mutex);
+                s.wake.wait_for(lock, std::chrono::milliseconds(sending ? 1 : 5), [&] { return s.stop || s.hasPending; });
+                if (s.stop) return;
+                if (s.hasPending)
+                {
+                    std::swap(s.current, s.pending);
+                    s.hasPending = false;
+                }
+                else
+                    s.current.width = 0;
+            }
+            ServiceClients();
+            if (s.current.width == 0 || s.clients.empty())
+                continue;
+
+            // a client that skipped a frame and is free again resyncs on a keyframe
+            for (const Client& c : s.clients)
+                if (c.skipped && !c.out)
+                    s.prevWidth = 0;
+            EncodeFrame();
+
+            FrameHeader header = { s.current.frame, (uint32_t)s.current.width, (uint32_t)s.current.height,
+                (uint32_t)kTileSize, 0, s.keyframe ? 1u : 0u };
+            // the NetSendMessage framing is written in front, so clients get the bytes as is
+            auto message = std::make_shared<std::vector<uint8_t>>(8 + sizeof(header), 0);
+            uint64_t raw = 0;
+            for (size_t t = 0; t < s.tileOut.size(); ++t)
+            {
+                if (!s.tileDirty[t]) continue;
+                TileHeader th = { (uint16_t)(t % s.tilesX), (uint16_t)(t / s.tilesX), (uint32_t)s.tileOut[t].size() };
+                const uint8_t* p = (const uint8_t*)&th;
+                message->insert(message->end(), p, p + sizeof(th));
+                message->insert(message->end(), s.tileOut[t].begin(), s.tileOut[t].end());
+                raw += (uint64_t)std::min(kTileSize, s.current.width - th.tx * kTileSize) *
+                    std::min(kTileSize, s.current.height - th.ty * kTileSize) * 4;
+                ++header.tileCount;
+            }
+            uint32_t framing[2] = { MsgStreamFrame, (uint32_t)(message->size() - 8) };
+            memcpy(message->data(), framing, sizeof(framing));
+            memcpy(message->data() + 8, &header, sizeof(header));
+
+            uint64_t sentBytes = 0;
+            uint64_t skipped = 0;
+            for (size_t i = 0; i < s.clients.size();)
+            {
+                Client& c = s.clients[i];
+                if (c.out || (c.skipped && !s.keyframe))
+                {
+                    c.skipped = true;
+                    ++skipped;
+                    ++i;
+                    continue;
+                }
+                c.out = message;
+                c.sent = 0;
+                c.skipped = false;
+                sentBytes += message->size();
+                if (!FlushClient(c))
+                {
+                    NetClose(c.socket);
+                    s.clients.erase(s.clients.begin() + i);
+                    continue;
+                }
+                ++i;
+            }
+
+            std::swap(s.previous, s.current.pixels);
+            s.prevWidth = s.current.width;
+            s.prevHeight = s.current.height;
+
+            std::lock_guard<std::mutex> lock(s.statsMutex);
+            s.stats.framesSent++;
+            s.stats.tilesTotal += s.tileOut.size();
+            s.stats.tilesDirty += header.tileCount;
+            s.stats.rawBytes += raw;
+            s.stats.sentBytes += sentBytes;
+            s.stats.clientFramesSkipped += skipped;
+        }
+    }
+
+    // hands a finished readback to the stream thread, replacing one it did not pick up yet
+    void HandOff(const ReadbackFrame& frame)
+    {
+        StreamServer& s = gStream;
+        const size_t bytes = (size_t)frame.width * frame.height * 4;
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            if (s.hasPending)
+            {
+                std::lock_guard<std::mutex> statsLock(s.statsMutex);
+                s.stats.framesDropped++;
+            }
+            s.pending.pixels.assign(frame.pixels, frame.pixels + bytes);
+            s.pending.width = frame.width;
+            s.pending.height = frame.height;
+            s.pending.frame = frame.frame;
+            s.hasPending = true;
+        }
+        s.wake.notify_one();
+    }
+}
+
+bool StreamServerStart(const char* address, std::string& errorOut)
+{
+    StreamServer& s = gStream;
+    if (s.running) return true;
+    if (!NetInit())
+    {
+        errorOut = "socket init failed";
+        return false;
+    }
+    std::string bound;
+    s.listener = NetListen(address, bound);
+    if (s.listener == kInvalidSocket)
+    {
+        errorOut = std::string("cannot listen on ") + address;
+        NetShutdown();
+        return false;
+    }
+    printf("streaming on %s\n", bound.c_str());
+
+    s.stop = false;
+    s.hasPending = false;
+    s.stats = StreamStats();
+    s.latencies.clear();
+    s.latencyNext = 0;
+    s.started = Clock::now();
+    s.thread = std::thread(StreamMain);
+    unsigned cores = std::thread::hardware_concurrency();
+    int helpers = (int)std::min(3u, cores > 2 ? cores - 2 : 0u);
+    for (int i = 0; i < helpers; ++i)
+        s.encoders.emplace_back(EncoderMain);
+    s.running = true;
+    return true;
+}
+
+bool StreamServerRunning()
+{
+    return gStream.running;
+}
+
+void StreamCaptureFrame(int width, int height)
+{
+    StreamServer& s = gStream;
+    if (!s.running || width <= 0 || height <= 0) return;
+
+    ReadbackFrame frame;
+    while (ReadbackMapOldest(s.readback, ReadbackFull(s.readback), frame))
+    {
+        HandOff(frame);
+        ReadbackUnmapOldest(s.readback);
+    }
+    uint32_t queued = ReadbackQueue(s.readback, width, height);
+
+    std::lock_guard<std::mutex> lock(s.statsMutex);
+    s.captureTimes[queued % kLatencyHistory] = Clock::now();
+    s.stats.framesCaptured++;
+}
+
+void StreamServerStop()
+{
+    StreamServer& s = gStream;
+    if (!s.running) return;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        std::lock_guard<std::mutex> jobLock(s.jobMutex);
+        s.stop = true;
+    }
+    s.wake.notify_all();
+    s.jobWake.notify_all();
+    s.thread.join();
+    for (std::thread& t : s.encoders) t.join();
+    s.encoders.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(s.statsMutex);
+        s.stats.seconds = std::chrono::duration<double>(Clock::now() - s.started).count();
+    }
+    ReadbackDestroy(s.readback);
+    for (Client& c : s.clients) NetClose(c.socket);
+    s.clients.clear();
+    NetClose(s.listener);
+    s.listener = kInvalidSocket;
+    s.previous.clear();
+    s.prevWidth = s.prevHeight = 0;
+    NetShutdown();
+    s.running = false;
+}
+
+StreamStats StreamServerStats()
+{
+    StreamServer& s = gStream;
+    std::lock_guard<std::mutex> lock(s.statsMutex);
+    StreamStats out = s.stats;
+    if (s.running)
+        out.seconds = std::chrono::duration<double>(Clock::now() - s.started).count();
+    out.latencyP50Ms = Percentile(s.latencies, 0.5f);
+    out.latencyP95Ms = Percentile(s.latencies, 0.95f);
+    return out;
+}
+
+void PrintStreamStats(const StreamStats& st)
+{
+    double seconds = std::max(1e-9, st.seconds);
+    printf("stream: %llu captured, %llu sent, %llu dropped, %llu skipped for slow viewers; dirty tiles %.1f%%, compression %.1fx, "
+        "%.2f Mbit/s; latency p50 %.2f ms p95 %.2f ms\n",
+        (unsigned long long)st.framesCaptured, (unsigned long long)st.framesSent, (unsigned long long)st.framesDropped,
+        (unsigned long long)st.clientFramesSkipped,
+        st.tilesTotal ? 100.0 * st.tilesDirty / st.tilesTotal : 0.0,
+        st.sentBytes ? (double)st.rawBytes / st.sentBytes : 0.0,
+        st.sentBytes * 8.0 / seconds / 1e6, st.latencyP50Ms, st.latencyP95Ms);
+}
+
+int RunStreamViewer(const char* address)
+{
+    if (!NetInit())
+        return -1;
+    NetSocket s = NetConnect(address);
+    if (s == kInvalidSocket)
+    {
+        fprintf(stderr, "viewer: cannot connect to %s\n", address);
+        NetShutdown();
+        return -1;
+    }
+
+    std::vector<uint32_t> image;
+    std::vector<uint32_t> tile(kTileSize * kTileSize);
+    int width = 0, height = 0;
+    RenderTarget* target = nullptr;
+    bool windowOpen = false;
+    uint64_t frames = 0, bytes = 0;
+    Clock::time_point start = Clock::now();
+    std::string payload;
+    bool ok = true;
+
+    while (ok && !(windowOpen && WindowShouldClose()))
+    {
+        if (!NetPoll(s, 16))
+        {
+            if (windowOpen) PollEvents();
+            continue;
+        }
+        uint32_t type = 0;
+        if (!NetRecvMessage(s, type, payload, kMaxFrameMessage))
+            break; // server went away
+        if (type != MsgStreamFrame || payload.size() < sizeof(FrameHeader))
+            continue;
+        bytes += payload.size() + 8;
+
+        FrameHeader header;
+        memcpy(&header, payload.data(), sizeof(header));
+        if (header.tileSize != (uint32_t)kTileSize || header.width == 0 || header.height == 0)
+        {
+            fprintf(stderr, "viewer: unsupported stream\n");
+            ok = false;
+            break;
+        }
+        if ((int)header.width != width || (int)header.height != height)
+        {
+            if (!header.keyframe) continue; // wait for a full frame at the new size
+            width = (int)header.width;
+            height = (int)header.height;
+            image.assign((size_t)width * height, 0);
+            if (!windowOpen)
+            {
+                if (!CreateWindow(width, height, "Graphics 1 - stream viewer"))
+                {
+                    ok = false;
+                    break;
+                }
+                SetSwapInterval(0);
+                windowOpen = true;
+            }
+            if (target) ReleaseRenderTarget(target);
+            target = AcquireRenderTarget(width, height);
+        }
+
+        const uint8_t* p = (const uint8_t*)payload.data() + sizeof(header);
+        const uint8_t* end = (const uint8_t*)payload.data() + payload.size();
+        for (uint32_t i = 0; i < header.tileCount && ok; ++i)
+        {
+            TileHeader th;
+            ok = end - p >= (ptrdiff_t)sizeof(th);
+            if (!ok) break;
+            memcpy(&th, p, sizeof(th));
+            p += sizeof(th);
+            int x0 = th.tx * kTileSize;
+            int y0 = th.ty * kTileSize;
+            int w = std::min(kTileSize, width - x0);
+            int h = std::min(kTileSize, height - y0);
+            ok = w > 0 && h > 0 && (size_t)(end - p) >= th.size && DecodePixels(p, th.size, tile.data(), (size_t)w * h);
+            if (!ok) break;
+            p += th.size;
+            for (int y = 0; y < h; ++y)
+                memcpy(&image[(size_t)(y0 + y) * width + x0], &tile[(size_t)y * w], (size_t)w * 4);
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "viewer: corrupt frame %u\n", header.frame);
+            break;
+        }
+
+        if (target)
+        {
+            glBindTexture(GL_TEXTURE_2D, target->color);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+            glBindTexture(GL_TEXTURE_2D, 0);
+            int fbW = 0, fbH = 0;
+            GetFramebufferSize(fbW, fbH);
+            BlitToBackbuffer(*target, fbW, fbH);
+            Loop();
+        }
+        ++frames;
+        ok = NetSendMessage(s, MsgStreamAck, &header.frame, sizeof(header.frame));
+    }
+
+    double seconds = std::max(1e-9, std::chrono::duration<double>(Clock::now() - start).count());
+    printf("viewer: %llu frames, %.1f fps, %.2f Mbit/s\n", (unsigned long long)frames, frames / seconds,
+        bytes * 8.0 / seconds / 1e6);
+    if (target) ReleaseRenderTarget(target);
+    if (windowOpen)
+    {
+        RenderTargetPoolShutdown();
+        DestroyWindow();
+    }
+    NetClose(s);
+    NetShutdown();
+    return ok ? 0 : -1;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Streams the rendered frames to remote viewers over TCP. Each frame is read back
+// asynchronously (PBO ring, no stall on the render thread), split into tiles, and only
+// tiles that changed since the previous sent frame are compressed and transmitted.
+// Diffing, compression and sending run on background threads; if they fall behind,
+// frames are dropped instead of blocking the renderer. Viewer sockets are non-blocking:
+// a viewer still receiving the previous frame skips the next one and resyncs on a
+// keyframe, so a slow viewer does not hold up the others.
+
+struct StreamStats
+{
+    uint64_t framesCaptured = 0;
+    uint64_t framesSent = 0;
+    uint64_t framesDropped = 0;     // captured while the encoder was still busy
+    uint64_t clientFramesSkipped = 0; // per viewer, not sent while it received the previous one
+    uint64_t tilesTotal = 0;
+    uint64_t tilesDirty = 0;
+    uint64_t rawBytes = 0;          // dirty tile bytes before compression
+    uint64_t sentBytes = 0;         // on the wire, all clients
+    double seconds = 0.0;
+    float latencyP50Ms = 0.0f;      // capture to viewer acknowledgement
+    float latencyP95Ms = 0.0f;
+};
+
+// address is "tcp:host:port"
+bool StreamServerStart(const char* address, std::string& errorOut);
+void StreamServerStop();
+bool StreamServerRunning();
+
+// queue a readback of the current back buffer; call after drawing, before the swap
+void StreamCaptureFrame(int width, int height);
+
+StreamStats StreamServerStats();
+void PrintStreamStats(const StreamStats& stats);
+
+// minimal viewer: connects, shows the stream in a window and acknowledges every frame;
+// returns a process exit code
+int RunStreamViewer(const char* address);
@@ -0,0 +1,440 @@
+#include "Tilemap.h"
+#include "Gfx.h"
+#include "Mesh.h"
+#include "Pipeline.h"
+#include "SceneGen.h"
+#include "Shader.h"
+#include "Warmup.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // the map's bounds as one quad; tile coordinates are interpolated across it
+    const char* tilemapVertexSrc = R"(
+#version 430 core
+layout(std140, binding = 0) uniform Camera { vec4 cameraTransform; vec2 cameraCenter; };
+uniform vec2 mapOrigin;     // map corner relative to the camera, rebased in double on the CPU
+uniform vec2 mapExtent;     // world units
+uniform vec2 mapTiles;
+uniform vec2 viewScale;
+out vec2 vTile;
+void main()
+{
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1));
+    vTile = corner * mapTiles;
+    vec2 view = mat2(cameraTransform.xy, cameraTransform.zw) * (mapOrigin + corner * mapExtent);
+    gl_Position = vec4(view * viewScale, 0.0, 1.0);
+}
+)";
+
+    const char* tilemapFragmentSrc = R"(
+#version 430 core
+in highp vec2 vTile;        // tile coordinates across the whole map need all the bits
+uniform usampler2DArray tiles;
+uniform usampler2D animation;
+uniform sampler2DArray atlas;
+uniform int layerCount;
+uniform int timeMs;
+out vec4 FragColor;
+void main()
+{
+    ivec2 size = textureSize(tiles, 0).xy;
+    ivec2 cell = min(ivec2(floor(vTile)), size - 1);
+    vec2 local = vTile - floor(vTile);
+    // gradients of the continuous coordinate, fract() would break them at tile edges
+    vec2 dx = dFdx(vTile);
+    vec2 dy = dFdy(vTile);
+    vec4 color = vec4(0.0);
+    for (int layer = 0; layer < layerCount; ++layer)
+    {
+        uint tile = texelFetch(tiles, ivec3(cell, layer), 0).r;
+        if (tile == 0u) continue;
+        uvec4 anim = texelFetch(animation, ivec2(int(tile), 0), 0);
+        uint frame = anim.y > 1u ? (uint(timeMs) / max(anim.z, 1u)) % anim.y : 0u;
+        vec4 c = textureGrad(atlas, vec3(local, float(anim.x + frame)), dx, dy);
+        color = vec4(mix(color.rgb, c.rgb, c.a), max(color.a, c.a));
+    }
+    if (color.a == 0.0) discard;
+    FragColor = vec4(color.rgb, 1.0);
+}
+)";
+
+    struct TilemapState
+    {
+        Shader shader;
+        PipelineId pipeline = 0;
+        GLint locMapOrigin = -1;
+        GLint locMapExtent = -1;
+        GLint locMapTiles = -1;
+        GLint locViewScale = -1;
+        GLint locLayerCount = -1;
+        GLint locTimeMs = -1;
+    } gTilemap;
+
+    // demo tiles; BuildDemoTilemap lays their frames out in the atlas in this order
+    enum DemoTile
+    {
+        TileEmpty = 0,
+        TileDeepWater, TileShallowWater, TileSand, TileGrass, TileForest, TileRock, TileSnow,
+        TileTree, TileFlower, TileStone,
+        DemoTileCount
+    };
+    const int kDemoFrames[DemoTileCount] = { 0, 4, 4, 1, 1, 1, 1, 1, 1, 2, 1 };
+    const int kDemoFrameMs[DemoTileCount] = { 0, 250, 180, 0, 0, 0, 0, 0, 0, 400, 0 };
+    const uint8_t kDemoColors[DemoTileCount][3] = {
+        { 0, 0, 0 }, { 24, 60, 140 }, { 50, 110, 190 }, { 220, 200, 140 }, { 90, 160, 70 }, { 40, 110, 50 },
+        { 120, 115, 110 }, { 240, 240, 245 }, { 20, 80, 30 }, { 230, 90, 160 }, { 150, 150, 150 },
+    };
+    const int kDemoTileSize = 16;
+    const int kDemoBandRows = 256;
+
+    // with the mip chain
+    int64_t AtlasBytes(int tileSize, int slices)
+    {
+        return (int64_t)tileSize * tileSize * 4 * slices * 4 / 3;
+    }
+
+    float Unit(uint32_t h)
+    {
+        return (h >> 8) * (1.0f / 16777216.0f);
+    }
+
+    float Smooth(float f)
+    {
+        return f * f * (3.0f - 2.0f * f);
+    }
+
+    // adds weight * smoothed value noise with the given lattice period for row y. The
+    // lattice columns are interpolated once per row, so a 16k map is not 12 hashes per cell
+    void AddNoiseRow(float* out, int width, int y, int period, float weight, uint32_t seed, std::vector<float>& column)
+    {
+        int cy = y / period;
+        float fy = Smooth((float)(y - cy * period) / period);
+        int cells = width / period + 2;
+        column.resize(cells);
+        for (int cx = 0; cx < cells; ++cx)
+        {
+            float a = Unit(HashCoords(cx, cy, seed));
+            float c = Unit(HashCoords(cx, cy + 1, seed));
+            column[cx] = a + (c - a) * fy;
+        }
+        for (int x = 0; x < width; ++x)
+        {
+            int cx = x / period;
+            float fx = Smooth((float)(x - cx * period) / period);
+            out[x] += weight * (column[cx] + (column[cx + 1] - column[cx]) * fx);
+        }
+    }
+
+    void PaintTile(uint8_t* px, int tile, int frame, uint32_t seed)
+    {
+        const int n = kDemoTileSize;
+        const uint8_t* base = kDemoColors[tile];
+        const bool decoration = tile >= TileTree;
+        for (int y = 0; y < n; ++y)
+        {
+            for (int x = 0; x < n; ++x)
+            {
+                uint8_t* p = px + ((size_t)y * n + x) * 4;
+                float shade = 0.85f + 0.3f * Unit(HashCoords(x, y, seed + tile));
+                float alpha = 1.0f;
+                if (tile == TileDeepWater || tile == TileShallowWater)
+                {
+                    // wave crests that move one quarter of the tile per frame
+                    float phase = (float)(x + y + frame * n / 4) / n * 6.2831853f;
+                    shade = 0.8f + 0.25f * sinf(phase * 2.0f);
+                }
+                else if (decoration)
+                {
+                    float dx = (x + 0.5f) / n - 0.5f;
+                    float dy = (y + 0.5f) / n - 0.5f;
+                    float r = sqrtf(dx * dx + dy * dy);
+                    float radius = tile == TileTree ? 0.42f : (tile == TileFlower ? 0.18f + 0.06f * frame : 0.3f);
+                    alpha = r < radius ? 1.0f : 0.0f;
+                }
+                for (int c = 0; c < 3; ++c)
+                    p[c] = (uint8_t)std::min(255.0f, base[c] * shade);
+                p[3] = (uint8_t)(alpha * 255.0f);
+            }
+        }
+    }
+
+    uint8_t TerrainTile(float e)
+    {
+        if (e < 0.30f) return TileDeepWater;
+        if (e < 0.36f) return TileShallowWater;
+        if (e < 0.40f) return TileSand;
+        if (e < 0.62f) return TileGrass;
+        if (e < 0.75f) return TileForest;
+        if (e < 0.88f) return TileRock;
+        return TileSnow;
+    }
+
+    uint8_t DecorationTile(uint8_t ground, uint32_t h)
+    {
+        float u = Unit(h);
+        if (ground == TileForest && u < 0.25f) return TileTree;
+        if (ground == TileGrass && u < 0.03f) return TileFlower;
+        if (ground == TileRock && u < 0.05f) return TileStone;
+        return TileEmpty;
+    }
+}
+
+bool TilemapInit(std::string& errorOut)
+{
+    if (!gTilemap.shader.CreateFromSource(tilemapVertexSrc, tilemapFragmentSrc, errorOut))
+        return false;
+    GLuint id = gTilemap.shader.GetID();
+    gTilemap.locMapOrigin = glGetUniformLocation(id, "mapOrigin");
+    gTilemap.locMapExtent = glGetUniformLocation(id, "mapExtent");
+    gTilemap.locMapTiles = glGetUniformLocation(id, "mapTiles");
+    gTilemap.locViewScale = glGetUniformLocation(id, "viewScale");
+    gTilemap.locLayerCount = glGetUniformLocation(id, "layerCount");
+    gTilemap.locTimeMs = glGetUniformLocation(id, "timeMs");
+    // fixed texture units, set without binding the program
+    glProgramUniform1i(id, glGetUniformLocation(id, "tiles"), 0);
+    glProgramUniform1i(id, glGetUniformLocation(id, "animation"), 1);
+    glProgramUniform1i(id, glGetUniformLocation(id, "atlas"), 2);
+
+    PipelineDesc desc;
+    desc.program = id;
+    gTilemap.pipeline = CreatePipeline(desc);
+    WarmupRegister("tilemap", gTilemap.pipeline, GL_TRIANGLE_STRIP);
+    return true;
+}
+
+void TilemapShutdown()
+{
+    WarmupUnregister(gTilemap.pipeline);
+    DestroyPipeline(gTilemap.pipeline);
+    gTilemap.pipeline = 0;
+    gTilemap.shader.Destroy();
+}
+
+bool CreateTilemap(Tilemap& map, int width, int height, int layers, std::string& errorOut)
+{
+    GLint maxSize = 0, maxLayers = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (width <= 0 || height <= 0 || layers <= 0)
+    {
+        errorOut = "empty tilemap";
+        return false;
+    }
+    if (width > maxSize || height > maxSize)
+    {
+        errorOut = "tilemap size " + std::to_string(width) + "x" + std::to_string(height) +
+            " exceeds GL_MAX_TEXTURE_SIZE " + std::to_string(maxSize);
+        return false;
+    }
+    if (layers > maxLayers)
+    {
+        errorOut = "tilemap layer count " + std::to_string(layers) +
+            " exceeds GL_MAX_ARRAY_TEXTURE_LAYERS " + std::to_string(maxLayers);
+        return false;
+    }
+
+    while (glGetError() != GL_NO_ERROR) {}
+    glGenTextures(1, &map.tiles);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, map.tiles);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_R8UI, width, height, layers);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    if (glGetError() != GL_NO_ERROR)
+    {
+        glDeleteTextures(1, &map.tiles);
+        map.tiles = 0;
+        errorOut = "cannot allocate the tile index texture";
+        return false;
+    }
+
+    // static tiles by default: tile t is atlas slice t - 1
+    for (int t = 0; t < kTilemapMaxTiles; ++t)
+    {
+        map.anim[t][0] = (uint16_t)std::max(0, t - 1);
+        map.anim[t][1] = 1;
+        map.anim[t][2] = 0;
+        map.anim[t][3] = 0;
+    }
+    glGenTextures(1, &map.animation);
+    glBindTexture(GL_TEXTURE_2D, map.animation);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA16UI, kTilemapMaxTiles, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, kTilemapMaxTiles, 1, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, map.anim);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    map.width = width;
+    map.height = height;
+    map.layers = layers;
+    map.bytes = (int64_t)width * height * layers + kTilemapMaxTiles * 8;
+    ProfilerTrackGpuBytes(map.bytes);
+    return true;
+}
+
+void DestroyTilemap(Tilemap& map)
+{
+    if (map.tiles) glDeleteTextures(1, &map.tiles);
+    if (map.atlas) glDeleteTextures(1, &map.atlas);
+    if (map.animation) glDeleteTextures(1, &map.animation);
+    ProfilerTrackGpuBytes(-map.bytes);
+    map = Tilemap();
+}
+
+void TilemapSetTiles(Tilemap& map, int layer, int x, int y, int w, int h, const uint8_t* tiles)
+{
+    glBindTexture(GL_TEXTURE_2D_ARRAY, map.tiles);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y, layer, w, h, 1, GL_RED_INTEGER, GL_UNSIGNED_BYTE, tiles);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+bool TilemapSetAtlas(Tilemap& map, int tileSize, int slices, const uint8_t* rgba, std::string& errorOut)
+{
+    if (tileSize <= 0 || slices <= 0)
+    {
+        errorOut = "empty tile atlas";
+        return false;
+    }
+    GLint maxSize = 0, maxLayers = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+    if (tileSize > maxSize)
+    {
+        errorOut = "atlas tile size " + std::to_string(tileSize) + " exceeds GL_MAX_TEXTURE_SIZE " + std::to_string(maxSize);
+        return false;
+    }
+    if (slices > maxLayers)
+    {
+        errorOut = "atlas slice count " + std::to_string(slices) +
+            " exceeds GL_MAX_ARRAY_TEXTURE_LAYERS " + std::to_string(maxLayers);
+        return false;
+    }
+    int levels = 1;
+    while ((tileSize >> levels) > 0) ++levels;
+    if (map.atlas)
+    {
+        glDeleteTextures(1, &map.atlas);
+        map.bytes -= AtlasBytes(map.atlasTileSize, map.atlasSlices);
+        ProfilerTrackGpuBytes(-AtlasBytes(map.atlasTileSize, map.atlasSlices));
+        map.atlas = 0;
+        map.atlasSlices = 0;
+        map.atlasTileSize = 0;
+    }
+    while (glGetError() != GL_NO_ERROR) {}
+    glGenTextures(1, &map.atlas);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, map.atlas);
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, tileSize, tileSize, slices);
+    glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, tileSize, tileSize, slices, GL_RGBA, GL_UNSIGNED_BYTE, rgba);
+    // slices cannot bleed into each other, so mips are safe; magnified tiles stay crisp
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    if (glGetError() != GL_NO_ERROR)
+    {
+        glDeleteTextures(1, &map.atlas);
+        map.atlas = 0;
+        errorOut = "cannot allocate the tile atlas";
+        return false;
+    }
+    map.atlasSlices = slices;
+    map.atlasTileSize = tileSize;
+    map.bytes += AtlasBytes(tileSize, slices);
+    ProfilerTrackGpuBytes(AtlasBytes(tileSize, slices));
+    return true;
+}
+
+void TilemapSetAnimation(Tilemap& map, int tile, int firstSlice, int frames, int frameMs)
+{
+    if (tile <= 0 || tile >= kTilemapMaxTiles) return;
+    map.anim[tile][0] = (uint16_t)firstSlice;
+    map.anim[tile][1] = (uint16_t)std::max(1, frames);
+    map.anim[tile][2] = (uint16_t)std::max(0, frameMs);
+    glBindTexture(GL_TEXTURE_2D, map.animation);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, tile, 0, 1, 1, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, map.anim[tile]);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+bool BuildDemoTilemap(Tilemap& map, uint32_t seed, std::string& errorOut)
+{
+    // atlas: every frame of every tile, in tile order
+    const size_t tileBytes = (size_t)kDemoTileSize * kDemoTileSize * 4;
+    std::vector<uint8_t> atlas;
+    int slice = 0;
+    for (int t = 1; t < DemoTileCount; ++t)
+    {
+        int first = slice;
+        for (int f = 0; f < kDemoFrames[t]; ++f, ++slice)
+        {
+            atlas.resize((size_t)(slice + 1) * tileBytes);
+            PaintTile(&atlas[(size_t)slice * tileBytes], t, f, seed);
+        }
+        TilemapSetAnimation(map, t, first, kDemoFrames[t], kDemoFrameMs[t]);
+    }
+    if (!TilemapSetAtlas(map, kDemoTileSize, slice, atlas.data(), errorOut))
+        return false;
+
+    // terrain from three octaves of value noise, decorations hashed per cell
+    std::vector<uint8_t> ground((size_t)map.width * kDemoBandRows);
+    std::vector<uint8_t> decoration(ground.size());
+    std::vector<float> elevation(map.width);
+    std::vector<float> column;
+    for (int y0 = 0; y0 < map.height; y0 += kDemoBandRows)
+    {
+        int rows = std::min(kDemoBandRows, map.height - y0);
+        for (int y = 0; y < rows; ++y)
+        {
+            int gy = y0 + y;
+            std::fill(elevation.begin(), elevation.end(), 0.0f);
+            AddNoiseRow(elevation.data(), map.width, gy, 256, 0.55f, seed, column);
+            AddNoiseRow(elevation.data(), map.width, gy, 64, 0.3f, seed + 1, column);
+            AddNoiseRow(elevation.data(), map.width, gy, 16, 0.15f, seed + 2, column);
+            for (int x = 0; x < map.width; ++x)
+            {
+                size_t i = (size_t)y * map.width + x;
+                ground[i] = TerrainTile(elevation[x]);
+                decoration[i] = DecorationTile(ground[i], HashCoords(x, gy, seed + 3));
+            }
+        }
+        TilemapSetTiles(map, 0, 0, y0, map.width, rows, ground.data());
+        if (map.layers > 1)
+            TilemapSetTiles(map, 1, 0, y0, map.width, rows, decoration.data());
+    }
+    return true;
+}
+
+void DrawTilemap(const Tilemap& map, const Camera2D& camera, const float* viewScale, float time)
+{
+    if (!map.tiles || !map.atlas)
+        return;
+    BindPipeline(gTilemap.pipeline);
+    float origin[2];
+    CameraRelative(camera, map.origin, origin);
+    GfxUniform2f(gTilemap.locMapOrigin, origin[0], origin[1]);
+    GfxUniform2f(gTilemap.locMapExtent, (float)(map.width * map.tileSize), (float)(map.height * map.tileSize));
+    GfxUniform2f(gTilemap.locMapTiles, (float)map.width, (float)map.height);
+    GfxUniform2f(gTilemap.locViewScale, viewScale[0], viewScale[1]);
+    GfxUniform1i(gTilemap.locLayerCount, map.layers);
+    // wraps after ~24 days, animations only need the phase
+    GfxUniform1i(gTilemap.locTimeMs, (GLint)(fmod((double)time, 2000000.0) * 1000.0));
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, map.tiles);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, map.animation);
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, map.atlas);
+    glActiveTexture(GL_TEXTURE0);
+
+    GfxBindVertexArray(EmptyVertexArray());
+    GfxDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    GfxBindVertexArray(0);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "Camera.h"
+#include <cstdint>
+#include <string>
+
+// Grid maps drawn with one quad, however many tiles there are. Tile indices live in an
+// R8UI array texture (one slice per layer, 0 = empty), the fragment shader looks up the
+// cell under each pixel, resolves animation and samples the tile image from an atlas
+// array texture. Layers are composited bottom to top by the tiles' alpha.
+
+static const int kTilemapMaxTiles = 256;    // R8UI indices, 0 is reserved for empty
+
+struct Tilemap
+{
+    GLuint tiles = 0;           // R8UI 2D array, width x height x layers
+    GLuint atlas = 0;           // RGBA8 2D array, one slice per tile image, mipmapped
+    GLuint animation = 0;       // RGBA16UI kTilemapMaxTiles x 1: first slice, frames, ms per frame
+    int width = 0;
+    int height = 0;
+    int layers = 0;
+    int atlasSlices = 0;
+    int atlasTileSize = 0;
+    double origin[2] = { 0.0, 0.0 };    // world position of the corner of tile (0, 0)
+    double tileSize = 1.0 / 32.0;       // world units per tile
+    uint16_t anim[kTilemapMaxTiles][4];
+    int64_t bytes = 0;
+};
+
+// the shared program; the tilemaps themselves are created separately
+bool TilemapInit(std::string& errorOut);
+void TilemapShutdown();
+
+// fails if the driver cannot hold the index texture
+bool CreateTilemap(Tilemap& map, int width, int height, int layers, std::string& errorOut);
+void DestroyTilemap(Tilemap& map);
+// w x h tile indices, row-major from (x, y)
+void TilemapSetTiles(Tilemap& map, int layer, int x, int y, int w, int h, const uint8_t* tiles);
+// slices tileSize x tileSize RGBA8 images, back to back; replaces the atlas
+bool TilemapSetAtlas(Tilemap& map, int tileSize, int slices, const uint8_t* rgba, std::string& errorOut);
+// tile shows slices firstSlice .. firstSlice + frames - 1, each for frameMs
+// (by default tile t shows slice t - 1)
+void TilemapSetAnimation(Tilemap& map, int tile, int firstSlice, int frames, int frameMs);
+
+// procedural terrain (animated water, sand, grass, forest, rock, snow) on layer 0 and
+// sparse decorations on layer 1, filled in bands so huge maps need little memory;
+// fails if the atlas cannot be created
+bool BuildDemoTilemap(Tilemap& map, uint32_t seed, std::string& errorOut);
+
+void DrawTilemap(const Tilemap& map, const Camera2D& camera, const float* viewScale, float time);
@@ -0,0 +1,555 @@
+#include "TimeSeries.h"
+#include "Caps.h"
+#include "DeferredDelete.h"
+#include "Gfx.h"
+#include "Mesh.h"
+#include "Pipeline.h"
+#include "SceneGen.h"
+#include "Shader.h"
+#include "Warmup.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+
+namespace
+{
+    const GLuint kPointsBinding = 3;
+    const int kLevelShift = 3;              // 8 entries per bucket of the next level
+    const int kMinBucketsPerColumn = 4;     // finer than this, step down a level
+    const uint32_t kTexelRowWidth = 2048;   // texel layout of every level, see Layout()
+    const uint32_t kTexelRows = 2048;
+    const uint32_t kMaxColumns = 16384;
+    const int kResolveGroup = 64;
+
+    // one invocation per pixel column: first, min, max and last of the samples in it, as
+    // 4 camera-relative points. With rawMode (less than 2 samples per column) one point
+    // per sample instead.
+    const char* resolveSrc = R"(
+#version 430 core
+layout(local_size_x = 64) in;
+layout(std430, binding = 3) writeonly buffer Points { vec2 points[]; };
+uniform sampler2DArray samples;     // R32F, the ring of raw samples
+uniform sampler2DArray buckets;     // RG32F min/max at levelIndex
+uniform int levelIndex;             // 0 reads min/max straight from the samples
+uniform uint bucketSize;            // samples per bucket, 8^levelIndex
+uniform uint baseBucket;            // logical index of the bucket column 0 starts in
+uniform float bucketPhase;          // how far into baseBucket column 0 starts
+uniform float bucketsPerColumn;
+uniform ivec2 bucketRange;          // buckets that hold data, relative to baseBucket
+uniform uint lastSample;            // newest sample, relative to the start of baseBucket
+uniform uint columns;
+uniform vec2 base;                  // start of baseBucket at value 0, relative to the camera
+uniform float sampleWidth;
+uniform float valueScale;
+uniform int rawMode;
+
+// every level uses the same layout: rows of 2048 texels, 2048 rows per layer, as a ring
+ivec3 Texel(uint i, ivec3 size)
+{
+    uint w = uint(size.x);
+    uint h = uint(size.y);
+    i &= w * h * uint(size.z) - 1u;
+    return ivec3(int(i % w), int((i / w) % h), int(i / (w * h)));
+}
+
+float Sample(uint i)
+{
+    return texelFetch(samples, Texel(i, textureSize(samples, 0)), 0).r;
+}
+
+vec2 Point(uint sampleOffset, float value)
+{
+    return base + vec2(float(sampleOffset) * sampleWidth, value * valueScale);
+}
+
+void main()
+{
+    uint c = gl_GlobalInvocationID.x;
+    if (c >= columns)
+        return;
+    uint start = baseBucket * bucketSize;
+    if (rawMode != 0)
+    {
+        points[c] = Point(c, Sample(start + c));
+        return;
+    }
+
+    int first = clamp(int(floor(bucketPhase + float(c) * bucketsPerColumn)), bucketRange.x, bucketRange.y - 1);
+    int end = clamp(int(floor(bucketPhase + float(c + 1u) * bucketsPerColumn)), first + 1, bucketRange.y);
+    vec2 range = vec2(1e30, -1e30);
+    for (int b = first; b < end; ++b)
+    {
+        vec2 r;
+        if (levelIndex == 0)
+            r = vec2(Sample(start + uint(b)));
+        else
+            r = texelFetch(buckets, Texel(baseBucket + uint(b), textureSize(buckets, 0)), 0).rg;
+        range = vec2(min(range.x, r.x), max(range.y, r.y));
+    }
+
+    uint firstSample = uint(first) * bucketSize;
+    uint lastInColumn = min(uint(end) * bucketSize - 1u, lastSample);
+    vec2 a = Point(firstSample, Sample(start + firstSample));
+    vec2 d = Point(lastInColumn, Sample(start + lastInColumn));
+    // min and max share an x, so which one came first does not change the pixels
+    float x = 0.5 * (a.x + d.x);
+    points[c * 4u + 0u] = a;
+    points[c * 4u + 1u] = vec2(x, base.y + range.x * valueScale);
+    points[c * 4u + 2u] = vec2(x, base.y + range.y * valueScale);
+    points[c * 4u + 3u] = d;
+}
+)";
+
+    const char* lineVertexSrc = R"(
+#version 430 core
+layout(std140, binding = 0) uniform Camera { vec4 cameraTransform; vec2 cameraCenter; };
+layout(std430, binding = 3) readonly buffer Points { vec2 points[]; };
+uniform vec2 viewScale;
+void main()
+{
+    vec2 view = mat2(cameraTransform.xy, cameraTransform.zw) * points[gl_VertexID];
+    gl_Position = vec4(view * viewScale, 0.0, 1.0);
+}
+)";
+
+    const char* lineFragmentSrc = R"(
+#version 430 core
+uniform vec3 color;
+out vec4 FragColor;
+void main()
+{
+    FragColor = vec4(color, 1.0);
+}
+)";
+
+    struct TimeSeriesState
+    {
+        Shader resolve;
+        GLint locLevelIndex = -1;
+        GLint locBucketSize = -1;
+        GLint locBaseBucket = -1;
+        GLint locBucketPhase = -1;
+        GLint locBucketsPerColumn = -1;
+        GLint locBucketRange = -1;
+        GLint locLastSample = -1;
+        GLint locColumns = -1;
+        GLint locBase = -1;
+        GLint locSampleWidth = -1;
+        GLint locValueScale = -1;
+        GLint locRawMode = -1;
+
+        Shader line;
+        PipelineId pipeline = 0;
+        GLint locViewScale = -1;
+        GLint locColor = -1;
+
+        // per level min/max of the buckets one append touched, interleaved
+        std::vector<float> staging[kTimeSeriesMaxLevels];
+    } gTimeSeries;
+
+    struct TexelLayout
+    {
+        uint32_t width, rows, layers;
+    };
+
+    TexelLayout Layout(uint64_t texels)
+    {
+        TexelLayout l;
+        l.width = (uint32_t)std::min<uint64_t>(texels, kTexelRowWidth);
+        l.rows = (uint32_t)std::min<uint64_t>(texels / l.width, kTexelRows);
+        l.layers = (uint32_t)(texels / ((uint64_t)l.width * l.rows));
+        return l;
+    }
+
+    uint64_t LevelTexels(const TimeSeries& series, int level)
+    {
+        return series.capacity >> (kLevelShift * level);
+    }
+
+    GLuint CreateLevelTexture(uint64_t texels, GLenum format)
+    {
+        TexelLayout l = Layout(texels);
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, format, l.width, l.rows, l.layers);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        return texture;
+    }
+
+    // writes count texels starting at ring position first, as few row blocks as the layout allows
+    void UploadTexels(GLuint texture, uint64_t texels, uint64_t first, size_t count, GLenum format,
+        size_t texelBytes, const void* data)
+    {
+        const TexelLayout l = Layout(texels);
+        const uint8_t* src = (const uint8_t*)data;
+        uint64_t i = first & (texels - 1);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        while (count)
+        {
+            uint32_t x = (uint32_t)(i % l.width);
+            uint32_t y = (uint32_t)((i / l.width) % l.rows);
+            uint32_t layer = (uint32_t)(i / ((uint64_t)l.width * l.rows));
+            size_t n;
+            if (x != 0 || count < l.width)
+            {
+                n = std::min<size_t>(l.width - x, count);
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y, layer, (GLsizei)n, 1, 1, format, GL_FLOAT, src);
+            }
+            else
+            {
+                uint32_t rows = (uint32_t)std::min<size_t>(count / l.width, l.rows - y);
+                n = (size_t)rows * l.width;
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, y, layer, l.width, rows, 1, format, GL_FLOAT, src);
+            }
+            src += n * texelBytes;
+            count -= n;
+            i = (i + n) & (texels - 1);
+        }
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
+
+    // at most the ring's capacity, so the ring upload never overlaps itself
+    void AppendChunk(TimeSeries& s, const float* samples, size_t count)
+    {
+        TimeSeriesState& st = gTimeSeries;
+        const int levels = s.levelCount;
+        for (int level = 1; level < levels; ++level)
+            st.staging[level].clear();
+
+        // complete buckets go up one level as soon as they close
+        for (size_t i = 0; i < count; ++i)
+        {
+            float mn = samples[i], mx = mn;
+            for (int level = 1; level < levels; ++level)
+            {
+                if (s.accFill[level] == 0)
+                {
+                    s.accMin[level] = mn;
+                    s.accMax[level] = mx;
+                }
+                else
+                {
+                    s.accMin[level] = std::min(s.accMin[level], mn);
+                    s.accMax[level] = std::max(s.accMax[level], mx);
+                }
+                if (++s.accFill[level] < 8)
+                    break;
+                s.accFill[level] = 0;
+                mn = s.accMin[level];
+                mx = s.accMax[level];
+                st.staging[level].push_back(mn);
+                st.staging[level].push_back(mx);
+            }
+        }
+
+        // the open bucket of each level, including the open bucket below it, so the newest
+        // samples show at every zoom
+        bool open = false;
+        float openMin = 0.0f, openMax = 0.0f;
+        for (int level = 1; level < levels; ++level)
+        {
+            if (s.accFill[level] > 0)
+            {
+                openMin = open ? std::min(openMin, s.accMin[level]) : s.accMin[level];
+                openMax = open ? std::max(openMax, s.accMax[level]) : s.accMax[level];
+                open = true;
+            }
+            if (!open)
+                continue;
+            st.staging[level].push_back(openMin);
+            st.staging[level].push_back(openMax);
+        }
+
+        UploadTexels(s.raw, s.capacity, s.count, count, GL_RED, sizeof(float), samples);
+        for (int level = 1; level < levels; ++level)
+        {
+            if (st.staging[level].empty()) continue;
+            uint64_t firstBucket = s.count >> (kLevelShift * level);
+            UploadTexels(s.levels[level], LevelTexels(s, level), firstBucket, st.staging[level].size() / 2, GL_RG,
+                2 * sizeof(float), st.staging[level].data());
+        }
+        s.count += count;
+    }
+
+    GLuint PointBuffer(TimeSeries& s, size_t points)
+    {
+        const size_t ctx = (size_t)gGfxContextIndex;
+        if (s.points.size() <= ctx)
+        {
+            s.points.resize(ctx + 1, 0);
+            s.pointCapacity.resize(ctx + 1, 0);
+        }
+        if (points > s.pointCapacity[ctx])
+        {
+            // the previous frame may still be drawing from the old one
+            if (s.points[ctx]) DeferDelete(DeferBuffer, s.points[ctx]);
+            size_t capacity = std::max<size_t>(points, 4096);
+            glGenBuffers(1, &s.points[ctx]);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, s.points[ctx]);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)(capacity * 2 * sizeof(float)), nullptr, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+            int64_t delta = (int64_t)(capacity - s.pointCapacity[ctx]) * 2 * sizeof(float);
+            s.bytes += delta;
+            ProfilerTrackGpuBytes(delta);
+            s.pointCapacity[ctx] = capacity;
+        }
+        return s.points[ctx];
+    }
+
+}
+
+bool TimeSeriesInit(std::string& errorOut)
+{
+    TimeSeriesState& st = gTimeSeries;
+    if (GetGpuCaps().maxVertexStorageBlocks < 1)
+    {
+        errorOut = "the plot line is read from a storage buffer in the vertex stage, GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS is 0";
+        return false;
+    }
+    if (!st.resolve.CreateComputeFromSource(resolveSrc, errorOut))
+        return false;
+    if (!st.line.CreateFromSource(lineVertexSrc, lineFragmentSrc, errorOut))
+    {
+        st.resolve.Destroy();
+        return false;
+    }
+    GLuint id = st.resolve.GetID();
+    st.locLevelIndex = glGetUniformLocation(id, "levelIndex");
+    st.locBucketSize = glGetUniformLocation(id, "bucketSize");
+    st.locBaseBucket = glGetUniformLocation(id, "baseBucket");
+    st.locBucketPhase = glGetUniformLocation(id, "bucketPhase");
+    st.locBucketsPerColumn = glGetUniformLocation(id, "bucketsPerColumn");
+    st.locBucketRange = glGetUniformLocation(id, "bucketRange");
+    st.locLastSample = glGetUniformLocation(id, "lastSample");
+    st.locColumns = glGetUniformLocation(id, "columns");
+    st.locBase = glGetUniformLocation(id, "base");
+    st.locSampleWidth = glGetUniformLocation(id, "sampleWidth");
+    st.locValueScale = glGetUniformLocation(id, "valueScale");
+    st.locRawMode = glGetUniformLocation(id, "rawMode");
+    glProgramUniform1i(id, glGetUniformLocation(id, "samples"), 0);
+    glProgramUniform1i(id, glGetUniformLocation(id, "buckets"), 1);
+
+    st.locViewScale = glGetUniformLocation(st.line.GetID(), "viewScale");
+    st.locColor = glGetUniformLocation(st.line.GetID(), "color");
+    PipelineDesc desc;
+    desc.program = st.line.GetID();
+    st.pipeline = CreatePipeline(desc);
+    WarmupRegister("timeseries", st.pipeline, GL_LINE_STRIP);
+    return true;
+}
+
+void TimeSeriesShutdown()
+{
+    TimeSeriesState& st = gTimeSeries;
+    WarmupUnregister(st.pipeline);
+    DestroyPipeline(st.pipeline);
+    st.resolve.Destroy();
+    st.line.Destroy();
+    gTimeSeries = TimeSeriesState();
+}
+
+bool CreateTimeSeries(TimeSeries& series, uint64_t capacity, std::string& errorOut)
+{
+    if (capacity == 0 || capacity > ((uint64_t)1 << 30))
+    {
+        errorOut = "time series capacity must be 1 .. 2^30 samples";
+        return false;
+    }
+    uint64_t ring = kTexelRowWidth;
+    while (ring < capacity) ring <<= 1;
+
+    TimeSeries s;
+    s.capacity = ring;
+    s.levelCount = 1;
+    while (s.levelCount < kTimeSeriesMaxLevels && (ring >> (kLevelShift * s.levelCount)) > 0)
+        ++s.levelCount;
+
+    while (glGetError() != GL_NO_ERROR) {}
+    s.raw = CreateLevelTexture(ring, GL_R32F);
+    s.bytes = (int64_t)ring * sizeof(float);
+    for (int level = 1; level < s.levelCount; ++level)
+    {
+        s.levels[level] = CreateLevelTexture(LevelTexels(s, level), GL_RG32F);
+        s.bytes += (int64_t)LevelTexels(s, level) * 2 * sizeof(float);
+    }
+    s.levels[0] = s.raw;
+    if (glGetError() != GL_NO_ERROR)
+    {
+        glDeleteTextures(s.levelCount, s.levels);
+        errorOut = "cannot allocate " + std::to_string(s.bytes >> 20) + " MB of time series textures";
+        return false;
+    }
+    for (int level = 0; level < kTimeSeriesMaxLevels; ++level)
+    {
+        s.accMin[level] = s.accMax[level] = 0.0f;
+        s.accFill[level] = 0;
+    }
+    s.origin[0] = series.origin[0];
+    s.origin[1] = series.origin[1];
+    s.sampleWidth = series.sampleWidth;
+    s.valueScale = series.valueScale;
+    ProfilerTrackGpuBytes(s.bytes);
+    series = s;
+    return true;
+}
+
+void DestroyTimeSeries(TimeSeries& series)
+{
+    if (series.raw)
+        glDeleteTextures(series.levelCount, series.levels);
+    for (GLuint points : series.points)
+        if (points) DeferDelete(DeferBuffer, points);
+    ProfilerTrackGpuBytes(-series.bytes);
+    series = TimeSeries();
+}
+
+void TimeSeriesAppend(TimeSeries& series, const float* samples, size_t count)
+{
+    if (!series.raw || count == 0)
+        return;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (count)
+    {
+        size_t n = (size_t)std::min<uint64_t>(count, series.capacity);
+        AppendChunk(series, samples, n);
+        samples += n;
+        count -= n;
+    }
+    series.appendMs = (float)std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void DrawTimeSeries(TimeSeries& series, const Camera2D& camera, const float* viewScale, int viewportWidth,
+    float r, float g, float b)
+{
+    TimeSeriesState& st = gTimeSeries;
+    if (!series.raw || series.count < 2 || viewportWidth <= 0)
+        return;
+
+    // visible samples, in sample units from the series origin
+    double viewMin[2], viewMax[2];
+    CameraVisibleBounds(camera, viewScale, viewMin, viewMax);
+    const uint64_t oldest = series.count > series.capacity ? series.count - series.capacity : 0;
+    const double lo = std::max((viewMin[0] - series.origin[0]) / series.sampleWidth, (double)oldest);
+    const double hi = std::min((viewMax[0] - series.origin[0]) / series.sampleWidth, (double)(series.count - 1));
+    if (hi <= lo)
+        return;
+    // one pixel in samples, ignoring rotation
+    const double perColumn = 2.0 / (viewScale[0] * camera.zoom * viewportWidth) / series.sampleWidth;
+
+    int level = 0;
+    uint64_t baseBucket, columns, points;
+    double phase = 0.0, bucketsPerColumn = 1.0;
+    int rangeFirst = 0, rangeEnd = 0;
+    const bool raw = perColumn < 2.0;
+    if (raw)
+    {
+        baseBucket = (uint64_t)floor(lo);
+        columns = std::min<uint64_t>((uint64_t)ceil(hi) - baseBucket + 1, (uint64_t)kMaxColumns * 4);
+        points = columns;
+    }
+    else
+    {
+        // coarsest level with at least kMinBucketsPerColumn buckets per column
+        while (level + 1 < series.levelCount &&
+               perColumn / (double)((uint64_t)1 << (kLevelShift * (level + 1))) >= kMinBucketsPerColumn)
+            ++level;
+        const int shift = kLevelShift * level;
+        const uint64_t bucket = (uint64_t)1 << shift;
+        bucketsPerColumn = perColumn / (double)bucket;
+        // whole buckets only at the old end, their first samples may have been overwritten
+        const uint64_t firstData = (oldest + bucket - 1) >> shift;
+        const uint64_t endData = (series.count + bucket - 1) >> shift;
+        // columns on a grid anchored at sample 0, so they do not slide against the data while panning
+        const double firstColumn = floor(std::max(lo, (double)(firstData << shift)) / perColumn);
+        if (hi < firstColumn * perColumn)
+            return;
+        columns = std::min<uint64_t>((uint64_t)(floor(hi / perColumn) - firstColumn) + 1, kMaxColumns);
+        const double start = firstColumn * bucketsPerColumn;
+        baseBucket = (uint64_t)floor(start);
+        phase = start - floor(start);
+        rangeFirst = (int)std::min<uint64_t>(firstData > baseBucket ? firstData - baseBucket : 0, INT_MAX);
+        rangeEnd = (int)std::min<uint64_t>(endData - baseBucket, INT_MAX);
+        if (rangeEnd <= rangeFirst)
+            return;
+        points = columns * 4;
+    }
+    const uint64_t startSample = baseBucket << (kLevelShift * level);
+
+    double baseWorld[2] = { series.origin[0] + (double)startSample * series.sampleWidth, series.origin[1] };
+    float base[2];
+    CameraRelative(camera, baseWorld, base);
+    GLuint buffer = PointBuffer(series, (size_t)points);
+
+    // raw bind: the next BindPipeline must not assume its program is still current
+    glUseProgram(st.resolve.GetID());
+    glUniform1i(st.locLevelIndex, level);
+    glUniform1ui(st.locBucketSize, 1u << (kLevelShift * level));
+    glUniform1ui(st.locBaseBucket, (GLuint)baseBucket);
+    glUniform1f(st.locBucketPhase, (float)phase);
+    glUniform1f(st.locBucketsPerColumn, (float)bucketsPerColumn);
+    glUniform2i(st.locBucketRange, rangeFirst, rangeEnd);
+    glUniform1ui(st.locLastSample, (GLuint)(series.count - 1 - startSample));
+    glUniform1ui(st.locColumns, (GLuint)columns);
+    glUniform2f(st.locBase, base[0], base[1]);
+    glUniform1f(st.locSampleWidth, (float)series.sampleWidth);
+    glUniform1f(st.locValueScale, (float)series.valueScale);
+    glUniform1i(st.locRawMode, raw ? 1 : 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, series.raw);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, series.levels[level]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, kPointsBinding, buffer);
+    glDispatchCompute((GLuint)((columns + kResolveGroup - 1) / kResolveGroup), 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    InvalidatePipelineState();
+
+    glProgramUniform3f(st.line.GetID(), st.locColor, r, g, b);
+    BindPipeline(st.pipeline);
+    GfxUniform2f(st.locViewScale, viewScale[0], viewScale[1]);
+    GfxBindStorageBuffer(kPointsBinding, buffer);
+    GfxBindVertexArray(EmptyVertexArray());
+    GfxDrawArrays(GL_LINE_STRIP, 0, (GLsizei)points);
+    GfxBindVertexArray(0);
+
+    series.drawLevel = level;
+    series.drawPoints = (uint32_t)points;
+    series.drawColumns = (uint32_t)columns;
+}
+
+void GenerateSensorSamples(uint64_t first, size_t count, uint32_t seed, float* out)
+{
+    // three oscillators advanced by rotation instead of a sin() per sample each
+    const double periods[3] = { 5.0e6, 4.0e4, 97.0 };
+    const double amplitudes[3] = { 0.6, 0.25, 0.1 };
+    double c[3], s[3], stepC[3], stepS[3];
+    for (int k = 0; k < 3; ++k)
+    {
+        double w = 6.283185307179586 / periods[k];
+        double phase = fmod((double)first, periods[k]) * w;
+        c[k] = cos(phase);
+        s[k] = sin(phase);
+        stepC[k] = cos(w);
+        stepS[k] = sin(w);
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        uint32_t h = HashIndex(first + i, seed);
+        double v = 0.08 * ((h >> 8) * (1.0 / 16777216.0) - 0.5);
+        for (int k = 0; k < 3; ++k)
+        {
+            v += amplitudes[k] * s[k];
+            double nc = c[k] * stepC[k] - s[k] * stepS[k];
+            s[k] = s[k] * stepC[k] + c[k] * stepS[k];
+            c[k] = nc;
+        }
+        // single-sample spikes, the detail decimation by averaging or striding would lose
+        if ((h & 0x3ffffu) == 0)
+            v += (h & 0x80000000u) ? 1.5 : -1.5;
+        out[i] = (float)v;
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "Camera.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Line charts over far more samples than pixels. Samples (uniformly spaced in time)
+// live in a ring of R32F texels on the GPU, next to a min/max pyramid where each level
+// aggregates 8 entries of the one below. Appends update the pyramid incrementally: only
+// the buckets the new samples fall into are recomputed and uploaded.
+//
+// Drawing is M4 aggregation: a compute pass reduces every pixel column to its first,
+// min, max and last sample, reading from the coarsest level that still has at least
+// 4 buckets per column, and the chart is a line strip through those 4 points per column.
+// Buckets are not aligned to columns, so a bucket's min or max can land in the
+// neighbouring column: the result matches drawing every sample to within one column,
+// whatever the zoom. Columns are laid on a grid anchored in the series, not the screen,
+// so panning does not shimmer.
+
+static const int kTimeSeriesMaxLevels = 11;
+
+struct TimeSeries
+{
+    GLuint raw = 0;                             // R32F 2D array, one sample per texel
+    GLuint levels[kTimeSeriesMaxLevels] = {};   // RG32F min/max, level L covers 8^L samples per texel
+    int levelCount = 0;                         // including the raw level 0
+    uint64_t capacity = 0;                      // power of two, the oldest samples are overwritten
+    uint64_t count = 0;                         // samples appended so far
+
+    // placement: sample s is at origin + (s * sampleWidth, value * valueScale)
+    double origin[2] = { 0.0, 0.0 };
+    double sampleWidth = 1.0;
+    double valueScale = 1.0;
+
+    // incremental pyramid state: per level the bucket being filled
+    float accMin[kTimeSeriesMaxLevels];
+    float accMax[kTimeSeriesMaxLevels];
+    uint32_t accFill[kTimeSeriesMaxLevels];
+
+    // per context, so one window rewriting its points cannot race another window's draw
+    std::vector<GLuint> points;         // M4 output, read back by the line shader
+    std::vector<size_t> pointCapacity;  // in points
+    int64_t bytes = 0;
+
+    // last append / draw
+    float appendMs = 0.0f;
+    int drawLevel = -1;         // -1 before the first draw; 0 is raw samples
+    uint32_t drawPoints = 0;
+    uint32_t drawColumns = 0;
+};
+
+// the shared programs; series are created separately
+bool TimeSeriesInit(std::string& errorOut);
+void TimeSeriesShutdown();
+
+// capacity is rounded up to a power of two; at most 2^30 samples
+bool CreateTimeSeries(TimeSeries& series, uint64_t capacity, std::string& errorOut);
+void DestroyTimeSeries(TimeSeries& series);
+void TimeSeriesAppend(TimeSeries& series, const float* samples, size_t count);
+
+// viewportWidth is the target's width in pixels, it decides the column size
+void DrawTimeSeries(TimeSeries& series, const Camera2D& camera, const float* viewScale, int viewportWidth,
+    float r, float g, float b);
+
+// deterministic test signal (slow drift, oscillations, noise and rare spikes that M4
+// must keep) for samples [first, first + count)
+void GenerateSensorSamples(uint64_t first, size_t count, uint32_t seed, float* out);
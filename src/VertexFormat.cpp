@@ -0,0 +1,58 @@
+#include "VertexFormat.h"
+
+namespace
+{
+    VertexFormat MakeFormat(GLint colorComponents, GLenum colorType, GLboolean colorNormalized, GLsizei stride)
+    {
+        VertexFormat f;
+        f.count = 2;
+        f.stride = stride;
+        // layout(location=0) vec2 position
+        f.attributes[0].location = 0;
+        f.attributes[0].components = 2;
+        // layout(location=1) color
+        f.attributes[1].location = 1;
+        f.attributes[1].components = colorComponents;
+        f.attributes[1].type = colorType;
+        f.attributes[1].normalized = colorNormalized;
+        f.attributes[1].offset = sizeof(float) * 2;
+        return f;
+    }
+}
+
+bool VertexFormat::operator==(const VertexFormat& other) const
+{
+    if (count != other.count || stride != other.stride)
+        return false;
+    for (int i = 0; i < count; ++i)
+    {
+        const VertexAttribute& a = attributes[i];
+        const VertexAttribute& b = other.attributes[i];
+        if (a.location != b.location || a.components != b.components || a.type != b.type ||
+            a.normalized != b.normalized || a.offset != b.offset)
+            return false;
+    }
+    return true;
+}
+
+const VertexFormat& MeshVertexFormat()
+{
+    static const VertexFormat format = MakeFormat(3, GL_FLOAT, GL_FALSE, sizeof(float) * 5);
+    return format;
+}
+
+const VertexFormat& PackedColorVertexFormat()
+{
+    static const VertexFormat format = MakeFormat(4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(float) * 2 + 4);
+    return format;
+}
+
+void ApplyVertexFormat(const VertexFormat& format)
+{
+    for (int i = 0; i < format.count; ++i)
+    {
+        const VertexAttribute& a = format.attributes[i];
+        glEnableVertexAttribArray(a.location);
+        glVertexAttribPointer(a.location, a.components, a.type, a.normalized, format.stride, (const void*)(uintptr_t)a.offset);
+    }
+}
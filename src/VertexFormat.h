@@ -0,0 +1,31 @@
+#pragma once
+#include <glad/glad.h>
+
+// layout of one interleaved vertex buffer
+struct VertexAttribute
+{
+    GLuint location = 0;
+    GLint components = 0;
+    GLenum type = GL_FLOAT;
+    GLboolean normalized = GL_FALSE;
+    GLuint offset = 0;
+};
+
+struct VertexFormat
+{
+    static const int kMaxAttributes = 4;
+    VertexAttribute attributes[kMaxAttributes];
+    int count = 0;
+    GLsizei stride = 0;
+
+    bool operator==(const VertexFormat& other) const;
+    bool operator!=(const VertexFormat& other) const { return !(*this == other); }
+};
+
+// pos2 float + color3 float, the scene mesh layout (CreateTriangle)
+const VertexFormat& MeshVertexFormat();
+// pos2 float + RGBA8 normalized color, used by debug draw and the HUD
+const VertexFormat& PackedColorVertexFormat();
+
+// points the bound VAO's attributes at the bound GL_ARRAY_BUFFER
+void ApplyVertexFormat(const VertexFormat& format);
@@ -0,0 +1,165 @@
+#include "Warmup.h"
+#include "RenderTarget.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    struct WarmupEntry
+    {
+        const char* name;
+        PipelineId pipeline;
+        GLenum primitive;
+        GLint variantLocation;
+        int variantCount;
+    };
+
+    std::vector<WarmupEntry> gWarmupEntries;
+
+    const int kWarmupTargetSize = 8;
+    const GLuint kWarmupStorageBindings = 4;
+
+    double MsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    GLsizei VertexCount(GLenum primitive)
+    {
+        if (primitive == GL_POINTS) return 1;
+        if (primitive == GL_LINES || primitive == GL_LINE_STRIP || primitive == GL_LINE_LOOP) return 2;
+        return 3;
+    }
+
+    // one covering triangle in whatever layout the format describes; float attributes at
+    // location 0 get the positions, everything else stays zero. The buffer is also bound
+    // to the low storage buffer bindings so programs that pull their vertices or instance
+    // records read zeros, not garbage.
+    void BuildVertexArray(const VertexFormat& format, GLuint& vao, GLuint& vbo)
+    {
+        static const float kPositions[3][2] = { { -1.0f, -1.0f }, { 3.0f, -1.0f }, { -1.0f, 3.0f } };
+        std::vector<uint8_t> data(std::max<size_t>((size_t)format.stride * 3, 256), 0);
+        for (int i = 0; i < format.count; ++i)
+        {
+            const VertexAttribute& a = format.attributes[i];
+            if (a.location != 0 || a.type != GL_FLOAT || a.components < 2)
+                continue;
+            for (int v = 0; v < 3; ++v)
+            {
+                float* p = (float*)(data.data() + (size_t)format.stride * v + a.offset);
+                p[0] = kPositions[v][0];
+                p[1] = kPositions[v][1];
+            }
+        }
+
+        glGenVertexArrays(1, &vao);
+        glGenBuffers(1, &vbo);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, vbo);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)data.size(), data.data(), GL_STATIC_DRAW);
+        ApplyVertexFormat(format);
+    }
+}
+
+void WarmupRegister(const char* name, PipelineId pipeline, GLenum primitive,
+                    GLint variantLocation, int variantCount)
+{
+    if (!pipeline)
+        return;
+    for (const WarmupEntry& e : gWarmupEntries)
+    {
+        if (e.pipeline == pipeline && e.primitive == primitive &&
+            e.variantLocation == variantLocation && e.variantCount == variantCount)
+            return;
+    }
+    gWarmupEntries.push_back({ name, pipeline, primitive, variantLocation, variantCount });
+}
+
+void WarmupUnregister(PipelineId pipeline)
+{
+    for (size_t i = 0; i < gWarmupEntries.size();)
+    {
+        if (gWarmupEntries[i].pipeline == pipeline)
+        {
+            gWarmupEntries[i] = gWarmupEntries.back();
+            gWarmupEntries.pop_back();
+        }
+        else
+            ++i;
+    }
+}
+
+WarmupStats RunPipelineWarmup()
+{
+    WarmupStats stats;
+    stats.combinations = (int)gWarmupEntries.size();
+    if (gWarmupEntries.empty())
+        return stats;
+
+    // raw draws on purpose: they are not part of any frame, so they stay out of the
+    // profiler's draw counts and out of captures
+    RenderTarget* target = AcquireRenderTarget(kWarmupTargetSize, kWarmupTargetSize);
+    if (!target)
+        return stats;
+
+    GLint viewport[4] = { 0, 0, 0, 0 };
+    glGetIntegerv(GL_VIEWPORT, viewport);
+
+    std::chrono::steady_clock::time_point submitStart = std::chrono::steady_clock::now();
+    glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+    glViewport(0, 0, kWarmupTargetSize, kWarmupTargetSize);
+
+    // one vertex array per distinct format
+    std::vector<VertexFormat> formats;
+    std::vector<GLuint> vaos, vbos;
+    for (const WarmupEntry& e : gWarmupEntries)
+    {
+        const VertexFormat& format = GetPipelineDesc(e.pipeline).format;
+        size_t f = 0;
+        while (f < formats.size() && formats[f] != format) ++f;
+        if (f == formats.size())
+        {
+            GLuint vao = 0, vbo = 0;
+            BuildVertexArray(format, vao, vbo);
+            formats.push_back(format);
+            vaos.push_back(vao);
+            vbos.push_back(vbo);
+        }
+
+        glBindVertexArray(vaos[f]);
+        for (GLuint binding = 0; binding < kWarmupStorageBindings; ++binding)
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, vbos[f]);
+        BindPipeline(e.pipeline);
+
+        int variants = e.variantLocation >= 0 && e.variantCount > 0 ? e.variantCount : 1;
+        for (int v = 0; v < variants; ++v)
+        {
+            if (e.variantLocation >= 0)
+                glUniform1i(e.variantLocation, v);
+            glDrawArrays(e.primitive, 0, VertexCount(e.primitive));
+            stats.draws++;
+        }
+    }
+    stats.submitMs = MsSince(submitStart);
+
+    std::chrono::steady_clock::time_point waitStart = std::chrono::steady_clock::now();
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (fence)
+    {
+        // one second is far beyond any sane warm-up; don't hang startup on a broken driver
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+        glDeleteSync(fence);
+    }
+    stats.waitMs = MsSince(waitStart);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    glDeleteBuffers((GLsizei)vbos.size(), vbos.data());
+    glDeleteVertexArrays((GLsizei)vaos.size(), vaos.data());
+    ReleaseRenderTarget(target);
+    return stats;
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include "Pipeline.h"
+#include <glad/glad.h>
+
+// Pipeline warm-up. Drivers finish compiling a program, and build the variants they
+// specialize on vertex layout and blend state, at the first draw that uses them, so
+// the first frame that touches a combination hitches. Renderers register each
+// pipeline with the primitives they draw it with; RunPipelineWarmup() issues one tiny
+// offscreen draw for each at load time and waits on a fence so the work is done
+// before the first frame.
+
+struct WarmupStats
+{
+    int combinations = 0;
+    int draws = 0;
+    double submitMs = 0.0;  // CPU time issuing the draws (driver compiles mostly land here)
+    double waitMs = 0.0;    // time blocked on the fence afterwards
+};
+
+// variantLocation/variantCount: an int uniform the shader branches on (e.g. the scene
+// mode), drawn once per value 0..variantCount-1; pass -1/0 when there is none
+void WarmupRegister(const char* name, PipelineId pipeline, GLenum primitive,
+                    GLint variantLocation = -1, int variantCount = 0);
+void WarmupUnregister(PipelineId pipeline);
+
+// GL thread only; leaves the default framebuffer and no VAO bound
+WarmupStats RunPipelineWarmup();
@@ -2,31 +2,150 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "Window.h"
-#include <cassert>
+#include "Gfx.h"
+#include "Gles.h"
+#include "Stats.h"
+#include <cstdio>
+#include <bitset>
+#include <vector>
+
+int gGfxContextIndex = 0;
+bool gGfxGles = false;
+bool gGfxTimerQueries = true;
 struct App
 {
 	GLFWwindow* window = nullptr;
+	std::bitset<GLFW_KEY_LAST + 1> keysPressed;
+	double scrollY = 0.0;
+
+	// resize events are only recorded here and applied once per frame by the caller
+	int pendingWidth = 0;
+	int pendingHeight = 0;
+	bool resizePending = false;
+	unsigned resizeEvents = 0;
+	void (*refreshCallback)() = nullptr;
+
+	// extra outputs sharing the primary context's objects; index 0 is gApp.window,
+	// slot i holds window i (nullptr once destroyed)
+	std::vector<GLFWwindow*> secondary;
+	int current = 0;
+	bool gles = false;
+	uint64_t inputPollNs = 0;
 } gApp;
 
-void CreateWindow(int width, int height, const char* title)
+static void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+    if (action == GLFW_PRESS && key >= 0 && key <= GLFW_KEY_LAST)
+        gApp.keysPressed.set(key);
+}
+
+static void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset)
+{
+    gApp.scrollY += yoffset;
+}
+
+static void FramebufferSizeCallback(GLFWwindow* window, int width, int height)
+{
+    gApp.pendingWidth = width;
+    gApp.pendingHeight = height;
+    gApp.resizePending = true;
+    gApp.resizeEvents++;
+}
+
+static void RefreshCallback(GLFWwindow* window)
 {
-    /* Initialize the library */
-    assert(glfwInit() == GLFW_TRUE);
+    // the OS runs a modal loop while a window is dragged/resized, so the main loop
+    // is not running; let the app draw from here to keep the content live
+    if (gApp.refreshCallback)
+        gApp.refreshCallback();
+}
+
+// the same context flavour for the primary and the secondary windows
+static void ContextHints(bool visible, bool egl)
+{
+    if (gApp.gles)
+    {
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, egl ? GLFW_EGL_CONTEXT_API : GLFW_NATIVE_CONTEXT_API);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_ANY_PROFILE);
+    }
+    else
+    {
+        // Request OpenGL 4.3 (1.0 loaded by default)
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_API);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_NATIVE_CONTEXT_API);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    }
+    glfwWindowHint(GLFW_VISIBLE, visible ? GLFW_TRUE : GLFW_FALSE);
+}
+
+void SetWindowContextGles(bool gles)
+{
+    gApp.gles = gles;
+}
 
-    // Request OpenGL 4.3 (1.0 loaded by default)
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+bool CreateWindow(int width, int height, const char* title, bool visible)
+{
+    // checked explicitly, inside assert() the calls would vanish from Release builds
+    if (glfwInit() != GLFW_TRUE)
+    {
+        fprintf(stderr, "glfwInit failed\n");
+        return false;
+    }
 
     /* Create a windowed mode window and its OpenGL context */
+    ContextHints(visible, true);
     gApp.window = glfwCreateWindow(width, height, title, NULL, NULL);
-    assert(gApp.window != nullptr);
+    // ES goes through EGL on embedded Linux; elsewhere the platform API may offer it
+    if (!gApp.window && gApp.gles)
+    {
+        ContextHints(visible, false);
+        gApp.window = glfwCreateWindow(width, height, title, NULL, NULL);
+    }
+    if (!gApp.window)
+    {
+        fprintf(stderr, "cannot create a window with an %s context\n", gApp.gles ? "OpenGL ES 3.1" : "OpenGL 4.3 core");
+        glfwTerminate();
+        return false;
+    }
 
     /* Make the window's context current */
     glfwMakeContextCurrent(gApp.window);
 
     // Load OpenGL extensions
-    assert(gladLoadGLLoader((GLADloadproc)glfwGetProcAddress));
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        fprintf(stderr, "cannot load OpenGL functions\n");
+        glfwDestroyWindow(gApp.window);
+        gApp.window = nullptr;
+        glfwTerminate();
+        return false;
+    }
+    gGfxGles = gApp.gles;
+    gGfxTimerQueries = true;
+    std::string err;
+    if (gGfxGles && !LoadGlesFunctions((GLADloadproc)glfwGetProcAddress, err))
+    {
+        fprintf(stderr, "%s\n", err.c_str());
+        glfwDestroyWindow(gApp.window);
+        gApp.window = nullptr;
+        glfwTerminate();
+        return false;
+    }
+
+    glfwSetKeyCallback(gApp.window, KeyCallback);
+    glfwSetScrollCallback(gApp.window, ScrollCallback);
+    glfwSetFramebufferSizeCallback(gApp.window, FramebufferSizeCallback);
+    glfwSetWindowRefreshCallback(gApp.window, RefreshCallback);
+
+    // report the initial size through the same path as later resizes
+    glfwGetFramebufferSize(gApp.window, &gApp.pendingWidth, &gApp.pendingHeight);
+    gApp.resizePending = true;
+    return true;
 }
 
 bool WindowShouldClose()
@@ -37,13 +156,187 @@ bool WindowShouldClose()
 void Loop()
 {
     /* Swap front and back buffers */
+    GfxEndBackbufferPass();
     glfwSwapBuffers(gApp.window);
 
+    // presses are reported for one frame only
+    gApp.keysPressed.reset();
+
     /* Poll for and process events */
     glfwPollEvents();
+    gApp.inputPollNs = NowNs();
+}
+
+void SwapWindowBuffers()
+{
+    GfxEndBackbufferPass();
+    glfwSwapBuffers(gApp.window);
+}
+
+bool ConsumeFramebufferResize(int& width, int& height)
+{
+    if (!gApp.resizePending)
+        return false;
+    gApp.resizePending = false;
+    width = gApp.pendingWidth;
+    height = gApp.pendingHeight;
+    return true;
+}
+
+unsigned FramebufferResizeEvents()
+{
+    return gApp.resizeEvents;
+}
+
+void SetWindowRefreshCallback(void (*callback)())
+{
+    gApp.refreshCallback = callback;
+}
+
+void SetSwapInterval(int interval)
+{
+    glfwSwapInterval(interval);
+}
+
+void PollEvents()
+{
+    glfwPollEvents();
+    gApp.inputPollNs = NowNs();
+}
+
+uint64_t LastInputPollNs()
+{
+    return gApp.inputPollNs;
+}
+
+int GetRefreshRate()
+{
+    GLFWmonitor* monitor = glfwGetPrimaryMonitor();
+    const GLFWvidmode* mode = monitor ? glfwGetVideoMode(monitor) : nullptr;
+    return mode && mode->refreshRate > 0 ? mode->refreshRate : 60;
+}
+
+bool WasKeyPressed(int key)
+{
+    return key >= 0 && key <= GLFW_KEY_LAST && gApp.keysPressed.test(key);
+}
+
+bool IsKeyDown(int key)
+{
+    return gApp.window && glfwGetKey(gApp.window, key) == GLFW_PRESS;
+}
+
+bool IsMouseButtonDown(int button)
+{
+    return gApp.window && glfwGetMouseButton(gApp.window, button) == GLFW_PRESS;
+}
+
+void GetCursorNdc(double& x, double& y)
+{
+    x = y = 0.0;
+    int w = 0, h = 0;
+    glfwGetWindowSize(gApp.window, &w, &h);
+    if (w <= 0 || h <= 0)
+        return;
+    double cx = 0.0, cy = 0.0;
+    glfwGetCursorPos(gApp.window, &cx, &cy);
+    x = cx / w * 2.0 - 1.0;
+    y = 1.0 - cy / h * 2.0;
+}
+
+double ConsumeScroll()
+{
+    double y = gApp.scrollY;
+    gApp.scrollY = 0.0;
+    return y;
+}
+
+void GetFramebufferSize(int& width, int& height)
+{
+    glfwGetFramebufferSize(gApp.window, &width, &height);
+}
+
+static GLFWwindow* WindowAt(int index)
+{
+    if (index == 0) return gApp.window;
+    if (index < 1 || index > (int)gApp.secondary.size()) return nullptr;
+    return gApp.secondary[index - 1];
+}
+
+int CreateSecondaryWindow(int width, int height, const char* title)
+{
+    // the same API as the primary, sharing needs it
+    ContextHints(true, glfwGetWindowAttrib(gApp.window, GLFW_CONTEXT_CREATION_API) == GLFW_EGL_CONTEXT_API);
+
+    // share buffers, textures and programs with the primary context
+    GLFWwindow* window = glfwCreateWindow(width, height, title, NULL, gApp.window);
+    if (!window)
+        return -1;
+
+    gApp.secondary.push_back(window);
+    int index = (int)gApp.secondary.size();
+
+    // only the primary may block on vsync, the others present immediately
+    int previous = gApp.current;
+    MakeWindowCurrent(index);
+    glfwSwapInterval(0);
+    MakeWindowCurrent(previous);
+    return index;
+}
+
+void DestroySecondaryWindow(int index)
+{
+    GLFWwindow* window = index > 0 ? WindowAt(index) : nullptr;
+    if (!window) return;
+    if (gApp.current == index)
+        MakeWindowCurrent(0);
+    glfwDestroyWindow(window);
+    gApp.secondary[index - 1] = nullptr;
+}
+
+int WindowSlotCount()
+{
+    return 1 + (int)gApp.secondary.size();
+}
+
+bool IsWindowOpen(int index)
+{
+    GLFWwindow* window = WindowAt(index);
+    return window && !glfwWindowShouldClose(window);
+}
+
+void MakeWindowCurrent(int index)
+{
+    GLFWwindow* window = WindowAt(index);
+    if (!window || gApp.current == index) return;
+    glfwMakeContextCurrent(window);
+    gApp.current = index;
+    gGfxContextIndex = index;
+}
+
+void GetWindowFramebufferSize(int index, int& width, int& height)
+{
+    width = height = 0;
+    if (GLFWwindow* window = WindowAt(index))
+        glfwGetFramebufferSize(window, &width, &height);
+}
+
+void SwapWindow(int index)
+{
+    GLFWwindow* window = WindowAt(index);
+    if (!window) return;
+    // invalidation works on the current context, the usual case
+    if (index == gApp.current)
+        GfxEndBackbufferPass();
+    glfwSwapBuffers(window);
 }
 
 void DestroyWindow()
 {
+    for (GLFWwindow* window : gApp.secondary)
+        if (window) glfwDestroyWindow(window);
+    gApp.secondary.clear();
+    gApp.current = 0;
+    gGfxContextIndex = 0;
     glfwTerminate();
 }
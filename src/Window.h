@@ -1,7 +1,52 @@
 #pragma once
+#include <cstdint>
 
-void CreateWindow(int width, int height, const char* title);
+// Ask CreateWindow for an OpenGL ES 3.1 context (through EGL where GLFW has it) instead
+// of desktop 4.3 core; see Gles.h. Call before CreateWindow.
+void SetWindowContextGles(bool gles);
+
+// visible=false creates a hidden window for headless runs (replay, benchmarks);
+// false (with a message on stderr) if GLFW, the window or the GL loader failed
+bool CreateWindow(int width, int height, const char* title, bool visible = true);
 void DestroyWindow();
 
 bool WindowShouldClose();
 void Loop();
+void SetSwapInterval(int interval);
+// process pending window/input events without swapping (Loop() does both)
+void PollEvents();
+// when Loop() or PollEvents() last polled input, on the NowNs() clock; 0 before the first
+uint64_t LastInputPollNs();
+// refresh rate of the primary monitor, 60 if unknown
+int GetRefreshRate();
+
+// true if the key went down since the previous Loop() (GLFW_KEY_* codes)
+bool WasKeyPressed(int key);
+// current state of a key / mouse button on the primary window (GLFW_KEY_*, GLFW_MOUSE_BUTTON_*)
+bool IsKeyDown(int key);
+bool IsMouseButtonDown(int button);
+// cursor over the primary window in [-1,1], y up
+void GetCursorNdc(double& x, double& y);
+// vertical scroll accumulated since the previous call
+double ConsumeScroll();
+void GetFramebufferSize(int& width, int& height);
+
+// Resize events are coalesced: returns true once with the latest framebuffer size if
+// it changed since the last call (also true once after CreateWindow).
+bool ConsumeFramebufferResize(int& width, int& height);
+unsigned FramebufferResizeEvents();
+// called while the OS blocks the main loop (e.g. during a resize drag); the callback
+// should draw and call SwapWindowBuffers()
+void SetWindowRefreshCallback(void (*callback)());
+void SwapWindowBuffers();
+
+// Additional windows for multi-output setups. They share the primary window's GL
+// objects (buffers, textures, programs; not VAOs or queries) and use swap interval 0 so
+// only the primary paces the loop. Index 0 is the primary window.
+int CreateSecondaryWindow(int width, int height, const char* title);   // -1 on failure
+void DestroySecondaryWindow(int index);
+int WindowSlotCount();              // highest index + 1, destroyed slots included
+bool IsWindowOpen(int index);       // exists and was not asked to close
+void MakeWindowCurrent(int index);
+void GetWindowFramebufferSize(int index, int& width, int& height);
+void SwapWindow(int index);
@@ -0,0 +1,630 @@
+#include "World.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    typedef std::chrono::steady_clock Clock;
+
+    const char kWorldMagic[5] = { 'G', 'L', 'W', 'L', 'D' };
+    const uint32_t kWorldVersion = 1;
+    const size_t kHeaderBytes = 5 + 3 * sizeof(uint32_t) + 3 * sizeof(double);
+    const double kVelocitySmoothing = 0.2;
+    // objects near a chunk's edge stick out of it by up to this fraction of the chunk
+    const double kChunkOverhang = 0.25;
+
+    struct ChunkEntry
+    {
+        uint64_t offset;
+        uint32_t bytes;
+        uint32_t objects;
+    };
+
+    enum ChunkState
+    {
+        ChunkEmpty,
+        ChunkQueued,        // in the loader's request list or being read
+        ChunkUploading,     // read, meshes being created a budget's worth per frame
+        ChunkResident,
+        ChunkFailed         // unreadable, never requested again
+    };
+
+    struct Chunk
+    {
+        ChunkState state = ChunkEmpty;
+        Scene scene;
+        GeneratedScene pending;     // read but not uploaded yet
+        size_t nextObject = 0;
+        uint64_t bytes = 0;         // vertex bytes created on the GPU so far
+        uint64_t fullBytes = 0;     // GPU bytes of the whole chunk, 0 until it was uploaded once
+        uint64_t lastVisible = 0;   // frame number, 0 = never
+        uint64_t wantedFrame = 0;
+        uint64_t visibleFrame = 0;
+        double priority = 0.0;      // lower loads first
+    };
+
+    struct LoadedChunk
+    {
+        int index;
+        bool ok;
+        GeneratedScene scene;
+    };
+
+    struct WorldState
+    {
+        bool open = false;
+        uint32_t chunksX = 0;
+        uint32_t chunksY = 0;
+        double chunkSize = 1.0;
+        double origin[2] = { 0.0, 0.0 };
+        std::vector<ChunkEntry> table;
+        std::vector<Chunk> chunks;
+        WorldStreamOptions options;
+
+        // loader thread; requests are sorted best last so it can pop_back
+        FILE* file = nullptr;
+        std::thread loader;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::vector<int> requests;
+        std::vector<LoadedChunk> loaded;
+        int inFlight = -1;
+        bool stop = false;
+
+        // GL thread
+        uint64_t frame = 0;
+        double lastTime = -1.0;
+        double lastCenter[2] = { 0.0, 0.0 };
+        double velocity[2] = { 0.0, 0.0 };
+        std::vector<int> candidates;
+        std::vector<int> uploading;
+        WorldStats stats;
+    } gWorld;
+
+    bool SeekTo(FILE* f, uint64_t offset)
+    {
+#ifdef _WIN32
+        return _fseeki64(f, (long long)offset, SEEK_SET) == 0;
+#else
+        return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+    }
+
+    bool FileSize(FILE* f, uint64_t& size)
+    {
+#ifdef _WIN32
+        if (_fseeki64(f, 0, SEEK_END) != 0) return false;
+        long long end = _ftelli64(f);
+#else
+        if (fseeko(f, 0, SEEK_END) != 0) return false;
+        off_t end = ftello(f);
+#endif
+        size = (uint64_t)end;
+        return end >= 0;
+    }
+
+    template <typename T>
+    bool ReadPod(FILE* f, T& v) { return fread(&v, sizeof(T), 1, f) == 1; }
+    template <typename T>
+    bool WritePod(FILE* f, const T& v) { return fwrite(&v, sizeof(T), 1, f) == 1; }
+
+    // chunk index range [lo, hi] covering a world-space box, false if it misses the grid
+    bool ChunkRange(const double* minW, const double* maxW, int* lo, int* hi)
+    {
+        const WorldState& w = gWorld;
+        const int count[2] = { (int)w.chunksX, (int)w.chunksY };
+        for (int a = 0; a < 2; ++a)
+        {
+            double l = floor((minW[a] - w.origin[a]) / w.chunkSize);
+            double h = floor((maxW[a] - w.origin[a]) / w.chunkSize);
+            if (h < 0.0 || l >= count[a]) return false;
+            lo[a] = (int)std::max(0.0, l);
+            hi[a] = (int)std::min((double)count[a] - 1.0, h);
+        }
+        return true;
+    }
+
+    void ChunkCenter(int index, double* out)
+    {
+        const WorldState& w = gWorld;
+        out[0] = w.origin[0] + ((index % (int)w.chunksX) + 0.5) * w.chunkSize;
+        out[1] = w.origin[1] + ((index / (int)w.chunksX) + 0.5) * w.chunkSize;
+    }
+
+    // distance from a point to the chunk's square, 0 inside
+    double ChunkDistance(int index, const double* p)
+    {
+        double c[2];
+        ChunkCenter(index, c);
+        double half = gWorld.chunkSize * 0.5;
+        double dx = std::max(0.0, fabs(p[0] - c[0]) - half);
+        double dy = std::max(0.0, fabs(p[1] - c[1]) - half);
+        return sqrt(dx * dx + dy * dy);
+    }
+
+    void LoaderMain()
+    {
+        WorldState& w = gWorld;
+        std::vector<char> bytes;
+        for (;;)
+        {
+            int index = -1;
+            {
+                std::unique_lock<std::mutex> lock(w.mutex);
+                w.wake.wait(lock, [&] { return w.stop || !w.requests.empty(); });
+                if (w.stop) return;
+                index = w.requests.back();
+                w.requests.pop_back();
+                w.inFlight = index;
+            }
+
+            LoadedChunk result;
+            result.index = index;
+            const ChunkEntry& e = w.table[index];
+            bytes.resize(e.bytes);
+            result.ok = SeekTo(w.file, e.offset) && fread(bytes.data(), 1, bytes.size(), w.file) == bytes.size()
+                && DeserializeScene(bytes.data(), bytes.size(), result.scene);
+
+            std::lock_guard<std::mutex> lock(w.mutex);
+            w.loaded.push_back(std::move(result));
+            w.inFlight = -1;
+        }
+    }
+
+    void ReleaseChunk(Chunk& c)
+    {
+        DestroyScene(c.scene);
+        c.pending.objects.clear();
+        c.pending.objects.shrink_to_fit();
+        c.nextObject = 0;
+        gWorld.stats.residentBytes -= c.bytes;
+        c.bytes = 0;
+        c.state = ChunkEmpty;
+    }
+
+    // marks every chunk in the box as wanted this frame and collects the new ones
+    void WantBox(const double* minW, const double* maxW, bool visible)
+    {
+        WorldState& w = gWorld;
+        int lo[2], hi[2];
+        if (!ChunkRange(minW, maxW, lo, hi)) return;
+        for (int y = lo[1]; y <= hi[1]; ++y)
+        {
+            for (int x = lo[0]; x <= hi[0]; ++x)
+            {
+                int index = y * (int)w.chunksX + x;
+                Chunk& c = w.chunks[index];
+                if (visible)
+                {
+                    c.visibleFrame = w.frame;
+                    c.lastVisible = w.frame;
+                }
+                if (c.wantedFrame == w.frame) continue;
+                c.wantedFrame = w.frame;
+                w.candidates.push_back(index);
+            }
+        }
+    }
+
+    void SelectChunks(const Camera2D& camera, const float* viewScale, double dt)
+    {
+        WorldState& w = gWorld;
+        if (dt > 0.0)
+        {
+            for (int a = 0; a < 2; ++a)
+            {
+                double v = (camera.center[a] - w.lastCenter[a]) / dt;
+                w.velocity[a] += (v - w.velocity[a]) * kVelocitySmoothing;
+            }
+        }
+        w.lastCenter[0] = camera.center[0];
+        w.lastCenter[1] = camera.center[1];
+        w.stats.speed = sqrt(w.velocity[0] * w.velocity[0] + w.velocity[1] * w.velocity[1]);
+
+        double minV[2], maxV[2];
+        CameraVisibleBounds(camera, viewScale, minV, maxV);
+        const double overhang = kChunkOverhang * w.chunkSize;
+        for (int a = 0; a < 2; ++a)
+        {
+            minV[a] -= overhang;
+            maxV[a] += overhang;
+        }
+        double margin = w.options.marginChunks * w.chunkSize;
+        double minP[2] = { minV[0] - margin, minV[1] - margin };
+        double maxP[2] = { maxV[0] + margin, maxV[1] + margin };
+        // the same box moved to where the camera is heading
+        double ahead[2] = { w.velocity[0] * w.options.lookaheadSeconds, w.velocity[1] * w.options.lookaheadSeconds };
+        double minA[2] = { minP[0] + ahead[0], minP[1] + ahead[1] };
+        double maxA[2] = { maxP[0] + ahead[0], maxP[1] + ahead[1] };
+
+        w.candidates.clear();
+        WantBox(minV, maxV, true);
+        WantBox(minP, maxP, false);
+        WantBox(minA, maxA, false);
+        // visible chunks always sort ahead of prefetched ones, then by distance
+        for (int index : w.candidates)
+        {
+            Chunk& c = w.chunks[index];
+            c.priority = ChunkDistance(index, camera.center) + (c.visibleFrame == w.frame ? 0.0 : 1e30);
+        }
+        std::sort(w.candidates.begin(), w.candidates.end(),
+            [&](int a, int b) { return w.chunks[a].priority < w.chunks[b].priority; });
+
+        // keep the best chunks that fit under the cap, judged by their GPU size once they
+        // have been uploaded and by their file size, which is larger, until then
+        uint64_t budget = 0;
+        size_t keep = 0;
+        for (; keep < w.candidates.size(); ++keep)
+        {
+            int index = w.candidates[keep];
+            budget += w.chunks[index].fullBytes ? w.chunks[index].fullBytes : w.table[index].bytes;
+            if (budget > w.options.memoryCap && keep > 0) break;
+        }
+        for (size_t i = keep; i < w.candidates.size(); ++i)
+            w.chunks[w.candidates[i]].wantedFrame = 0;
+        w.candidates.resize(keep);
+    }
+
+    void UpdateRequests()
+    {
+        WorldState& w = gWorld;
+        std::lock_guard<std::mutex> lock(w.mutex);
+        // arrivals first, so a chunk that was just read is not requested again
+        for (LoadedChunk& l : w.loaded)
+        {
+            Chunk& c = w.chunks[l.index];
+            if (!l.ok)
+            {
+                c.state = ChunkFailed;
+                w.stats.failed++;
+                continue;
+            }
+            if (c.wantedFrame != w.frame)
+            {
+                c.state = ChunkEmpty;
+                w.stats.dropped++;
+                continue;
+            }
+            c.state = ChunkUploading;
+            c.pending = std::move(l.scene);
+            c.nextObject = 0;
+            w.uploading.push_back(l.index);
+        }
+        w.loaded.clear();
+
+        // queued chunks that fell out of the wanted set are cancelled, unless already being read
+        for (int index : w.requests)
+        {
+            Chunk& c = w.chunks[index];
+            if (c.wantedFrame != w.frame && index != w.inFlight) c.state = ChunkEmpty;
+        }
+        w.requests.clear();
+        for (int index : w.candidates)
+        {
+            Chunk& c = w.chunks[index];
+            if (c.state == ChunkEmpty) c.state = ChunkQueued;
+            if (c.state == ChunkQueued && index != w.inFlight) w.requests.push_back(index);
+        }
+        std::reverse(w.requests.begin(), w.requests.end());
+        if (!w.requests.empty()) w.wake.notify_one();
+    }
+
+    void UploadChunks(const Camera2D& camera)
+    {
+        WorldState& w = gWorld;
+        // stale uploads are abandoned, the rest go in priority order
+        for (size_t i = 0; i < w.uploading.size();)
+        {
+            Chunk& c = w.chunks[w.uploading[i]];
+            if (c.state == ChunkUploading && c.wantedFrame == w.frame) { ++i; continue; }
+            if (c.state == ChunkUploading) ReleaseChunk(c);
+            w.uploading[i] = w.uploading.back();
+            w.uploading.pop_back();
+        }
+        std::sort(w.uploading.begin(), w.uploading.end(),
+            [&](int a, int b) { return w.chunks[a].priority < w.chunks[b].priority; });
+
+        // at least one object per frame so a tiny budget still makes progress
+        uint64_t spent = 0;
+        size_t done = 0;
+        for (int index : w.uploading)
+        {
+            Chunk& c = w.chunks[index];
+            c.scene.objects.reserve(c.pending.objects.size());
+            while (c.nextObject < c.pending.objects.size() && (spent < w.options.uploadBudget || spent == 0))
+            {
+                const GeneratedObject& g = c.pending.objects[c.nextObject++];
+                if (!InstantiateObject(g, c.scene)) continue;
+                SceneObject& o = c.scene.objects.back();
+                ChunkCenter(index, o.origin);
+                uint64_t bytes = MeshBytes(o.mesh);
+                c.bytes += bytes;
+                w.stats.residentBytes += bytes;
+                spent += bytes;
+            }
+            if (c.nextObject < c.pending.objects.size())
+                break;
+            c.pending.objects.clear();
+            c.pending.objects.shrink_to_fit();
+            c.state = ChunkResident;
+            c.fullBytes = c.bytes;
+            w.stats.loaded++;
+            ++done;
+            // it was on screen as a hole until now
+            if (c.visibleFrame == w.frame)
+            {
+                double d = ChunkDistance(index, camera.center) * camera.zoom;
+                w.stats.closestPopIn = w.stats.popIns == 0 ? d : std::min(w.stats.closestPopIn, d);
+                w.stats.popIns++;
+            }
+        }
+        w.uploading.erase(w.uploading.begin(), w.uploading.begin() + done);
+        w.stats.peakBytes = std::max(w.stats.peakBytes, w.stats.residentBytes);
+    }
+
+    void EvictChunks()
+    {
+        WorldState& w = gWorld;
+        if (w.stats.residentBytes <= w.options.memoryCap) return;
+        // least recently visible first, never anything still wanted
+        std::vector<int> victims;
+        for (size_t i = 0; i < w.chunks.size(); ++i)
+        {
+            const Chunk& c = w.chunks[i];
+            if (c.state == ChunkResident && c.wantedFrame != w.frame) victims.push_back((int)i);
+        }
+        std::sort(victims.begin(), victims.end(),
+            [&](int a, int b) { return w.chunks[a].lastVisible < w.chunks[b].lastVisible; });
+        for (int index : victims)
+        {
+            if (w.stats.residentBytes <= w.options.memoryCap) break;
+            ReleaseChunk(w.chunks[index]);
+            w.stats.evicted++;
+        }
+    }
+}
+
+bool WriteWorldFile(const char* path, const WorldGenParams& params, std::string& errorOut)
+{
+    if (params.chunksX <= 0 || params.chunksY <= 0 || params.chunkSize <= 0.0)
+    {
+        errorOut = "world needs at least one chunk and a positive chunk size";
+        return false;
+    }
+    FILE* f = fopen(path, "wb");
+    if (!f)
+    {
+        errorOut = std::string("cannot open ") + path;
+        return false;
+    }
+
+    const uint32_t chunksX = (uint32_t)params.chunksX;
+    const uint32_t chunksY = (uint32_t)params.chunksY;
+    const double origin[2] = { -0.5 * chunksX * params.chunkSize, -0.5 * chunksY * params.chunkSize };
+    std::vector<ChunkEntry> table((size_t)chunksX * chunksY);
+    bool ok = fwrite(kWorldMagic, 1, 5, f) == 5 && WritePod(f, kWorldVersion) && WritePod(f, chunksX)
+        && WritePod(f, chunksY) && WritePod(f, params.chunkSize) && WritePod(f, origin[0]) && WritePod(f, origin[1]);
+    // the table is filled in once the payload offsets are known
+    const uint64_t tableOffset = kHeaderBytes;
+    uint64_t offset = tableOffset + table.size() * (sizeof(uint64_t) + 2 * sizeof(uint32_t));
+    ok = ok && SeekTo(f, offset);
+
+    // the generator lays objects out in [-1,1]
+    const float scale = (float)(params.chunkSize * 0.5);
+    GeneratedScene chunk;
+    std::string bytes;
+    for (size_t i = 0; ok && i < table.size(); ++i)
+    {
+        SceneGenParams p = params.scene;
+        p.seed = params.scene.seed * 0x9E3779B1u + (uint32_t)i;
+        GenerateScene(p, chunk);
+        for (GeneratedObject& o : chunk.objects)
+        {
+            o.center[0] *= scale;
+            o.center[1] *= scale;
+            o.amplitude *= scale;
+            for (size_t v = 0; v < o.vertices.size(); v += 5)
+            {
+                o.vertices[v] *= scale;
+                o.vertices[v + 1] *= scale;
+            }
+        }
+        SerializeScene(chunk, bytes);
+        table[i].offset = offset;
+        table[i].bytes = (uint32_t)bytes.size();
+        table[i].objects = (uint32_t)chunk.objects.size();
+        ok = fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+        offset += bytes.size();
+    }
+
+    ok = ok && SeekTo(f, tableOffset);
+    for (size_t i = 0; ok && i < table.size(); ++i)
+        ok = WritePod(f, table[i].offset) && WritePod(f, table[i].bytes) && WritePod(f, table[i].objects);
+    ok = fclose(f) == 0 && ok;
+    if (!ok) errorOut = std::string("cannot write ") + path;
+    return ok;
+}
+
+bool ParseWorldGenArg(int& i, int argc, char** argv, WorldGenParams& params)
+{
+    const char* arg = argv[i];
+    if (i + 1 >= argc) return false;
+    const char* value = argv[i + 1];
+
+    if (!strcmp(arg, "--chunks"))
+    {
+        if (sscanf(value, "%dx%d", &params.chunksX, &params.chunksY) != 2)
+            params.chunksX = params.chunksY = atoi(value);
+    }
+    else if (!strcmp(arg, "--chunk-size")) params.chunkSize = atof(value);
+    else return false;
+
+    ++i;
+    return true;
+}
+
+bool WorldOpen(const char* path, const WorldStreamOptions& options, std::string& errorOut)
+{
+    WorldState& w = gWorld;
+    if (w.open) WorldClose();
+
+    FILE* f = fopen(path, "rb");
+    if (!f)
+    {
+        errorOut = std::string("cannot open ") + path;
+        return false;
+    }
+    char magic[5];
+    uint32_t version = 0;
+    bool ok = fread(magic, 1, 5, f) == 5 && !memcmp(magic, kWorldMagic, 5) && ReadPod(f, version)
+        && version == kWorldVersion && ReadPod(f, w.chunksX) && ReadPod(f, w.chunksY) && ReadPod(f, w.chunkSize)
+        && ReadPod(f, w.origin[0]) && ReadPod(f, w.origin[1])
+        && w.chunksX > 0 && w.chunksY > 0 && w.chunkSize > 0.0 && (uint64_t)w.chunksX * w.chunksY <= (1u << 24);
+    if (ok)
+    {
+        w.table.resize((size_t)w.chunksX * w.chunksY);
+        for (size_t i = 0; ok && i < w.table.size(); ++i)
+            ok = ReadPod(f, w.table[i].offset) && ReadPod(f, w.table[i].bytes) && ReadPod(f, w.table[i].objects);
+    }
+    // the loader allocates what the table says, so it has to lie inside the file
+    uint64_t fileSize = 0;
+    ok = ok && FileSize(f, fileSize);
+    for (size_t i = 0; ok && i < w.table.size(); ++i)
+        ok = w.table[i].offset <= fileSize && w.table[i].bytes <= fileSize - w.table[i].offset;
+    if (!ok)
+    {
+        fclose(f);
+        w.table.clear();
+        errorOut = std::string(path) + " is not a world file";
+        return false;
+    }
+
+    w.file = f;
+    w.options = options;
+    w.origin[0] += options.offset[0];
+    w.origin[1] += options.offset[1];
+    w.chunks.clear();
+    w.chunks.resize(w.table.size());
+    w.frame = 0;
+    w.lastTime = -1.0;
+    w.velocity[0] = w.velocity[1] = 0.0;
+    w.stats = WorldStats();
+    w.stats.chunks = (uint32_t)w.table.size();
+    w.stop = false;
+    w.inFlight = -1;
+    w.loader = std::thread(LoaderMain);
+    w.open = true;
+    return true;
+}
+
+void WorldClose()
+{
+    WorldState& w = gWorld;
+    if (!w.open) return;
+    {
+        std::lock_guard<std::mutex> lock(w.mutex);
+        w.stop = true;
+    }
+    w.wake.notify_all();
+    w.loader.join();
+    fclose(w.file);
+    w.file = nullptr;
+    for (Chunk& c : w.chunks)
+        if (c.state == ChunkUploading || c.state == ChunkResident) ReleaseChunk(c);
+    w.chunks.clear();
+    w.table.clear();
+    w.requests.clear();
+    w.loaded.clear();
+    w.uploading.clear();
+    w.open = false;
+}
+
+bool WorldIsOpen()
+{
+    return gWorld.open;
+}
+
+void WorldCenter(double* out)
+{
+    const WorldState& w = gWorld;
+    out[0] = w.origin[0] + 0.5 * w.chunksX * w.chunkSize;
+    out[1] = w.origin[1] + 0.5 * w.chunksY * w.chunkSize;
+}
+
+void WorldUpdate(const Camera2D& camera, const float* viewScale, double now)
+{
+    WorldState& w = gWorld;
+    if (!w.open) return;
+    Clock::time_point start = Clock::now();
+    w.frame++;
+    double dt = w.lastTime < 0.0 ? 0.0 : now - w.lastTime;
+    if (w.lastTime < 0.0)
+    {
+        w.lastCenter[0] = camera.center[0];
+        w.lastCenter[1] = camera.center[1];
+    }
+    w.lastTime = now;
+
+    SelectChunks(camera, viewScale, dt);
+    UpdateRequests();
+    UploadChunks(camera);
+    EvictChunks();
+
+    WorldStats& s = w.stats;
+    s.resident = s.loading = s.visible = s.missingVisible = 0;
+    for (const Chunk& c : w.chunks)
+    {
+        if (c.state == ChunkResident) s.resident++;
+        else if (c.state == ChunkQueued || c.state == ChunkUploading) s.loading++;
+        if (c.visibleFrame != w.frame) continue;
+        s.visible++;
+        // empty chunks count as present, there is nothing to pop in
+        if (c.state != ChunkResident && w.table[&c - w.chunks.data()].objects > 0) s.missingVisible++;
+    }
+    s.frames++;
+    if (s.missingVisible) s.holeFrames++;
+    s.updateMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+    s.maxUpdateMs = std::max(s.maxUpdateMs, s.updateMs);
+    if (s.updateMs > kWorldHitchMs) s.hitches++;
+}
+
+void WorldDraw(const SceneProgram& program, float t, const Camera2D& camera)
+{
+    WorldState& w = gWorld;
+    if (!w.open) return;
+    // windows differ in aspect, so cull against this program's view rather than the
+    // visible set WorldUpdate computed for the primary
+    double minV[2], maxV[2];
+    int lo[2], hi[2];
+    CameraVisibleBounds(camera, program.viewScale, minV, maxV);
+    for (int a = 0; a < 2; ++a)
+    {
+        minV[a] -= kChunkOverhang * w.chunkSize;
+        maxV[a] += kChunkOverhang * w.chunkSize;
+    }
+    if (!ChunkRange(minV, maxV, lo, hi)) return;
+    for (int y = lo[1]; y <= hi[1]; ++y)
+    {
+        for (int x = lo[0]; x <= hi[0]; ++x)
+        {
+            const Chunk& c = w.chunks[y * (int)w.chunksX + x];
+            if (c.state == ChunkResident)
+                DrawScene(c.scene, program, t, camera);
+        }
+    }
+}
+
+WorldStats GetWorldStats()
+{
+    WorldStats s = gWorld.stats;
+    s.chunks = (uint32_t)gWorld.table.size();
+    return s;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#include "Camera.h"
+#include "Scene.h"
+#include "SceneGen.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A world too large to keep resident, split into a grid of square chunks in one file:
+//   "GLWLD", u32 version, u32 chunksX, u32 chunksY, f64 chunkSize, f64 origin[2],
+//   then chunksX * chunksY entries { u64 offset, u32 bytes, u32 objects } (row-major,
+//   chunk (0,0) has its corner at origin, x right, y up), then the chunk payloads.
+// A payload is a scene file (see SerializeScene) with positions relative to the chunk
+// center, so each chunk is one seek + read and stays float-precise anywhere in the world.
+
+struct WorldGenParams
+{
+    int chunksX = 32;
+    int chunksY = 32;
+    double chunkSize = 2.0;     // world units; the generator's [-1,1] layout is scaled to fit
+    SceneGenParams scene;       // per chunk; the seed is mixed with the chunk index
+};
+
+// generates and writes one chunk at a time, so the world never has to fit in memory
+bool WriteWorldFile(const char* path, const WorldGenParams& params, std::string& errorOut);
+// consumes --chunks <n>|<x>x<y> or --chunk-size <s> at argv[i], like ParseSceneGenArg
+bool ParseWorldGenArg(int& i, int argc, char** argv, WorldGenParams& params);
+
+struct WorldStreamOptions
+{
+    size_t memoryCap = (size_t)64 << 20;    // vertex bytes kept on the GPU
+    size_t uploadBudget = (size_t)1 << 20;  // vertex bytes uploaded per frame
+    double lookaheadSeconds = 0.5;          // also prefetch where the camera will be this soon
+    int marginChunks = 1;                   // ring of chunks prefetched around the view
+    double offset[2] = { 0.0, 0.0 };        // moves the whole world, added to the file's origin
+};
+
+struct WorldStats
+{
+    uint32_t chunks = 0;
+    uint32_t resident = 0;
+    uint32_t loading = 0;           // requested, being read or uploading
+    uint32_t visible = 0;
+    uint32_t missingVisible = 0;    // visible this frame but not resident yet
+    uint64_t residentBytes = 0;
+    uint64_t peakBytes = 0;
+    uint64_t loaded = 0;
+    uint64_t evicted = 0;
+    uint64_t dropped = 0;           // read, but no longer wanted when it arrived
+    uint64_t failed = 0;
+    uint64_t frames = 0;
+    uint64_t holeFrames = 0;        // frames with at least one visible chunk missing
+    uint64_t hitches = 0;           // frames where the streaming work took over kWorldHitchMs
+    float updateMs = 0.0f;
+    float maxUpdateMs = 0.0f;
+    uint64_t popIns = 0;            // chunks that finished while already on screen
+    double closestPopIn = 0.0;      // view units from the camera center, 0 until a pop-in
+    double speed = 0.0;             // smoothed camera speed, world units per second
+};
+
+static const double kWorldHitchMs = 4.0;
+
+bool WorldOpen(const char* path, const WorldStreamOptions& options, std::string& errorOut);
+void WorldClose();
+bool WorldIsOpen();
+void WorldCenter(double* out);
+
+// once per frame on the GL thread, after the camera moved: picks the chunks to keep,
+// hands reads to the loader thread, uploads within the budget and evicts over the cap
+void WorldUpdate(const Camera2D& camera, const float* viewScale, double now);
+// resident chunks that intersect the program's view
+void WorldDraw(const SceneProgram& program, float t, const Camera2D& camera);
+
+WorldStats GetWorldStats();
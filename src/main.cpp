@@ -1,240 +1,927 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include "Window.h"
-#include "Shader.h"
+#include "Benchmark.h"
+#include "Camera.h"
+#include "Caps.h"
+#include "Capture.h"
+#include "Cluster.h"
+#include "DebugDraw.h"
+#include "DeferredDelete.h"
+#include "FrameExport.h"
+#include "FramePacer.h"
+#include "Gfx.h"
+#include "Hud.h"
+#include "Instances.h"
+#include "MicroBench.h"
+#include "PointCloud.h"
+#include "Process.h"
+#include "Profiler.h"
+#include "RenderTarget.h"
+#include "Replay.h"
+#include "Scene.h"
+#include "SceneControl.h"
+#include "SceneGen.h"
+#include "Startup.h"
+#include "Stream.h"
+#include "Tilemap.h"
+#include "TimeSeries.h"
+#include "Warmup.h"
+#include "World.h"
 #include <iostream>
 #include <vector>
 #include <cmath>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+
+// everything a frame needs, shared by the main loop and the window refresh callback
+struct Demo
+{
+    SceneProgram program;
+    Scene scene;
+    Tilemap tilemap;            // drawn under the scene when --tilemap is given
+    TimeSeries plot;            // drawn over everything when --plot is given
+    double plotRate = 0.0;      // samples appended per second
+    double plotTime = -1.0;
+    std::vector<float> plotScratch;
+    PointCloud points;          // drawn over the scene when --points is given; F4/F5 switch
+    PointSplatMode pointMode = SplatDensity;
+    PointDrawPath pointPath = PointPathCompute;
+    bool offscreen = false;     // render the scene into a pooled target and blit it
+    int msaa = 0;               // samples of that target, 0 = none
+    int width = 0;
+    int height = 0;
+
+    // frame times while a resize is in progress
+    std::chrono::steady_clock::time_point lastResize;
+    std::chrono::steady_clock::time_point lastFrame;
+    bool hasLastFrame = false;
+    unsigned resizesApplied = 0;
+    unsigned dragFrames = 0;
+    double dragFrameMsSum = 0.0;
+    double dragFrameMsMax = 0.0;
+
+    // per output: time from making its context current to its swap returning
+    struct OutputTiming
+    {
+        unsigned frames = 0;
+        double sumMs = 0.0;
+        double maxMs = 0.0;
+    };
+    std::vector<OutputTiming> outputs;
+    std::chrono::steady_clock::time_point primaryDrawEnd;
+
+    // primary draw + swap time of the first frames, where first-use pipeline hitches land
+    static const int kEarlyFrames = 60;
+    std::vector<double> earlyFrameMs;
+    bool warmup = false;
+    WarmupStats warmupStats;
+
+    // view into the world; Home returns to homeCamera. Locked while capturing, captures
+    // do not record the camera block
+    Camera2D camera;
+    Camera2D homeCamera;
+    bool cameraLocked = false;
+    double cameraTime = -1.0;
+    bool dragging = false;
+    double dragLast[2] = { 0.0, 0.0 };
+} gDemo;
+
+// pick up the latest framebuffer size once per frame; everything size-dependent is
+// updated here instead of in the event callback
+static void ApplyResize()
+{
+    int w = 0, h = 0;
+    if (!ConsumeFramebufferResize(w, h) || w <= 0 || h <= 0)
+        return;
+    gDemo.width = w;
+    gDemo.height = h;
+    gDemo.resizesApplied++;
+    gDemo.lastResize = std::chrono::steady_clock::now();
+
+    glViewport(0, 0, w, h);
+    SetSceneViewport(gDemo.program, w, h);
+    DebugDrawSetViewScale(gDemo.program.viewScale[0], gDemo.program.viewScale[1]);
+}
 
-// Vertex shader - supports position + per-vertex color and simple transforms based on mode
-static const char* vertexSrc = R"(
-#version 430 core
-layout(location = 0) in vec2 aPos;
-layout(location = 1) in vec3 aColor;
+static void TrackResizeFrameTime()
+{
+    using namespace std::chrono;
+    steady_clock::time_point now = steady_clock::now();
+    // the first resize comes from window creation, it is not a drag
+    if (gDemo.hasLastFrame && gDemo.resizesApplied > 1 && now - gDemo.lastResize < milliseconds(250))
+    {
+        double ms = duration<double, std::milli>(now - gDemo.lastFrame).count();
+        gDemo.dragFrames++;
+        gDemo.dragFrameMsSum += ms;
+        if (ms > gDemo.dragFrameMsMax) gDemo.dragFrameMsMax = ms;
+    }
+    gDemo.lastFrame = now;
+    gDemo.hasLastFrame = true;
+}
 
-uniform int mode;      // indicates which triangle behavior to apply
-uniform float time;    // global time
-uniform vec2 offset;   // translation offset for mode 3
-uniform float angle;   // rotation angle for mode 4
-uniform vec2 center;   // center for rotations/translations if needed
+// arrows pan, PageUp/PageDown and the wheel zoom, Q/E rotate, left drag pans, Home resets
+static void UpdateCamera(double now)
+{
+    double dt = gDemo.cameraTime < 0.0 ? 0.0 : std::min(0.1, now - gDemo.cameraTime);
+    gDemo.cameraTime = now;
+    Camera2D& cam = gDemo.camera;
+    if (!gDemo.cameraLocked)
+    {
+        if (WasKeyPressed(GLFW_KEY_HOME))
+            cam = gDemo.homeCamera;
+
+        const double panSpeed = 1.0;    // view units per second, so the same at any zoom
+        double dx = (IsKeyDown(GLFW_KEY_RIGHT) ? 1.0 : 0.0) - (IsKeyDown(GLFW_KEY_LEFT) ? 1.0 : 0.0);
+        double dy = (IsKeyDown(GLFW_KEY_UP) ? 1.0 : 0.0) - (IsKeyDown(GLFW_KEY_DOWN) ? 1.0 : 0.0);
+        // the keys move the camera, which moves the content the other way
+        if (dx != 0.0 || dy != 0.0)
+            CameraPanView(cam, -dx * panSpeed * dt, -dy * panSpeed * dt);
+
+        double zoomSteps = (IsKeyDown(GLFW_KEY_PAGE_UP) ? 1.0 : 0.0) - (IsKeyDown(GLFW_KEY_PAGE_DOWN) ? 1.0 : 0.0);
+        if (zoomSteps != 0.0)
+            CameraZoomAt(cam, pow(2.0, zoomSteps * dt), 0.0, 0.0);
+        cam.rotation += ((IsKeyDown(GLFW_KEY_Q) ? 1.0 : 0.0) - (IsKeyDown(GLFW_KEY_E) ? 1.0 : 0.0)) * dt;
+
+        // mouse input is in NDC, the camera works in view units before aspect correction
+        double cx = 0.0, cy = 0.0;
+        GetCursorNdc(cx, cy);
+        double vx = cx / gDemo.program.viewScale[0];
+        double vy = cy / gDemo.program.viewScale[1];
+        double scroll = ConsumeScroll();
+        if (scroll != 0.0)
+            CameraZoomAt(cam, pow(1.1, scroll), vx, vy);
+        bool down = IsMouseButtonDown(GLFW_MOUSE_BUTTON_LEFT);
+        if (down && gDemo.dragging)
+            CameraPanView(cam, vx - gDemo.dragLast[0], vy - gDemo.dragLast[1]);
+        gDemo.dragging = down;
+        gDemo.dragLast[0] = vx;
+        gDemo.dragLast[1] = vy;
+    }
+    CameraUpload(cam);
+}
 
-out vec3 vColor;
+// streams synthetic samples into the plot at plotRate
+static void AppendPlotSamples(double now)
+{
+    TimeSeries& plot = gDemo.plot;
+    double dt = gDemo.plotTime < 0.0 ? 0.0 : now - gDemo.plotTime;
+    gDemo.plotTime = now;
+    size_t n = (size_t)std::min(gDemo.plotRate * dt, (double)plot.capacity);
+    if (!plot.raw || n == 0)
+        return;
+    gDemo.plotScratch.resize(n);
+    GenerateSensorSamples(plot.count, n, 1234u, gDemo.plotScratch.data());
+    TimeSeriesAppend(plot, gDemo.plotScratch.data(), n);
+}
 
-void main()
+static void DrawFrame(double now)
 {
-    vec2 pos = aPos;
+    ApplyResize();
+    TrackResizeFrameTime();
 
-    if (mode == 3) {
-        // translation triangle: translate by offset
-        pos += offset;
+    ProfilerBeginFrame();
+    if (WasKeyPressed(GLFW_KEY_F1))
+        HudToggle();
+    if (gDemo.points.count && WasKeyPressed(GLFW_KEY_F4))
+    {
+        gDemo.pointMode = (PointSplatMode)((gDemo.pointMode + 1) % PointSplatModeCount);
+        std::cout << "points: " << PointSplatModeName(gDemo.pointMode) << std::endl;
     }
-    else if (mode == 4) {
-        // rotate about the provided center
-        vec2 p = pos - center;
-        float s = sin(angle);
-        float c = cos(angle);
-        p = vec2(c*p.x - s*p.y, s*p.x + c*p.y);
-        pos = p + center;
+    if (gDemo.points.count && WasKeyPressed(GLFW_KEY_F5))
+    {
+        gDemo.pointPath = (PointDrawPath)((gDemo.pointPath + 1) % PointDrawPathCount);
+        std::cout << "points: " << PointDrawPathName(gDemo.pointPath) << std::endl;
     }
 
-    gl_Position = vec4(pos, 0.0, 1.0);
-    vColor = aColor;
+    float r = 239.0f / 255.0f;
+    float g = 136.0f / 255.0f;
+    float b = 190.0f / 255.0f;
+    float a = 1.0f;
+
+    RenderTarget* target = gDemo.offscreen ? AcquireRenderTarget(gDemo.width, gDemo.height, gDemo.msaa) : nullptr;
+    if (target)
+        glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+
+    GfxClear(r, g, b, a);
+
+    float t = (float)now;
+    UpdateCamera(now);
+    WorldUpdate(gDemo.camera, gDemo.program.viewScale, now);
+    InstancesUpdate();
+    AppendPlotSamples(now);
+    DrawTilemap(gDemo.tilemap, gDemo.camera, gDemo.program.viewScale, t);
+    DrawScene(gDemo.scene, gDemo.program, t, gDemo.camera);
+    WorldDraw(gDemo.program, t, gDemo.camera);
+    DrawInstances(gDemo.program.viewScale, t);
+    DrawPointCloud(gDemo.points, gDemo.camera, gDemo.program.viewScale, gDemo.width, gDemo.height, gDemo.pointMode,
+        gDemo.pointPath);
+    DrawTimeSeries(gDemo.plot, gDemo.camera, gDemo.program.viewScale, gDemo.width, 0.1f, 0.1f, 0.3f);
+
+    if (target)
+    {
+        BlitToBackbuffer(*target, gDemo.width, gDemo.height);
+        ReleaseRenderTarget(target);
+    }
+
+    // visualize the animated transforms: translation offset and rotation pivot
+    for (const SceneObject& o : gDemo.scene.objects)
+    {
+        float offsetX = 0.0f, angle = 0.0f;
+        EvaluateObject(o, t, offsetX, angle);
+        // debug draw takes float world coordinates
+        float x = (float)(o.origin[0] + o.center[0]);
+        float y = (float)(o.origin[1] + o.center[1]);
+        if (o.mode == ModeTranslate)
+            DebugArrow(x, y, x + offsetX, y, DebugColor(0.1f, 0.4f, 0.1f));
+        else if (o.mode == ModeRotate)
+        {
+            DebugMarker(x, y, 0.02f, DebugColor(0.2f, 0.2f, 0.2f));
+            DebugCircle(x, y, 0.27f, DebugColor(0.5f, 0.3f, 0.1f, 0.6f), 48);
+        }
+    }
+    DebugDrawFlush();
+
+    HudDraw(gDemo.width, gDemo.height);
+    ProfilerEndFrame();
+    RenderTargetPoolEndFrame();
+    DeferredDeleteEndFrame();
+    if (gCaptureActive)
+        CaptureFrame(t);
+    gDemo.primaryDrawEnd = std::chrono::steady_clock::now();
 }
-)";
 
-// Fragment shader - supports pulsing color when mode==2
-static const char* fragmentSrc = R"(
-#version 430 core
-in vec3 vColor;
-uniform int mode;
-uniform float time;
+// keeps drawing while the OS holds the main loop in a modal resize/move loop
+static void RefreshWhileBlocked()
+{
+    DrawFrame(PacerNow());
+    SwapWindowBuffers();
+}
 
-out vec4 FragColor;
+static void AddOutputTime(int index, double ms)
+{
+    if ((int)gDemo.outputs.size() <= index)
+        gDemo.outputs.resize(index + 1);
+    Demo::OutputTiming& o = gDemo.outputs[index];
+    o.frames++;
+    o.sumMs += ms;
+    if (ms > o.maxMs) o.maxMs = ms;
+}
 
-void main()
+static void PrintOutputStats()
 {
-    vec3 color = vColor;
-    if (mode == 2) {
-        // color changes over time (pulse)
-        float t = 0.5 + 0.5 * sin(time * 2.0); // ranges [0,1]
-        color = color * (0.25 + 0.75 * t);
+    int open = 0;
+    for (int i = 0; i < WindowSlotCount(); ++i)
+        open += IsWindowOpen(i) ? 1 : 0;
+    std::cout << "outputs: " << open << " open" << std::endl;
+    for (size_t i = 0; i < gDemo.outputs.size(); ++i)
+    {
+        const Demo::OutputTiming& o = gDemo.outputs[i];
+        if (!o.frames) continue;
+        std::cout << "  window " << i << (i == 0 ? " (primary, incl. overlays)" : "") << ": avg "
+                  << o.sumMs / o.frames << " ms, max " << o.maxMs << " ms over " << o.frames << " frames" << std::endl;
     }
-    FragColor = vec4(color, 1.0);
+    gDemo.outputs.assign(gDemo.outputs.size(), Demo::OutputTiming());
 }
-)";
 
-// helper to create VAO/VBO from position vec2 and color vec3 per-vertex
-struct VAOHandle {
-    GLuint vao = 0;
-    GLuint vbo = 0;
-};
-
-VAOHandle CreateTriangle(const std::vector<float>& interleavedData)
+static void PrintEarlyFrames()
 {
-    VAOHandle h;
-    glGenVertexArrays(1, &h.vao);
-    glGenBuffers(1, &h.vbo);
-
-    glBindVertexArray(h.vao);
-    glBindBuffer(GL_ARRAY_BUFFER, h.vbo);
-    glBufferData(GL_ARRAY_BUFFER, interleavedData.size() * sizeof(float), interleavedData.data(), GL_STATIC_DRAW);
-
-    // layout(location=0) vec2 position
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (void*)0);
+    std::vector<double> sorted = gDemo.earlyFrameMs;
+    if (sorted.empty()) return;
+    std::sort(sorted.begin(), sorted.end());
+    std::cout << "first frames (warm-up " << (gDemo.warmup ? "on" : "off") << "): first "
+              << gDemo.earlyFrameMs[0] << " ms, worst of " << sorted.size() << " " << sorted.back()
+              << " ms, median " << sorted[sorted.size() / 2] << " ms" << std::endl;
+    if (gDemo.warmup)
+        std::cout << "  warm-up: " << gDemo.warmupStats.draws << " draws over " << gDemo.warmupStats.combinations
+                  << " combinations, submit " << gDemo.warmupStats.submitMs << " ms, fence wait "
+                  << gDemo.warmupStats.waitMs << " ms" << std::endl;
+}
 
-    // layout(location=1) vec3 color
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(float) * 5, (void*)(sizeof(float) * 2));
+// draws the scene into every secondary window; the primary is swapped last by Loop()
+// so only it can block on vsync
+static void DrawSecondaryWindows(double now)
+{
+    using namespace std::chrono;
+    float primaryScale[2] = { gDemo.program.viewScale[0], gDemo.program.viewScale[1] };
+    for (int i = 1; i < WindowSlotCount(); ++i)
+    {
+        if (!IsWindowOpen(i))
+        {
+            DestroySecondaryWindow(i);
+            ForgetContextVertexArrays(i);
+            ForgetContextPipelineState(i);
+            continue;
+        }
+        steady_clock::time_point start = steady_clock::now();
+        MakeWindowCurrent(i);
+        CollectContextVertexArrays();
+        CameraBind();
+
+        int w = 0, h = 0;
+        GetWindowFramebufferSize(i, w, h);
+        glViewport(0, 0, w, h);
+        SetSceneViewport(gDemo.program, w, h);
+        GfxClear(239.0f / 255.0f, 136.0f / 255.0f, 190.0f / 255.0f, 1.0f);
+        DrawTilemap(gDemo.tilemap, gDemo.camera, gDemo.program.viewScale, (float)now);
+        DrawScene(gDemo.scene, gDemo.program, (float)now, gDemo.camera);
+        WorldDraw(gDemo.program, (float)now, gDemo.camera);
+        DrawInstances(gDemo.program.viewScale, (float)now);
+        DrawPointCloud(gDemo.points, gDemo.camera, gDemo.program.viewScale, w, h, gDemo.pointMode, gDemo.pointPath);
+        DrawTimeSeries(gDemo.plot, gDemo.camera, gDemo.program.viewScale, w, 0.1f, 0.1f, 0.3f);
+        SwapWindow(i);
+        AddOutputTime(i, duration<double, std::milli>(steady_clock::now() - start).count());
+    }
+    MakeWindowCurrent(0);
+    gDemo.program.viewScale[0] = primaryScale[0];
+    gDemo.program.viewScale[1] = primaryScale[1];
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+static void PrintResizeStats()
+{
+    const RenderTargetStats& rt = RenderTargetPoolStats();
+    std::cout << "resize: " << FramebufferResizeEvents() << " events coalesced into " << gDemo.resizesApplied
+              << " applies; render targets " << rt.allocations << " allocated, " << rt.reuses << " reused, "
+              << rt.frees << " freed";
+    if (gDemo.dragFrames)
+        std::cout << "; during resize avg " << gDemo.dragFrameMsSum / gDemo.dragFrames << " ms, max "
+                  << gDemo.dragFrameMsMax << " ms over " << gDemo.dragFrames << " frames";
+    std::cout << std::endl;
+}
 
-    return h;
+static void PrintPacing()
+{
+    const PacingStats& s = PacerStats();
+    std::cout << "pacing " << PacingModeName(PacerMode()) << " @" << PacerTargetHz() << "Hz: frame "
+              << s.avgFrameMs << " ms (max " << s.maxFrameMs << "), jitter " << s.jitterMs
+              << " ms, est. input-to-present " << s.latencyMs << " ms" << std::endl;
 }
 
-void DestroyTriangle(VAOHandle& h)
+static void PrintUsage()
 {
-    if (h.vbo) { glDeleteBuffers(1, &h.vbo); h.vbo = 0; }
-    if (h.vao) { glDeleteVertexArrays(1, &h.vao); h.vao = 0; }
+    std::cout << "usage: graphics-1-f2025 [--capture <file>] [--scene <file> | [--generate] <generator options>]\n"
+                 "                       [--pacing vsync|uncapped|cap|latelatch] [--fps <hz>] [--offscreen]\n"
+                 "                       [--msaa <samples>] [--gles]\n"
+                 "                       [--windows <n>] [--stream tcp:<host>:<port>] [--headless]\n"
+                 "                       [--export <address>] [--resolution <max w>x<max h>]\n"
+                 "                       [--control <address>] [--no-cache] [--startup-report]\n"
+                 "                       [--no-warmup] [--vertex-pulling] [--world-origin <x>,<y>]\n"
+                 "                       [--world <file>] [--world-cap <MB>] [--world-upload <KB/frame>]\n"
+                 "                       [--tilemap <w>x<h>] [--plot <samples>] [--plot-rate <samples/s>]\n"
+                 "                       [--points <n>] [--points-mode density|nearest]\n"
+                 "                       [--points-path compute|points|quads]\n"
+                 "       graphics-1-f2025 --stream-view tcp:<host>:<port>\n"
+                 "       graphics-1-f2025 --controller <address> [--objects <n>] [--rate <cmds/s>] [--seconds <s>]\n"
+                 "       graphics-1-f2025 --export-consume <address> [shm|pipe]\n"
+                 "       graphics-1-f2025 --export-bench [--resolution <w>x<h>] [--frames <n>]\n"
+                 "       graphics-1-f2025 --replay <file> [--paced] [--loops <n>]\n"
+                 "       graphics-1-f2025 --bench [--runs <n>] [--frames <n>] [--filter <name>]\n"
+                 "                        [--baseline <json>] [--out <json>] [--update-baseline] [--large]\n"
+                 "       graphics-1-f2025 --compare <baseline.json> <results.json>\n"
+                 "       graphics-1-f2025 --microbench [--filter <name>] [--out <json>]\n"
+                 "       graphics-1-f2025 --gen-scene <file> <generator options>\n"
+                 "       graphics-1-f2025 --gen-world <file> [--chunks <n>|<x>x<y>] [--chunk-size <s>] <generator options>\n"
+                 "       graphics-1-f2025 --cluster <workers> | --cluster-bench <max workers> [--scene <file>]\n"
+                 "                        [--resolution <w>x<h>] [--frames <n>] [--transport unix|tcp]\n"
+                 "                        [--dump <ppm>] [--out <json>] <generator options>\n"
+              << SceneGenUsage();
 }
 
-int main()
+int main(int argc, char** argv)
 {
-    CreateWindow(800, 800, "Graphics 1");
+    StartupBegin();
+    const char* capturePath = nullptr;
+    ReplayOptions replay;
+    BenchOptions bench;
+    bool runBench = false;
+    bool runMicro = false;
+    bool outputSet = false;
+    const char* compare[2] = { nullptr, nullptr };
+    SceneGenParams gen;
+    const char* genScenePath = nullptr;
+    const char* scenePath = nullptr;
+    bool generate = false;
+    bool genOptionsSet = false;
+    bool offscreen = false;
+    int windowCount = 1;
+    PacingMode pacing = PacingVsync;
+    double pacingHz = 0.0;
+    ClusterOptions cluster;
+    int clusterBench = 0;
+    bool framesSet = false;
+    const char* streamAddress = nullptr;
+    bool headless = false;
+    const char* exportAddress = nullptr;
+    bool exportBench = false;
+    int exportWidth = 1920;
+    int exportHeight = 1080;
+    const char* controlAddress = nullptr;
+    const char* controllerAddress = nullptr;
+    ControllerOptions controller;
+    bool useCache = true;
+    bool startupReport = false;
+    bool warmup = true;
+    bool vertexPulling = false;
+    double worldOrigin[2] = { 0.0, 0.0 };
+    const char* worldPath = nullptr;
+    const char* genWorldPath = nullptr;
+    WorldGenParams worldGen;
+    WorldStreamOptions worldStream;
+    int tilemapSize[2] = { 0, 0 };
+    uint64_t plotSamples = 0;
+    uint64_t pointCount = 0;
+    SetExecutablePath(argv[0]);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--capture") && i + 1 < argc) capturePath = argv[++i];
+        else if (!strcmp(argv[i], "--replay") && i + 1 < argc) replay.path = argv[++i];
+        else if (!strcmp(argv[i], "--paced")) replay.paced = true;
+        else if (!strcmp(argv[i], "--loops") && i + 1 < argc) replay.loops = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--bench")) runBench = true;
+        else if (!strcmp(argv[i], "--microbench")) runMicro = true;
+        else if (!strcmp(argv[i], "--runs") && i + 1 < argc) bench.runs = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc) { bench.frames = atoi(argv[++i]); framesSet = true; }
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc) bench.filter = argv[++i];
+        else if (!strcmp(argv[i], "--baseline") && i + 1 < argc) bench.baselinePath = argv[++i];
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) { bench.outputPath = argv[++i]; outputSet = true; }
+        else if (!strcmp(argv[i], "--update-baseline")) bench.updateBaseline = true;
+        else if (!strcmp(argv[i], "--large")) bench.large = true;
+        else if (!strcmp(argv[i], "--compare") && i + 2 < argc) { compare[0] = argv[++i]; compare[1] = argv[++i]; }
+        else if (!strcmp(argv[i], "--gen-scene") && i + 1 < argc) genScenePath = argv[++i];
+        else if (!strcmp(argv[i], "--scene") && i + 1 < argc) scenePath = argv[++i];
+        else if (!strcmp(argv[i], "--generate")) generate = true;
+        else if (!strcmp(argv[i], "--offscreen")) offscreen = true;
+        else if (!strcmp(argv[i], "--msaa") && i + 1 < argc) { gDemo.msaa = atoi(argv[++i]); offscreen = true; }
+        else if (!strcmp(argv[i], "--gles")) SetWindowContextGles(true);
+        else if (!strcmp(argv[i], "--windows") && i + 1 < argc) windowCount = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--pacing") && i + 1 < argc && ParsePacingMode(argv[i + 1], pacing)) ++i;
+        else if (!strcmp(argv[i], "--fps") && i + 1 < argc) pacingHz = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--cluster") && i + 1 < argc) { cluster.workers = atoi(argv[++i]); cluster.display = true; }
+        else if (!strcmp(argv[i], "--cluster-bench") && i + 1 < argc) clusterBench = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--cluster-worker") && i + 2 < argc) return RunClusterWorker(argv[i + 1], atoi(argv[i + 2]));
+        else if (!strcmp(argv[i], "--transport") && i + 1 < argc) cluster.transport = argv[++i];
+        else if (!strcmp(argv[i], "--dump") && i + 1 < argc) cluster.dumpPath = argv[++i];
+        else if (!strcmp(argv[i], "--resolution") && i + 1 < argc &&
+            sscanf(argv[i + 1], "%dx%d", &cluster.width, &cluster.height) == 2)
+        {
+            exportWidth = cluster.width;
+            exportHeight = cluster.height;
+            ++i;
+        }
+        else if (!strcmp(argv[i], "--export") && i + 1 < argc) exportAddress = argv[++i];
+        else if (!strcmp(argv[i], "--export-bench")) exportBench = true;
+        else if (!strcmp(argv[i], "--export-consume") && i + 1 < argc)
+            return RunExportConsumer(argv[i + 1], i + 2 < argc ? argv[i + 2] : "shm");
+        else if (!strcmp(argv[i], "--stream") && i + 1 < argc) streamAddress = argv[++i];
+        else if (!strcmp(argv[i], "--stream-view") && i + 1 < argc) return RunStreamViewer(argv[i + 1]);
+        else if (!strcmp(argv[i], "--headless")) headless = true;
+        else if (!strcmp(argv[i], "--control") && i + 1 < argc) controlAddress = argv[++i];
+        else if (!strcmp(argv[i], "--controller") && i + 1 < argc) controllerAddress = argv[++i];
+        else if (!strcmp(argv[i], "--rate") && i + 1 < argc) controller.rate = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) controller.seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--no-cache")) useCache = false;
+        else if (!strcmp(argv[i], "--startup-report")) startupReport = true;
+        else if (!strcmp(argv[i], "--no-warmup")) warmup = false;
+        else if (!strcmp(argv[i], "--vertex-pulling")) vertexPulling = true;
+        else if (!strcmp(argv[i], "--world-origin") && i + 1 < argc &&
+            sscanf(argv[i + 1], "%lf,%lf", &worldOrigin[0], &worldOrigin[1]) == 2) ++i;
+        else if (!strcmp(argv[i], "--world") && i + 1 < argc) worldPath = argv[++i];
+        else if (!strcmp(argv[i], "--world-cap") && i + 1 < argc) worldStream.memoryCap = (size_t)(atof(argv[++i]) * (1 << 20));
+        else if (!strcmp(argv[i], "--world-upload") && i + 1 < argc) worldStream.uploadBudget = (size_t)(atof(argv[++i]) * 1024);
+        else if (!strcmp(argv[i], "--gen-world") && i + 1 < argc) genWorldPath = argv[++i];
+        else if (!strcmp(argv[i], "--tilemap") && i + 1 < argc &&
+            sscanf(argv[i + 1], "%dx%d", &tilemapSize[0], &tilemapSize[1]) == 2) ++i;
+        else if (!strcmp(argv[i], "--plot") && i + 1 < argc) plotSamples = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--plot-rate") && i + 1 < argc) gDemo.plotRate = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--points") && i + 1 < argc) pointCount = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--points-mode") && i + 1 < argc)
+            gDemo.pointMode = !strcmp(argv[++i], "nearest") ? SplatNearest : SplatDensity;
+        else if (!strcmp(argv[i], "--points-path") && i + 1 < argc)
+        {
+            ++i;
+            gDemo.pointPath = !strcmp(argv[i], "points") ? PointPathPoints :
+                (!strcmp(argv[i], "quads") ? PointPathQuads : PointPathCompute);
+        }
+        else if (ParseWorldGenArg(i, argc, argv, worldGen)) {}
+        else if (ParseSceneGenArg(i, argc, argv, gen)) genOptionsSet = true;
+        else { PrintUsage(); return -1; }
+    }
+    // generator options describe a scene, so on their own they ask for it to be generated
+    if (genOptionsSet && scenePath)
+    {
+        std::cerr << "Generator options cannot be combined with --scene" << std::endl;
+        PrintUsage();
+        return -1;
+    }
+    if (genOptionsSet)
+        generate = true;
+    if (replay.path)
+        return RunReplay(replay);
+    if (runBench)
+        return RunBenchmarkSuite(bench);
+    if (runMicro)
+    {
+        MicroBenchOptions micro;
+        micro.filter = bench.filter;
+        micro.outputPath = outputSet ? bench.outputPath : nullptr;
+        return RunMicroBenchmarks(micro);
+    }
+    if (genScenePath)
+    {
+        GeneratedScene generated;
+        GenerateScene(gen, generated);
+        if (!WriteSceneFile(genScenePath, generated)) {
+            std::cerr << "Cannot write scene file " << genScenePath << std::endl;
+            return -1;
+        }
+        std::cout << "wrote " << generated.objects.size() << " objects to " << genScenePath << std::endl;
+        return 0;
+    }
+    if (genWorldPath)
+    {
+        std::string err;
+        worldGen.scene = gen;
+        if (!WriteWorldFile(genWorldPath, worldGen, err)) {
+            std::cerr << "Cannot write world file: " << err << std::endl;
+            return -1;
+        }
+        std::cout << "wrote " << worldGen.chunksX << "x" << worldGen.chunksY << " chunks of " << gen.objectCount
+                  << " objects to " << genWorldPath << std::endl;
+        return 0;
+    }
+    if (controllerAddress)
+    {
+        controller.objects = gen.objectCount;
+        controller.seed = gen.seed;
+        return RunSceneController(controllerAddress, controller);
+    }
+    if (exportBench)
+        return RunExportBenchmark(exportWidth, exportHeight, framesSet ? bench.frames : 600);
+    if (cluster.display || clusterBench > 0)
+    {
+        GeneratedScene generated;
+        if (scenePath && !ReadSceneFile(scenePath, generated)) {
+            std::cerr << "Cannot read scene file " << scenePath << std::endl;
+            return -1;
+        }
+        if (!scenePath)
+            GenerateScene(gen, generated);
+        if (framesSet)
+            cluster.frames = bench.frames;
+        if (clusterBench > 0)
+            return RunClusterBenchmark(cluster, generated, clusterBench, outputSet ? bench.outputPath : nullptr);
+        return RunClusterCoordinator(cluster, generated);
+    }
+    if (compare[0])
+    {
+        std::vector<BenchCase> baseline, current;
+        if (!ReadBenchJson(compare[0], baseline) || !ReadBenchJson(compare[1], current)) {
+            std::cerr << "Cannot read benchmark files" << std::endl;
+            return -1;
+        }
+        return CompareBenchResults(baseline, current, bench.threshold, bench.alpha) ? 1 : 0;
+    }
+
+    // CPU-only work (cache files, scene loading) overlaps window and context creation,
+    // which has to stay on the main thread
+    GpuCaps cachedCaps;
+    bool haveCachedCaps = false;
+    GeneratedScene generated;
+    bool sceneLoaded = true;
+    std::thread prepare([&] {
+        if (useCache)
+        {
+            StartupPhase phase("cache read");
+            useCache = EnsureDirectory("cache") && EnsureDirectory("cache/shaders");
+            haveCachedCaps = useCache && LoadCapsCache("cache/caps.txt", cachedCaps);
+        }
+        if (scenePath || generate)
+        {
+            StartupPhase phase("scene load");
+            if (scenePath)
+                sceneLoaded = ReadSceneFile(scenePath, generated);
+            else
+                GenerateScene(gen, generated);
+        }
+    });
+
+    bool windowCreated = false;
+    {
+        StartupPhase phase("window + context");
+        windowCreated = CreateWindow(800, 800, "Graphics 1", !headless);
+    }
+    prepare.join();
+    if (!windowCreated)
+        return -1;
+
+    {
+        StartupPhase phase("capabilities");
+        GpuCaps caps;
+        ProbeCaps(haveCachedCaps ? &cachedCaps : nullptr, caps);
+        if (useCache && !caps.fromCache && !SaveCapsCache("cache/caps.txt", caps))
+            std::cerr << "Cannot write cache/caps.txt" << std::endl;
+        if (useCache && caps.programBinaryFormats > 0)
+            Shader::SetBinaryCache("cache/shaders", caps.DriverKey());
+    }
+
+    // start before any resources exist so the capture is self-contained
+    if (capturePath && !CaptureBegin(capturePath, 800, 800))
+        std::cerr << "Cannot open capture file " << capturePath << std::endl;
 
     // create shader
-    Shader shader;
+    SceneProgram& program = gDemo.program;
     std::string err;
-    if (!shader.CreateFromSource(vertexSrc, fragmentSrc, err)) {
+    double shadersStart = StartupElapsedMs();
+    if (vertexPulling && capturePath)
+    {
+        std::cerr << "Captures do not record storage buffer binds, using vertex attributes" << std::endl;
+        vertexPulling = false;
+    }
+    if (vertexPulling && GetGpuCaps().maxVertexStorageBlocks < 1)
+    {
+        std::cerr << "No storage buffers in the vertex stage, using vertex attributes" << std::endl;
+        vertexPulling = false;
+    }
+    if (!CreateSceneProgram(program, err, vertexPulling ? FetchPulled : FetchAttributes)) {
         std::cerr << "Shader compile/link error:\n" << err << std::endl;
         DestroyWindow();
         return -1;
     }
 
-    // Triangles will be positioned vertically down the screen so you can see them all:
-    // Top y = 0.75, next 0.35, -0.05, -0.45, -0.85
-    // We'll use small triangles (height ~0.25) so they don't overlap.
-
-    // 1) White triangle (mode 0)
-    std::vector<float> white = {
-        // pos.x, pos.y,  r, g, b
-         -0.2f,  0.85f,  1.0f, 1.0f, 1.0f,
-          0.2f,  0.85f,  1.0f, 1.0f, 1.0f,
-          0.0f,  0.60f,  1.0f, 1.0f, 1.0f
-    };
-
-    // 2) Rainbow triangle (mode 1) - per-vertex color
-    std::vector<float> rainbow = {
-        -0.2f,  0.45f,   1.0f, 0.0f, 0.0f, // red
-         0.2f,  0.45f,   0.0f, 1.0f, 0.0f, // green
-         0.0f,  0.20f,   0.0f, 0.0f, 1.0f  // blue
-    };
+    CameraInit();
+    if (!DebugDrawInit(err)) {
+        std::cerr << "Debug draw shader error:\n" << err << std::endl;
+        CameraShutdown();
+        DestroySceneProgram(program);
+        DestroyWindow();
+        return -1;
+    }
 
-    // 3) Pulsing color (mode 2) - base color is magenta
-    std::vector<float> pulsing = {
-        -0.2f, -0.05f,   0.94f, 0.53f, 0.75f, // pastel magenta-ish
-         0.2f, -0.05f,   0.94f, 0.53f, 0.75f,
-         0.0f, -0.30f,   0.94f, 0.53f, 0.75f
-    };
+    if (!HudInit(err)) {
+        std::cerr << "HUD shader error:\n" << err << std::endl;
+        DebugDrawShutdown();
+        CameraShutdown();
+        DestroySceneProgram(program);
+        DestroyWindow();
+        return -1;
+    }
+    if (tilemapSize[0] > 0 && !TilemapInit(err)) {
+        std::cerr << "Tilemap shader error:\n" << err << std::endl;
+        tilemapSize[0] = 0;
+    }
+    if (plotSamples > 0 && !TimeSeriesInit(err)) {
+        std::cerr << "Time series shader error:\n" << err << std::endl;
+        plotSamples = 0;
+    }
+    if (pointCount > 0 && !PointCloudInit(err)) {
+        std::cerr << "Point cloud shader error:\n" << err << std::endl;
+        pointCount = 0;
+    }
+    StartupRecord("shaders", shadersStart, StartupElapsedMs());
+    ProfilerInit();
 
-    // 4) Translating triangle (mode 3) - place around y = -0.55
-    // Positions are centered so when offset is applied it moves left-right
-    std::vector<float> translating = {
-        -0.15f, -0.35f,  0.2f, 0.8f, 0.2f, // light green
-         0.15f, -0.35f,  0.2f, 0.8f, 0.2f,
-         0.0f, -0.60f,   0.2f, 0.8f, 0.2f
-    };
+    Scene& scene = gDemo.scene;
+    gDemo.offscreen = offscreen;
+    if (worldPath)
+    {
+        StartupPhase phase("world open");
+        worldStream.offset[0] = worldOrigin[0];
+        worldStream.offset[1] = worldOrigin[1];
+        if (!WorldOpen(worldPath, worldStream, err))
+            std::cerr << "Cannot open world: " << err << std::endl;
+    }
+    if (tilemapSize[0] > 0)
+    {
+        StartupPhase phase("tilemap");
+        Tilemap& map = gDemo.tilemap;
+        bool built = CreateTilemap(map, tilemapSize[0], tilemapSize[1], 2, err);
+        if (built)
+        {
+            // centered on the world origin
+            map.origin[0] = worldOrigin[0] - 0.5 * map.width * map.tileSize;
+            map.origin[1] = worldOrigin[1] - 0.5 * map.height * map.tileSize;
+            built = BuildDemoTilemap(map, 1234u, err);
+        }
+        if (!built)
+        {
+            std::cerr << "Cannot create tilemap: " << err << std::endl;
+            DestroyTilemap(map);
+        }
+    }
+    if (plotSamples > 0)
+    {
+        StartupPhase phase("time series");
+        TimeSeries& plot = gDemo.plot;
+        // the preloaded samples span [-1, 1] around the world origin, new ones extend it to the right
+        plot.origin[0] = worldOrigin[0] - 1.0;
+        plot.origin[1] = worldOrigin[1];
+        plot.sampleWidth = 2.0 / (double)plotSamples;
+        plot.valueScale = 0.4;
+        if (CreateTimeSeries(plot, plotSamples, err))
+        {
+            // in chunks, the pyramid is built as it goes like for any other append
+            const size_t chunk = (size_t)1 << 20;
+            gDemo.plotScratch.resize(chunk);
+            for (uint64_t first = 0; first < plotSamples; first += chunk)
+            {
+                size_t n = (size_t)std::min<uint64_t>(chunk, plotSamples - first);
+                GenerateSensorSamples(first, n, 1234u, gDemo.plotScratch.data());
+                TimeSeriesAppend(plot, gDemo.plotScratch.data(), n);
+            }
+        }
+        else std::cerr << "Cannot create time series: " << err << std::endl;
+    }
+    if (pointCount > 0)
+    {
+        StartupPhase phase("point cloud");
+        PointCloud& cloud = gDemo.points;
+        cloud.origin[0] = worldOrigin[0];
+        cloud.origin[1] = worldOrigin[1];
+        if (CreatePointCloud(cloud, pointCount, err))
+        {
+            const size_t chunk = (size_t)1 << 20;
+            std::vector<float> positions(2 * chunk), values(chunk);
+            for (uint64_t first = 0; first < pointCount; first += chunk)
+            {
+                size_t n = (size_t)std::min<uint64_t>(chunk, pointCount - first);
+                GenerateScatterPoints(first, n, 1234u, positions.data(), values.data());
+                PointCloudAppend(cloud, positions.data(), values.data(), n);
+            }
+        }
+        else std::cerr << "Cannot create point cloud: " << err << std::endl;
+    }
+    {
+        StartupPhase phase("scene upload");
+        if (!sceneLoaded)
+            std::cerr << "Cannot read scene file " << scenePath << ", using the default scene" << std::endl;
+        InstantiateScene(generated, scene);
+        generated.objects.clear();
+        if (scene.objects.empty() && !WorldIsOpen())
+            BuildFiveModeScene(scene);
+        // place the whole scene far from the origin; only the camera-relative offset
+        // reaches the GPU, so it should look the same as at (0, 0)
+        for (SceneObject& o : scene.objects)
+        {
+            o.origin[0] = worldOrigin[0];
+            o.origin[1] = worldOrigin[1];
+        }
+    }
+    gDemo.homeCamera.center[0] = worldOrigin[0];
+    gDemo.homeCamera.center[1] = worldOrigin[1];
+    if (WorldIsOpen())
+        WorldCenter(gDemo.homeCamera.center);
+    gDemo.camera = gDemo.homeCamera;
+    gDemo.cameraLocked = capturePath != nullptr;
+    gDemo.warmup = warmup;
+    if (warmup)
+    {
+        StartupPhase phase("pipeline warm-up");
+        gDemo.warmupStats = RunPipelineWarmup();
+    }
 
-    // 5) Rotating triangle (mode 4) - center about its own center near bottom
-    // We'll provide a center uniform so rotation is around the triangle's center
-    std::vector<float> rotating = {
-        -0.25f, -0.75f,  1.0f, 0.6f, 0.2f, // orange
-         0.25f, -0.75f,  1.0f, 0.6f, 0.2f,
-         0.0f,  -0.55f,  1.0f, 0.6f, 0.2f
-    };
+    if (streamAddress && !StreamServerStart(streamAddress, err))
+        std::cerr << "Cannot start streaming: " << err << std::endl;
+    if (controlAddress && (!InstancesInit(err) || !SceneControlStart(controlAddress, err)))
+        std::cerr << "Cannot start scene control: " << err << std::endl;
+    if (exportAddress && !FrameExportStart(exportAddress, exportWidth, exportHeight, err))
+        std::cerr << "Cannot start frame export: " << err << std::endl;
 
-    // Create VAOs
-    VAOHandle vaoWhite = CreateTriangle(white);
-    VAOHandle vaoRainbow = CreateTriangle(rainbow);
-    VAOHandle vaoPulsing = CreateTriangle(pulsing);
-    VAOHandle vaoTrans = CreateTriangle(translating);
-    VAOHandle vaoRot = CreateTriangle(rotating);
-
-    // Get uniform locations
-    shader.Use();
-    GLint locMode = glGetUniformLocation(shader.GetID(), "mode");
-    GLint locTime = glGetUniformLocation(shader.GetID(), "time");
-    GLint locOffset = glGetUniformLocation(shader.GetID(), "offset");
-    GLint locAngle = glGetUniformLocation(shader.GetID(), "angle");
-    GLint locCenter = glGetUniformLocation(shader.GetID(), "center");
+    PacerSetMode(pacing, pacingHz > 0.0 ? pacingHz : (double)GetRefreshRate());
+    SetWindowRefreshCallback(RefreshWhileBlocked);
+    for (int i = 1; i < windowCount; ++i)
+        CreateSecondaryWindow(640, 360, "Graphics 1 - output");
 
     // render loop
     while (!WindowShouldClose())
     {
-        float r = 239.0f / 255.0f;
-        float g = 136.0f / 255.0f;
-        float b = 190.0f / 255.0f;
-        float a = 1.0f;
-
-        glClearColor(r, g, b, a);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        shader.Use();
-        float t = (float)glfwGetTime();
-        glUniform1f(locTime, t);
-
-        // 1) white
-        glUniform1i(locMode, 0);
-        glBindVertexArray(vaoWhite.vao);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
-
-        // 2) rainbow (uses per-vertex color)
-        glUniform1i(locMode, 1);
-        glBindVertexArray(vaoRainbow.vao);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
-
-        // 3) pulsing color (shader multiplies by time)
-        glUniform1i(locMode, 2);
-        glBindVertexArray(vaoPulsing.vao);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
-
-        // 4) translating left-right between x = -1 and x = 1
-        // we'll compute offset.x = sin(t) * 0.75 to keep it within bounds
-        glUniform1i(locMode, 3);
-        float translateAmount = sinf(t * 1.2f) * 0.75f; // speed multiplier 1.2
-        // only x translation needed
-        glUniform2f(locOffset, translateAmount, 0.0f);
-        glBindVertexArray(vaoTrans.vao);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
-
-        // 5) rotating CCW about z-axis
-        glUniform1i(locMode, 4);
-        // compute rotation angle - rotate counter-clockwise: angle increases with time
-        float ang = t * 1.0f; // 1 radian per second
-        glUniform1f(locAngle, ang);
-        // center of rotation = approximate center of the triangle vertices used above
-        // we calculated the triangle roughly centered at x=0, y=-0.68 (est)
-        // to be precise, calculate average of its positions:
-        // here we pass a center that matches the geometry chosen above:
-        glUniform2f(locCenter, 0.0f, -0.68f);
-        glBindVertexArray(vaoRot.vao);
-        glDrawArrays(GL_TRIANGLES, 0, 3);
-
-        // unbind VAO
-        glBindVertexArray(0);
-
+        double now = PacerBeginFrame();
+        SceneControlApply();
+        if (WasKeyPressed(GLFW_KEY_F2))
+        {
+            PrintPacing();
+            PacerSetMode((PacingMode)((PacerMode() + 1) % PacingModeCount), PacerTargetHz());
+        }
+        if (WasKeyPressed(GLFW_KEY_F3))
+        {
+            PrintOutputStats();
+            if (CreateSecondaryWindow(640, 360, "Graphics 1 - output") < 0)
+                std::cerr << "Cannot create another window" << std::endl;
+        }
+
+        std::chrono::steady_clock::time_point primaryStart = std::chrono::steady_clock::now();
+        DrawFrame(now);
+        DrawSecondaryWindows(now);
+        StreamCaptureFrame(gDemo.width, gDemo.height);
+        FrameExportCaptureFrame(gDemo.width, gDemo.height);
+
+        std::chrono::steady_clock::time_point swapStart = std::chrono::steady_clock::now();
         Loop();
+        if (StartupTimeToFirstFrameMs() == 0.0)
+        {
+            StartupFirstFrame();
+            StartupReport(startupReport);
+        }
+        PacerEndFrame();
+        // primary time excludes the secondaries drawn in between
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        double primaryMs = std::chrono::duration<double, std::milli>(end - swapStart).count() +
+            std::chrono::duration<double, std::milli>(gDemo.primaryDrawEnd - primaryStart).count();
+        AddOutputTime(0, primaryMs);
+        if ((int)gDemo.earlyFrameMs.size() < Demo::kEarlyFrames)
+        {
+            gDemo.earlyFrameMs.push_back(primaryMs);
+            if ((int)gDemo.earlyFrameMs.size() == Demo::kEarlyFrames)
+                PrintEarlyFrames();
+        }
+    }
+    SetWindowRefreshCallback(nullptr);
+    if ((int)gDemo.earlyFrameMs.size() < Demo::kEarlyFrames)
+        PrintEarlyFrames();
+    PrintPacing();
+    PrintResizeStats();
+    PrintOutputStats();
+    if (StreamServerRunning())
+        PrintStreamStats(StreamServerStats());
+    if (SceneControlRunning())
+    {
+        SceneControlStats control = SceneControlGetStats();
+        std::cout << "control: " << control.commandsApplied << " commands ("
+                  << control.commandsApplied / std::max(1e-9, control.seconds) << "/s), apply "
+                  << control.applyMs << " ms/frame (max " << control.maxApplyMs << "), latency p50 "
+                  << control.latencyP50Ms << " ms p95 " << control.latencyP95Ms << " ms" << std::endl;
+        InstanceStats instances = GetInstanceStats();
+        std::cout << "instances: " << instances.live << " live, " << instances.drawn << " drawn of "
+                  << instances.capacity << " slots, fragmentation " << instances.fragmentation * 100.0f
+                  << "%, " << instances.compactions << " compactions moved " << instances.moved
+                  << " (cpu " << instances.compactCpuMs << " ms, gpu " << instances.compactGpuMs
+                  << " ms each)" << std::endl;
+    }
+    if (FrameExportRunning())
+    {
+        FrameExportStats exported = FrameExportGetStats();
+        std::cout << "export: " << exported.framesExported << " frames, " << exported.framesDropped
+                  << " dropped, copy " << exported.copyMs << " ms/frame" << std::endl;
     }
 
-    // cleanup
-    DestroyTriangle(vaoWhite);
-    DestroyTriangle(vaoRainbow);
-    DestroyTriangle(vaoPulsing);
-    DestroyTriangle(vaoTrans);
-    DestroyTriangle(vaoRot);
+    if (WorldIsOpen())
+    {
+        WorldStats world = GetWorldStats();
+        std::cout << "world: " << world.resident << "/" << world.chunks << " chunks resident, "
+                  << world.residentBytes / (1024.0 * 1024.0) << " MB (peak " << world.peakBytes / (1024.0 * 1024.0)
+                  << " MB of " << worldStream.memoryCap / (1024.0 * 1024.0) << " MB cap); " << world.loaded
+                  << " loaded, " << world.evicted << " evicted, " << world.dropped << " dropped" << std::endl;
+        std::cout << "  streaming: max " << world.maxUpdateMs << " ms/frame, " << world.hitches << " frames over "
+                  << kWorldHitchMs << " ms; holes in " << world.holeFrames << " of " << world.frames << " frames, "
+                  << world.popIns << " pop-ins";
+        if (world.popIns)
+            std::cout << " (closest " << world.closestPopIn << " view units from the center)";
+        std::cout << std::endl;
+    }
+
+    if (gDemo.plot.raw)
+    {
+        const TimeSeries& plot = gDemo.plot;
+        std::cout << "plot: " << plot.count << " samples in a ring of " << plot.capacity << ", "
+                  << plot.levelCount << " levels, " << plot.bytes / (1024.0 * 1024.0) << " MB; last append "
+                  << plot.appendMs << " ms, last draw level " << plot.drawLevel << " with " << plot.drawPoints
+                  << " points over " << plot.drawColumns << " columns" << std::endl;
+    }
+
+    MeshPoolStats meshes = GetMeshPoolStats();
+    DeferredDeleteStats deferred = GetDeferredDeleteStats();
+    std::cout << "meshes: " << meshes.live << " live in " << meshes.slots << " slots, " << meshes.bytes
+              << " bytes; " << deferred.deleted << " GL objects released after their frames, "
+              << deferred.pending << " pending" << std::endl;
 
-    shader.Destroy();
+    // cleanup
+    DestroyScene(scene);
+    WorldClose();
+    DestroyTilemap(gDemo.tilemap);
+    if (tilemapSize[0] > 0)
+        TilemapShutdown();
+    DestroyTimeSeries(gDemo.plot);
+    if (plotSamples > 0)
+        TimeSeriesShutdown();
+    DestroyPointCloud(gDemo.points);
+    PointCloudShutdown();
+    SceneControlStop();
+    InstancesShutdown();
+
+    StreamServerStop();
+    FrameExportStop();
+    RenderTargetPoolShutdown();
+    ProfilerShutdown();
+    HudShutdown();
+    if (capturePath && !CaptureEnd())
+        std::cerr << "Capture " << capturePath << " is incomplete, a write failed" << std::endl;
+    DebugDrawShutdown();
+    CameraShutdown();
+    DestroySceneProgram(program);
+    DeferredDeleteFlush();
     DestroyWindow();
     return 0;
 }